@@ -3,7 +3,8 @@
 // ============================================================
 // Provides a password-protected HTTP endpoint for flashing new ESP32-P4
 // firmware over WiFi. Mirrors the OLD ESP32's ArduinoOTA feature, but uses
-// native ESP-IDF APIs (esp_https_ota) since the P4 build is pure ESP-IDF.
+// native ESP-IDF APIs (esp_ota_ops) since the P4 build is pure ESP-IDF. The
+// shared OTA pipeline below also serves the SD-card update (sd_flash.cpp).
 //
 // USAGE (from a terminal on the same WiFi network) — RAW binary POST, NOT a
 // multipart form (the handler writes the request body straight to flash):
@@ -23,10 +24,14 @@
 #include "ui.h"  // show_firmware_progress / hide_firmware_progress
 #include "freertos/FreeRTOS.h"  // vTaskDelay / pdMS_TO_TICKS
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "esp_http_server.h"
+#include "esp_heap_caps.h"
 #include "esp_ota_ops.h"
 #include "esp_log.h"
 #include "esp_system.h"
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -36,8 +41,10 @@ static const char *TAG = "OTA";
 #define OTA_USERNAME "admin"
 #define OTA_PASSWORD "spotwelder2024"
 
-// Chunk size for reading the uploaded binary from the HTTP request.
-#define OTA_BUF_SIZE 1024
+// Pipeline buffers (PSRAM): one fills from the reader while the other is
+// written to flash.
+#define OTA_PIPE_BUF  (32 * 1024)
+#define OTA_PIPE_NBUF 2
 
 // ============================================================
 //  HTTP BASIC AUTH
@@ -70,128 +77,239 @@ static bool check_auth(httpd_req_t *req)
 }
 
 // ============================================================
-//  OTA UPLOAD HANDLER
+//  OTA PIPELINE (reader -> PSRAM buffers -> writer task)
 // ============================================================
-// POST /ota — receives the firmware binary, writes it to the inactive OTA
-// partition, validates it, and reboots into the new firmware.
-static esp_err_t ota_post_handler(httpd_req_t *req)
-{
-    // Basic auth check (password protection)
-    if (!check_auth(req)) {
-        return ESP_OK;  // 401 already sent
-    }
+// The reader (HTTP socket or SD file) runs on the caller's task; a writer task
+// owns esp_ota_write. Two buffers cycle through a free and a full queue, so
+// the update takes as long as the slower of the two stages instead of their
+// sum. A zero-length buffer is the end marker. Progress goes through
+// show_firmware_progress(), which only latches the value for lvgl_task, so
+// neither stage has to yield for the bar to repaint.
+typedef struct {
+    uint8_t *data;
+    size_t   len;
+} ota_buf_t;
 
-    ESP_LOGI(TAG, "OTA update started (content-length=%d)", req->content_len);
+typedef struct {
+    esp_ota_handle_t  handle;
+    QueueHandle_t     free_q;
+    QueueHandle_t     full_q;
+    SemaphoreHandle_t done;
+    size_t            total;
+    size_t            written;
+    volatile esp_err_t err;     // first esp_ota_write error
+} ota_pipe_t;
 
-    // Show progress UI (full-screen modal, same as OLD ESP32).
-    show_firmware_progress("ESP32-P4", 0, "Preparing...");
+static volatile bool s_ota_busy = false;
 
-    esp_ota_handle_t ota_handle = 0;
-    const esp_partition_t *update_partition = NULL;
-    esp_err_t err;
+bool ota_in_progress(void) { return __atomic_load_n(&s_ota_busy, __ATOMIC_ACQUIRE); }
+
+static void ota_writer_task(void *arg)
+{
+    ota_pipe_t *p = (ota_pipe_t *)arg;
+    int last_pct = -1;
+    ota_buf_t *b = NULL;
+    while (xQueueReceive(p->full_q, &b, portMAX_DELAY) == pdTRUE) {
+        if (b->len == 0) break;  // end marker
+        if (p->err == ESP_OK) {
+            esp_err_t err = esp_ota_write(p->handle, b->data, b->len);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "esp_ota_write failed at %u bytes: %s",
+                         (unsigned)p->written, esp_err_to_name(err));
+                p->err = err;
+            } else {
+                p->written += b->len;
+            }
+        }
+        xQueueSend(p->free_q, &b, portMAX_DELAY);
+
+        int pct = (p->total > 0) ? (int)((uint64_t)p->written * 100 / p->total) : 0;
+        if (pct > 100) pct = 100;
+        if (pct != last_pct) {
+            last_pct = pct;
+            show_firmware_progress("ESP32-P4", pct, "Writing firmware...");
+        }
+    }
+    xSemaphoreGive(p->done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t ota_pipeline_run(ota_read_fn read, void *ctx, size_t total,
+                           char *err_msg, size_t err_len)
+{
+    // Claim the pipeline in one step: the HTTP and SD paths can race here.
+    if (__atomic_exchange_n(&s_ota_busy, true, __ATOMIC_ACQ_REL)) {
+        snprintf(err_msg, err_len, "Update already running");
+        return ESP_ERR_INVALID_STATE;
+    }
 
-    // Find the next OTA partition (ota_0 or ota_1, whichever is NOT running).
     const esp_partition_t *running = esp_ota_get_running_partition();
-    update_partition = esp_ota_get_next_update_partition(NULL);
+    const esp_partition_t *update_partition = esp_ota_get_next_update_partition(NULL);
     if (!update_partition) {
         ESP_LOGE(TAG, "No OTA partition found");
-        show_firmware_progress("ESP32-P4", 0, "No OTA partition!");
-        vTaskDelay(pdMS_TO_TICKS(3000));
-        hide_firmware_progress();
-        httpd_resp_send_500(req);
-        return ESP_FAIL;
+        snprintf(err_msg, err_len, "No OTA partition!");
+        __atomic_store_n(&s_ota_busy, false, __ATOMIC_RELEASE);
+        return ESP_ERR_NOT_FOUND;
     }
     ESP_LOGI(TAG, "Writing to partition '%s' at 0x%lx (running: '%s')",
              update_partition->label, update_partition->address, running->label);
 
-    // Begin OTA (erases the target partition header).
-    err = esp_ota_begin(update_partition, OTA_SIZE_UNKNOWN, &ota_handle);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "esp_ota_begin failed: %s", esp_err_to_name(err));
-        show_firmware_progress("ESP32-P4", 0, "OTA begin failed!");
-        vTaskDelay(pdMS_TO_TICKS(3000));
-        hide_firmware_progress();
-        httpd_resp_send_500(req);
-        return err;
-    }
+    ota_pipe_t p = {};
+    p.total = total;
+    p.err = ESP_OK;
+    ota_buf_t bufs[OTA_PIPE_NBUF] = {};
+    esp_err_t err = ESP_OK;
 
-    // Read the uploaded binary in chunks and write to the OTA partition.
-    char *buf = (char *)malloc(OTA_BUF_SIZE);
-    if (!buf) {
-        esp_ota_abort(ota_handle);
-        httpd_resp_send_500(req);
-        return ESP_ERR_NO_MEM;
-    }
+    do {
+        // Sequential-write mode erases each sector just before it is written,
+        // so the erase overlaps the transfer instead of all happening up front.
+        err = esp_ota_begin(update_partition, OTA_WITH_SEQUENTIAL_WRITES, &p.handle);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "esp_ota_begin failed: %s", esp_err_to_name(err));
+            snprintf(err_msg, err_len, "OTA begin failed!");
+            p.handle = 0;
+            break;
+        }
 
-    int total = req->content_len;
-    int received = 0;
-    int last_pct = -1;
+        p.free_q = xQueueCreate(OTA_PIPE_NBUF, sizeof(ota_buf_t *));
+        p.full_q = xQueueCreate(OTA_PIPE_NBUF, sizeof(ota_buf_t *));
+        p.done   = xSemaphoreCreateBinary();
+        bool alloc_ok = p.free_q && p.full_q && p.done;
+        for (int i = 0; i < OTA_PIPE_NBUF && alloc_ok; i++) {
+            bufs[i].data = (uint8_t *)heap_caps_malloc(OTA_PIPE_BUF, MALLOC_CAP_SPIRAM);
+            if (!bufs[i].data) { alloc_ok = false; break; }
+            ota_buf_t *b = &bufs[i];
+            xQueueSend(p.free_q, &b, 0);
+        }
+        if (!alloc_ok) {
+            err = ESP_ERR_NO_MEM;
+            snprintf(err_msg, err_len, "Out of memory");
+            break;
+        }
 
-    while (received < total) {
-        int to_read = (total - received) > OTA_BUF_SIZE ? OTA_BUF_SIZE : (total - received);
-        int ret = httpd_req_recv(req, buf, to_read);
-        if (ret <= 0) {
-            if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
-                continue;  // retry
+        // Internal-RAM stack: esp_ota_write runs with the flash cache paused.
+        if (xTaskCreate(ota_writer_task, "ota_writer", 4096, &p, 5, NULL) != pdPASS) {
+            err = ESP_ERR_NO_MEM;
+            snprintf(err_msg, err_len, "Out of memory");
+            break;
+        }
+
+        // Reader stage: fill a free buffer, hand it to the writer.
+        bool read_err = false, eof = false;
+        while (!eof && !read_err && p.err == ESP_OK) {
+            ota_buf_t *b = NULL;
+            xQueueReceive(p.free_q, &b, portMAX_DELAY);
+            b->len = 0;
+            while (b->len < OTA_PIPE_BUF) {
+                int r = read(ctx, b->data + b->len, OTA_PIPE_BUF - b->len);
+                if (r < 0) { read_err = true; break; }
+                if (r == 0) { eof = true; break; }
+                b->len += (size_t)r;
             }
-            ESP_LOGE(TAG, "httpd_req_recv failed");
-            esp_ota_abort(ota_handle);
-            free(buf);
-            show_firmware_progress("ESP32-P4", 0, "Download failed!");
-            vTaskDelay(pdMS_TO_TICKS(3000));
-            hide_firmware_progress();
-            httpd_resp_send_500(req);
-            return ESP_FAIL;
+            if (read_err) b->len = 0;  // drop a partial buffer
+            if (b->len > 0) xQueueSend(p.full_q, &b, portMAX_DELAY);
+            else xQueueSend(p.free_q, &b, portMAX_DELAY);
+        }
+
+        // End marker, then wait for the writer to drain.
+        ota_buf_t marker = {NULL, 0};
+        ota_buf_t *m = &marker;
+        xQueueSend(p.full_q, &m, portMAX_DELAY);
+        xSemaphoreTake(p.done, portMAX_DELAY);
+
+        if (read_err) {
+            err = ESP_FAIL;
+            snprintf(err_msg, err_len, "Download failed!");
+            break;
+        }
+        if (p.err != ESP_OK) {
+            err = p.err;
+            snprintf(err_msg, err_len, "Write failed!");
+            break;
         }
+        if (total > 0 && p.written != total) {
+            ESP_LOGW(TAG, "Size mismatch: expected %u, wrote %u",
+                     (unsigned)total, (unsigned)p.written);
+        }
+        ESP_LOGI(TAG, "OTA write complete: %u bytes", (unsigned)p.written);
 
-        // Write chunk to OTA partition.
-        err = esp_ota_write(ota_handle, buf, ret);
+        // Finalize OTA (validates the binary and sets the boot partition).
+        err = esp_ota_end(p.handle);
+        p.handle = 0;
         if (err != ESP_OK) {
-            ESP_LOGE(TAG, "esp_ota_write failed: %s", esp_err_to_name(err));
-            esp_ota_abort(ota_handle);
-            free(buf);
-            show_firmware_progress("ESP32-P4", 0, "Write failed!");
-            vTaskDelay(pdMS_TO_TICKS(3000));
-            hide_firmware_progress();
-            httpd_resp_send_500(req);
-            return err;
+            ESP_LOGE(TAG, "esp_ota_end failed: %s", esp_err_to_name(err));
+            snprintf(err_msg, err_len, "Validation failed!");
+            break;
         }
+        err = esp_ota_set_boot_partition(update_partition);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "esp_ota_set_boot_partition failed: %s", esp_err_to_name(err));
+            snprintf(err_msg, err_len, "Set boot failed!");
+            break;
+        }
+    } while (0);
 
-        received += ret;
-        int pct = (total > 0) ? (received * 100 / total) : 0;
+    if (p.handle) esp_ota_abort(p.handle);
+    for (int i = 0; i < OTA_PIPE_NBUF; i++) {
+        if (bufs[i].data) heap_caps_free(bufs[i].data);
+    }
+    if (p.free_q) vQueueDelete(p.free_q);
+    if (p.full_q) vQueueDelete(p.full_q);
+    if (p.done) vSemaphoreDelete(p.done);
+    __atomic_store_n(&s_ota_busy, false, __ATOMIC_RELEASE);
+    return err;
+}
 
-        // Update UI every 1% for smooth animated progress (bar has LV_ANIM_ON).
-        if (pct > last_pct || pct >= 100) {
-            last_pct = pct;
-            show_firmware_progress("ESP32-P4", pct, "Writing firmware...");
-            ESP_LOGI(TAG, "OTA progress: %d%%", pct);
+// ============================================================
+//  OTA UPLOAD HANDLER
+// ============================================================
+// POST /ota — streams the firmware binary through the OTA pipeline into the
+// inactive OTA partition, validates it, and reboots into the new firmware.
+typedef struct {
+    httpd_req_t *req;
+    int          remaining;
+} ota_http_src_t;
+
+static int ota_http_read(void *ctx, uint8_t *buf, size_t cap)
+{
+    ota_http_src_t *src = (ota_http_src_t *)ctx;
+    while (src->remaining > 0) {
+        int to_read = src->remaining < (int)cap ? src->remaining : (int)cap;
+        int ret = httpd_req_recv(src->req, (char *)buf, to_read);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) continue;  // retry
+        if (ret <= 0) {
+            ESP_LOGE(TAG, "httpd_req_recv failed (%d bytes left)", src->remaining);
+            return -1;
         }
+        src->remaining -= ret;
+        return ret;
+    }
+    return 0;
+}
 
-        // Yield the CPU briefly so lvgl_task can refresh the screen (prevents
-        // the glitchy/frozen progress bar the old board didn't have). Network
-        // I/O is the bottleneck, so this 1-tick delay per chunk (~10ms per KB)
-        // adds negligible overhead and keeps the UI smooth during the 10s write.
-        vTaskDelay(pdMS_TO_TICKS(1));
+static esp_err_t ota_post_handler(httpd_req_t *req)
+{
+    // Basic auth check (password protection)
+    if (!check_auth(req)) {
+        return ESP_OK;  // 401 already sent
+    }
+    if (ota_in_progress()) {
+        httpd_resp_set_status(req, "409 Conflict");
+        httpd_resp_sendstr(req, "OTA update already in progress\n");
+        return ESP_OK;
     }
 
-    free(buf);
+    ESP_LOGI(TAG, "OTA update started (content-length=%d)", req->content_len);
 
-    // Finalize OTA (validates the binary and sets the boot partition).
-    err = esp_ota_end(ota_handle);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "esp_ota_end failed: %s", esp_err_to_name(err));
-        show_firmware_progress("ESP32-P4", 0, "Validation failed!");
-        vTaskDelay(pdMS_TO_TICKS(3000));
-        hide_firmware_progress();
-        httpd_resp_send_500(req);
-        return err;
-    }
+    // Show progress UI (full-screen modal, same as OLD ESP32).
+    show_firmware_progress("ESP32-P4", 0, "Preparing...");
 
-    // Set the new partition as the boot partition.
-    err = esp_ota_set_boot_partition(update_partition);
+    ota_http_src_t src = { req, req->content_len };
+    char msg[48];
+    esp_err_t err = ota_pipeline_run(ota_http_read, &src,
+                                     (size_t)req->content_len, msg, sizeof(msg));
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "esp_ota_set_boot_partition failed: %s", esp_err_to_name(err));
-        show_firmware_progress("ESP32-P4", 0, "Set boot failed!");
+        show_firmware_progress("ESP32-P4", 0, msg);
         vTaskDelay(pdMS_TO_TICKS(3000));
         hide_firmware_progress();
         httpd_resp_send_500(req);
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
 #include "esp_http_server.h"
 
 #ifdef __cplusplus
@@ -12,6 +17,21 @@ extern "C" {
 // HTTP basic auth (admin:spotwelder2024).
 void ota_register_handler(httpd_handle_t server);
 
+// Reader stage of the OTA pipeline: copy up to `cap` bytes of the image into
+// `buf`. Return the byte count, 0 at the end of the image, or -1 on error.
+typedef int (*ota_read_fn)(void *ctx, uint8_t *buf, size_t cap);
+
+// Write an ESP32-P4 image to the inactive OTA partition and make it the boot
+// partition (does not reboot). `read` runs on the calling task and fills PSRAM
+// buffers while a writer task drains them into flash, so receive/read and
+// flash write overlap. `total` (0 = unknown) drives the percent shown through
+// show_firmware_progress(). On failure `err_msg` gets a short UI reason.
+esp_err_t ota_pipeline_run(ota_read_fn read, void *ctx, size_t total,
+                           char *err_msg, size_t err_len);
+
+// True while ota_pipeline_run() is writing (HTTP or SD).
+bool ota_in_progress(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,181 @@
+// ============================================================
+//  Perf Stats — latency histograms for the P4 side of the weld path
+// ============================================================
+// Same log-linear histogram as the STM32's PERF (exact below 16, then four
+// bins per power of two), here in microseconds: p99 is the upper edge of
+// its bin, so it reads at most 25 % high. Each record is a handful of
+// integer ops under a spinlock, cheap enough for every send() and frame.
+
+#include "perf_stats.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PERF_BINS 128
+
+typedef struct {
+    uint32_t n, min, max;
+    uint64_t sum;
+    uint16_t bin[PERF_BINS];    // saturating counts
+} perf_hist_t;
+
+static const char *const s_stage_names[PERF_STAGE_COUNT] = {
+    "wd_rx_parse", "wd_parse_bcast", "wd_rx_ui", "tcp_send", "lvgl_frame",
+};
+
+static perf_hist_t  s_hist[PERF_STAGE_COUNT];
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// WELD_DONE milestones. One weld is in flight at a time (welds are >= 1 s
+// apart), so a single set of timestamps is enough.
+static volatile uint32_t s_wd_rx_us = 0;
+static volatile uint32_t s_wd_parsed_us = 0;
+static volatile bool     s_wd_bcast_due = false;
+static volatile bool     s_wd_ui_due = false;
+
+static inline uint32_t now_us(void) { return (uint32_t)esp_timer_get_time(); }
+
+static uint32_t perf_bin(uint32_t v)
+{
+    if (v < 16) return v;
+    uint32_t msb = 31 - (uint32_t)__builtin_clz(v);
+    return 16 + (msb - 4) * 4 + ((v >> (msb - 2)) & 3);
+}
+
+static uint32_t perf_bin_upper(uint32_t b)
+{
+    if (b < 16) return b;
+    uint32_t msb = (b - 16) / 4 + 4, sub = (b - 16) % 4;
+    return ((4 + sub) << (msb - 2)) + ((1u << (msb - 2)) - 1);
+}
+
+static uint32_t perf_p99(const perf_hist_t *h)
+{
+    uint32_t want = h->n - h->n / 100, seen = 0;  // ceil(0.99 n)
+    for (uint32_t b = 0; b < PERF_BINS; b++) {
+        seen += h->bin[b];
+        if (seen >= want) {
+            uint32_t up = perf_bin_upper(b);
+            return up < h->max ? up : h->max;
+        }
+    }
+    return h->max;  // a bin saturated
+}
+
+void perf_record_us(perf_stage_t stage, uint32_t us)
+{
+    if (stage >= PERF_STAGE_COUNT) return;
+    perf_hist_t *h = &s_hist[stage];
+    portENTER_CRITICAL(&s_mux);
+    if (h->n == 0 || us < h->min) h->min = us;
+    if (us > h->max) h->max = us;
+    h->n++;
+    h->sum += us;
+    uint16_t *b = &h->bin[perf_bin(us)];
+    if (*b != 0xFFFF) (*b)++;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+void perf_weld_rx(void)
+{
+    s_wd_rx_us = now_us();
+}
+
+void perf_weld_parsed(void)
+{
+    uint32_t t = now_us();
+    perf_record_us(PERF_WD_RX_PARSE, t - s_wd_rx_us);
+    s_wd_parsed_us = t;
+    s_wd_bcast_due = true;
+    s_wd_ui_due = true;
+}
+
+void perf_weld_broadcast(void)
+{
+    if (!s_wd_bcast_due) return;
+    s_wd_bcast_due = false;
+    perf_record_us(PERF_WD_PARSE_BCAST, now_us() - s_wd_parsed_us);
+}
+
+void perf_weld_ui(void)
+{
+    if (!s_wd_ui_due) return;
+    s_wd_ui_due = false;
+    perf_record_us(PERF_WD_RX_UI, now_us() - s_wd_rx_us);
+}
+
+void perf_reset(void)
+{
+    portENTER_CRITICAL(&s_mux);
+    memset(s_hist, 0, sizeof(s_hist));
+    portEXIT_CRITICAL(&s_mux);
+}
+
+// PERF_TASK lines need CONFIG_FREERTOS_USE_TRACE_FACILITY and
+// CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS (sdkconfig.defaults).
+static bool perf_report_tasks(perf_emit_fn emit, void *ctx, unsigned *count)
+{
+    *count = 0;
+#if (configUSE_TRACE_FACILITY == 1) && (configGENERATE_RUN_TIME_STATS == 1)
+    UBaseType_t cap = uxTaskGetNumberOfTasks() + 4;
+    TaskStatus_t *ts = (TaskStatus_t *)malloc(cap * sizeof(TaskStatus_t));
+    if (!ts) return true;
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t n = uxTaskGetSystemState(ts, cap, &total);
+    bool ok = true;
+    char line[128];
+    for (UBaseType_t i = 0; i < n && ok; i++) {
+        // Run time is per task over boot; the total counts one core, so a
+        // task pinned to a busy core can read up to 100 %.
+        float pct = total ? 100.0f * (float)ts[i].ulRunTimeCounter / (float)total : 0.0f;
+        int core = (ts[i].xCoreID == tskNO_AFFINITY) ? -1 : (int)ts[i].xCoreID;
+        snprintf(line, sizeof(line),
+                 "PERF_TASK,src=p4,name=%s,core=%d,prio=%u,cpu_pct=%.1f,stack_free=%lu",
+                 ts[i].pcTaskName, core, (unsigned)ts[i].uxCurrentPriority, pct,
+                 (unsigned long)ts[i].usStackHighWaterMark);
+        ok = emit(line, ctx);
+    }
+    *count = (unsigned)n;
+    free(ts);
+    return ok;
+#else
+    (void)emit;
+    (void)ctx;
+    return true;
+#endif
+}
+
+void perf_report(perf_emit_fn emit, void *ctx)
+{
+    char line[192];
+    for (int s = 0; s < PERF_STAGE_COUNT; s++) {
+        perf_hist_t h;
+        portENTER_CRITICAL(&s_mux);
+        h = s_hist[s];
+        portEXIT_CRITICAL(&s_mux);
+        snprintf(line, sizeof(line),
+                 "PERF,src=p4,stage=%s,n=%lu,min_us=%.1f,avg_us=%.1f,p99_us=%.1f,max_us=%.1f",
+                 s_stage_names[s], (unsigned long)h.n, (float)h.min,
+                 h.n ? (float)h.sum / (float)h.n : 0.0f,
+                 h.n ? (float)perf_p99(&h) : 0.0f, (float)h.max);
+        if (!emit(line, ctx)) return;
+    }
+
+    perf_rx_counters_t rx;
+    welder_get_rx_counters(&rx);
+    snprintf(line, sizeof(line),
+             "PERF_UART,src=p4,lines=%lu,overlong=%lu,uart_ovf=%lu,parse_drop=%lu,bcast_drop=%lu",
+             (unsigned long)rx.lines, (unsigned long)rx.overlong, (unsigned long)rx.uart_ovf,
+             (unsigned long)rx.parse_drop, (unsigned long)rx.bcast_drop);
+    if (!emit(line, ctx)) return;
+
+    unsigned tasks = 0;
+    if (!perf_report_tasks(emit, ctx, &tasks)) return;
+
+    snprintf(line, sizeof(line), "PERF_END,src=p4,stages=%d,tasks=%u,uptime_ms=%lu",
+             (int)PERF_STAGE_COUNT, tasks, (unsigned long)(esp_timer_get_time() / 1000ULL));
+    emit(line, ctx);
+}
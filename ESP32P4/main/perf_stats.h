@@ -0,0 +1,55 @@
+// ============================================================
+//  Perf Stats — latency histograms for the P4 side of the weld path
+// ============================================================
+// esp_timer timestamps at each P4 stage an EVENT,WELD_DONE passes through,
+// plus per-call costs of the hot loops, kept as min/avg/p99/max histograms.
+// Answered locally to the TCP command PERF (the bridge also forwards PERF to
+// the STM32, which reports its own DWT-timed stages). PERF_RESET clears both.
+// See PROTOCOL.md, "Latency instrumentation".
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    PERF_WD_RX_PARSE = 0,   // WELD_DONE framed (stm32_task) -> stm32_parse_task
+    PERF_WD_PARSE_BCAST,    // parse task took it -> queued to the TCP clients
+    PERF_WD_RX_UI,          // framed -> next Status-tab refresh (lvgl_task)
+    PERF_TCP_SEND,          // one send() in bridge_tx_task
+    PERF_LVGL_FRAME,        // one lv_timer_handler() call
+    PERF_STAGE_COUNT
+} perf_stage_t;
+
+// stm32_task's loss counters (provided by welder_main.cpp).
+typedef struct {
+    uint32_t lines;
+    uint32_t overlong;
+    uint32_t uart_ovf;
+    uint32_t parse_drop;
+    uint32_t bcast_drop;
+} perf_rx_counters_t;
+void welder_get_rx_counters(perf_rx_counters_t *out);
+
+// Fold one duration into a stage histogram. Any task; each stage should
+// have a single writer.
+void perf_record_us(perf_stage_t stage, uint32_t us);
+
+// WELD_DONE milestones, each called by the task that owns that stage.
+void perf_weld_rx(void);         // stm32_task: line framed
+void perf_weld_parsed(void);     // stm32_parse_task: line dequeued
+void perf_weld_broadcast(void);  // stm32_bcast_task: wifi_bridge_broadcast returned
+void perf_weld_ui(void);         // lvgl_task: ui_update ran
+
+// Emit the report (PERF / PERF_UART / PERF_TASK lines, then PERF_END).
+// Stops early if emit() returns false.
+typedef bool (*perf_emit_fn)(const char *line, void *ctx);
+void perf_report(perf_emit_fn emit, void *ctx);
+void perf_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,10 +4,11 @@
 #include "sd_flash.h"
 #include "ui.h"          // show_firmware_progress / hide_firmware_progress / show_firmware_result_popup
 #include "stm32_flash.h" // stm32_flash_start / stm32_flash_in_progress
+#include "ota.h"         // ota_pipeline_run / ota_in_progress
+#include "weld_log.h"    // weld_log_suspend / weld_log_resume around remount
 
 #include "esp_log.h"
 #include "esp_err.h"
-#include "esp_ota_ops.h"
 #include "esp_system.h"
 #include "esp_heap_caps.h"   // heap_caps_malloc / heap_caps_free / MALLOC_CAP_SPIRAM
 #include "freertos/FreeRTOS.h"
@@ -26,6 +27,10 @@
 
 static const char *TAG = "SD_FLASH";
 
+// Handed from sd_flash_esp32() to sd_ota_task (one update at a time).
+static FILE  *sd_ota_file = NULL;
+static size_t sd_ota_size = 0;
+
 // SD card mount point and handle
 #define SD_MOUNT_POINT "/sdcard"
 static sdmmc_card_t *g_sd_card = NULL;
@@ -35,9 +40,6 @@ static bool g_sd_mounted = false;
 #define SD_ESP32_FW_PATH  SD_MOUNT_POINT "/esp32_firmware.bin"
 #define SD_STM32_FW_PATH  SD_MOUNT_POINT "/stm32_firmware.bin"
 
-// OTA buffer size (balance between speed and RAM usage; use PSRAM for large buffer)
-#define OTA_BUF_SIZE (16 * 1024)
-
 // ============================================================
 //  SD CARD INITIALIZATION (SDMMC SLOT_0, 1-bit)
 // ============================================================
@@ -124,6 +126,7 @@ static bool sd_flash_force_remount(void)
     // controller and causes a Guru Meditation (instruction access fault in
     // sd_host_del_controller).
     if (g_sd_mounted) {
+        weld_log_suspend();  // close WELDLOG files before the FAT goes away
         esp_vfs_fat_sdcard_unmount(SD_MOUNT_POINT, g_sd_card);
         g_sd_card = NULL;
         g_sd_mounted = false;
@@ -137,17 +140,35 @@ static bool sd_flash_force_remount(void)
     // re-init the host AND re-probe the card (full CMD0/CMD8/ACMD41 sequence),
     // which is exactly what's needed to detect a hot-swapped card.
     ESP_LOGI(TAG, "  Re-initializing SDMMC + FAT...");
-    return sd_flash_init();
+    bool ok = sd_flash_init();
+    weld_log_resume();
+    return ok;
 }
 
 // ============================================================
 //  ESP32-P4 SELF-FLASH (OTA from SD)
 // ============================================================
-// Reads /esp32_firmware.bin from SD, writes to the inactive OTA partition
-// using the esp_ota_* API, validates, switches boot partition, and reboots.
-// Shows progress UI during the flash.
+// Reads /esp32_firmware.bin from SD through the shared OTA pipeline (ota.cpp):
+// fread fills PSRAM buffers on sd_ota_task while the pipeline's writer task
+// programs the inactive OTA partition. The button callback only does the
+// checks, so lvgl_task keeps painting the progress bar during the flash.
+static void sd_ota_task(void *arg);
+
+static int sd_ota_read(void *ctx, uint8_t *buf, size_t cap)
+{
+    FILE *f = (FILE *)ctx;
+    size_t rd = fread(buf, 1, cap, f);
+    if (rd == 0 && ferror(f)) return -1;
+    return (int)rd;
+}
+
 bool sd_flash_esp32(void)
 {
+    if (ota_in_progress() || sd_ota_file) {
+        ESP_LOGW(TAG, "ESP32 update already in progress — ignoring duplicate request");
+        return false;
+    }
+
     // FORCE REMOUNT every time: handles hot-swap (card removed/re-inserted after
     // boot) without needing a hardware card-detect pin. This tears down and
     // rebuilds the SDMMC/FAT stack from scratch so the controller re-probes.
@@ -203,108 +224,46 @@ bool sd_flash_esp32(void)
         return false;
     }
 
-    // Begin OTA
-    const esp_partition_t *update_partition = esp_ota_get_next_update_partition(NULL);
-    if (!update_partition) {
-        ESP_LOGE(TAG, "No OTA update partition available");
-        fclose(f);
-        show_firmware_result_popup(false, "No OTA partition found", "ESP32-P4");
-        return false;
-    }
-    ESP_LOGI(TAG, "Writing to OTA partition: %s (offset 0x%lx, size %lu bytes)",
-             update_partition->label, update_partition->address, update_partition->size);
-
-    esp_ota_handle_t ota_handle = 0;
-    esp_err_t err = esp_ota_begin(update_partition, fw_size, &ota_handle);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "esp_ota_begin failed: %s", esp_err_to_name(err));
-        fclose(f);
-        show_firmware_result_popup(false, "OTA begin failed", "ESP32-P4");
-        return false;
-    }
-
-    // Allocate read buffer in PSRAM (large buffer for speed)
-    uint8_t *buf = (uint8_t*)heap_caps_malloc(OTA_BUF_SIZE, MALLOC_CAP_SPIRAM);
-    if (!buf) {
-        ESP_LOGE(TAG, "Failed to allocate %d-byte OTA buffer in PSRAM", OTA_BUF_SIZE);
-        esp_ota_abort(ota_handle);
+    // Show progress UI (initial state: 0%) and hand the file to the flash task.
+    // sd_ota_file only marks the update busy; the task gets f as its argument.
+    show_firmware_progress("ESP32-P4", 0, "Writing firmware...");
+    sd_ota_file = f;
+    sd_ota_size = fw_size;
+    if (xTaskCreate(sd_ota_task, "sd_ota", 4096, f, 5, NULL) != pdPASS) {
+        sd_ota_file = NULL;
+        sd_ota_size = 0;
         fclose(f);
+        hide_firmware_progress();
         show_firmware_result_popup(false, "Out of memory", "ESP32-P4");
         return false;
     }
+    return true;
+}
 
-    // Show progress UI (initial state: 0%)
-    show_firmware_progress("ESP32-P4", 0, "Writing firmware...");
-
-    // Read and write firmware in chunks
-    size_t bytes_written = 0;
-    int last_pct = -1;
-    while (true) {
-        size_t rd = fread(buf, 1, OTA_BUF_SIZE, f);
-        if (rd == 0) {
-            break;  // EOF
-        }
-
-        err = esp_ota_write(ota_handle, buf, rd);
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "esp_ota_write failed at %zu bytes: %s", bytes_written, esp_err_to_name(err));
-            heap_caps_free(buf);
-            esp_ota_abort(ota_handle);
-            fclose(f);
-            hide_firmware_progress();
-            show_firmware_result_popup(false, "OTA write failed", "ESP32-P4");
-            return false;
-        }
-
-        bytes_written += rd;
-        int pct = (int)((bytes_written * 100) / fw_size);
-        if (pct != last_pct && pct <= 100) {
-            show_firmware_progress("ESP32-P4", pct, NULL);
-            last_pct = pct;
-        }
-
-        // Yield to LVGL task periodically (every 64 KB written)
-        if ((bytes_written & 0xFFFF) == 0) {
-            vTaskDelay(pdMS_TO_TICKS(10));
-        }
-    }
-
-    heap_caps_free(buf);
+static void sd_ota_task(void *arg)
+{
+    FILE *f = (FILE *)arg;
+    char msg[48];
+    esp_err_t err = ota_pipeline_run(sd_ota_read, f, sd_ota_size,
+                                     msg, sizeof(msg));
     fclose(f);
+    sd_ota_file = NULL;
+    sd_ota_size = 0;
 
-    if (bytes_written != fw_size) {
-        ESP_LOGW(TAG, "File size mismatch: expected %zu, wrote %zu", fw_size, bytes_written);
-    }
-
-    ESP_LOGI(TAG, "OTA write complete: %zu bytes", bytes_written);
-
-    // End OTA and validate
-    err = esp_ota_end(ota_handle);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "esp_ota_end failed: %s (image validation failed)", esp_err_to_name(err));
+        // Not on lvgl_task: report through the (latched) progress modal.
+        show_firmware_progress("ESP32-P4", 0, msg);
+        vTaskDelay(pdMS_TO_TICKS(3000));
         hide_firmware_progress();
-        show_firmware_result_popup(false, "Firmware validation failed", "ESP32-P4");
-        return false;
-    }
-
-    // Set new boot partition
-    err = esp_ota_set_boot_partition(update_partition);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "esp_ota_set_boot_partition failed: %s", esp_err_to_name(err));
-        hide_firmware_progress();
-        show_firmware_result_popup(false, "Failed to set boot partition", "ESP32-P4");
-        return false;
+        vTaskDelete(NULL);
+        return;
     }
 
     ESP_LOGI(TAG, "ESP32-P4 firmware flash SUCCESS — rebooting in 2 seconds");
-    hide_firmware_progress();
-    show_firmware_result_popup(true, "Flash complete! Rebooting...", "ESP32-P4");
+    show_firmware_progress("ESP32-P4", 100, "Flash complete! Rebooting...");
 
     vTaskDelay(pdMS_TO_TICKS(2000));
     esp_restart();
-
-    // Never reached
-    return true;
 }
 
 // ============================================================
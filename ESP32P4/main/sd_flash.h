@@ -8,7 +8,8 @@
 // ARCHITECTURE (Simplified for SPI WiFi):
 //   Since WiFi now runs over SPI (external XIAO C6), not SDIO, the SDMMC
 //   controller is free for the SD card. We mount it at boot and keep it mounted.
-//   Flashing happens synchronously when the user presses the UI button.
+//   The UI button only validates and starts the flash; the transfer runs on a
+//   background task so the progress modal keeps repainting.
 //
 // Hardware: ESP32-P4 SDMMC pins (1-bit mode, proven Elecrow config):
 //   CLK  = GPIO43
@@ -39,9 +40,10 @@ bool sd_flash_init(void);
 bool sd_flash_is_mounted(void);
 
 // Flash the ESP32-P4 from /esp32_firmware.bin on the SD card.
-// Blocks until complete, shows progress UI, then REBOOTS on success.
-// On failure, shows error popup and returns false (no reboot).
-// Safe to call from LVGL button callbacks (runs in app_main task context).
+// Checks the card/file, then starts a background task (OTA pipeline, see
+// ota.h) that shows progress and REBOOTS on success. Returns true once started.
+// A check failure shows an error popup and returns false; a write failure is
+// shown on the progress modal (no reboot). Call from LVGL button callbacks.
 bool sd_flash_esp32(void);
 
 // Flash the STM32G474 from /stm32_firmware.bin on the SD card.
@@ -24,6 +24,7 @@
 
 #include "stm32_flash.h"
 
+#include <stdlib.h>
 #include <string.h>
 #include <strings.h>   // strcasecmp() for the ?method= query parse
 #include <stdio.h>
@@ -31,6 +32,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "driver/uart.h"
 #include "driver/gpio.h"
 #include "esp_attr.h"
@@ -38,6 +40,7 @@
 #include "esp_private/esp_clk.h" // esp_clk_cpu_freq()
 #include "esp_rom_gpio.h"        // esp_rom_gpio_connect_out_signal()
 #include "esp_rom_sys.h"         // esp_rom_delay_us()
+#include "esp_rom_crc.h"         // esp_rom_crc32_le() (zlib CRC-32)
 #include "soc/gpio_sig_map.h"    // SIG_GPIO_OUT_IDX
 #include "esp_log.h"
 #include "esp_system.h"
@@ -90,9 +93,38 @@ extern "C" void welder_prep_stm32_flash(void);
 
 // ---- Flasher state ----
 static volatile bool s_in_progress = false;
-static uint8_t      *s_fw  = NULL;   // owned heap buffer (freed by the task)
+static uint8_t      *s_fw  = NULL;   // owned heap buffer (freed by the task),
+                                     // NULL when the image is streamed
 static size_t        s_len = 0;
 
+// ---- Streamed image (POST /stm32) ----
+// The upload handler (producer) and the flasher task (consumer) pass two
+// STM32_STREAM_BUF buffers back and forth: one fills from the socket while the
+// other is sent to Katapult, so the flash runs while the upload is arriving.
+#define STM32_STREAM_BUF     4096
+#define STM32_STREAM_NBUF    2
+#define STM32_STREAM_WAIT_MS 10000   // max wait for the other side, per buffer
+
+typedef struct {
+    uint8_t *data;
+    size_t   len;                    // bytes filled
+} stream_buf_t;
+
+static stream_buf_t   s_stream_bufs[STM32_STREAM_NBUF];
+static QueueHandle_t  s_stream_free = NULL;     // empty buffers -> producer
+static QueueHandle_t  s_stream_full = NULL;     // filled buffers -> flasher
+static SemaphoreHandle_t s_stream_done = NULL;  // flasher finished (either way)
+static volatile bool  s_stream_aborted = false; // upload cut short
+static volatile bool  s_flash_failed   = false; // flasher gave up
+static volatile bool  s_flash_ok       = false;
+static char           s_result_msg[128];
+
+// Consumer cursor + running CRC-32 of everything handed to Katapult.
+static stream_buf_t  *s_cur     = NULL;
+static size_t         s_cur_off = 0;
+static size_t         s_src_off = 0;
+static uint32_t       s_img_crc = 0;
+
 // ROM-entry method selector, set from the /stm32?method= query before each flash:
 //   ENTRY_AUTO (default) = try the 2-wire software jump first, fall back to the
 //                          BOOT0+NRST hardware pulse if the ROM stays silent.
@@ -856,16 +888,96 @@ static void IRAM_ATTR katapult_double_tap_nrst(void) {
     ESP_LOGI(TAG, "Katapult: double-tap complete, bootloader should be active");
 }
 
+// ============================================================
+//  IMAGE SOURCE (in-RAM image or streamed upload)
+// ============================================================
+
+// Copy the next n image bytes to dst, from s_fw or from the upload stream.
+// Returns false if the upload was aborted or stalled.
+static bool image_read(uint8_t *dst, size_t n) {
+    if (s_fw) {
+        memcpy(dst, s_fw + s_src_off, n);
+    } else {
+        size_t got = 0;
+        while (got < n) {
+            if (!s_cur) {
+                int waited = 0;
+                while (xQueueReceive(s_stream_full, &s_cur, pdMS_TO_TICKS(100)) != pdTRUE) {
+                    waited += 100;
+                    if (s_stream_aborted || waited >= STM32_STREAM_WAIT_MS) return false;
+                }
+                s_cur_off = 0;
+            }
+            size_t take = s_cur->len - s_cur_off;
+            if (take > n - got) take = n - got;
+            memcpy(dst + got, s_cur->data + s_cur_off, take);
+            got += take;
+            s_cur_off += take;
+            if (s_cur_off >= s_cur->len) {
+                xQueueSend(s_stream_free, &s_cur, 0);  // never full: NBUF slots
+                s_cur = NULL;
+            }
+        }
+    }
+    s_img_crc = esp_rom_crc32_le(s_img_crc, dst, n);
+    s_src_off += n;
+    return true;
+}
+
+// After COMPLETE Katapult launches the new app. Ask it for the CRC-32 of the
+// first len bytes of its own image (FW_CRC,<len>) and compare with what was
+// sent. This replaces a full read-back: one short line instead of the image.
+// Returns 1 on match, 0 on mismatch, -1 if the app never answered (an image
+// without FW_CRC, or it did not boot). The caller fails the update on both 0
+// and -1: an unverified image is not reported as a success.
+static int katapult_verify_crc(size_t len, uint32_t want) {
+    uart_set_baudrate(STM_BOOT_UART, STM_APP_BAUD);
+    vTaskDelay(pdMS_TO_TICKS(300));  // app boot
+    uart_flush_input(STM_BOOT_UART);
+
+    char cmd[32];
+    int cmd_len = snprintf(cmd, sizeof(cmd), "FW_CRC,%u\n", (unsigned)len);
+    char line[96];
+    size_t ll = 0;
+    for (int attempt = 0; attempt < 6; attempt++) {
+        uart_write_bytes(STM_BOOT_UART, cmd, cmd_len);
+        uart_wait_tx_done(STM_BOOT_UART, pdMS_TO_TICKS(20));
+        TickType_t until = xTaskGetTickCount() + pdMS_TO_TICKS(500);
+        while ((int32_t)(until - xTaskGetTickCount()) > 0) {
+            uint8_t c;
+            if (uart_read_bytes(STM_BOOT_UART, &c, 1, pdMS_TO_TICKS(20)) != 1) continue;
+            if (c == '\r') continue;
+            if (c != '\n') {
+                if (ll < sizeof(line) - 1) line[ll++] = (char)c;
+                continue;
+            }
+            line[ll] = '\0';
+            ll = 0;
+            if (strncmp(line, "ACK,FW_CRC,", 11) != 0) continue;
+            const char *p = strstr(line, "crc32=");
+            if (!p) continue;
+            uint32_t got = (uint32_t)strtoul(p + 6, NULL, 16);
+            ESP_LOGI(TAG, "FW_CRC: app reports 0x%08lX, sent 0x%08lX",
+                     (unsigned long)got, (unsigned long)want);
+            return (got == want) ? 1 : 0;
+        }
+    }
+    return -1;
+}
+
 // ============================================================
 //  KATAPULT FLASH WORKER
 // ============================================================
 
-// Flash via Katapult bootloader (250000 8N1, CRC-checked block protocol)
-static bool katapult_flash_worker(const uint8_t *fw, size_t len, char *msg, size_t msgn) {
+// Flash via Katapult bootloader (250000 8N1, CRC-checked block protocol).
+// Blocks come from image_read(), so a streamed upload is written as it
+// arrives; the end-to-end check is the app's FW_CRC after COMPLETE.
+static bool katapult_flash_worker(size_t len, char *msg, size_t msgn) {
     bool ok = false;
     const char *err = NULL;
     uint32_t app_start = 0;
     uint32_t block_size = 0;
+    int verified = -1;
 
     do {
         // 1) Try software entry: Send BOOTLOADER command to the running app @ 1Mbaud 8N1
@@ -989,8 +1101,13 @@ static bool katapult_flash_worker(const uint8_t *fw, size_t len, char *msg, size
 
             uint8_t block_buf[1024 + 4];
             
-            // Copy the actual firmware data
-            memcpy(block_buf + 4, fw + done, chunk);
+            // Copy the actual firmware data (waits for the upload if streaming)
+            if (!image_read(block_buf + 4, chunk)) {
+                snprintf(msg, msgn, "STM32 upload %s at offset %u",
+                         s_stream_aborted ? "aborted" : "stalled", (unsigned)done);
+                err = msg;
+                break;
+            }
 
             // Pad the rest of the block to FULL block_size with 0xFF (flash erased state)
             // This matches flashtool.py: block + b'\xff' * (BLOCK_SIZE - len(block))
@@ -1040,7 +1157,8 @@ static bool katapult_flash_worker(const uint8_t *fw, size_t len, char *msg, size
                 last_pct = pct;
                 show_firmware_progress("STM32", pct, "Writing firmware...");
             }
-            vTaskDelay(1);  // yield
+            // No per-block vTaskDelay: every block already blocks on its ACK
+            // (and on the upload when streaming), which yields the CPU.
         }
 
         if (err) break;
@@ -1080,6 +1198,22 @@ static bool katapult_flash_worker(const uint8_t *fw, size_t len, char *msg, size
         }
 
         ESP_LOGI(TAG, "Katapult flash complete! Katapult will now launch the app.");
+
+        // 8) Verify: CRC-32 of the image as sent vs. as it reads in flash
+        show_firmware_progress("STM32", 97, "Verifying...");
+        verified = katapult_verify_crc(len, s_img_crc);
+        if (verified == 0) {
+            snprintf(msg, msgn, "STM32 verify failed: flash CRC does not match image 0x%08lX",
+                     (unsigned long)s_img_crc);
+            err = msg;
+            break;
+        }
+        if (verified < 0) {
+            snprintf(msg, msgn, "STM32 verify failed: no FW_CRC answer from the new app "
+                     "(image 0x%08lX not verified)", (unsigned long)s_img_crc);
+            err = msg;
+            break;
+        }
         ok = true;
 
     } while (0);
@@ -1088,7 +1222,10 @@ static bool katapult_flash_worker(const uint8_t *fw, size_t len, char *msg, size
         err = "Katapult flash failed (unknown error)";
     }
 
-    snprintf(msg, msgn, "%s", ok ? "STM32 firmware updated via Katapult. Restarting..." : err);
+    if (ok)
+        snprintf(msg, msgn, "STM32 firmware updated via Katapult (CRC verified). Restarting...");
+    else if (err != msg)
+        snprintf(msg, msgn, "%s", err);
     return ok;
 }
 
@@ -1340,7 +1477,7 @@ static void stm32_flash_task(void *arg) {
     welder_prep_stm32_flash();
     
     // Use Katapult protocol (CRC-checked, 250k 8N1, no BOOT0/NRST needed)
-    bool ok = katapult_flash_worker(s_fw, s_len, msg, sizeof(msg));
+    bool ok = katapult_flash_worker(s_len, msg, sizeof(msg));
 
     ESP_LOGI(TAG, "flash %s: %s", ok ? "OK" : "FAIL", msg);
     show_firmware_progress("STM32", 100,
@@ -1350,12 +1487,27 @@ static void stm32_flash_task(void *arg) {
     if (s_fw) { free(s_fw); s_fw = NULL; }
     s_len = 0;
 
+    // Streamed upload: a still-blocked producer stops, and the HTTP handler
+    // reports the real result before the reboot below drops the connection.
+    snprintf(s_result_msg, sizeof(s_result_msg), "%s", msg);
+    s_flash_ok = ok;
+    s_flash_failed = !ok;
+    if (s_stream_done) xSemaphoreGive(s_stream_done);
+
     // Always reboot so both sides start from a clean app link (mirrors the OLD
     // board). s_in_progress is implicitly cleared by the reboot.
     vTaskDelay(pdMS_TO_TICKS(1500));
     esp_restart();  // never returns
 }
 
+static void stm32_flash_spawn(void) {
+    s_src_off = 0;
+    s_img_crc = 0;
+    // Internal-RAM stack (xTaskCreate, not PinnedToCore-PSRAM) for the timing-
+    // sensitive flasher. 8 KB stack; priority 6 (above stm32_task's 4).
+    xTaskCreate(stm32_flash_task, "stm32_flash", 8192, NULL, 6, NULL);
+}
+
 void stm32_flash_start(uint8_t *fw, size_t len) {
     if (s_in_progress) {            // refuse a second concurrent request
         if (fw) free(fw);
@@ -1364,17 +1516,53 @@ void stm32_flash_start(uint8_t *fw, size_t len) {
     s_fw = fw;
     s_len = len;
     s_in_progress = true;
-    // Internal-RAM stack (xTaskCreate, not PinnedToCore-PSRAM) for the timing-
-    // sensitive flasher. 8 KB stack; priority 6 (above stm32_task's 4).
-    xTaskCreate(stm32_flash_task, "stm32_flash", 8192, NULL, 6, NULL);
+    stm32_flash_spawn();
+}
+
+// Start a flash whose image arrives through the stream buffers. Internal RAM
+// for the buffers: they are touched at UART pace from the flasher task.
+static bool stm32_flash_stream_begin(size_t len) {
+    if (s_in_progress) return false;
+    for (int i = 0; i < STM32_STREAM_NBUF; i++) {
+        if (!s_stream_bufs[i].data)
+            s_stream_bufs[i].data = (uint8_t *)heap_caps_malloc(
+                STM32_STREAM_BUF, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!s_stream_bufs[i].data) {
+            ESP_LOGE(TAG, "stream buffers: out of memory");
+            return false;
+        }
+    }
+    if (!s_stream_free) s_stream_free = xQueueCreate(STM32_STREAM_NBUF, sizeof(stream_buf_t *));
+    if (!s_stream_full) s_stream_full = xQueueCreate(STM32_STREAM_NBUF, sizeof(stream_buf_t *));
+    if (!s_stream_done) s_stream_done = xSemaphoreCreateBinary();
+    if (!s_stream_free || !s_stream_full || !s_stream_done) return false;
+    xQueueReset(s_stream_free);
+    xQueueReset(s_stream_full);
+    xSemaphoreTake(s_stream_done, 0);
+    for (int i = 0; i < STM32_STREAM_NBUF; i++) {
+        stream_buf_t *b = &s_stream_bufs[i];
+        b->len = 0;
+        xQueueSend(s_stream_free, &b, 0);
+    }
+    s_cur = NULL;
+    s_stream_aborted = false;
+    s_flash_failed = false;
+    s_flash_ok = false;
+    s_result_msg[0] = '\0';
+    s_fw = NULL;
+    s_len = len;
+    s_in_progress = true;
+    stm32_flash_spawn();
+    return true;
 }
 
 // ============================================================
 //  HTTP UPLOAD HANDLER  (POST /stm32)
 // ============================================================
-// Receives a raw STM32 .bin image into a PSRAM buffer, then hands it to
-// stm32_flash_start() (which owns + frees the buffer and reboots when done).
-// Mirrors ota.cpp's /ota handler. The G474CE has 512 KB flash, so we accept
+// Streams a raw STM32 .bin image into the flasher as it arrives (see "Streamed
+// image" above): Katapult blocks are written while the rest of the upload is
+// still in flight, and the response carries the flash result. The flasher
+// reboots the ESP32 when done. The G474CE has 512 KB flash, so we accept
 // images in the 256 B .. 512 KB range.
 #define STM32_MIN_IMG  256u
 #define STM32_MAX_IMG  (512u * 1024u)
@@ -1419,37 +1607,62 @@ static esp_err_t stm32_post_handler(httpd_req_t *req) {
         return ESP_OK;
     }
 
-    uint8_t *buf = (uint8_t *)heap_caps_malloc(total, MALLOC_CAP_SPIRAM);
-    if (!buf) buf = (uint8_t *)malloc(total);  // fall back to internal RAM
-    if (!buf) {
-        ESP_LOGE(TAG, "failed to allocate %d bytes for STM32 image", total);
+    if (!stm32_flash_stream_begin((size_t)total)) {
         httpd_resp_send_500(req);
         return ESP_FAIL;
     }
 
+    // Producer: fill a free buffer from the socket, hand it to the flasher.
     int received = 0;
-    while (received < total) {
+    stream_buf_t *b = NULL;
+    bool failed = false;
+    while (received < total && !s_flash_failed) {
+        if (!b) {
+            int waited = 0;
+            while (xQueueReceive(s_stream_free, &b, pdMS_TO_TICKS(100)) != pdTRUE) {
+                waited += 100;
+                if (s_flash_failed || waited >= STM32_STREAM_WAIT_MS) break;
+            }
+            if (!b) { failed = true; break; }
+            b->len = 0;
+        }
         int to_read = total - received;
         if (to_read > STM32_RECV_CHUNK) to_read = STM32_RECV_CHUNK;
-        int r = httpd_req_recv(req, (char *)(buf + received), to_read);
+        if (to_read > (int)(STM32_STREAM_BUF - b->len)) to_read = (int)(STM32_STREAM_BUF - b->len);
+        int r = httpd_req_recv(req, (char *)(b->data + b->len), to_read);
         if (r == HTTPD_SOCK_ERR_TIMEOUT) continue;
         if (r <= 0) {
             ESP_LOGE(TAG, "httpd_req_recv failed at %d/%d", received, total);
-            free(buf);
-            httpd_resp_send_500(req);
-            return ESP_FAIL;
+            failed = true;
+            break;
         }
+        b->len += r;
         received += r;
+        if (b->len == STM32_STREAM_BUF || received == total) {
+            xQueueSend(s_stream_full, &b, portMAX_DELAY);  // never full: NBUF slots
+            b = NULL;
+        }
     }
-    ESP_LOGI(TAG, "STM32 image received (%d bytes), starting flash", received);
-
-    // Respond BEFORE flashing: the flash reboots the ESP32, so the client must
-    // get its 200 first. The browser/script then loses the connection on reboot.
-    httpd_resp_sendstr(req, "STM32 image received - flashing now, device will "
-                            "reboot when done.\n");
-
-    // Hand off ownership of the buffer to the async flasher.
-    stm32_flash_start(buf, received);
+    if (failed && !s_flash_failed) {
+        // The flasher stops before COMPLETE, so Katapult keeps the STM32 in its
+        // update loop rather than launching a half-written image.
+        s_stream_aborted = true;
+    }
+    ESP_LOGI(TAG, "STM32 upload %s (%d/%d bytes)", failed ? "aborted" : "streamed",
+             received, total);
+
+    // Wait for the last blocks + verify, then report before the reboot.
+    if (xSemaphoreTake(s_stream_done, pdMS_TO_TICKS(30000)) == pdTRUE && s_flash_ok) {
+        char out[160];
+        snprintf(out, sizeof(out), "%s\n", s_result_msg);
+        httpd_resp_sendstr(req, out);
+        return ESP_OK;
+    }
+    char out[160];
+    snprintf(out, sizeof(out), "STM32 flash failed: %s\n",
+             s_result_msg[0] ? s_result_msg : "timeout");
+    httpd_resp_set_status(req, "500 Internal Server Error");
+    httpd_resp_sendstr(req, out);
     return ESP_OK;
 }
 
@@ -22,7 +22,8 @@ extern "C" {
 // Register the wireless STM32-flash HTTP endpoint (POST /stm32) with the given
 // HTTP server. Mirrors ota_register_handler(): call it for both the AP captive
 // portal server and the LAN (STA-mode) server so the STM32 can be updated over
-// either link. The endpoint receives a raw STM32 .bin and kicks off the flash.
+// either link. The endpoint streams a raw STM32 .bin into the Katapult flasher
+// as it arrives and answers with the result (CRC-verified via FW_CRC).
 void stm32_flash_register_handler(httpd_handle_t server);
 
 // Start an asynchronous STM32 flash from an in-RAM firmware image.
@@ -0,0 +1,120 @@
+// ============================================================
+//  Telemetry Parse — STATUS tokenizer, enrichment, voltage smoother
+// ============================================================
+// No ESP-IDF includes on purpose: bench/ builds this file on the host.
+
+#include "telemetry_parse.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct StatusFieldDef {
+    const char *key;
+    uint8_t     key_len;
+    uint8_t     type;      // StatusFieldType
+    uint16_t    offset;    // into StatusFields
+};
+
+static const StatusFieldDef k_status_fields[SF_COUNT] = {
+#define X(key, ctype, type) { #key, sizeof(#key) - 1, type, offsetof(StatusFields, key) },
+    STATUS_FIELD_LIST(X)
+#undef X
+};
+
+StatusPacketKind status_packet_kind(const char *line)
+{
+    if (strncmp(line, "STATUS,", 7) == 0)       return STATUS_PKT_MAIN;
+    if (strncmp(line, "STATUS2,", 8) == 0)      return STATUS_PKT_BATT;
+    if (strncmp(line, "STATUS_DELTA,", 13) == 0) return STATUS_PKT_DELTA;
+    return STATUS_PKT_NONE;
+}
+
+int status_field_find(const char *key, size_t len)
+{
+    int lo = 0, hi = SF_COUNT - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        const StatusFieldDef *d = &k_status_fields[mid];
+        int c = strncmp(key, d->key, len);
+        if (c == 0 && len < d->key_len) c = -1;   // key is a prefix of d->key
+        if (c == 0) return mid;
+        if (c < 0) hi = mid - 1; else lo = mid + 1;
+    }
+    return -1;
+}
+
+const char *status_schema_check(void)
+{
+    for (int i = 1; i < SF_COUNT; i++) {
+        if (strcmp(k_status_fields[i - 1].key, k_status_fields[i].key) >= 0) {
+            return k_status_fields[i].key;
+        }
+    }
+    return NULL;
+}
+
+void status_fields_parse(const char *line, StatusFields *out)
+{
+    out->present = 0;
+    const char *p = strchr(line, ',');
+    while (p) {
+        const char *key = p + 1;
+        const char *q = key;
+        while (*q && *q != '=' && *q != ',') q++;
+        if (*q == '=') {
+            int id = status_field_find(key, (size_t)(q - key));
+            if (id >= 0) {
+                const StatusFieldDef *d = &k_status_fields[id];
+                char *end = NULL;
+                uint8_t *dst = (uint8_t *)out + d->offset;
+                if (d->type == SF_TYPE_FLOAT) {
+                    float v = strtof(q + 1, &end);
+                    if (end != q + 1) { memcpy(dst, &v, sizeof(v)); out->present |= 1ULL << id; }
+                } else {
+                    int v = (int)strtol(q + 1, &end, 10);
+                    if (end != q + 1) { memcpy(dst, &v, sizeof(v)); out->present |= 1ULL << id; }
+                }
+            }
+        }
+        p = strchr(q, ',');
+    }
+}
+
+size_t status_enrich_line(const char *line, const StatusFields &f,
+                          const StatusEnrichValues &v,
+                          const char *tail, size_t tail_len,
+                          char *out, size_t cap)
+{
+    size_t line_len = strlen(line);
+    if (line_len + 192 + tail_len >= cap) return 0;
+    memcpy(out, line, line_len);
+    size_t len = line_len;
+
+    // Compute derived fields (Flask UI depends on these).
+    bool enabled = SF_HAS(f, armed) && f.armed == 1;
+    const char *state;
+    if (!enabled) {
+        state = "DISABLED";
+    } else if (SF_HAS(f, welding) && f.welding == 1) {
+        state = "WELDING";
+    } else if (SF_HAS(f, chg_en) && f.chg_en == 1) {
+        state = "CHARGING";
+    } else {
+        state = "IDLE";
+    }
+
+    // Add computed fields (Flask expects enabled for arm button, state for
+    // status label), energy (already parsed from STM32 into globals) and the
+    // weld counter.
+    len += snprintf(out + len, cap - len,
+                    ",enabled=%d,state=%s"
+                    ",energy_cap_j=%.3f,energy_weld_j=%.3f,energy_loss_j=%.3f"
+                    ",weld_count=%lu",
+                    enabled ? 1 : 0, state,
+                    (double)v.energy_cap_j, (double)v.energy_weld_j,
+                    (double)v.energy_loss_j, (unsigned long)v.weld_count);
+
+    memcpy(out + len, tail, tail_len);
+    out[len + tail_len] = '\0';
+    return len + tail_len;
+}
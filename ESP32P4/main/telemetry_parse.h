@@ -0,0 +1,165 @@
+// ============================================================
+//  Telemetry Parse — STATUS tokenizer, enrichment, voltage smoother
+// ============================================================
+// The per-packet work stm32_parse_task does on every STATUS / STATUS2 /
+// STATUS_DELTA line, kept free of ESP-IDF so bench/ can time the same code
+// on the host: the field schema + single-pass tokenizer, the enriched STATUS
+// line builder (the WiFi/system tail is formatted by welder_main.cpp) and
+// the display deadband smoother. C++ only (welder_main.cpp and bench/).
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================
+//  TELEMETRY FIELD SCHEMA (STATUS / STATUS2 / STATUS_DELTA)
+// ============================================================
+// The one place that lists the STM32 telemetry keys the P4 consumes (see
+// PROTOCOL.md). The three packets share one key space. Each entry expands to
+// a typed StatusFields member, a presence bit (SF_<key>) and a row of the
+// lookup table. status_fields_parse() walks a line ONCE, token by token,
+// instead of one strstr() per key. Keep the list in strcmp() order:
+// status_field_find() binary-searches it (checked by status_schema_check()).
+#define STATUS_FIELD_LIST(X)                        \
+    X(armed,              int,   SF_TYPE_INT)       \
+    X(cap_v,              float, SF_TYPE_FLOAT)     \
+    X(caps,               int,   SF_TYPE_INT)       \
+    X(cell1,              float, SF_TYPE_FLOAT)     \
+    X(cell2,              float, SF_TYPE_FLOAT)     \
+    X(cell3,              float, SF_TYPE_FLOAT)     \
+    X(chg_en,             int,   SF_TYPE_INT)       \
+    X(contact,            int,   SF_TYPE_INT)       \
+    X(contact_hold_steps, int,   SF_TYPE_INT)       \
+    X(contact_with_pedal, int,   SF_TYPE_INT)       \
+    X(control_mode,       int,   SF_TYPE_INT)       \
+    X(d1,                 int,   SF_TYPE_INT)       \
+    X(d2,                 int,   SF_TYPE_INT)       \
+    X(d3,                 int,   SF_TYPE_INT)       \
+    X(energy_cap_j,       float, SF_TYPE_FLOAT)     \
+    X(energy_loss_j,      float, SF_TYPE_FLOAT)     \
+    X(energy_weld_j,      float, SF_TYPE_FLOAT)     \
+    X(fault,              int,   SF_TYPE_INT)       \
+    X(gap1,               int,   SF_TYPE_INT)       \
+    X(gap2,               int,   SF_TYPE_INT)       \
+    X(ichg,               float, SF_TYPE_FLOAT)     \
+    X(joule_actual,       float, SF_TYPE_FLOAT)     \
+    X(joule_max_ms,       int,   SF_TYPE_INT)       \
+    X(joule_target_j,     float, SF_TYPE_FLOAT)     \
+    X(lead_r_ohm,         float, SF_TYPE_FLOAT)     \
+    X(link_baud,          int,   SF_TYPE_INT)       \
+    X(mode,               int,   SF_TYPE_INT)       \
+    X(power,              int,   SF_TYPE_INT)       \
+    X(preheat_en,         int,   SF_TYPE_INT)       \
+    X(preheat_gap_ms,     int,   SF_TYPE_INT)       \
+    X(preheat_ms,         int,   SF_TYPE_INT)       \
+    X(preheat_pct,        int,   SF_TYPE_INT)       \
+    X(ready,              int,   SF_TYPE_INT)       \
+    X(temp,               float, SF_TYPE_FLOAT)     \
+    X(trigger_mode,       int,   SF_TYPE_INT)       \
+    X(vcap,               float, SF_TYPE_FLOAT)     \
+    X(vpack,              float, SF_TYPE_FLOAT)     \
+    X(weld_v,             float, SF_TYPE_FLOAT)     \
+    X(welding,            int,   SF_TYPE_INT)       \
+    X(wf_fmt,             int,   SF_TYPE_INT)       \
+    X(wf_mode,            int,   SF_TYPE_INT)
+
+enum StatusFieldType : uint8_t { SF_TYPE_INT, SF_TYPE_FLOAT };
+
+enum StatusFieldId {
+#define X(key, ctype, type) SF_##key,
+    STATUS_FIELD_LIST(X)
+#undef X
+    SF_COUNT
+};
+static_assert(SF_COUNT <= 64, "StatusFields::present is a 64-bit mask");
+
+// Integer fields are parsed with strtol (so "power=80.00" reads as 80, as the
+// old extract_int() did); a member is only valid if its SF_ bit is set.
+struct StatusFields {
+    uint64_t present;
+#define X(key, ctype, type) ctype key;
+    STATUS_FIELD_LIST(X)
+#undef X
+};
+
+#define SF_HAS(f, key) ((((f).present) >> SF_##key) & 1ULL)
+
+enum StatusPacketKind { STATUS_PKT_NONE, STATUS_PKT_MAIN, STATUS_PKT_BATT, STATUS_PKT_DELTA };
+
+StatusPacketKind status_packet_kind(const char *line);
+
+// Binary search of the schema for the (non-terminated) key. -1 if unknown.
+int status_field_find(const char *key, size_t len);
+
+// Key of the first schema row out of strcmp() order, NULL if sorted.
+const char *status_schema_check(void);
+
+// Single pass over "NAME,k=v,k=v,...": every known key is parsed into *out
+// and its presence bit set; unknown keys are skipped. Exact key match, so
+// e.g. "mode=" no longer depends on where "trigger_mode=" sits in the line.
+void status_fields_parse(const char *line, StatusFields *out);
+
+// ============================================================
+//  STATUS ENRICHMENT
+// ============================================================
+// The per-packet part of an enriched STATUS line (see welder_main.cpp,
+// "STATUS ENRICHMENT"): the raw line, then the derived enabled/state, the
+// energy mirror and the weld counter, then the pre-formatted WiFi + system
+// tail. Returns the line length, or 0 if it does not fit in cap (the caller
+// relays the raw line).
+struct StatusEnrichValues {
+    float    energy_cap_j;
+    float    energy_weld_j;
+    float    energy_loss_j;
+    uint32_t weld_count;
+};
+
+size_t status_enrich_line(const char *line, const StatusFields &f,
+                          const StatusEnrichValues &v,
+                          const char *tail, size_t tail_len,
+                          char *out, size_t cap);
+
+// ============================================================
+//  VOLTAGE DISPLAY SMOOTHER (ported 1:1 from OLD ESP32)
+// ============================================================
+// Matches ESP32_8048S043C/src/main.cpp VoltageDisplaySmoother (lines 216-265).
+class VoltageDisplaySmoother {
+   private:
+    struct Channel {
+        float lastValue;
+        bool  initialized;
+    };
+    static const int MAX_CHANNELS = 8;
+    Channel channels[MAX_CHANNELS];
+    float   threshold;
+
+   public:
+    explicit VoltageDisplaySmoother(float thresh = 0.02f) : threshold(thresh) {
+        for (int i = 0; i < MAX_CHANNELS; i++) {
+            channels[i].initialized = false;
+            channels[i].lastValue   = 0.0f;
+        }
+    }
+
+    float getDisplayValue(int channel, float rawValue) {
+        if (channel < 0 || channel >= MAX_CHANNELS) return rawValue;
+        if (!channels[channel].initialized) {
+            channels[channel].lastValue   = rawValue;
+            channels[channel].initialized = true;
+            return rawValue;
+        }
+        float delta = fabsf(rawValue - channels[channel].lastValue);
+        if (delta < threshold) return channels[channel].lastValue;
+        channels[channel].lastValue = rawValue;
+        return rawValue;
+    }
+};
+
+enum VoltageChannel {
+    CH_VPACK = 0,
+    CH_VCAP  = 1,
+    CH_CELL1 = 2,
+    CH_CELL2 = 3,
+    CH_CELL3 = 4,
+};
@@ -5,8 +5,10 @@
  * internal lv_snprintf does NOT support %f / %.2f etc.  All float formatting
  * uses standard C snprintf() into a local char buffer.
  *
- * ANTI-FLICKER:  ui_update() uses static "previous value" variables and
- * is gated by hardware touch state to prevent redraws during touch.
+ * ANTI-FLICKER:  ui_update() only repaints values that changed (the
+ * read-only telemetry labels go through the DATA BINDING table and are only
+ * painted on the visible tab) and is gated by hardware touch state to
+ * prevent redraws during touch.
  *
  * ARM BUTTON:  Uses plain lv_obj (NOT lv_button) to avoid LVGL theme
  * GROW/transition animations that caused whole-screen twitch.
@@ -53,6 +55,8 @@
 #include "esp_log.h"         // ESP_LOGI for debug logging
 #include "freertos/FreeRTOS.h"  // portMUX_TYPE / taskENTER_CRITICAL (deferred WiFi UI)
 #include "freertos/task.h"
+#include "freertos/semphr.h"  // Wave-tab plot hand-over (ui_set_waveform)
+#include "esp_heap_caps.h"    // Wave-tab plot buffers in PSRAM
 #include <lvgl.h>
 #include <math.h>
 #include <stdio.h>   // for standard snprintf/sscanf (supports %f)
@@ -432,8 +436,10 @@ static const uint16_t JOULE_MAXMS_STEP = 5;
 static lv_obj_t* tab_status = nullptr;
 static lv_obj_t* tab_pulse = nullptr;
 static lv_obj_t* tab_joule = nullptr;
+static lv_obj_t* tab_wave = nullptr;
 static lv_obj_t* tab_config = nullptr;
 static lv_obj_t* tab_logs = nullptr;  // repurposed as the "Setup" tab
+static lv_obj_t* _tabview = nullptr;  // active tab gates the bound labels
 
 // ============================================================
 // SETUP TAB + WiFi provisioning handles
@@ -1997,6 +2003,145 @@ static void build_joule_tab(lv_obj_t* tab) {
     paint_joule_tab();
 }
 
+// ============================================================
+// WAVE TAB  (last-weld current/voltage plot)
+// ============================================================
+// The chart has exactly UI_WAVE_COLS points, one per pixel column, and
+// draws straight from s_wave_disp via lv_chart_set_ext_y_array. Each trace is
+// a min and a max series, so the envelope of every column is visible. A new
+// plot is installed by apply_waveform() (from ui_poll_deferred) with one
+// memcpy + lv_chart_refresh(), which invalidates only the chart's own area.
+static lv_obj_t* chart_wave = nullptr;
+static lv_obj_t* lbl_wave_title = nullptr;
+static lv_obj_t* lbl_wave_stats = nullptr;
+static lv_obj_t* lbl_wave_scale = nullptr;
+static WaveformPlot* s_wave_disp = nullptr;       // arrays the chart draws from
+static WaveformPlot* s_wave_pend = nullptr;       // latest plot from the parser
+static volatile bool s_wave_pend_ready = false;
+static SemaphoreHandle_t s_wave_mtx = nullptr;
+
+#define C_WAVE_I C_ACCENT  // current trace
+#define C_WAVE_V C_YELLOW  // voltage trace
+
+static void build_wave_tab(lv_obj_t* tab) {
+    lv_obj_set_style_bg_color(tab, C_BG, LV_PART_MAIN);
+    lv_obj_set_style_pad_all(tab, 10, LV_PART_MAIN);
+    lv_obj_set_scrollbar_mode(tab, LV_SCROLLBAR_MODE_OFF);
+    lv_obj_clear_flag(tab, LV_OBJ_FLAG_SCROLLABLE);
+
+    lbl_wave_title = lv_label_create(tab);
+    lv_label_set_text(lbl_wave_title, "Last Weld Waveform");
+    lv_obj_set_style_text_color(lbl_wave_title, C_ACCENT, 0);
+    lv_obj_set_style_text_font(lbl_wave_title, &lv_font_montserrat_16, 0);
+    lv_obj_set_pos(lbl_wave_title, 0, 0);
+
+    lbl_wave_stats = lv_label_create(tab);
+    lv_label_set_text(lbl_wave_stats, "No capture yet - fire a weld");
+    lv_obj_set_style_text_color(lbl_wave_stats, C_WHITE, 0);
+    lv_obj_set_style_text_font(lbl_wave_stats, &lv_font_montserrat_14, 0);
+    lv_obj_set_pos(lbl_wave_stats, 240, 2);
+
+    lbl_wave_scale = lv_label_create(tab);
+    lv_label_set_text(lbl_wave_scale, "");
+    lv_obj_set_style_text_color(lbl_wave_scale, C_GREY, 0);
+    lv_obj_set_style_text_font(lbl_wave_scale, &lv_font_montserrat_14, 0);
+    lv_obj_set_pos(lbl_wave_scale, 0, 26);
+
+    s_wave_disp = (WaveformPlot*)heap_caps_calloc(1, sizeof(WaveformPlot), MALLOC_CAP_SPIRAM);
+    s_wave_pend = (WaveformPlot*)heap_caps_calloc(1, sizeof(WaveformPlot), MALLOC_CAP_SPIRAM);
+    s_wave_mtx = xSemaphoreCreateMutex();
+    if (!s_wave_disp || !s_wave_pend || !s_wave_mtx) {
+        lv_label_set_text(lbl_wave_stats, "Waveform view unavailable (no PSRAM)");
+        return;
+    }
+    for (int c = 0; c < UI_WAVE_COLS; c++) {
+        s_wave_disp->i_min[c] = s_wave_disp->i_max[c] = LV_CHART_POINT_NONE;
+        s_wave_disp->v_min[c] = s_wave_disp->v_max[c] = LV_CHART_POINT_NONE;
+    }
+
+    // Plain chart: no border/padding so point n lands on pixel column n.
+    chart_wave = lv_chart_create(tab);
+    lv_obj_set_size(chart_wave, UI_WAVE_COLS, 364);
+    lv_obj_set_pos(chart_wave, 0, 52);
+    lv_obj_set_style_bg_color(chart_wave, C_CARD, LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(chart_wave, LV_OPA_COVER, LV_PART_MAIN);
+    lv_obj_set_style_border_width(chart_wave, 0, LV_PART_MAIN);
+    lv_obj_set_style_radius(chart_wave, 0, LV_PART_MAIN);
+    lv_obj_set_style_pad_all(chart_wave, 0, LV_PART_MAIN);
+    lv_obj_set_style_line_color(chart_wave, C_DARK_GREY, LV_PART_MAIN);
+    lv_obj_set_style_line_width(chart_wave, 1, LV_PART_ITEMS);
+    lv_obj_set_style_size(chart_wave, 0, 0, LV_PART_INDICATOR);  // no point dots
+    lv_obj_clear_flag(chart_wave, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_clear_flag(chart_wave, LV_OBJ_FLAG_SCROLLABLE);
+    lv_chart_set_type(chart_wave, LV_CHART_TYPE_LINE);
+    lv_chart_set_div_line_count(chart_wave, 5, 9);
+    lv_chart_set_point_count(chart_wave, UI_WAVE_COLS);
+    lv_chart_set_range(chart_wave, LV_CHART_AXIS_PRIMARY_Y, 0, 10000);
+    lv_chart_set_range(chart_wave, LV_CHART_AXIS_SECONDARY_Y, 0, 10000);
+
+    lv_chart_series_t* s;
+    s = lv_chart_add_series(chart_wave, C_WAVE_I, LV_CHART_AXIS_PRIMARY_Y);
+    lv_chart_set_ext_y_array(chart_wave, s, s_wave_disp->i_min);
+    s = lv_chart_add_series(chart_wave, C_WAVE_I, LV_CHART_AXIS_PRIMARY_Y);
+    lv_chart_set_ext_y_array(chart_wave, s, s_wave_disp->i_max);
+    s = lv_chart_add_series(chart_wave, C_WAVE_V, LV_CHART_AXIS_SECONDARY_Y);
+    lv_chart_set_ext_y_array(chart_wave, s, s_wave_disp->v_min);
+    s = lv_chart_add_series(chart_wave, C_WAVE_V, LV_CHART_AXIS_SECONDARY_Y);
+    lv_chart_set_ext_y_array(chart_wave, s, s_wave_disp->v_max);
+}
+
+// Round a positive axis maximum up to a whole number of `step`.
+static int32_t wave_axis_max(int32_t peak, int32_t step) {
+    if (peak < step) return step;
+    return ((peak + step - 1) / step) * step;
+}
+
+// Install the latest plot (LVGL task only). Deferred while a touch is active
+// (same anti-shudder rule as ui_update) and never blocks: if the parser is
+// mid-copy we simply try again on the next lvgl_task loop.
+static void apply_waveform() {
+    if (!s_wave_pend_ready || !chart_wave) return;
+    if (_hw_touch_active || _widget_touch_active) return;
+    if (xSemaphoreTake(s_wave_mtx, 0) != pdTRUE) return;
+    memcpy(s_wave_disp, s_wave_pend, sizeof(WaveformPlot));
+    s_wave_pend_ready = false;
+    xSemaphoreGive(s_wave_mtx);
+
+    const WaveformPlot& w = *s_wave_disp;
+    int32_t i_lo = 0;
+    for (int c = 0; c < UI_WAVE_COLS; c++) {
+        if (w.i_min[c] != LV_CHART_POINT_NONE && w.i_min[c] < i_lo) i_lo = w.i_min[c];
+    }
+    int32_t i_hi = wave_axis_max(w.i_peak_da, 1000);  // 100 A steps
+    int32_t v_hi = wave_axis_max(w.v_peak_mv, 1000);  // 1 V steps
+    lv_chart_set_range(chart_wave, LV_CHART_AXIS_PRIMARY_Y, i_lo, i_hi);
+    lv_chart_set_range(chart_wave, LV_CHART_AXIS_SECONDARY_Y, 0, v_hi);
+    lv_chart_refresh(chart_wave);
+
+    char buf[128];
+    snprintf(buf, sizeof(buf), LV_SYMBOL_CHARGE " Weld #%lu", (unsigned long)w.weld_id);
+    lv_label_set_text(lbl_wave_title, buf);
+
+    bool partial = (w.received < w.samples);
+    if (partial) {
+        snprintf(buf, sizeof(buf), "%.1f ms   Peak %.0f A / %.2f V   INCOMPLETE %lu/%lu",
+                 (double)w.duration_us / 1000.0, (double)w.i_peak_da / 10.0,
+                 (double)w.v_peak_mv / 1000.0, (unsigned long)w.received,
+                 (unsigned long)w.samples);
+    } else {
+        snprintf(buf, sizeof(buf), "%.1f ms   Peak %.0f A / %.2f V   %lu samples",
+                 (double)w.duration_us / 1000.0, (double)w.i_peak_da / 10.0,
+                 (double)w.v_peak_mv / 1000.0, (unsigned long)w.samples);
+    }
+    lv_label_set_text(lbl_wave_stats, buf);
+    lv_obj_set_style_text_color(lbl_wave_stats, partial ? C_RED : C_WHITE, 0);
+
+    snprintf(buf, sizeof(buf), "Current 0-%.0f A (orange)   Voltage 0-%.0f V (yellow)   "
+             "Time 0-%.1f ms",
+             (double)i_hi / 10.0, (double)v_hi / 1000.0, (double)w.duration_us / 1000.0);
+    lv_label_set_text(lbl_wave_scale, buf);
+}
+
 // ============================================================
 // SETUP TAB helpers
 // ============================================================
@@ -2900,9 +3045,10 @@ void ui_init(arm_toggle_cb_t on_arm_toggle, recipe_apply_cb_t on_recipe_apply) {
     lv_obj_t* scr = lv_screen_active();
     lv_obj_set_style_bg_color(scr, C_BG, LV_PART_MAIN);
 
-    // Tabview – 5 tabs, tab bar at top, 42 px tall (slightly larger for easier
+    // Tabview – 6 tabs, tab bar at top, 42 px tall (slightly larger for easier
     // touch)
     lv_obj_t* tv = lv_tabview_create(scr);
+    _tabview = tv;
     lv_tabview_set_tab_bar_position(tv, LV_DIR_TOP);
     lv_tabview_set_tab_bar_size(tv, 42);
     lv_obj_set_size(tv, 800, 480);
@@ -2932,6 +3078,7 @@ void ui_init(arm_toggle_cb_t on_arm_toggle, recipe_apply_cb_t on_recipe_apply) {
     tab_status = lv_tabview_add_tab(tv, LV_SYMBOL_HOME " Status");
     tab_pulse = lv_tabview_add_tab(tv, LV_SYMBOL_CHARGE " Pulse");
     tab_joule = lv_tabview_add_tab(tv, LV_SYMBOL_BATTERY_FULL " Joule");
+    tab_wave = lv_tabview_add_tab(tv, LV_SYMBOL_IMAGE " Wave");
     tab_config = lv_tabview_add_tab(tv, LV_SYMBOL_SETTINGS " Config");
     tab_logs = lv_tabview_add_tab(tv, LV_SYMBOL_WIFI " Setup");
 
@@ -2939,6 +3086,7 @@ void ui_init(arm_toggle_cb_t on_arm_toggle, recipe_apply_cb_t on_recipe_apply) {
     build_status_tab(tab_status);
     build_pulse_tab(tab_pulse);
     build_joule_tab(tab_joule);
+    build_wave_tab(tab_wave);
     build_config_tab(tab_config);
     build_setup_tab(tab_logs);
 
@@ -2957,6 +3105,8 @@ void ui_init(arm_toggle_cb_t on_arm_toggle, recipe_apply_cb_t on_recipe_apply) {
     lv_obj_clear_flag(tab_joule, LV_OBJ_FLAG_SCROLLABLE);
     lv_obj_clear_flag(tab_joule, LV_OBJ_FLAG_GESTURE_BUBBLE);
 
+    lv_obj_clear_flag(tab_wave, LV_OBJ_FLAG_GESTURE_BUBBLE);
+
     // Config tab keeps vertical scrolling but is tuned for a smooth feel:
     //  - GESTURE_BUBBLE off  : touch gestures don't bubble up to the tabview.
     //  - SCROLL_CHAIN off    : no scroll chaining to parent (the inner
@@ -3018,6 +3168,145 @@ void ui_mark_settings_applied() {
 // ============================================================
 bool ui_has_pending_changes() { return draft_dirty; }
 
+// ============================================================
+// DATA BINDING – read-only telemetry labels
+// ============================================================
+// Each value label is bound to one WelderDisplayState field through a value
+// getter, one formatter and a change epsilon. A binding is dirty while its
+// value differs from the one last painted by at least eps; bind_flush()
+// paints only the dirty bindings on the ACTIVE tab. Labels on a hidden tab
+// are not touched at all (no label/style churn, no invalidated area to
+// re-render into the PSRAM framebuffer) and catch up on the first tick after
+// their tab is shown. NAN is a value of its own ("--" / "ERR" / "not this
+// session") so switching between a number and "no reading" is a change too.
+struct UiBinding {
+    lv_obj_t** widget;
+    lv_obj_t** tab;
+    float (*value)(const WelderDisplayState& st);
+    const char* fmt;                     // snprintf format for the value
+    void (*paint)(lv_obj_t* w, float v,  // custom painter (nullptr = fmt)
+                  const char* fmt);
+    float eps;
+    float shown = NAN;                   // value last painted
+    bool  dirty = true;                  // first paint pending
+};
+
+static float bv_pack_v(const WelderDisplayState& st) { return st.pack_voltage; }
+static float bv_ichg(const WelderDisplayState& st) { return st.charger_current; }
+static float bv_cell1(const WelderDisplayState& st) { return st.cell1_v; }
+static float bv_cell2(const WelderDisplayState& st) { return st.cell2_v; }
+static float bv_cell3(const WelderDisplayState& st) { return st.cell3_v; }
+static float bv_temp(const WelderDisplayState& st) {
+    // -99 = sensor fault
+    return (isfinite(st.temperature) && st.temperature >= -50.0f)
+               ? st.temperature : NAN;
+}
+static float bv_cal_age(const WelderDisplayState& st) {
+    return st.cal_valid ? (float)st.cal_age_sec : NAN;
+}
+static float bv_lw_dur(const WelderDisplayState& st) {
+    return st.last_weld_valid ? (float)st.last_weld_duration_ms : NAN;
+}
+static float bv_lw_peak(const WelderDisplayState& st) {
+    return st.last_weld_valid ? st.last_weld_peak_a : NAN;
+}
+static float bv_lw_avg(const WelderDisplayState& st) {
+    return st.last_weld_valid ? st.last_weld_avg_a : NAN;
+}
+static float bv_lw_joules(const WelderDisplayState& st) {
+    return st.last_weld_valid ? st.last_weld_energy_j : NAN;
+}
+static float bv_weld_cnt(const WelderDisplayState& st) { return (float)st.weld_count; }
+
+static void bp_text(lv_obj_t* w, float v, const char* fmt) {
+    char buf[32];
+    if (isnan(v)) {
+        lv_label_set_text(w, "--");
+        return;
+    }
+    snprintf(buf, sizeof(buf), fmt, (double)v);
+    lv_label_set_text(w, buf);
+}
+
+static void bp_pack_v(lv_obj_t* w, float v, const char* fmt) {
+    bp_text(w, v, fmt);
+    lv_color_t c = (v < 8.0f) ? C_RED : (v > 9.0f) ? C_YELLOW : C_GREEN;
+    lv_obj_set_style_text_color(w, c, LV_PART_MAIN);
+}
+
+static void bp_temp(lv_obj_t* w, float v, const char* fmt) {
+    if (isnan(v)) {
+        lv_label_set_text(w, "ERR");
+        lv_obj_set_style_text_color(w, C_RED, LV_PART_MAIN);
+        return;
+    }
+    bp_text(w, v, fmt);
+    lv_obj_set_style_text_color(w, (v > 50.0f) ? C_RED : C_GREEN, LV_PART_MAIN);
+}
+
+static void bp_cal_age(lv_obj_t* w, float v, const char* fmt) {
+    (void)fmt;
+    if (isnan(v)) {
+        lv_label_set_text(w, "\xE2\x80\x94 (not this session)");
+        lv_obj_set_style_text_color(w, C_GREY, LV_PART_MAIN);
+        return;
+    }
+    char buf[32];
+    unsigned long s = (unsigned long)v;
+    if (s < 60)
+        snprintf(buf, sizeof(buf), "%lus ago", s);
+    else if (s < 3600)
+        snprintf(buf, sizeof(buf), "%lum ago", s / 60);
+    else
+        snprintf(buf, sizeof(buf), "%luh ago", s / 3600);
+    lv_label_set_text(w, buf);
+    lv_obj_set_style_text_color(w, C_GREEN, LV_PART_MAIN);
+}
+
+static UiBinding _bindings[] = {
+    // widget            tab          value         fmt                 painter     eps
+    {&lbl_pack_v,      &tab_status, bv_pack_v,    "%.2f V",           bp_pack_v,  0.01f},
+    {&lbl_temp,        &tab_status, bv_temp,
+     "%.1f \xC2\xB0" "C",                                             bp_temp,    0.05f},
+    {&lbl_ichg,        &tab_status, bv_ichg,      "%.2f A",           nullptr,    0.01f},
+    {&lbl_cell1,       &tab_status, bv_cell1,     "C1: %.3f V",       nullptr,    0.001f},
+    {&lbl_cell2,       &tab_status, bv_cell2,     "C2: %.3f V",       nullptr,    0.001f},
+    {&lbl_cell3,       &tab_status, bv_cell3,     "C3: %.3f V",       nullptr,    0.001f},
+    {&lbl_lw_duration, &tab_status, bv_lw_dur,    "%.0f ms",          nullptr,    0.5f},
+    {&lbl_lw_peak,     &tab_status, bv_lw_peak,   "%.0f A",           nullptr,    1.0f},
+    {&lbl_lw_avg,      &tab_status, bv_lw_avg,    "%.0f A",           nullptr,    1.0f},
+    // Joules: measured workpiece energy delivered (moved from Joule tab).
+    {&lbl_lw_joules,   &tab_status, bv_lw_joules, "%.1f J",           nullptr,    0.05f},
+    {&lbl_weld_cnt,    &tab_status, bv_weld_cnt,  "%.0f",             nullptr,    0.5f},
+    {&lbl_cfg_cal_age, &tab_config, bv_cal_age,   nullptr,            bp_cal_age, 0.5f},
+};
+
+static lv_obj_t* active_tab() {
+    if (!_tabview) return nullptr;
+    return lv_obj_get_child(lv_tabview_get_content(_tabview),
+                            (int32_t)lv_tabview_get_tab_active(_tabview));
+}
+
+static void bind_flush(const WelderDisplayState& st) {
+    lv_obj_t* shown_tab = active_tab();
+    for (UiBinding& b : _bindings) {
+        lv_obj_t* w = *b.widget;
+        if (!w || (shown_tab && *b.tab != shown_tab)) continue;
+        float v = b.value(st);
+        if (!b.dirty) {
+            if (isnan(v) || isnan(b.shown)) {
+                if (isnan(v) == isnan(b.shown)) continue;
+            } else if (fabsf(v - b.shown) < b.eps) {
+                continue;
+            }
+        }
+        if (b.paint) b.paint(w, v, b.fmt);
+        else bp_text(w, v, b.fmt);
+        b.shown = v;
+        b.dirty = false;
+    }
+}
+
 // ============================================================
 // PUBLIC: ui_update – Touch-aware with anti-shudder gating
 // ============================================================
@@ -3052,13 +3341,6 @@ void ui_update(const WelderDisplayState& st) {
     // enforced) lock_pulse_tab(st.armed);
 
     // ---- Change-detection state (static across calls) ----
-    static float prev_pack_v = -999.0f;
-    static float prev_temp = -999.0f;
-    static bool prev_temp_fin = false;
-    static float prev_ichg = -999.0f;
-    static float prev_cell1 = -999.0f;
-    static float prev_cell2 = -999.0f;
-    static float prev_cell3 = -999.0f;
     static bool prev_armed = false;
     static bool prev_welding = false;
     static bool prev_charging = false;
@@ -3066,65 +3348,8 @@ void ui_update(const WelderDisplayState& st) {
 
     char buf[32];
 
-    // ---- Pack Voltage ----
-    if (lbl_pack_v &&
-        (first_run || fabsf(st.pack_voltage - prev_pack_v) >= 0.01f)) {
-        snprintf(buf, sizeof(buf), "%.2f V", (double)st.pack_voltage);
-        lv_label_set_text(lbl_pack_v, buf);
-        lv_color_t c = (st.pack_voltage < 8.0f)   ? C_RED
-                       : (st.pack_voltage > 9.0f) ? C_YELLOW
-                                                  : C_GREEN;
-        lv_obj_set_style_text_color(lbl_pack_v, c, LV_PART_MAIN);
-        prev_pack_v = st.pack_voltage;
-    }
-
-    // ---- Temperature ----
-    {
-        bool fin = isfinite(st.temperature);
-        bool valid = fin && st.temperature >= -50.0f;  // -99 = sensor fault
-        if (lbl_temp && (first_run || valid != prev_temp_fin ||
-                         (valid && fabsf(st.temperature - prev_temp) >= 0.05f))) {
-            if (valid) {
-                snprintf(buf, sizeof(buf),
-                         "%.1f \xC2\xB0"
-                         "C",
-                         (double)st.temperature);
-                lv_label_set_text(lbl_temp, buf);
-                lv_color_t c = (st.temperature > 50.0f) ? C_RED : C_GREEN;
-                lv_obj_set_style_text_color(lbl_temp, c, LV_PART_MAIN);
-            } else {
-                lv_label_set_text(lbl_temp, "ERR");
-                lv_obj_set_style_text_color(lbl_temp, C_RED, LV_PART_MAIN);
-            }
-            prev_temp = st.temperature;
-            prev_temp_fin = valid;
-        }
-    }
-
-    // ---- Charger Current ----
-    if (lbl_ichg &&
-        (first_run || fabsf(st.charger_current - prev_ichg) >= 0.01f)) {
-        snprintf(buf, sizeof(buf), "%.2f A", (double)st.charger_current);
-        lv_label_set_text(lbl_ichg, buf);
-        prev_ichg = st.charger_current;
-    }
-
-    // ---- Cell Voltages ----
-    if (lbl_cell1 && (first_run || fabsf(st.cell1_v - prev_cell1) >= 0.001f)) {
-        snprintf(buf, sizeof(buf), "C1: %.3f V", (double)st.cell1_v);
-        lv_label_set_text(lbl_cell1, buf);
-        prev_cell1 = st.cell1_v;
-    }
-    if (lbl_cell2 && (first_run || fabsf(st.cell2_v - prev_cell2) >= 0.001f)) {
-        snprintf(buf, sizeof(buf), "C2: %.3f V", (double)st.cell2_v);
-        lv_label_set_text(lbl_cell2, buf);
-        prev_cell2 = st.cell2_v;
-    }
-    if (lbl_cell3 && (first_run || fabsf(st.cell3_v - prev_cell3) >= 0.001f)) {
-        snprintf(buf, sizeof(buf), "C3: %.3f V", (double)st.cell3_v);
-        lv_label_set_text(lbl_cell3, buf);
-        prev_cell3 = st.cell3_v;
-    }
+    // ---- Read-only telemetry labels (active tab only) ----
+    bind_flush(st);
 
     // ---- Dashboard: Mode line ----
     // The MODE box is now a long-press switcher (TIME<->JOULE). Keep the
@@ -3162,94 +3387,6 @@ void ui_update(const WelderDisplayState& st) {
         }
     }
 
-    // ---- Dashboard: Calibration age (Config tab) ----
-    {
-        static int32_t prev_cal_age = -2;
-        int32_t age = st.cal_valid ? (int32_t)st.cal_age_sec : -1;
-        if (lbl_cfg_cal_age && (first_run || age != prev_cal_age)) {
-            if (!st.cal_valid) {
-                lv_label_set_text(lbl_cfg_cal_age, "\xE2\x80\x94 (not this session)");
-                lv_obj_set_style_text_color(lbl_cfg_cal_age, C_GREY,
-                                            LV_PART_MAIN);
-            } else {
-                uint32_t s = st.cal_age_sec;
-                if (s < 60)
-                    snprintf(buf, sizeof(buf), "%lus ago", (unsigned long)s);
-                else if (s < 3600)
-                    snprintf(buf, sizeof(buf), "%lum ago",
-                             (unsigned long)(s / 60));
-                else
-                    snprintf(buf, sizeof(buf), "%luh ago",
-                             (unsigned long)(s / 3600));
-                lv_label_set_text(lbl_cfg_cal_age, buf);
-                lv_obj_set_style_text_color(lbl_cfg_cal_age, C_GREEN,
-                                            LV_PART_MAIN);
-            }
-            prev_cal_age = age;
-        }
-    }
-
-    // ---- Last Weld results: Duration | Peak | Avg | Joules ----
-    {
-        static bool  prev_lw_valid = false;
-        static float prev_lw_energy = -999.0f;
-        static float prev_lw_peak = -999.0f;
-        static float prev_lw_avg = -999.0f;
-        static uint32_t prev_lw_dur = 0xFFFFFFFF;
-        bool changed = first_run || st.last_weld_valid != prev_lw_valid ||
-                       fabsf(st.last_weld_energy_j - prev_lw_energy) >= 0.05f ||
-                       fabsf(st.last_weld_peak_a - prev_lw_peak) >= 1.0f ||
-                       fabsf(st.last_weld_avg_a - prev_lw_avg) >= 1.0f ||
-                       st.last_weld_duration_ms != prev_lw_dur;
-        if (changed) {
-            if (!st.last_weld_valid) {
-                if (lbl_lw_duration) lv_label_set_text(lbl_lw_duration, "--");
-                if (lbl_lw_peak) lv_label_set_text(lbl_lw_peak, "--");
-                if (lbl_lw_avg) lv_label_set_text(lbl_lw_avg, "--");
-                if (lbl_lw_joules) lv_label_set_text(lbl_lw_joules, "--");
-            } else {
-                if (lbl_lw_duration) {
-                    snprintf(buf, sizeof(buf), "%u ms",
-                             (unsigned)st.last_weld_duration_ms);
-                    lv_label_set_text(lbl_lw_duration, buf);
-                }
-                if (lbl_lw_peak) {
-                    snprintf(buf, sizeof(buf), "%.0f A",
-                             (double)st.last_weld_peak_a);
-                    lv_label_set_text(lbl_lw_peak, buf);
-                }
-                if (lbl_lw_avg) {
-                    snprintf(buf, sizeof(buf), "%.0f A",
-                             (double)st.last_weld_avg_a);
-                    lv_label_set_text(lbl_lw_avg, buf);
-                }
-                // Joules: measured workpiece energy delivered (moved from Joule tab).
-                if (lbl_lw_joules) {
-                    snprintf(buf, sizeof(buf), "%.1f J",
-                             (double)st.last_weld_energy_j);
-                    lv_label_set_text(lbl_lw_joules, buf);
-                }
-            }
-            prev_lw_valid = st.last_weld_valid;
-            prev_lw_energy = st.last_weld_energy_j;
-            prev_lw_peak = st.last_weld_peak_a;
-            prev_lw_avg = st.last_weld_avg_a;
-            prev_lw_dur = st.last_weld_duration_ms;
-        }
-    }
-
-
-    // ---- Weld Counter ----
-    {
-        static uint32_t prev_weld_count = 0xFFFFFFFF;
-        if (lbl_weld_cnt && (first_run || st.weld_count != prev_weld_count)) {
-            char wbuf[16];
-            snprintf(wbuf, sizeof(wbuf), "%lu", (unsigned long)st.weld_count);
-            lv_label_set_text(lbl_weld_cnt, wbuf);
-            prev_weld_count = st.weld_count;
-        }
-    }
-
     // ---- Dashboard trigger line sync from state ----
     // Don't stomp the value while the user is holding a long-press swap.
     {
@@ -4220,4 +4357,17 @@ void ui_poll_deferred(void) {
     if (do_fwp_hide) apply_hide_firmware_progress();
     if (do_fwp_show) apply_show_firmware_progress(fwp_dev, fwp_pct,
                                                   fwp_status[0] ? fwp_status : nullptr);
+
+    apply_waveform();
+}
+
+// ---- Wave tab hand-over (safe to call from ANY task) --------------------
+// A 12 KB copy is too long for the s_wifi_ui_mux spinlock, so the plot slot
+// has its own mutex; apply_waveform() only ever try-takes it.
+void ui_set_waveform(const WaveformPlot& wf) {
+    if (!s_wave_pend || !s_wave_mtx) return;
+    xSemaphoreTake(s_wave_mtx, portMAX_DELAY);
+    memcpy(s_wave_pend, &wf, sizeof(WaveformPlot));
+    s_wave_pend_ready = true;
+    xSemaphoreGive(s_wave_mtx);
 }
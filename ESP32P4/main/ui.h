@@ -28,6 +28,7 @@ struct WelderDisplayState {
 
     bool armed;
     bool welding;
+    bool contact;               // electrodes on the work (STATUS_DELTA contact=)
     bool charging;
     uint32_t weld_count;
 
@@ -310,6 +311,31 @@ void ui_show_wifi_setup(const char* qr_payload, const char* ap_ssid,
 // (status/info/maintenance) layout.
 void ui_hide_wifi_setup();
 
+// ============================================================
+// WAVE TAB API (last-weld waveform plot)
+// ============================================================
+// One min/max pair per pixel column of the Wave-tab chart. Built incrementally
+// by waveform_plot.cpp on the STM32 parse task as WAVEFORM_DATA / WAVEFORM_BIN
+// chunks arrive (never on the LVGL task), so at WAVEFORM_END only a copy
+// remains. Columns with no sample hold LV_CHART_POINT_NONE.
+#define UI_WAVE_COLS 780  // = chart width (tab content width)
+
+struct WaveformPlot {
+    uint32_t weld_id;       // P4 weld_count of this capture
+    uint32_t samples;       // samples announced by WAVEFORM_START
+    uint32_t received;      // samples actually decoded
+    uint32_t duration_us;   // timestamp of the last sample
+    int32_t  i_peak_da;     // peak current (0.1 A)
+    int32_t  v_peak_mv;     // peak weld voltage (mV)
+    int32_t  i_min[UI_WAVE_COLS], i_max[UI_WAVE_COLS];  // 0.1 A
+    int32_t  v_min[UI_WAVE_COLS], v_max[UI_WAVE_COLS];  // mV
+};
+
+// Hand a finished plot to the Wave tab. Safe to call from ANY task: it only
+// copies into a latched slot; ui_poll_deferred() applies it on the LVGL task
+// (deferred while a touch is active, like ui_update()).
+void ui_set_waveform(const WaveformPlot& wf);
+
 // Drain pending WiFi-UI requests queued by ui_show_wifi_setup() /
 // ui_hide_wifi_setup() / ui_set_wifi_info(). Those public functions are safe to
 // call from ANY task (e.g. the WiFi provisioning task); they only latch their
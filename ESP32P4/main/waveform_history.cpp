@@ -0,0 +1,437 @@
+// ============================================================
+//  Waveform History (PSRAM) — store and replay recent weld captures
+// ============================================================
+// The STM32 streams each weld's capture exactly once, right after the weld:
+//   EVENT,WELD_DONE,...  WAVEFORM_START,...  WAVEFORM_DATA|BIN,... (many)
+//   WAVEFORM_END[,chunks=N][,aborted=1]  WAVEFORM_PHASES,...
+// or, in STM32 summary mode (WAVEFORM_MODE,SUMMARY), EVENT,WELD_DONE then
+//   WAVEFORM_SUMMARY,...  WAVEFORM_ENV,... (<= 8)  WAVEFORM_PHASE_STATS,... (3)
+// A client that is not connected (or is connected but busy) at that moment
+// used to lose the waveform for good. The P4 now keeps the raw lines of the
+// last WF_HISTORY_WELDS welds in a PSRAM byte ring so they can be fetched
+// later in bulk, at WiFi speed, over the TCP bridge or HTTP.
+//
+// STORAGE: one WF_HISTORY_ARENA_SIZE byte ring of [u16 len][line bytes]
+// records addressed by an absolute 64-bit write position. A weld record only
+// holds positions into the ring; it is still readable while its first byte
+// has not been overwritten (start + ARENA_SIZE >= head). No per-weld copies,
+// no fragmentation, and a stuck reader can never block the writer.
+//
+// CONCURRENCY: stm32_parse_task is the only writer. Readers (bridge client
+// task, httpd task) copy one line at a time under s_mtx and re-check that it
+// is still valid, so the mutex is held for a memcpy of at most one line.
+
+#include "waveform_history.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "WF_HIST";
+
+#define WF_HISTORY_WELDS       16                  // weld records kept
+#define WF_HISTORY_ARENA_SIZE  (4 * 1024 * 1024)  // PSRAM byte ring
+#define WF_HISTORY_LINE_MAX    8192                // = welder_main BUF_SIZE
+#define WF_HISTORY_HTTP_BUF    4096                // coalesced HTTP chunk
+
+typedef struct {
+    uint32_t weld_id;     // P4 weld_count of the WELD_DONE that opened it
+    uint64_t start;       // ring position of the first stored line
+    uint64_t end;         // ring position one past the last stored line
+    uint32_t lines;
+    uint32_t samples;     // WAVEFORM_START samples=
+    uint32_t chunks;      // WAVEFORM_DATA / WAVEFORM_BIN lines stored
+    uint32_t t_ms;        // capture time (esp_timer, ms)
+    int32_t  bin_seq;     // last WAVEFORM_BIN seq seen, -1 = none
+    bool     in_use;
+    bool     open;        // still receiving lines from the STM32
+    bool     seen_start;
+    bool     seen_end;
+    bool     seq_gap;     // BIN seq skipped, END chunk count mismatch or aborted=1
+    bool     summary;     // WAVEFORM_SUMMARY seen (STM32 summary mode: no burst)
+    bool     complete;    // closed by WAVEFORM_PHASES with no gaps
+} wf_record_t;
+
+static uint8_t          *s_arena = NULL;
+static uint64_t          s_head = 0;               // total bytes ever written
+static wf_record_t       s_recs[WF_HISTORY_WELDS];
+static int               s_open = -1;              // index of the open record
+static unsigned          s_next = 0;               // next slot to (re)use
+static SemaphoreHandle_t s_mtx = NULL;
+
+// ============================================================
+//  RING (call with s_mtx held)
+// ============================================================
+static inline bool rec_valid(const wf_record_t *r)
+{
+    return r->in_use && r->start + WF_HISTORY_ARENA_SIZE >= s_head;
+}
+
+static void arena_write(uint64_t pos, const void *src, size_t n)
+{
+    size_t off = (size_t)(pos % WF_HISTORY_ARENA_SIZE);
+    size_t first = WF_HISTORY_ARENA_SIZE - off;
+    if (first > n) first = n;
+    memcpy(s_arena + off, src, first);
+    if (n > first) memcpy(s_arena, (const uint8_t *)src + first, n - first);
+}
+
+static void arena_read(uint64_t pos, void *dst, size_t n)
+{
+    size_t off = (size_t)(pos % WF_HISTORY_ARENA_SIZE);
+    size_t first = WF_HISTORY_ARENA_SIZE - off;
+    if (first > n) first = n;
+    memcpy(dst, s_arena + off, first);
+    if (n > first) memcpy((uint8_t *)dst + first, s_arena, n - first);
+}
+
+static void arena_append(wf_record_t *r, const char *line, size_t len)
+{
+    if (len > WF_HISTORY_LINE_MAX) len = WF_HISTORY_LINE_MAX;
+    uint16_t l16 = (uint16_t)len;
+    arena_write(s_head, &l16, sizeof(l16));
+    arena_write(s_head + sizeof(l16), line, len);
+    s_head += sizeof(l16) + len;
+    r->end = s_head;
+    r->lines++;
+}
+
+static void rec_close(wf_record_t *r)
+{
+    r->open = false;
+    r->complete = r->seen_start && r->seen_end && !r->seq_gap;
+    s_open = -1;
+}
+
+static wf_record_t *rec_open(uint32_t weld_id)
+{
+    if (s_open >= 0) rec_close(&s_recs[s_open]);  // PHASES never arrived
+    wf_record_t *r = &s_recs[s_next];
+    memset(r, 0, sizeof(*r));
+    r->in_use  = true;
+    r->open    = true;
+    r->weld_id = weld_id;
+    r->start   = s_head;
+    r->end     = s_head;
+    r->bin_seq = -1;
+    r->t_ms    = (uint32_t)(esp_timer_get_time() / 1000ULL);
+    s_open = (int)s_next;
+    s_next = (s_next + 1) % WF_HISTORY_WELDS;
+    return r;
+}
+
+static unsigned long field_ul(const char *line, const char *key)
+{
+    const char *p = strstr(line, key);
+    return p ? strtoul(p + strlen(key), NULL, 10) : 0;
+}
+
+// ============================================================
+//  PUBLIC API — writer
+// ============================================================
+bool wf_history_init(void)
+{
+    if (s_arena) return true;
+    s_mtx = xSemaphoreCreateMutex();
+    s_arena = (uint8_t *)heap_caps_malloc(WF_HISTORY_ARENA_SIZE, MALLOC_CAP_SPIRAM);
+    if (!s_mtx || !s_arena) {
+        ESP_LOGE(TAG, "PSRAM alloc failed (%d KB) - waveform history disabled",
+                 WF_HISTORY_ARENA_SIZE / 1024);
+        return false;
+    }
+    ESP_LOGI(TAG, "Waveform history: %d KB PSRAM, last %d welds",
+             WF_HISTORY_ARENA_SIZE / 1024, WF_HISTORY_WELDS);
+    return true;
+}
+
+void wf_history_feed(const char *line, uint32_t weld_id)
+{
+    if (!s_arena) return;
+    bool is_done = (strncmp(line, "EVENT,WELD_DONE,", 16) == 0);
+    if (!is_done && strncmp(line, "WAVEFORM_", 9) != 0) return;
+
+    const char *kind = line + 9;
+    size_t len = strlen(line);
+    xSemaphoreTake(s_mtx, portMAX_DELAY);
+    wf_record_t *r = (s_open >= 0) ? &s_recs[s_open] : NULL;
+
+    if (is_done) {
+        r = rec_open(weld_id);
+    } else if (strncmp(kind, "START,", 6) == 0) {
+        // A capture with no WELD_DONE in front (e.g. the P4 joined mid-burst
+        // or the STATS line was dropped): keep it under the current count.
+        if (!r || r->seen_start) r = rec_open(weld_id);
+        r->seen_start = true;
+        r->samples = (uint32_t)field_ul(line, "samples=");
+    } else if (!r) {
+        xSemaphoreGive(s_mtx);  // DATA/BIN/END/PHASES of a capture we missed
+        return;
+    } else if (strncmp(kind, "SUMMARY,", 8) == 0) {
+        r->summary = true;
+    } else if (strncmp(kind, "DATA,", 5) == 0) {
+        r->chunks++;
+    } else if (strncmp(kind, "BIN,", 4) == 0) {
+        long seq = strtol(line + 13, NULL, 10);
+        if (seq != r->bin_seq + 1) r->seq_gap = true;
+        r->bin_seq = (int32_t)seq;
+        r->chunks++;
+    } else if (strncmp(kind, "END", 3) == 0) {
+        r->seen_end = true;
+        const char *c = strstr(line, "chunks=");
+        if (c && strtoul(c + 7, NULL, 10) != r->chunks) r->seq_gap = true;
+        if (strstr(line, "aborted=1")) r->seq_gap = true;   // cut short by the next weld
+    }
+
+    arena_append(r, line, len);
+    if (strncmp(kind, "PHASES", 6) == 0) rec_close(r);
+    // Summary mode ends with the main phase's stats; a later WAVEFORM_GET
+    // burst from the STM32 opens a record of its own at WAVEFORM_START.
+    if (r->summary && !r->seen_start &&
+        strncmp(kind, "PHASE_STATS,phase=main", 22) == 0) rec_close(r);
+    // A single capture larger than the whole arena has overrun itself.
+    if (r->open && !rec_valid(r)) {
+        r->in_use = false;
+        s_open = -1;
+    }
+    xSemaphoreGive(s_mtx);
+}
+
+// ============================================================
+//  PUBLIC API — readers
+// ============================================================
+// Newest closed record wins (the counter can repeat after a weld-count
+// reset); an open one is only returned when nothing closed matches, so the
+// caller can answer IN_PROGRESS. weld_id 0 never matches the open record.
+static int find_record(uint32_t weld_id)
+{
+    int best = -1;
+    for (int i = 0; i < WF_HISTORY_WELDS; i++) {
+        const wf_record_t *r = &s_recs[i];
+        if (!rec_valid(r)) continue;
+        if (weld_id != 0 ? r->weld_id != weld_id : r->open) continue;
+        if (best < 0 ||
+            (s_recs[best].open && !r->open) ||
+            (s_recs[best].open == r->open && r->start > s_recs[best].start)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+wf_history_result_t wf_history_replay(uint32_t weld_id, wf_history_emit_fn emit, void *ctx)
+{
+    if (!s_arena) return WF_HISTORY_NOT_FOUND;
+
+    xSemaphoreTake(s_mtx, portMAX_DELAY);
+    int idx = find_record(weld_id);
+    wf_record_t rec;
+    if (idx >= 0) rec = s_recs[idx];
+    xSemaphoreGive(s_mtx);
+    if (idx < 0) return WF_HISTORY_NOT_FOUND;
+    if (rec.open) return WF_HISTORY_IN_PROGRESS;
+
+    // Line buffer on the heap: callers run on small task stacks.
+    char *buf = (char *)heap_caps_malloc(WF_HISTORY_LINE_MAX + 256, MALLOC_CAP_SPIRAM);
+    if (!buf) return WF_HISTORY_ABORTED;
+
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000ULL);
+    int hdr = snprintf(buf, 256,
+                       "WAVEFORM_REPLAY,weld_id=%lu,lines=%lu,samples=%lu,"
+                       "chunks=%lu,complete=%d,age_s=%lu",
+                       (unsigned long)rec.weld_id, (unsigned long)rec.lines,
+                       (unsigned long)rec.samples, (unsigned long)rec.chunks,
+                       rec.complete ? 1 : 0,
+                       (unsigned long)((now_ms - rec.t_ms) / 1000U));
+
+    wf_history_result_t res = WF_HISTORY_OK;
+    bool header_sent = false;
+    bool overwritten = false;
+    uint64_t pos = rec.start;
+    while (pos < rec.end) {
+        // The stored WELD_DONE line (if any) rides on the REPLAY header with
+        // its EVENT,WELD_DONE, prefix stripped; the rest goes out verbatim.
+        char *dst = header_sent ? buf : buf + hdr + 1;
+        bool ok;
+        uint16_t l16 = 0;
+        xSemaphoreTake(s_mtx, portMAX_DELAY);
+        ok = (pos + WF_HISTORY_ARENA_SIZE >= s_head);
+        if (ok) {
+            arena_read(pos, &l16, sizeof(l16));
+            arena_read(pos + sizeof(l16), dst, l16);
+        }
+        xSemaphoreGive(s_mtx);
+        if (!ok) { res = WF_HISTORY_ABORTED; overwritten = true; break; }
+        dst[l16] = '\0';
+        pos += sizeof(l16) + l16;
+
+        if (!header_sent) {
+            header_sent = true;
+            bool done = (strncmp(dst, "EVENT,WELD_DONE,", 16) == 0);
+            if (done) {
+                buf[hdr] = ',';
+                memmove(buf + hdr + 1, dst + 16, strlen(dst + 16) + 1);
+            }
+            if (!emit(buf, ctx)) { res = WF_HISTORY_ABORTED; break; }
+            if (done) continue;
+            memmove(buf, dst, (size_t)l16 + 1);
+        }
+        if (!emit(buf, ctx)) { res = WF_HISTORY_ABORTED; break; }
+    }
+
+    if (res == WF_HISTORY_OK || overwritten) {
+        snprintf(buf, 256, "WAVEFORM_REPLAY_END,weld_id=%lu,status=%s",
+                 (unsigned long)rec.weld_id,
+                 res == WF_HISTORY_OK ? "OK" : "OVERWRITTEN");
+        emit(buf, ctx);
+    }
+    heap_caps_free(buf);
+    return res;
+}
+
+void wf_history_list(wf_history_emit_fn emit, void *ctx)
+{
+    wf_record_t snap[WF_HISTORY_WELDS];
+    uint64_t head = 0;
+    if (s_arena) {
+        xSemaphoreTake(s_mtx, portMAX_DELAY);
+        memcpy(snap, s_recs, sizeof(snap));
+        head = s_head;
+        xSemaphoreGive(s_mtx);
+    } else {
+        memset(snap, 0, sizeof(snap));
+    }
+
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000ULL);
+    char line[192];
+    int count = 0;
+    // Newest first: walk back from the slot rec_open() fills next.
+    for (int k = 1; k <= WF_HISTORY_WELDS; k++) {
+        const wf_record_t *r = &snap[(s_next + WF_HISTORY_WELDS - k) % WF_HISTORY_WELDS];
+        if (!r->in_use || r->start + WF_HISTORY_ARENA_SIZE < head) continue;
+        snprintf(line, sizeof(line),
+                 "WAVEFORM_HIST,weld_id=%lu,samples=%lu,chunks=%lu,bytes=%lu,"
+                 "complete=%d,open=%d,age_s=%lu",
+                 (unsigned long)r->weld_id, (unsigned long)r->samples,
+                 (unsigned long)r->chunks, (unsigned long)(r->end - r->start),
+                 r->complete ? 1 : 0, r->open ? 1 : 0,
+                 (unsigned long)((now_ms - r->t_ms) / 1000U));
+        if (!emit(line, ctx)) return;
+        count++;
+    }
+    snprintf(line, sizeof(line), "WAVEFORM_HIST_END,count=%d", count);
+    emit(line, ctx);
+}
+
+// ============================================================
+//  HTTP: GET /waveform[?id=<weld_id|last>]
+// ============================================================
+// text/plain, one protocol line per row, sent chunked. Lines are coalesced
+// into WF_HISTORY_HTTP_BUF chunks so a 12k-sample capture is a few hundred
+// TCP segments rather than one send per line.
+typedef struct {
+    httpd_req_t *req;
+    char        *buf;
+    size_t       len;
+    bool         failed;
+} wf_http_ctx_t;
+
+static bool http_flush(wf_http_ctx_t *c)
+{
+    if (c->len && !c->failed &&
+        httpd_resp_send_chunk(c->req, c->buf, (ssize_t)c->len) != ESP_OK) {
+        c->failed = true;
+    }
+    c->len = 0;
+    return !c->failed;
+}
+
+static bool http_emit(const char *line, void *ctx)
+{
+    wf_http_ctx_t *c = (wf_http_ctx_t *)ctx;
+    size_t n = strlen(line);
+    if (c->len + n + 1 > WF_HISTORY_HTTP_BUF && !http_flush(c)) return false;
+    if (n + 1 > WF_HISTORY_HTTP_BUF) {
+        // Oversized line (long CSV chunk): send it straight through.
+        if (httpd_resp_send_chunk(c->req, line, (ssize_t)n) != ESP_OK ||
+            httpd_resp_send_chunk(c->req, "\n", 1) != ESP_OK) {
+            c->failed = true;
+        }
+        return !c->failed;
+    }
+    memcpy(c->buf + c->len, line, n);
+    c->len += n;
+    c->buf[c->len++] = '\n';
+    return true;
+}
+
+static esp_err_t waveform_get_handler(httpd_req_t *req)
+{
+    char query[48] = {0};
+    char id[16] = {0};
+    bool have_id = (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+                    httpd_query_key_value(query, "id", id, sizeof(id)) == ESP_OK);
+
+    uint32_t weld_id = 0;
+    if (have_id && strcmp(id, "last") != 0) {
+        char *end = NULL;
+        weld_id = (uint32_t)strtoul(id, &end, 10);
+        if (end == id || *end != '\0' || weld_id == 0) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "id must be a weld number or 'last'");
+            return ESP_FAIL;
+        }
+    }
+
+    wf_http_ctx_t c = { req, (char *)malloc(WF_HISTORY_HTTP_BUF), 0, false };
+    if (!c.buf) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "out of memory");
+        return ESP_FAIL;
+    }
+    httpd_resp_set_type(req, "text/plain");
+
+    if (!have_id) {
+        wf_history_list(http_emit, &c);
+    } else {
+        wf_history_result_t res = wf_history_replay(weld_id, http_emit, &c);
+        if (res == WF_HISTORY_NOT_FOUND || res == WF_HISTORY_IN_PROGRESS) {
+            free(c.buf);
+            httpd_resp_set_status(req, res == WF_HISTORY_NOT_FOUND ? "404 Not Found"
+                                                                   : "409 Conflict");
+            httpd_resp_sendstr(req, res == WF_HISTORY_NOT_FOUND
+                                    ? "DENY,WAVEFORM_GET,NOT_FOUND\n"
+                                    : "DENY,WAVEFORM_GET,IN_PROGRESS\n");
+            return ESP_OK;
+        }
+    }
+    http_flush(&c);
+    free(c.buf);
+    if (c.failed) return ESP_FAIL;
+    httpd_resp_send_chunk(req, NULL, 0);
+    return ESP_OK;
+}
+
+void wf_history_register_handler(httpd_handle_t server)
+{
+    if (!server) {
+        ESP_LOGW(TAG, "wf_history_register_handler: no HTTP server (skipped)");
+        return;
+    }
+
+    httpd_uri_t uri = {
+        .uri       = "/waveform",
+        .method    = HTTP_GET,
+        .handler   = waveform_get_handler,
+        .user_ctx  = NULL
+    };
+
+    esp_err_t err = httpd_register_uri_handler(server, &uri);
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Waveform endpoint registered: GET /waveform[?id=N|last]");
+    } else {
+        ESP_LOGE(TAG, "Failed to register /waveform handler: %s", esp_err_to_name(err));
+    }
+}
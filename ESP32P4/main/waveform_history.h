@@ -0,0 +1,53 @@
+// ============================================================
+//  Waveform History (PSRAM) — last WF_HISTORY_WELDS weld captures
+// ============================================================
+// stm32_parse_task feeds every EVENT,WELD_DONE and WAVEFORM_* line it sees.
+// Each weld becomes one record: the WELD_DONE stats line plus the complete
+// WAVEFORM_START .. WAVEFORM_PHASES burst, stored verbatim (CSV or BIN) in
+// a PSRAM byte ring and tagged with the P4 weld counter. Oldest records are
+// overwritten as the ring wraps.
+//
+// Retrieval (see PROTOCOL.md, "Waveform history"):
+//   - TCP bridge: WAVEFORM_GET,<weld_id|last> and WAVEFORM_LIST (wifi_bridge)
+//   - HTTP (LAN httpd): GET /waveform?id=<weld_id|last>, GET /waveform (list)
+// A replay is wrapped in WAVEFORM_REPLAY,... / WAVEFORM_REPLAY_END,... so
+// consumers never mistake it for a new weld.
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_http_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Per-line sink for replay/list. Return false to abort (client gone).
+typedef bool (*wf_history_emit_fn)(const char *line, void *ctx);
+
+typedef enum {
+    WF_HISTORY_OK = 0,
+    WF_HISTORY_NOT_FOUND,     // no such weld (or already overwritten)
+    WF_HISTORY_IN_PROGRESS,   // capture still streaming from the STM32
+    WF_HISTORY_ABORTED,       // emit() returned false / overwritten mid-replay
+} wf_history_result_t;
+
+// Allocate the PSRAM arena. Call once from app_main before the STM32 tasks.
+bool wf_history_init(void);
+
+// Feed one STM32 line (stm32_parse_task only). weld_id is the P4 weld counter
+// AFTER a WELD_DONE has been counted. Non-waveform lines are ignored.
+void wf_history_feed(const char *line, uint32_t weld_id);
+
+// Replay one weld (weld_id 0 = most recent complete record) through emit().
+wf_history_result_t wf_history_replay(uint32_t weld_id, wf_history_emit_fn emit, void *ctx);
+
+// One WAVEFORM_HIST line per stored weld (newest first), then WAVEFORM_HIST_END.
+void wf_history_list(wf_history_emit_fn emit, void *ctx);
+
+// Register GET /waveform on the LAN httpd (called from wifi_bridge).
+void wf_history_register_handler(httpd_handle_t server);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,169 @@
+// ============================================================
+//  Waveform Plot — min/max decimation for the Wave tab
+// ============================================================
+// WAVEFORM_START,samples=N fixes the sample -> column mapping
+// (col = idx * UI_WAVE_COLS / N), so each chunk is reduced the moment it is
+// parsed: per column we keep the min and max current and voltage. A spike one
+// sample wide still shows at full height, which plain every-Nth-sample
+// decimation would miss. At WAVEFORM_END empty columns (N < UI_WAVE_COLS, or
+// lost chunks) are held from their left neighbour and the plot is handed to
+// the UI. All of this runs on stm32_parse_task; the LVGL task only copies
+// the result into the chart's arrays.
+
+#include "waveform_plot.h"
+#include "ui.h"  // WaveformPlot, ui_set_waveform
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "mbedtls/base64.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+static const char *TAG = "WF_PLOT";
+
+#define WF_PLOT_MAX_CHUNK 100   // WAVEFORM_BIN count limit (PROTOCOL.md)
+#define WF_PLOT_BIN_BYTES 5     // int16 current, uint16 voltage, uint8 dt_us
+
+static WaveformPlot *s_plot = NULL;
+static bool          s_active = false;   // between WAVEFORM_START and _END
+static uint32_t      s_csv_idx = 0;      // next sample index (CSV chunks)
+
+// ============================================================
+//  DECIMATION
+// ============================================================
+static void plot_begin(uint32_t weld_id, uint32_t samples)
+{
+    s_plot->weld_id     = weld_id;
+    s_plot->samples     = samples;
+    s_plot->received    = 0;
+    s_plot->duration_us = 0;
+    s_plot->i_peak_da   = 0;
+    s_plot->v_peak_mv   = 0;
+    for (int c = 0; c < UI_WAVE_COLS; c++) {
+        s_plot->i_min[c] = s_plot->v_min[c] = INT32_MAX;
+        s_plot->i_max[c] = s_plot->v_max[c] = INT32_MIN;
+    }
+    s_csv_idx = 0;
+    s_active  = (samples > 0);
+}
+
+static void plot_add(uint32_t idx, uint32_t t_us, int32_t v_mv, int32_t i_da)
+{
+    if (idx >= s_plot->samples) return;
+    int c = (int)((uint64_t)idx * UI_WAVE_COLS / s_plot->samples);
+    if (i_da < s_plot->i_min[c]) s_plot->i_min[c] = i_da;
+    if (i_da > s_plot->i_max[c]) s_plot->i_max[c] = i_da;
+    if (v_mv < s_plot->v_min[c]) s_plot->v_min[c] = v_mv;
+    if (v_mv > s_plot->v_max[c]) s_plot->v_max[c] = v_mv;
+    if (i_da > s_plot->i_peak_da) s_plot->i_peak_da = i_da;
+    if (v_mv > s_plot->v_peak_mv) s_plot->v_peak_mv = v_mv;
+    if (t_us > s_plot->duration_us) s_plot->duration_us = t_us;
+    s_plot->received++;
+}
+
+static void plot_finish(void)
+{
+    bool have_prev = false;
+    for (int c = 0; c < UI_WAVE_COLS; c++) {
+        if (s_plot->i_min[c] != INT32_MAX) {
+            have_prev = true;
+        } else if (have_prev) {
+            s_plot->i_min[c] = s_plot->i_max[c] = s_plot->i_max[c - 1];
+            s_plot->v_min[c] = s_plot->v_max[c] = s_plot->v_max[c - 1];
+        } else {
+            s_plot->i_min[c] = s_plot->i_max[c] = LV_CHART_POINT_NONE;
+            s_plot->v_min[c] = s_plot->v_max[c] = LV_CHART_POINT_NONE;
+        }
+    }
+    s_active = false;
+    ui_set_waveform(*s_plot);
+}
+
+// ============================================================
+//  CHUNK DECODERS
+// ============================================================
+// WAVEFORM_DATA,t_us,volts,amps,t_us,volts,amps,...
+static void decode_csv(const char *p)
+{
+    char *end = NULL;
+    while (*p == ',') {
+        float t = strtof(p + 1, &end);
+        if (*end != ',') return;
+        float v = strtof(end + 1, &end);
+        if (*end != ',') return;
+        float a = strtof(end + 1, &end);
+        if (!isfinite(t) || !isfinite(v) || !isfinite(a) || t < 0.0f) return;
+        plot_add(s_csv_idx++, (uint32_t)t, (int32_t)lroundf(v * 1000.0f),
+                 (int32_t)lroundf(a * 10.0f));
+        p = end;
+    }
+}
+
+// WAVEFORM_BIN,seq,start,count,t0_us,crc32,payload — the CRC is left to the
+// TCP clients; a corrupt chunk here only mis-draws a column or two.
+static void decode_bin(const char *p)
+{
+    unsigned long f[4];
+    char *end = NULL;
+    for (int k = 0; k < 4; k++) {
+        f[k] = strtoul(p, &end, 10);
+        if (*end != ',') return;
+        p = end + 1;
+    }
+    const char *payload = strchr(p, ',');  // skip crc32
+    if (!payload) return;
+    uint32_t start = (uint32_t)f[1], count = (uint32_t)f[2];
+    if (count > WF_PLOT_MAX_CHUNK) return;
+
+    uint8_t raw[WF_PLOT_MAX_CHUNK * WF_PLOT_BIN_BYTES];
+    size_t n = 0;
+    if (mbedtls_base64_decode(raw, sizeof(raw), &n, (const unsigned char *)payload + 1,
+                              strlen(payload + 1)) != 0 ||
+        n != count * WF_PLOT_BIN_BYTES) return;
+
+    uint32_t t = (uint32_t)f[3];
+    for (uint32_t k = 0; k < count; k++) {
+        const uint8_t *s = raw + k * WF_PLOT_BIN_BYTES;
+        int16_t  i_da = (int16_t)(s[0] | (s[1] << 8));
+        uint16_t v_mv = (uint16_t)(s[2] | (s[3] << 8));
+        t += s[4];
+        plot_add(start + k, t, v_mv, i_da);
+    }
+}
+
+// ============================================================
+//  PUBLIC API
+// ============================================================
+bool wf_plot_init(void)
+{
+    if (s_plot) return true;
+    s_plot = (WaveformPlot *)heap_caps_malloc(sizeof(WaveformPlot), MALLOC_CAP_SPIRAM);
+    if (!s_plot) {
+        ESP_LOGE(TAG, "PSRAM alloc failed - Wave tab disabled");
+        return false;
+    }
+    return true;
+}
+
+void wf_plot_feed(const char *line, uint32_t weld_id)
+{
+    if (!s_plot || strncmp(line, "WAVEFORM_", 9) != 0) return;
+    const char *kind = line + 9;
+
+    if (strncmp(kind, "START,", 6) == 0) {
+        const char *p = strstr(kind, "samples=");
+        plot_begin(weld_id, p ? (uint32_t)strtoul(p + 8, NULL, 10) : 0);
+    } else if (!s_active) {
+        return;  // chunk of a capture whose START we missed
+    } else if (strncmp(kind, "DATA,", 5) == 0) {
+        decode_csv(kind + 4);
+    } else if (strncmp(kind, "BIN,", 4) == 0) {
+        decode_bin(kind + 4);
+    } else if (strncmp(kind, "END", 3) == 0) {
+        plot_finish();
+        ESP_LOGI(TAG, "Weld #%lu plot: %lu/%lu samples, %lu us",
+                 (unsigned long)s_plot->weld_id, (unsigned long)s_plot->received,
+                 (unsigned long)s_plot->samples, (unsigned long)s_plot->duration_us);
+    }
+}
@@ -0,0 +1,17 @@
+// ============================================================
+//  Waveform Plot — min/max decimation for the Wave tab
+// ============================================================
+// stm32_parse_task feeds every WAVEFORM_* line. Samples are decoded (CSV or
+// BIN) and folded straight into one min/max pair per chart column, so the
+// 12k-sample capture is never buffered and the LVGL task only receives the
+// finished UI_WAVE_COLS-wide plot (ui_set_waveform) at WAVEFORM_END.
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Allocate the plot buffer (PSRAM). Call once from app_main.
+bool wf_plot_init(void);
+
+// Feed one STM32 line (stm32_parse_task only). weld_id tags the plot.
+void wf_plot_feed(const char *line, uint32_t weld_id);
@@ -0,0 +1,777 @@
+// ============================================================
+//  Weld Log (SD card) — append-only binary record of every weld
+// ============================================================
+// PIPELINE:
+//   stm32_parse_task  weld_log_feed(): assembles the current record in a PSRAM
+//                     buffer (WELD_DONE stats + decoded waveform), then copies
+//                     the sector-padded record into the stage ring and queues
+//                     its index entry. Never touches the card, never waits: if
+//                     the stage is full the record is dropped and counted.
+//   wlog_task         drains the stage with POSIX write()s of up to 64 whole
+//                     sectors at sector-aligned offsets (FATFS writes those
+//                     straight to the card, no window-buffer copy), fsync()s the
+//                     segment, and only then appends the index entries. An
+//                     index entry therefore never points at unwritten data; a
+//                     power cut loses at most the last WLOG_FLUSH_MS of welds.
+//   readers           TCP bridge / httpd tasks look records up under s_io_mtx.
+//
+// Per-record cost stays constant however long the shift: segments are capped
+// at WELD_LOG_SEG_MAX_BYTES, files are kept open between writes, and a lookup
+// touches one small summary table plus a binary search of one index file.
+
+#include "weld_log.h"
+#include "sd_flash.h"        // sd_flash_is_mounted
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_vfs_fat.h"     // esp_vfs_fat_info (free space for rotation)
+#include "esp_rom_crc.h"
+#include "mbedtls/base64.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <errno.h>
+
+static const char *TAG = "WELD_LOG";
+
+#define WLOG_MOUNT           "/sdcard"
+#define WLOG_DIR             WLOG_MOUNT "/WELDLOG"
+#define WELD_LOG_SEG_MAX_BYTES (64u * 1024 * 1024)   // rotate segments at 64 MB
+#define WLOG_MAX_SEGMENTS    256                    // summary table size
+#define WLOG_MIN_FREE_BYTES  (2ull * WELD_LOG_SEG_MAX_BYTES)  // delete oldest below this
+#define WLOG_STAGE_SIZE      (2 * 1024 * 1024)      // PSRAM batch ring (~32 full records)
+#define WLOG_QUEUE_LEN       512                    // staged index entries
+#define WLOG_FLUSH_MS        1000                   // max staging latency
+#define WLOG_WRITE_CHUNK     (64 * WELD_LOG_SECTOR) // one write() call
+#define WLOG_IDX_BATCH       32                     // index entries per write()
+#define WLOG_OPEN_IDLE_MS    3000                   // commit an unfinished record
+#define WLOG_TIME_VALID      1700000000u            // 2023-11: clock has been set
+#define WLOG_REC_MAX         WELD_LOG_PAD(sizeof(weld_log_rec_t) + \
+                                          WELD_LOG_MAX_SAMPLES * WELD_LOG_SAMPLE_BYTES)
+
+static_assert(sizeof(weld_log_rec_t) == 128, "weld_log_rec_t layout");
+static_assert(sizeof(weld_log_idx_t) == 32, "weld_log_idx_t layout");
+static_assert(WLOG_STAGE_SIZE % WELD_LOG_SECTOR == 0, "stage must hold whole sectors");
+
+typedef struct {
+    uint32_t num;               // WLnnnnnn
+    uint32_t count;             // index entries
+    uint32_t bytes;             // .BIN size covered by the index
+    weld_log_idx_t first, last;
+} wlog_seg_t;
+
+// ---- producer state (stm32_parse_task only) ----
+static uint8_t  *s_cur = NULL;          // record being assembled (WLOG_REC_MAX)
+static bool      s_cur_open = false;
+static uint32_t  s_cur_touch_ms = 0;    // last line added
+static uint32_t  s_cur_last_t_us = 0;   // timestamp of the last stored sample
+
+// ---- stage ring + index queue (s_q_mtx) ----
+static uint8_t          *s_stage = NULL;
+static size_t            s_stage_head = 0, s_stage_tail = 0, s_stage_used = 0;
+static weld_log_idx_t    s_q[WLOG_QUEUE_LEN];
+static unsigned          s_q_head = 0, s_q_tail = 0, s_q_count = 0;
+static SemaphoreHandle_t s_q_mtx = NULL;
+
+// ---- store state (s_io_mtx: writer task + readers + suspend) ----
+static SemaphoreHandle_t s_io_mtx = NULL;
+static wlog_seg_t       *s_segs = NULL;     // ascending by num; last = open segment
+static unsigned          s_seg_count = 0;
+static int               s_data_fd = -1, s_idx_fd = -1;
+static bool              s_ready = false;
+static bool              s_suspended = false;
+static volatile bool     s_rotate_req = false;
+static weld_log_stats_t  s_stats;
+static TaskHandle_t      s_task = NULL;
+
+static inline uint32_t now_ms(void) { return (uint32_t)(esp_timer_get_time() / 1000ULL); }
+static inline weld_log_rec_t *cur_hdr(void) { return (weld_log_rec_t *)s_cur; }
+
+// ============================================================
+//  RECORD ASSEMBLY (stm32_parse_task)
+// ============================================================
+// ",key=" lookups so e.g. "energy_j=" never matches inside "..._energy_j=".
+static const char *fld(const char *line, const char *key)
+{
+    const char *p = strstr(line, key);
+    return p ? p + strlen(key) : NULL;
+}
+
+static float fld_f(const char *line, const char *key)
+{
+    const char *p = fld(line, key);
+    float v = p ? strtof(p, NULL) : 0.0f;
+    return isfinite(v) ? v : 0.0f;
+}
+
+static uint32_t fld_u(const char *line, const char *key)
+{
+    const char *p = fld(line, key);
+    return p ? (uint32_t)strtoul(p, NULL, 10) : 0;
+}
+
+static void rec_begin(uint32_t weld_id)
+{
+    weld_log_rec_t *h = cur_hdr();
+    memset(h, 0, sizeof(*h));
+    h->magic     = WELD_LOG_REC_MAGIC;
+    h->version   = WELD_LOG_VERSION;
+    h->hdr_len   = sizeof(weld_log_rec_t);
+    h->weld_id   = weld_id;
+    h->uptime_ms = now_ms();
+    time_t t = time(NULL);
+    if ((uint32_t)t >= WLOG_TIME_VALID) {
+        h->unix_s = (uint32_t)t;
+        h->flags |= WELD_LOG_F_TIME;
+    }
+    s_cur_open = true;
+    s_cur_touch_ms = h->uptime_ms;
+    s_cur_last_t_us = 0;
+}
+
+static void rec_stats(const char *line)
+{
+    weld_log_rec_t *h = cur_hdr();
+    h->flags         |= WELD_LOG_F_STATS;
+    h->total_ms       = fld_u(line, ",total_ms=");
+    h->mode           = (uint8_t)fld_u(line, ",mode=");
+    h->d1_ms          = (uint16_t)fld_u(line, ",d1=");
+    h->gap1_ms        = (uint16_t)fld_u(line, ",gap1=");
+    h->d2_ms          = (uint16_t)fld_u(line, ",d2=");
+    h->gap2_ms        = (uint16_t)fld_u(line, ",gap2=");
+    h->d3_ms          = (uint16_t)fld_u(line, ",d3=");
+    h->power_pct      = (uint8_t)fld_u(line, ",power_pct=");
+    h->preheat_en     = (uint8_t)fld_u(line, ",preheat_en=");
+    h->preheat_ms     = (uint16_t)fld_u(line, ",preheat_ms=");
+    h->wf_interval_us = (uint16_t)fld_u(line, ",wf_interval_us=");
+    h->peak_a            = fld_f(line, ",peak_a=");
+    h->avg_a             = fld_f(line, ",avg_a=");
+    h->vcap_b            = fld_f(line, ",vcap_b=");
+    h->vcap_a            = fld_f(line, ",vcap_a=");
+    h->energy_weld_j     = fld_f(line, ",energy_weld_j=");
+    h->energy_cap_j      = fld_f(line, ",energy_cap_j=");
+    h->energy_lead_j     = fld_f(line, ",energy_lead_j=");
+    h->joule_workpiece_j = fld_f(line, ",joule_workpiece_j=");
+    h->joule_pred_j      = fld_f(line, ",joule_pred_j=");
+    h->pulse_ms          = fld_f(line, ",pulse_ms=");
+    h->pedal_fet_us      = fld_u(line, ",pedal_fet_us=");
+    h->didt_a_us         = fld_f(line, ",didt_a_us=");
+    h->r_start_mohm      = fld_f(line, ",r_start_mohm=");
+    h->r_end_mohm        = fld_f(line, ",r_end_mohm=");
+}
+
+static void rec_add_sample(uint32_t t_us, int32_t i_da, int32_t v_mv)
+{
+    weld_log_rec_t *h = cur_hdr();
+    if (h->wf_samples >= WELD_LOG_MAX_SAMPLES) {
+        h->flags |= WELD_LOG_F_TRUNCATED;
+        return;
+    }
+    uint32_t dt = (h->wf_samples == 0 || t_us < s_cur_last_t_us) ? 0 : t_us - s_cur_last_t_us;
+    if (dt > 255) dt = 255;
+    if (i_da < INT16_MIN) i_da = INT16_MIN;
+    if (i_da > INT16_MAX) i_da = INT16_MAX;
+    if (v_mv < 0) v_mv = 0;
+    if (v_mv > UINT16_MAX) v_mv = UINT16_MAX;
+    uint8_t *s = s_cur + sizeof(weld_log_rec_t) + (size_t)h->wf_samples * WELD_LOG_SAMPLE_BYTES;
+    s[0] = (uint8_t)(i_da & 0xFF);
+    s[1] = (uint8_t)((uint16_t)i_da >> 8);
+    s[2] = (uint8_t)(v_mv & 0xFF);
+    s[3] = (uint8_t)(v_mv >> 8);
+    s[4] = (uint8_t)dt;
+    s_cur_last_t_us = t_us;
+    h->wf_samples++;
+}
+
+// WAVEFORM_DATA,t_us,volts,amps,...
+static void rec_csv(const char *p)
+{
+    char *end = NULL;
+    while (*p == ',') {
+        float t = strtof(p + 1, &end);
+        if (*end != ',') return;
+        float v = strtof(end + 1, &end);
+        if (*end != ',') return;
+        float a = strtof(end + 1, &end);
+        if (!isfinite(t) || !isfinite(v) || !isfinite(a) || t < 0.0f) return;
+        rec_add_sample((uint32_t)t, (int32_t)lroundf(a * 10.0f), (int32_t)lroundf(v * 1000.0f));
+        p = end;
+    }
+}
+
+// WAVEFORM_BIN,seq,start,count,t0_us,crc32,payload
+static void rec_bin(const char *p)
+{
+    unsigned long f[4];
+    char *end = NULL;
+    for (int k = 0; k < 4; k++) {
+        f[k] = strtoul(p, &end, 10);
+        if (*end != ',') return;
+        p = end + 1;
+    }
+    const char *payload = strchr(p, ',');
+    if (!payload) return;
+    payload++;
+
+    weld_log_rec_t *h = cur_hdr();
+    if (f[1] != h->wf_samples && !(h->flags & WELD_LOG_F_TRUNCATED)) {
+        h->flags |= WELD_LOG_F_WF_GAP;  // start != next index
+    }
+
+    uint8_t raw[100 * WELD_LOG_SAMPLE_BYTES];
+    size_t n = 0;
+    if (mbedtls_base64_decode(raw, sizeof(raw), &n, (const unsigned char *)payload,
+                              strlen(payload)) != 0 ||
+        n != f[2] * WELD_LOG_SAMPLE_BYTES) {
+        h->flags |= WELD_LOG_F_WF_GAP;
+        return;
+    }
+    uint32_t t = (uint32_t)f[3];
+    for (size_t k = 0; k < f[2]; k++) {
+        const uint8_t *s = raw + k * WELD_LOG_SAMPLE_BYTES;
+        t += s[4];
+        rec_add_sample(t, (int16_t)(s[0] | (s[1] << 8)), (uint16_t)(s[2] | (s[3] << 8)));
+    }
+}
+
+// Hand the finished record to the writer (copy into the stage ring).
+static void rec_commit(void)
+{
+    if (!s_cur_open) return;
+    s_cur_open = false;
+
+    weld_log_rec_t *h = cur_hdr();
+    h->rec_len = (uint32_t)(sizeof(weld_log_rec_t) + (size_t)h->wf_samples * WELD_LOG_SAMPLE_BYTES);
+    size_t padded = WELD_LOG_PAD(h->rec_len);
+    memset(s_cur + h->rec_len, 0, padded - h->rec_len);
+    h->crc32 = esp_rom_crc32_le(0, s_cur + 16, h->rec_len - 16);
+
+    weld_log_idx_t e = {};
+    e.weld_id   = h->weld_id;
+    e.unix_s    = h->unix_s;
+    e.uptime_ms = h->uptime_ms;
+    e.rec_len   = h->rec_len;
+    e.energy_j  = h->energy_weld_j;
+    e.peak_a    = h->peak_a;
+    e.flags     = h->flags;
+    e.total_ms  = (uint16_t)(h->total_ms > 0xFFFF ? 0xFFFF : h->total_ms);
+
+    xSemaphoreTake(s_q_mtx, portMAX_DELAY);
+    if (s_q_count >= WLOG_QUEUE_LEN || s_stage_used + padded > WLOG_STAGE_SIZE) {
+        s_stats.dropped++;
+        xSemaphoreGive(s_q_mtx);
+        ESP_LOGW(TAG, "Stage full - weld #%lu not logged", (unsigned long)h->weld_id);
+        return;
+    }
+    size_t first = WLOG_STAGE_SIZE - s_stage_head;
+    if (first > padded) first = padded;
+    memcpy(s_stage + s_stage_head, s_cur, first);
+    memcpy(s_stage, s_cur + first, padded - first);
+    s_stage_head = (s_stage_head + padded) % WLOG_STAGE_SIZE;
+    s_stage_used += padded;
+    s_q[s_q_head] = e;
+    s_q_head = (s_q_head + 1) % WLOG_QUEUE_LEN;
+    s_q_count++;
+    xSemaphoreGive(s_q_mtx);
+    if (s_task) xTaskNotifyGive(s_task);
+}
+
+// ============================================================
+//  STORE  (s_io_mtx held)
+// ============================================================
+static void seg_path(char *out, size_t cap, uint32_t num, const char *ext)
+{
+    snprintf(out, cap, WLOG_DIR "/WL%06lu.%s", (unsigned long)num, ext);
+}
+
+static void store_close(void)
+{
+    if (s_data_fd >= 0) close(s_data_fd);
+    if (s_idx_fd >= 0) close(s_idx_fd);
+    s_data_fd = s_idx_fd = -1;
+    s_ready = false;
+}
+
+static void store_delete_oldest(void)
+{
+    char path[48];
+    const wlog_seg_t *g = &s_segs[0];
+    seg_path(path, sizeof(path), g->num, "BIN");
+    unlink(path);
+    seg_path(path, sizeof(path), g->num, "IDX");
+    unlink(path);
+    ESP_LOGI(TAG, "Deleted oldest segment WL%06lu (%lu welds)",
+             (unsigned long)g->num, (unsigned long)g->count);
+    s_stats.records -= g->count;
+    s_stats.bytes   -= g->bytes;
+    memmove(&s_segs[0], &s_segs[1], (s_seg_count - 1) * sizeof(wlog_seg_t));
+    s_seg_count--;
+}
+
+// Read an existing segment's index into its summary entry.
+static void seg_load_summary(wlog_seg_t *g)
+{
+    char path[48];
+    seg_path(path, sizeof(path), g->num, "IDX");
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+    off_t size = lseek(fd, 0, SEEK_END);
+    g->count = (uint32_t)(size / (off_t)sizeof(weld_log_idx_t));  // drops a torn tail
+    if (g->count) {
+        lseek(fd, 0, SEEK_SET);
+        read(fd, &g->first, sizeof(g->first));
+        lseek(fd, (off_t)(g->count - 1) * sizeof(weld_log_idx_t), SEEK_SET);
+        read(fd, &g->last, sizeof(g->last));
+        g->bytes = g->last.offset + (uint32_t)WELD_LOG_PAD(g->last.rec_len);
+    }
+    close(fd);
+}
+
+static int seg_cmp(const void *a, const void *b)
+{
+    uint32_t x = ((const wlog_seg_t *)a)->num, y = ((const wlog_seg_t *)b)->num;
+    return (x > y) - (x < y);
+}
+
+// Start segment number num (new files). Frees space first if needed.
+static bool store_open_segment(uint32_t num)
+{
+    if (s_data_fd >= 0) close(s_data_fd);
+    if (s_idx_fd >= 0) close(s_idx_fd);
+    s_data_fd = s_idx_fd = -1;
+
+    uint64_t total = 0, free_b = 0;
+    while (s_seg_count > 0 &&
+           (s_seg_count >= WLOG_MAX_SEGMENTS ||
+            (esp_vfs_fat_info(WLOG_MOUNT, &total, &free_b) == ESP_OK &&
+             free_b < WLOG_MIN_FREE_BYTES))) {
+        store_delete_oldest();
+    }
+
+    char path[48];
+    seg_path(path, sizeof(path), num, "BIN");
+    s_data_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    seg_path(path, sizeof(path), num, "IDX");
+    s_idx_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (s_data_fd < 0 || s_idx_fd < 0) {
+        ESP_LOGE(TAG, "Cannot create segment WL%06lu: errno %d", (unsigned long)num, errno);
+        store_close();
+        return false;
+    }
+    wlog_seg_t *g = &s_segs[s_seg_count++];
+    memset(g, 0, sizeof(*g));
+    g->num = num;
+    s_stats.segments = s_seg_count;
+    ESP_LOGI(TAG, "Logging to " WLOG_DIR "/WL%06lu.BIN", (unsigned long)num);
+    return true;
+}
+
+// Scan the card, load segment summaries and open a fresh segment.
+static bool store_open(void)
+{
+    mkdir(WLOG_DIR, 0755);
+    DIR *d = opendir(WLOG_DIR);
+    if (!d) {
+        ESP_LOGE(TAG, "Cannot open " WLOG_DIR ": errno %d", errno);
+        return false;
+    }
+    s_seg_count = 0;
+    s_stats.records = 0;
+    s_stats.bytes = 0;
+    struct dirent *ent;
+    while ((ent = readdir(d)) != NULL && s_seg_count < WLOG_MAX_SEGMENTS) {
+        unsigned long num;
+        char ext[4];
+        if (sscanf(ent->d_name, "WL%6lu.%3s", &num, ext) == 2 &&
+            strcasecmp(ext, "IDX") == 0) {
+            memset(&s_segs[s_seg_count], 0, sizeof(wlog_seg_t));
+            s_segs[s_seg_count++].num = (uint32_t)num;
+        }
+    }
+    closedir(d);
+    qsort(s_segs, s_seg_count, sizeof(wlog_seg_t), seg_cmp);
+    for (unsigned i = 0; i < s_seg_count; i++) {
+        seg_load_summary(&s_segs[i]);
+        s_stats.records += s_segs[i].count;
+        s_stats.bytes   += s_segs[i].bytes;
+    }
+    uint32_t next = s_seg_count ? s_segs[s_seg_count - 1].num + 1 : 1;
+    ESP_LOGI(TAG, "Weld log: %u segments, %lu welds on card",
+             s_seg_count, (unsigned long)s_stats.records);
+    s_ready = store_open_segment(next);
+    return s_ready;
+}
+
+static bool write_all(int fd, const uint8_t *p, size_t n)
+{
+    while (n > 0) {
+        ssize_t w = write(fd, p, n);
+        if (w <= 0) return false;
+        p += w;
+        n -= (size_t)w;
+    }
+    return true;
+}
+
+// Move staged records to the card. Data first (fsync), then the index.
+static void store_drain(void)
+{
+    weld_log_idx_t batch[WLOG_IDX_BATCH];
+    unsigned nb = 0;
+    bool ok = true;
+
+    while (ok) {
+        xSemaphoreTake(s_q_mtx, portMAX_DELAY);
+        bool have = (s_q_count > 0);
+        weld_log_idx_t e = have ? s_q[s_q_tail] : weld_log_idx_t{};
+        size_t tail = s_stage_tail;
+        xSemaphoreGive(s_q_mtx);
+        if (!have || nb == WLOG_IDX_BATCH) break;
+
+        wlog_seg_t *g = &s_segs[s_seg_count - 1];
+        size_t padded = WELD_LOG_PAD(e.rec_len);
+        if (s_rotate_req || (g->count && g->bytes + padded > WELD_LOG_SEG_MAX_BYTES)) {
+            if (nb) break;  // flush this segment's batch first
+            s_rotate_req = false;
+            if (!store_open_segment(g->num + 1)) { ok = false; break; }
+            g = &s_segs[s_seg_count - 1];
+        }
+
+        // The record's bytes at [tail, tail+padded) are ours until we pop
+        // it; the producer only writes into free space.
+        size_t left = padded, pos = tail;
+        while (ok && left > 0) {
+            size_t n = WLOG_STAGE_SIZE - pos;
+            if (n > left) n = left;
+            if (n > WLOG_WRITE_CHUNK) n = WLOG_WRITE_CHUNK;
+            ok = write_all(s_data_fd, s_stage + pos, n);
+            pos = (pos + n) % WLOG_STAGE_SIZE;
+            left -= n;
+        }
+        if (!ok) break;
+
+        e.offset = g->bytes;
+        if (g->count == 0) g->first = e;
+        g->last = e;
+        g->bytes += (uint32_t)padded;
+        g->count++;
+        s_stats.records++;
+        s_stats.bytes += padded;
+        batch[nb++] = e;
+
+        xSemaphoreTake(s_q_mtx, portMAX_DELAY);
+        s_q_tail = (s_q_tail + 1) % WLOG_QUEUE_LEN;
+        s_q_count--;
+        s_stage_tail = (s_stage_tail + padded) % WLOG_STAGE_SIZE;
+        s_stage_used -= padded;
+        xSemaphoreGive(s_q_mtx);
+    }
+
+    if (ok && nb) {
+        ok = (fsync(s_data_fd) == 0) &&
+             write_all(s_idx_fd, (const uint8_t *)batch, nb * sizeof(weld_log_idx_t)) &&
+             (fsync(s_idx_fd) == 0);
+    }
+    if (!ok) {
+        // Drop the open files and rescan next pass: the card may be gone or
+        // full. Records still staged are retried; those already popped in
+        // this batch are lost, and the rescan forgets their summary.
+        s_stats.write_errors++;
+        ESP_LOGE(TAG, "SD write failed (errno %d) - reopening log", errno);
+        store_close();
+    }
+}
+
+static void wlog_task(void *arg)
+{
+    (void)arg;
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(WLOG_FLUSH_MS));
+        xSemaphoreTake(s_io_mtx, portMAX_DELAY);
+        if (!s_suspended && sd_flash_is_mounted()) {
+            if (!s_ready) store_open();
+            if (s_ready) store_drain();
+        }
+        xSemaphoreGive(s_io_mtx);
+
+        xSemaphoreTake(s_q_mtx, portMAX_DELAY);
+        bool more = s_ready && s_q_count > 0;
+        xSemaphoreGive(s_q_mtx);
+        if (more) xTaskNotifyGive(s_task);  // batch limit hit: go again
+    }
+}
+
+// ============================================================
+//  PUBLIC API — writer side
+// ============================================================
+bool weld_log_init(void)
+{
+    if (s_task) return true;
+    s_cur   = (uint8_t *)heap_caps_malloc(WLOG_REC_MAX, MALLOC_CAP_SPIRAM);
+    s_stage = (uint8_t *)heap_caps_malloc(WLOG_STAGE_SIZE, MALLOC_CAP_SPIRAM);
+    s_segs  = (wlog_seg_t *)heap_caps_calloc(WLOG_MAX_SEGMENTS, sizeof(wlog_seg_t),
+                                             MALLOC_CAP_SPIRAM);
+    s_q_mtx  = xSemaphoreCreateMutex();
+    s_io_mtx = xSemaphoreCreateMutex();
+    if (!s_cur || !s_stage || !s_segs || !s_q_mtx || !s_io_mtx) {
+        ESP_LOGE(TAG, "PSRAM alloc failed - weld log disabled");
+        return false;
+    }
+    // Below stm32_parse_task (3): SD latency never delays telemetry.
+    xTaskCreatePinnedToCore(wlog_task, "weld_log", 4096, NULL, 2, &s_task, 1);
+    return true;
+}
+
+void weld_log_feed(const char *line, uint32_t weld_id)
+{
+    if (!s_task) return;
+    if (strncmp(line, "EVENT,WELD_DONE,", 16) == 0) {
+        rec_commit();  // previous weld's waveform never finished
+        rec_begin(weld_id);
+        rec_stats(line);
+        return;
+    }
+    if (strncmp(line, "WAVEFORM_", 9) != 0) return;
+    const char *kind = line + 9;
+
+    if (strncmp(kind, "START,", 6) == 0) {
+        if (!s_cur_open || (cur_hdr()->flags & WELD_LOG_F_WAVEFORM)) {
+            rec_commit();
+            rec_begin(weld_id);  // capture without a WELD_DONE in front
+        }
+        weld_log_rec_t *h = cur_hdr();
+        h->flags         |= WELD_LOG_F_WAVEFORM;
+        h->wf_announced   = (uint16_t)fld_u(kind, "samples=");
+        h->wf_preheat_end = (uint16_t)fld_u(kind, "preheat=");
+        h->wf_gap_end     = (uint16_t)fld_u(kind, "gap=");
+        h->wf_main_end    = (uint16_t)fld_u(kind, "main=");
+    } else if (!s_cur_open) {
+        return;
+    } else if (strncmp(kind, "DATA,", 5) == 0) {
+        rec_csv(kind + 4);
+    } else if (strncmp(kind, "BIN,", 4) == 0) {
+        rec_bin(kind + 4);
+    } else if (strncmp(kind, "END", 3) == 0) {
+        weld_log_rec_t *h = cur_hdr();
+        if (h->wf_samples == h->wf_announced && !(h->flags & WELD_LOG_F_WF_GAP)) {
+            h->flags |= WELD_LOG_F_WF_DONE;
+        }
+        rec_commit();
+        return;
+    }
+    s_cur_touch_ms = now_ms();
+}
+
+void weld_log_poll(void)
+{
+    if (s_cur_open && now_ms() - s_cur_touch_ms >= WLOG_OPEN_IDLE_MS) rec_commit();
+}
+
+void weld_log_note_count_reset(void)
+{
+    s_rotate_req = true;
+}
+
+void weld_log_suspend(void)
+{
+    if (!s_io_mtx) return;
+    xSemaphoreTake(s_io_mtx, portMAX_DELAY);
+    store_close();
+    s_suspended = true;
+    xSemaphoreGive(s_io_mtx);
+}
+
+void weld_log_resume(void)
+{
+    if (!s_io_mtx) return;
+    xSemaphoreTake(s_io_mtx, portMAX_DELAY);
+    s_suspended = false;  // wlog_task rescans and opens a new segment
+    xSemaphoreGive(s_io_mtx);
+    if (s_task) xTaskNotifyGive(s_task);
+}
+
+// ============================================================
+//  PUBLIC API — readers
+// ============================================================
+static bool idx_read(int fd, uint32_t i, weld_log_idx_t *e)
+{
+    return lseek(fd, (off_t)i * sizeof(*e), SEEK_SET) >= 0 &&
+           read(fd, e, sizeof(*e)) == (ssize_t)sizeof(*e);
+}
+
+// First entry in [0, g->count) whose key >= want (key = weld_id or unix_s).
+static bool seg_search(const wlog_seg_t *g, bool by_time, uint32_t want, weld_log_idx_t *out)
+{
+    char path[48];
+    seg_path(path, sizeof(path), g->num, "IDX");
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    uint32_t lo = 0, hi = g->count;
+    weld_log_idx_t e;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (!idx_read(fd, mid, &e)) { close(fd); return false; }
+        if ((by_time ? e.unix_s : e.weld_id) < want) lo = mid + 1;
+        else hi = mid;
+    }
+    bool found = (lo < g->count) && idx_read(fd, lo, out) &&
+                 (by_time || out->weld_id == want);
+    close(fd);
+    return found;
+}
+
+bool weld_log_find(uint32_t weld_id, uint32_t unix_s, weld_log_loc_t *out)
+{
+    if (!s_io_mtx || (weld_id == 0) == (unix_s == 0)) return false;
+    bool found = false;
+    xSemaphoreTake(s_io_mtx, portMAX_DELAY);
+    if (s_ready) {
+        if (weld_id) {
+            for (int i = (int)s_seg_count - 1; i >= 0 && !found; i--) {
+                const wlog_seg_t *g = &s_segs[i];
+                if (!g->count || weld_id < g->first.weld_id || weld_id > g->last.weld_id) continue;
+                found = seg_search(g, false, weld_id, &out->idx);
+                out->seg = g->num;
+            }
+        } else {
+            for (unsigned i = 0; i < s_seg_count && !found; i++) {
+                const wlog_seg_t *g = &s_segs[i];
+                if (!g->count || g->last.unix_s < unix_s) continue;
+                found = seg_search(g, true, unix_s, &out->idx);
+                out->seg = g->num;
+            }
+        }
+    }
+    xSemaphoreGive(s_io_mtx);
+    return found;
+}
+
+static bool weld_log_read(const weld_log_loc_t *loc, uint8_t *buf, size_t len)
+{
+    bool ok = false;
+    char path[48];
+    seg_path(path, sizeof(path), loc->seg, "BIN");
+    xSemaphoreTake(s_io_mtx, portMAX_DELAY);
+    if (s_ready) {
+        int fd = open(path, O_RDONLY);
+        if (fd >= 0) {
+            ok = lseek(fd, loc->idx.offset, SEEK_SET) >= 0 &&
+                 read(fd, buf, len) == (ssize_t)len;
+            close(fd);
+        }
+    }
+    xSemaphoreGive(s_io_mtx);
+    return ok;
+}
+
+void weld_log_get_stats(weld_log_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (!s_io_mtx) return;
+    xSemaphoreTake(s_io_mtx, portMAX_DELAY);
+    *out = s_stats;
+    out->ready = s_ready;
+    xSemaphoreGive(s_io_mtx);
+    xSemaphoreTake(s_q_mtx, portMAX_DELAY);
+    out->pending = s_q_count;
+    out->dropped = s_stats.dropped;
+    xSemaphoreGive(s_q_mtx);
+}
+
+// ============================================================
+//  HTTP: GET /weldlog
+// ============================================================
+//   /weldlog             text: stats line + one line per segment
+//   /weldlog?id=N        binary record (weld_log_rec_t + samples)
+//   /weldlog?t=UNIX_S    binary record of the first weld at/after t
+static esp_err_t weldlog_get_handler(httpd_req_t *req)
+{
+    char query[64] = {0}, val[16] = {0};
+    uint32_t id = 0, t = 0;
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        if (httpd_query_key_value(query, "id", val, sizeof(val)) == ESP_OK) id = strtoul(val, NULL, 10);
+        if (httpd_query_key_value(query, "t", val, sizeof(val)) == ESP_OK)  t  = strtoul(val, NULL, 10);
+    }
+
+    if (id == 0 && t == 0) {
+        weld_log_stats_t st;
+        weld_log_get_stats(&st);
+        char line[192];
+        httpd_resp_set_type(req, "text/plain");
+        snprintf(line, sizeof(line),
+                 "WELDLOG,ready=%d,segments=%lu,records=%lu,bytes=%llu,pending=%lu,"
+                 "dropped=%lu,write_errors=%lu\n",
+                 st.ready ? 1 : 0, (unsigned long)st.segments, (unsigned long)st.records,
+                 (unsigned long long)st.bytes, (unsigned long)st.pending,
+                 (unsigned long)st.dropped, (unsigned long)st.write_errors);
+        httpd_resp_send_chunk(req, line, HTTPD_RESP_USE_STRLEN);
+        xSemaphoreTake(s_io_mtx, portMAX_DELAY);
+        for (unsigned i = 0; i < s_seg_count; i++) {
+            const wlog_seg_t *g = &s_segs[i];
+            snprintf(line, sizeof(line),
+                     "WELDLOG_SEG,seg=%lu,count=%lu,bytes=%lu,first_id=%lu,last_id=%lu,"
+                     "first_t=%lu,last_t=%lu\n",
+                     (unsigned long)g->num, (unsigned long)g->count, (unsigned long)g->bytes,
+                     (unsigned long)g->first.weld_id, (unsigned long)g->last.weld_id,
+                     (unsigned long)g->first.unix_s, (unsigned long)g->last.unix_s);
+            if (httpd_resp_send_chunk(req, line, HTTPD_RESP_USE_STRLEN) != ESP_OK) break;
+        }
+        xSemaphoreGive(s_io_mtx);
+        httpd_resp_send_chunk(req, NULL, 0);
+        return ESP_OK;
+    }
+
+    weld_log_loc_t loc;
+    if (!weld_log_find(id, id ? 0 : t, &loc)) {
+        httpd_resp_set_status(req, "404 Not Found");
+        httpd_resp_sendstr(req, "DENY,WELDLOG_GET,NOT_FOUND\n");
+        return ESP_OK;
+    }
+    uint8_t *buf = (uint8_t *)heap_caps_malloc(loc.idx.rec_len, MALLOC_CAP_SPIRAM);
+    if (!buf || !weld_log_read(&loc, buf, loc.idx.rec_len)) {
+        heap_caps_free(buf);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "SD read failed");
+        return ESP_FAIL;
+    }
+    char name[64];
+    snprintf(name, sizeof(name), "attachment; filename=\"weld_%lu.wrec\"",
+             (unsigned long)loc.idx.weld_id);
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", name);
+    esp_err_t err = httpd_resp_send(req, (const char *)buf, loc.idx.rec_len);
+    heap_caps_free(buf);
+    return err;
+}
+
+void weld_log_register_handler(httpd_handle_t server)
+{
+    if (!server) {
+        ESP_LOGW(TAG, "weld_log_register_handler: no HTTP server (skipped)");
+        return;
+    }
+
+    httpd_uri_t uri = {
+        .uri       = "/weldlog",
+        .method    = HTTP_GET,
+        .handler   = weldlog_get_handler,
+        .user_ctx  = NULL
+    };
+
+    esp_err_t err = httpd_register_uri_handler(server, &uri);
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Weld log endpoint registered: GET /weldlog[?id=N|?t=unix_s]");
+    } else {
+        ESP_LOGE(TAG, "Failed to register /weldlog handler: %s", esp_err_to_name(err));
+    }
+}
@@ -0,0 +1,142 @@
+// ============================================================
+//  Weld Log (SD card) — append-only binary record of every weld
+// ============================================================
+// Every weld (EVENT,WELD_DONE stats + recipe + the full waveform) becomes one
+// binary record on the SD card, so traceability does not depend on a PC
+// running Flask. Records are batched in PSRAM by stm32_parse_task (never
+// blocks) and written by a low-priority writer task in sector-aligned blocks.
+//
+// ON-CARD LAYOUT (/sdcard/WELDLOG):
+//   WLnnnnnn.BIN  segment: records back to back, each padded to 512 bytes
+//   WLnnnnnn.IDX  index:   one weld_log_idx_t per record, same order
+// A new segment starts at every boot, every WELD_LOG_SEG_MAX_BYTES and on a
+// weld-counter reset, so weld_id (and unix_s once SNTP has synced) only ever
+// increase within a segment and a lookup is a binary search of one index.
+// The oldest segments are deleted when the card runs low on space.
+//
+// Retrieval: TCP bridge WELDLOG / WELDLOG_GET,<id|t=unix_s> (summary line),
+// LAN httpd GET /weldlog[?id=N|?t=unix_s] (full binary record). See
+// PROTOCOL.md, "Weld log".
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_http_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WELD_LOG_REC_MAGIC    0x43455257u  // "WREC" little-endian
+#define WELD_LOG_VERSION      1
+#define WELD_LOG_SECTOR       512
+#define WELD_LOG_MAX_SAMPLES  12288        // = STM32 packed capture limit
+#define WELD_LOG_SAMPLE_BYTES 5            // same packing as WAVEFORM_BIN
+#define WELD_LOG_PAD(n)       (((n) + WELD_LOG_SECTOR - 1) & ~(size_t)(WELD_LOG_SECTOR - 1))
+
+// weld_log_rec_t.flags
+#define WELD_LOG_F_STATS      0x0001  // WELD_DONE fields present
+#define WELD_LOG_F_WAVEFORM   0x0002  // WAVEFORM_START seen
+#define WELD_LOG_F_WF_DONE    0x0004  // WAVEFORM_END seen, sample count matches
+#define WELD_LOG_F_WF_GAP     0x0008  // chunk missing/out of order
+#define WELD_LOG_F_TRUNCATED  0x0010  // more than WELD_LOG_MAX_SAMPLES
+#define WELD_LOG_F_TIME       0x0020  // unix_s is wall-clock (SNTP synced)
+
+// Record header (128 bytes, little-endian), followed by wf_samples packed
+// samples: int16 current (0.1 A), uint16 voltage (mV), uint8 dt_us since the
+// previous sample (clamped to 255). Zero padding up to WELD_LOG_PAD(rec_len).
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             // WELD_LOG_REC_MAGIC
+    uint16_t version;           // WELD_LOG_VERSION
+    uint16_t hdr_len;           // sizeof(weld_log_rec_t)
+    uint32_t rec_len;           // header + samples, without padding
+    uint32_t crc32;             // CRC-32 (zlib) of bytes [16, rec_len)
+    uint32_t weld_id;           // P4 weld_count
+    uint32_t unix_s;            // wall clock, 0 if not synced
+    uint32_t uptime_ms;         // P4 uptime at WELD_DONE
+    uint16_t flags;             // WELD_LOG_F_*
+    uint8_t  mode;              // recipe (from WELD_DONE)
+    uint8_t  power_pct;
+    uint16_t d1_ms, gap1_ms, d2_ms, gap2_ms, d3_ms;
+    uint16_t preheat_ms;
+    uint8_t  preheat_en;
+    uint8_t  reserved0;
+    uint16_t wf_interval_us;
+    uint32_t total_ms;
+    float    peak_a, avg_a;
+    float    vcap_b, vcap_a;
+    float    energy_weld_j, energy_cap_j, energy_lead_j;
+    float    joule_workpiece_j, joule_pred_j;
+    float    pulse_ms;
+    uint16_t wf_samples;        // samples stored after this header
+    uint16_t wf_announced;      // WAVEFORM_START samples=
+    uint16_t wf_preheat_end;    // WAVEFORM_START phase boundaries
+    uint16_t wf_gap_end;
+    uint16_t wf_main_end;
+    uint32_t pedal_fet_us;      // pedal edge -> first FET on, 0 = not pedal
+    float    didt_a_us;         // main-pulse current rise rate
+    float    r_start_mohm;      // contact resistance, first / last quarter
+    float    r_end_mohm;        //   of the main pulse (0 = not measured)
+    uint8_t  reserved1[10];
+} weld_log_rec_t;
+
+// Index entry (32 bytes). offset is the sector-aligned record offset in the
+// segment's .BIN file.
+typedef struct __attribute__((packed)) {
+    uint32_t weld_id;
+    uint32_t unix_s;
+    uint32_t uptime_ms;
+    uint32_t offset;
+    uint32_t rec_len;
+    float    energy_j;          // energy_weld_j
+    float    peak_a;
+    uint16_t flags;
+    uint16_t total_ms;          // clamped to 65535
+} weld_log_idx_t;
+
+typedef struct {
+    uint32_t       seg;         // segment number (WLnnnnnn)
+    weld_log_idx_t idx;
+} weld_log_loc_t;
+
+typedef struct {
+    bool     ready;             // store open on a mounted card
+    uint32_t segments;
+    uint32_t records;           // indexed records on the card
+    uint64_t bytes;             // segment bytes on the card
+    uint32_t pending;           // records staged, not yet on the card
+    uint32_t dropped;           // records lost: stage full
+    uint32_t write_errors;
+} weld_log_stats_t;
+
+// Allocate the PSRAM buffers and start the writer task. Call once from
+// app_main after sd_flash_init(). Without a card the log stays idle.
+bool weld_log_init(void);
+
+// Feed one STM32 line (stm32_parse_task only). EVENT,WELD_DONE opens a record
+// (weld_id = weld_count after the increment), WAVEFORM_* fill it, END commits.
+void weld_log_feed(const char *line, uint32_t weld_id);
+
+// Commit an open record whose waveform never completed (stm32_parse_task).
+void weld_log_poll(void);
+
+// The weld counter was reset: start a new segment (ids stay monotonic).
+void weld_log_note_count_reset(void);
+
+// Close the log files around an SD unmount/remount (sd_flash).
+void weld_log_suspend(void);
+void weld_log_resume(void);
+
+// Locate a record by weld_id (unix_s = 0) or the first record at/after unix_s
+// (weld_id = 0). Newest segment wins for a repeated weld_id.
+bool weld_log_find(uint32_t weld_id, uint32_t unix_s, weld_log_loc_t *out);
+
+void weld_log_get_stats(weld_log_stats_t *out);
+
+// Register GET /weldlog on the LAN httpd (called from wifi_bridge).
+void weld_log_register_handler(httpd_handle_t server);
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,7 +2,7 @@
 // ESP32-P4 (CrowPanel Advance 5") spot-welder DISPLAY/BRIDGE firmware.
 //
 // Ported from the original Sunton ESP32-S3 build:
-//   - Full 5-tab LVGL UI lives in ui.cpp / ui.h (unchanged logic).
+//   - Full 6-tab LVGL UI lives in ui.cpp / ui.h (unchanged logic).
 //   - This file is the ESP-IDF bootstrap: RGB LCD + STC8 backlight + GT911
 //     touch + STM32 UART link, and it bridges between the UI callbacks and the
 //     STM32 controller protocol.
@@ -10,12 +10,20 @@
 // Threading model (LVGL is NOT thread-safe):
 //   - lvgl_task  : owns ALL LVGL calls (lv_timer_handler + ui_update). Touch
 //                  event callbacks (which send STM32 commands) also run here.
-//   - stm32_task : polls the STM32 over UART, parses STATUS, and stores the
-//                  result into g_state under a mutex. Never touches LVGL.
+//   - stm32_task : UART ingest. Waits on the UART event queue, frames lines
+//                  and queues them; also sends READY/STREAM (falls back to
+//                  polling STATUS on older firmware). Never parses or logs.
+//   - stm32_parse_task : parses queued lines into g_state and publishes a
+//                  lock-free snapshot for the readers
+//                  (plus STATUS enrichment, WELD_DONE/NVS, CAL notify,
+//                  console echo).
+//   - stm32_bcast_task : relays lines to the TCP bridge and sends the 1 Hz
+//                  DISPLAY packet. None of these touch LVGL.
 
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <math.h>
 #include <stdarg.h>
 #include <ctype.h>
@@ -23,6 +31,8 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/ringbuf.h"
 #include "driver/uart.h"
 #include "driver/gpio.h"
 #include "driver/i2c_master.h"
@@ -33,7 +43,8 @@
 #include "esp_lcd_panel_rgb.h"
 #include "esp_timer.h"
 #include "esp_system.h"
-#include "esp_chip_info.h"
+#include "esp_random.h"
+#include "esp_rom_crc.h"
 #include "esp_flash.h"
 #include "nvs.h"
 #include "nvs_flash.h"
@@ -43,6 +54,11 @@
 #include "touch_gt911.h"
 #include "wifi_bridge.h"
 #include "sd_flash.h"
+#include "waveform_history.h"
+#include "waveform_plot.h"
+#include "weld_log.h"
+#include "perf_stats.h"
+#include "telemetry_parse.h"
 
 static const char *TAG = "WELDER_UI";
 
@@ -55,7 +71,19 @@ static const char *TAG = "WELDER_UI";
 #define STM32_BOOT0_PIN     31
 #define STM32_NRST_PIN      32  // hardware reset for ROM bootloader entry
 #define BUF_SIZE            8192  // WAVEFORM_DATA lines can be huge (OLD board used 8192)
-#define UART_RX_BUF_SIZE    (128 * 1024)  // 128 KB buffer (generous for 576k baud)
+// Driver RX buffer. stm32_task drains it on every UART event, so it only has
+// to cover scheduling jitter (16 KB = ~280 ms at 576k); bursts that the parse
+// or broadcast stages can't keep up with queue in the line rings below.
+#define UART_RX_BUF_SIZE    (16 * 1024)
+#define UART_EVT_QUEUE_LEN  32
+#define PARSE_RING_SIZE     (32 * 1024)   // framed lines: ingest -> parse
+#define BCAST_RING_SIZE     (32 * 1024)   // parsed lines: parse -> broadcast
+#define STM32_POLL_MS       350           // legacy STATUS poll (no STREAM)
+
+// Telemetry subscription sent to the STM32: STATUS+STATUS2 at 5 Hz plus an
+// immediate STATUS_DELTA on every armed/ready/welding/contact/fault change.
+#define STM32_STREAM_CMD      "STREAM,5,7"
+#define STM32_STREAM_RETRY_MS 5000
 #define STM32_BAUD          576000  // 576 kbaud — safe through UART3-IN level shifters
 // WiFi credentials, captive portal and the Flask TCP bridge (port 8888) are all
 // handled in wifi_bridge.cpp (provisioning is done at runtime, stored in NVS).
@@ -118,9 +146,13 @@ static SemaphoreHandle_t  g_vsync_sem    = NULL;
 static i2c_master_dev_handle_t stc8_dev_handle = NULL;
 static i2c_master_bus_handle_t g_i2c_bus    = NULL;
 
-// Shared welder state (written by stm32_task, read by lvgl_task).
-static WelderDisplayState g_state;
-static SemaphoreHandle_t  g_state_mtx = NULL;
+// Shared welder state. stm32_parse_task is the only writer: it edits g_state
+// (private to it) and publishes a complete copy with state_publish(). Readers
+// (lvgl_task, stm32_bcast_task) take a consistent copy with state_read() and
+// never block the writer, nor it them. See "STATE SNAPSHOT".
+static WelderDisplayState g_state;        // stm32_parse_task working copy
+static WelderDisplayState g_state_pub;    // last published snapshot
+static uint32_t           g_state_seq = 0;  // seqlock: odd while publishing
 
 // STM32 remote-flash coordination (see stm32_task pause point + the
 // welder_prep_stm32_flash() hook called by stm32_flash.cpp).
@@ -128,6 +160,24 @@ static TaskHandle_t       s_stm32_task_handle = NULL;
 static volatile bool      s_stm32_pause_req   = false;  // flasher -> stm32_task
 static volatile bool      s_stm32_paused      = false;  // stm32_task -> flasher
 
+// STM32 RX pipeline (see stm32_task). Lines are NUL-terminated ring items.
+static QueueHandle_t      s_uart_evt_q = NULL;
+static RingbufHandle_t    s_parse_rb   = NULL;
+static RingbufHandle_t    s_bcast_rb   = NULL;
+
+// RX framing / queueing counters (written by stm32_task, except bcast_drop).
+static volatile uint32_t  s_rx_lines      = 0;
+static volatile uint32_t  s_rx_overlong   = 0;   // line > BUF_SIZE, discarded
+static volatile uint32_t  s_rx_uart_ovf   = 0;   // FIFO/driver overflow events
+static volatile uint32_t  s_rx_parse_drop = 0;   // parse ring full
+static volatile uint32_t  s_rx_bcast_drop = 0;   // broadcast ring full
+
+// STREAM subscription state. The parse stage sees ACK/ERR/BOOT and updates
+// it; stm32_task (the only task that talks to the UART) acts on it.
+enum StreamState { STREAM_IDLE = 0, STREAM_ACTIVE, STREAM_UNSUPPORTED };
+static volatile uint8_t   s_stream_state   = STREAM_IDLE;
+static volatile bool      s_stream_req_due = true;   // send STREAM now
+
 // Set true once the first STATUS line from the STM32 has been parsed. Used to
 // adopt the controller's flash-persisted settings into the Config UI exactly
 // once at boot ("load last settings on boot"). The STM32 is now the source of
@@ -149,7 +199,7 @@ static uint32_t weld_count = 0;
 
 // DISPLAY packet guard: only send after STATUS2 has populated voltage data.
 // Matches OLD ESP32 behaviour (ESP32_8048S043C line 4463: "if (hasRawStatus2Data)").
-static bool has_status2_data = false;
+static volatile bool has_status2_data = false;  // set by parse, read by bcast task
 
 // ============================================================
 //  VOLTAGE DISPLAY SMOOTHER (ported 1:1 from OLD ESP32)
@@ -160,46 +210,7 @@ static bool has_status2_data = false;
 // (DISPLAY packet) — so the device and the dashboard always agree. Raw STATUS2
 // is still forwarded separately for graph/calc consumers that need raw data.
 //
-// Matches ESP32_8048S043C/src/main.cpp VoltageDisplaySmoother (lines 216-265).
-class VoltageDisplaySmoother {
-   private:
-    struct Channel {
-        float lastValue;
-        bool  initialized;
-    };
-    static const int MAX_CHANNELS = 8;
-    Channel channels[MAX_CHANNELS];
-    float   threshold;
-
-   public:
-    explicit VoltageDisplaySmoother(float thresh = 0.02f) : threshold(thresh) {
-        for (int i = 0; i < MAX_CHANNELS; i++) {
-            channels[i].initialized = false;
-            channels[i].lastValue   = 0.0f;
-        }
-    }
-
-    float getDisplayValue(int channel, float rawValue) {
-        if (channel < 0 || channel >= MAX_CHANNELS) return rawValue;
-        if (!channels[channel].initialized) {
-            channels[channel].lastValue   = rawValue;
-            channels[channel].initialized = true;
-            return rawValue;
-        }
-        float delta = fabsf(rawValue - channels[channel].lastValue);
-        if (delta < threshold) return channels[channel].lastValue;
-        channels[channel].lastValue = rawValue;
-        return rawValue;
-    }
-};
-
-enum VoltageChannel {
-    CH_VPACK = 0,
-    CH_VCAP  = 1,
-    CH_CELL1 = 2,
-    CH_CELL2 = 3,
-    CH_CELL3 = 4,
-};
+// The smoother class itself lives in telemetry_parse.h.
 
 // Single global smoother instance — the "one place" all displayed voltages
 // pass through, so the local screen and Flask dashboard stay mirrored.
@@ -261,7 +272,8 @@ static void uart_init(void)
     ESP_ERROR_CHECK(uart_param_config(STM32_UART_NUM, &uart_config));
     ESP_ERROR_CHECK(uart_set_pin(STM32_UART_NUM, STM32_TX_PIN, STM32_RX_PIN,
                                  UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
-    ESP_ERROR_CHECK(uart_driver_install(STM32_UART_NUM, UART_RX_BUF_SIZE, 0, 0, NULL, 0));
+    ESP_ERROR_CHECK(uart_driver_install(STM32_UART_NUM, UART_RX_BUF_SIZE, 0,
+                                        UART_EVT_QUEUE_LEN, &s_uart_evt_q, 0));
     // Set RX timeout: flush after 10 symbol times of idle (helps partial-packet delivery).
     ESP_ERROR_CHECK(uart_set_rx_timeout(STM32_UART_NUM, 10));
     // Bump UART ISR priority to preempt normal tasks (helps during 30s UI build).
@@ -274,8 +286,9 @@ static void stm_send(const char *cmd)
 {
     uart_write_bytes(STM32_UART_NUM, cmd, strlen(cmd));
     uart_write_bytes(STM32_UART_NUM, "\n", 1);
-    // Debug-level: the periodic STATUS poll (every ~350 ms) would otherwise
-    // flood the console. Raise the log level to DEBUG to see it if needed.
+    // Debug-level: the STATUS poll (every ~350 ms until the STREAM
+    // subscription is ACKed) would otherwise flood the console. Raise the
+    // log level to DEBUG to see it if needed.
     ESP_LOGD(TAG, "-> STM32: %s", cmd);
 }
 
@@ -289,7 +302,95 @@ static void stm_sendf(const char *fmt, ...)
     stm_send(buf);
 }
 
-// ---- STATUS field extraction helpers ----
+// ============================================================
+//  STM32 LINK SPEED (opt-in)
+// ============================================================
+// The link runs at STM32_BAUD unless the build sets STM32_LINK_FAST_BAUD
+// (1000000, 2000000 or 3000000; see PROTOCOL.md "Link speed"). Then, once the
+// STREAM subscription is up and STATUS advertises caps bit 2, stm32_task:
+//   1. sends LINK_SPEED,<rate>; the STM32 ACKs at the old rate and switches,
+//   2. switches too and sends LINK_PROBE_COUNT CRC'd probes; each ACK carries
+//      a CRC'd payload back, so both directions are checked,
+//   3. sends LINK_SPEED,COMMIT.
+// Any miss drops this side back to STM32_BAUD; the STM32 reverts an
+// uncommitted trial on its own. A committed link falls back on a frame-error
+// burst or on silence, on both sides. Attempts are capped per boot so a
+// marginal shifter cannot keep the link flapping.
+#ifndef STM32_LINK_FAST_BAUD
+#define STM32_LINK_FAST_BAUD    0       // 0 = stay at STM32_BAUD
+#endif
+static_assert(STM32_LINK_FAST_BAUD == 0 || STM32_LINK_FAST_BAUD == 1000000 ||
+              STM32_LINK_FAST_BAUD == 2000000 || STM32_LINK_FAST_BAUD == 3000000,
+              "STM32_LINK_FAST_BAUD must be a rate the STM32 accepts");
+#define STM32_CAP_LINK_SPEED    (1u << 2)   // STATUS caps bit
+#define LINK_PROBE_COUNT        3
+#define LINK_PROBE_PAYLOAD      96      // chars; the STM32 takes lines <= 127
+#define LINK_REPLY_TIMEOUT_MS   300
+#define LINK_MAX_ATTEMPTS       3       // per boot
+#define LINK_RETRY_MS           10000
+#define LINK_ERR_LIMIT          8       // UART frame errors per window
+#define LINK_ERR_WINDOW_MS      1000
+#define LINK_SILENCE_MS         3000    // STREAM sends STATUS at 5 Hz
+
+enum LinkState { LINK_BASE = 0, LINK_REQUESTED, LINK_PROBING, LINK_COMMITTING, LINK_FAST };
+enum LinkReply {
+    LINK_REPLY_NONE = 0,
+    LINK_REPLY_SPEED,      // ACK,LINK_SPEED,baud=<arg>
+    LINK_REPLY_PROBE_OK,   // ACK,LINK_PROBE with an intact payload, seq=<arg>
+    LINK_REPLY_COMMIT,     // ACK,LINK_SPEED,COMMIT
+    LINK_REPLY_FAIL,       // DENY / unknown command / corrupt probe reply
+    LINK_REPLY_FALLBACK,   // EVENT,LINK_SPEED: the STM32 went back to base
+};
+
+// Reply mailbox: stm32_parse_task posts, stm32_task consumes. The exchange
+// is strictly request/response, so one slot is enough.
+static volatile uint8_t  s_link_reply     = LINK_REPLY_NONE;
+static volatile uint32_t s_link_reply_arg = 0;
+static volatile uint32_t s_stm32_caps     = 0;   // last STATUS caps
+
+static void link_post(uint8_t reply, uint32_t arg)
+{
+    s_link_reply_arg = arg;
+    s_link_reply = reply;
+}
+
+// ACK,LINK_PROBE,seq=<n>,len=<n>,crc=<hex>,data=<payload>: true if the
+// payload arrived intact.
+static bool link_probe_reply_ok(const char *line, uint32_t *seq)
+{
+    unsigned s = 0, len = 0;
+    unsigned long crc = 0;
+    int n = 0;
+    if (sscanf(line, "ACK,LINK_PROBE,seq=%u,len=%u,crc=%lx,data=%n", &s, &len, &crc, &n) != 3 ||
+        n <= 0) {
+        return false;
+    }
+    const char *data = line + n;
+    if (strlen(data) != len) return false;
+    *seq = s;
+    return esp_rom_crc32_le(0, (const uint8_t *)data, len) == (uint32_t)crc;
+}
+
+// stm32_parse_task: hand LINK_SPEED / LINK_PROBE replies to stm32_task.
+static void link_parse_reply(const char *line)
+{
+    if (strncmp(line, "ACK,LINK_PROBE,", 15) == 0) {
+        uint32_t seq = 0;
+        bool ok = link_probe_reply_ok(line, &seq);
+        link_post(ok ? LINK_REPLY_PROBE_OK : LINK_REPLY_FAIL, seq);
+    } else if (strncmp(line, "ACK,LINK_SPEED,COMMIT", 21) == 0) {
+        link_post(LINK_REPLY_COMMIT, 0);
+    } else if (strncmp(line, "ACK,LINK_SPEED,baud=", 20) == 0) {
+        link_post(LINK_REPLY_SPEED, (uint32_t)strtoul(line + 20, NULL, 10));
+    } else if (strncmp(line, "DENY,LINK_", 10) == 0 ||
+               strncmp(line, "ERR,UNKNOWN_CMD,rx=LINK_", 24) == 0) {
+        link_post(LINK_REPLY_FAIL, 0);
+    } else if (strncmp(line, "EVENT,LINK_SPEED,", 17) == 0) {
+        link_post(LINK_REPLY_FALLBACK, 0);
+    }
+}
+
+// ---- key=value extraction helpers (event lines, e.g. WELD_DONE) ----
 static bool extract_float(const char *s, const char *key, float *out)
 {
     const char *p = strstr(s, key);
@@ -337,6 +438,17 @@ static void save_weld_count_to_nvs(void)
     }
 }
 
+// ============================================================
+//  TELEMETRY FIELD SCHEMA (STATUS / STATUS2 / STATUS_DELTA)
+// ============================================================
+// STATUS_FIELD_LIST, StatusFields and the single-pass tokenizer live in
+// telemetry_parse.h/.cpp (host-buildable; timed by bench/).
+static void status_schema_check_log(void)
+{
+    const char *bad = status_schema_check();
+    if (bad) ESP_LOGE(TAG, "STATUS_FIELD_LIST not sorted at '%s'", bad);
+}
+
 // ============================================================
 //  STATUS ENRICHMENT (WiFi + System + Energy + Weld Count)
 // ============================================================
@@ -346,94 +458,106 @@ static void save_weld_count_to_nvs(void)
 //
 // CRITICAL: Only enrich STATUS. Forward STATUS2 (battery voltages) RAW so
 // Flask's _parse_status2() handler can parse it correctly.
-static void enrich_and_broadcast(const char *line)
+//
+// Runs in stm32_parse_task, from the fields status_fields_parse() already
+// extracted. Only the state/energy/weld_count part changes per packet; the
+// WiFi + system tail is cached: fw_version/chip_model/flash_size never
+// change (formatted once) and RSSI/heap/uptime are refreshed every
+// ENRICH_TAIL_REFRESH_MS (RSSI is an RPC to the C6 over SPI).
+#define ENRICH_TAIL_REFRESH_MS  1000
+
+static char     s_enrich_static[96];   // ",fw_version=...,chip_model=...,flash_size=..."
+static char     s_enrich_tail[320];    // ",wifi_*..." + s_enrich_static + ",free_heap,uptime_s"
+static size_t   s_enrich_tail_len = 0;
+static uint32_t s_enrich_tail_ms  = 0;
+
+static void enrich_refresh_tail(uint32_t now_ms)
 {
-    // STATUS2 (battery voltages): forward raw, no enrichment. Flask has a
-    // dedicated parser for this (_parse_status2).
-    if (strncmp(line, "STATUS2,", 8) == 0) {
-        wifi_bridge_broadcast(line);
-        return;
-    }
-
-    // Only enrich STATUS packets. Forward everything else as-is (events, etc.).
-    if (strncmp(line, "STATUS,", 7) != 0) {
-        wifi_bridge_broadcast(line);
-        return;
-    }
-
-    // Build enriched STATUS by appending WiFi/system/energy/weld_count fields.
-    char enriched[2048];
-    int len = snprintf(enriched, sizeof(enriched), "%s", line);
-    if (len < 0 || len >= (int)sizeof(enriched) - 512) {
-        wifi_bridge_broadcast(line);  // fallback if buffer too small
-        return;
+    if (!s_enrich_static[0]) {
+        uint32_t flash_size = 0;
+        esp_flash_get_size(NULL, &flash_size);  // NULL = default flash chip
+        snprintf(s_enrich_static, sizeof(s_enrich_static),
+                 ",fw_version=1.0.0,chip_model=%s,flash_size=%lu",
+                 CONFIG_IDF_TARGET, (unsigned long)flash_size);  // "esp32p4"
     }
 
-    // Parse fields from STATUS to compute state/enabled (Flask needs these).
-    int armed = 0, welding = 0, ready = 0, chg_en = 0;
-    extract_int(line, "armed=", &armed);
-    extract_int(line, "welding=", &welding);
-    extract_int(line, "ready=", &ready);
-    extract_int(line, "chg_en=", &chg_en);
-
-    // Compute derived fields (Flask UI depends on these).
-    bool enabled = (armed == 1);
-    const char *state;
-    if (!enabled) {
-        state = "DISABLED";
-    } else if (welding == 1) {
-        state = "WELDING";
-    } else if (chg_en == 1) {
-        state = "CHARGING";
-    } else {
-        state = "IDLE";
-    }
-
-    // Add computed fields (Flask expects enabled for arm button, state for status label).
-    len += snprintf(enriched + len, sizeof(enriched) - len,
-                    ",enabled=%d,state=%s", enabled ? 1 : 0, state);
-
-    // Energy (already parsed from STM32 into globals)
-    len += snprintf(enriched + len, sizeof(enriched) - len,
-                    ",energy_cap_j=%.3f,energy_weld_j=%.3f,energy_loss_j=%.3f",
-                    energy_cap_j, energy_weld_j, energy_loss_j);
-
-    // Weld counter
-    len += snprintf(enriched + len, sizeof(enriched) - len,
-                    ",weld_count=%lu", (unsigned long)weld_count);
-
     // WiFi info
     bool wifi_connected = false, wifi_ap_mode = false;
     char wifi_ssid[33] = {0}, wifi_ip[16] = {0};
     int wifi_rssi = 0;
     wifi_bridge_get_info(&wifi_connected, &wifi_ap_mode, wifi_ssid, wifi_ip, &wifi_rssi);
-    
+
     // Sanitize SSID (commas/equals break CSV parser)
     for (char *p = wifi_ssid; *p; p++) {
         if (*p == ',' || *p == '=') *p = ' ';
     }
 
-    len += snprintf(enriched + len, sizeof(enriched) - len,
-                    ",wifi_connected=%d,wifi_ap_mode=%d,wifi_ssid=%s,wifi_ip=%s,wifi_rssi=%d",
-                    wifi_connected ? 1 : 0, wifi_ap_mode ? 1 : 0,
-                    wifi_ssid, wifi_ip, wifi_rssi);
-
-    // System info
-    esp_chip_info_t chip_info;
-    esp_chip_info(&chip_info);
-    const char *chip_model = CONFIG_IDF_TARGET;  // "esp32p4"
-    
-    uint32_t flash_size = 0;
-    esp_flash_get_size(NULL, &flash_size);  // NULL = default flash chip
-    
-    len += snprintf(enriched + len, sizeof(enriched) - len,
-                    ",fw_version=1.0.0,chip_model=%s,flash_size=%lu,free_heap=%lu,uptime_s=%lu",
-                    chip_model,
-                    (unsigned long)flash_size,
-                    (unsigned long)esp_get_free_heap_size(),
-                    (unsigned long)(esp_timer_get_time() / 1000000ULL));
-
-    wifi_bridge_broadcast(enriched);
+    int len = snprintf(s_enrich_tail, sizeof(s_enrich_tail),
+                       ",wifi_connected=%d,wifi_ap_mode=%d,wifi_ssid=%s,wifi_ip=%s,wifi_rssi=%d"
+                       "%s,free_heap=%lu,uptime_s=%lu",
+                       wifi_connected ? 1 : 0, wifi_ap_mode ? 1 : 0,
+                       wifi_ssid, wifi_ip, wifi_rssi, s_enrich_static,
+                       (unsigned long)esp_get_free_heap_size(),
+                       (unsigned long)(esp_timer_get_time() / 1000000ULL));
+    s_enrich_tail_len = (len > 0 && len < (int)sizeof(s_enrich_tail)) ? (size_t)len : 0;
+    s_enrich_tail_ms = now_ms;
+}
+
+// Build the enriched STATUS line into out. Returns false (caller relays the
+// raw line) if it does not fit.
+static bool enrich_status_line(const char *line, const StatusFields &f,
+                               char *out, size_t cap)
+{
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000ULL);
+    if (s_enrich_tail_len == 0 || now_ms - s_enrich_tail_ms >= ENRICH_TAIL_REFRESH_MS) {
+        enrich_refresh_tail(now_ms);
+    }
+
+    StatusEnrichValues v = { energy_cap_j, energy_weld_j, energy_loss_j, weld_count };
+    return status_enrich_line(line, f, v, s_enrich_tail, s_enrich_tail_len, out, cap) != 0;
+}
+
+// ============================================================
+//  STATE SNAPSHOT (seqlock, single writer)
+// ============================================================
+// The writer bumps g_state_seq to odd, copies g_state into g_state_pub and
+// bumps it back to even. A reader copies g_state_pub between two reads of the
+// counter and retries if it was odd or moved, so a torn copy is never used.
+// The copy is ~200 bytes and a publish happens at telemetry rate, so a retry
+// is rare and costs one more memcpy — nobody waits on a lock held across a
+// render frame or a UART burst. seq / 2 is the snapshot version: consumers
+// that see the same version again can skip their work.
+static void state_publish(void)
+{
+    // Unchanged (repeated STATUS, DELTA with the same flags): keep the version
+    // so readers skip it. Only this task writes g_state_pub, so a plain read
+    // is safe here.
+    if (memcmp(&g_state_pub, &g_state, sizeof(g_state)) == 0) return;
+
+    uint32_t seq = __atomic_load_n(&g_state_seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_state_seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&g_state_pub, &g_state, sizeof(g_state));
+    __atomic_store_n(&g_state_seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t state_version(void)
+{
+    return __atomic_load_n(&g_state_seq, __ATOMIC_ACQUIRE) >> 1;
+}
+
+// Copy the latest published state into *out; returns its version.
+static uint32_t state_read(WelderDisplayState *out)
+{
+    uint32_t s1, s2;
+    do {
+        s1 = __atomic_load_n(&g_state_seq, __ATOMIC_ACQUIRE);
+        if (s1 & 1u) continue;  // publish in flight; s2 check below fails
+        memcpy(out, &g_state_pub, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        s2 = __atomic_load_n(&g_state_seq, __ATOMIC_RELAXED);
+        if (s1 == s2) return s1 >> 1;
+    } while (true);
 }
 
 // ============================================================
@@ -446,31 +570,30 @@ static void enrich_and_broadcast(const char *line)
 static void send_display_packet(void)
 {
     char buf[256];
-    xSemaphoreTake(g_state_mtx, portMAX_DELAY);
+    WelderDisplayState st;
+    state_read(&st);
 
-    // g_state already holds the SMOOTHED voltages (parse_status_line runs every
-    // value through g_volt_smoother). So this DISPLAY packet mirrors exactly
-    // what the local LVGL screen shows — one smoother, one source of truth.
+    // The snapshot already holds the SMOOTHED voltages (parse_status_line runs
+    // every value through g_volt_smoother). So this DISPLAY packet mirrors
+    // exactly what the local LVGL screen shows — one smoother, one source of
+    // truth.
     int len = snprintf(buf, sizeof(buf),
                        "DISPLAY,vpack=%.3f,vcap=%.3f,cell1=%.3f,cell2=%.3f,cell3=%.3f",
-                       g_state.pack_voltage,
-                       g_state.weld_v,  // vcap = contact voltage (weld_v), smoothed
-                       g_state.cell1_v,
-                       g_state.cell2_v,
-                       g_state.cell3_v);
-
-    xSemaphoreGive(g_state_mtx);
+                       st.pack_voltage,
+                       st.weld_v,  // vcap = contact voltage (weld_v), smoothed
+                       st.cell1_v,
+                       st.cell2_v,
+                       st.cell3_v);
 
     if (len > 0 && len < (int)sizeof(buf)) {
         wifi_bridge_broadcast(buf);
     }
 }
 
-// Parse a STATUS line from the STM32 into g_state (under mutex).
+// Parse an EVENT,WELD_DONE line from the STM32 into g_state and publish it.
 static void parse_weld_done(const char *line)
 {
     // Extract last-weld stats from EVENT,WELD_DONE for the Status dashboard.
-    xSemaphoreTake(g_state_mtx, portMAX_DELAY);
     float fv; int iv;
 
     if (extract_int(line, "total_ms=", &iv))
@@ -504,94 +627,111 @@ static void parse_weld_done(const char *line)
 
     g_state.last_weld_valid = true;
 
-    xSemaphoreGive(g_state_mtx);
+    state_publish();
 
     // Increment persistent weld counter for Flask dashboard "Total Welds".
     weld_count++;
     save_weld_count_to_nvs();
 }
 
-static void parse_status_line(const char *line)
+// Parse a STATUS / STATUS2 / STATUS_DELTA line (one pass) into *f and apply
+// it to g_state, then publish it. Returns the packet kind (NONE = not telemetry;
+// *f is then untouched).
+static StatusPacketKind parse_status_line(const char *line, StatusFields *f)
 {
-    if (!strstr(line, "STATUS")) return;
-
-    xSemaphoreTake(g_state_mtx, portMAX_DELAY);
-    float fv; int iv;
+    StatusPacketKind kind = status_packet_kind(line);
+    if (kind == STATUS_PKT_NONE) return kind;
+    status_fields_parse(line, f);
 
     // Battery voltages come from STATUS2 (INA226 readings), not STATUS.
     // Apply smoothing so the local screen and Flask DISPLAY match.
-    if (strncmp(line, "STATUS2,", 8) == 0) {
-        if (extract_float(line, "vpack=", &fv))  g_state.pack_voltage = g_volt_smoother.getDisplayValue(CH_VPACK, fv);
-        if (extract_float(line, "cell1=", &fv))  g_state.cell1_v      = g_volt_smoother.getDisplayValue(CH_CELL1, fv);
-        if (extract_float(line, "cell2=", &fv))  g_state.cell2_v      = g_volt_smoother.getDisplayValue(CH_CELL2, fv);
-        if (extract_float(line, "cell3=", &fv))  g_state.cell3_v      = g_volt_smoother.getDisplayValue(CH_CELL3, fv);
-        
+    if (kind == STATUS_PKT_BATT) {
+        if (SF_HAS(*f, vpack))  g_state.pack_voltage = g_volt_smoother.getDisplayValue(CH_VPACK, f->vpack);
+        if (SF_HAS(*f, cell1))  g_state.cell1_v      = g_volt_smoother.getDisplayValue(CH_CELL1, f->cell1);
+        if (SF_HAS(*f, cell2))  g_state.cell2_v      = g_volt_smoother.getDisplayValue(CH_CELL2, f->cell2);
+        if (SF_HAS(*f, cell3))  g_state.cell3_v      = g_volt_smoother.getDisplayValue(CH_CELL3, f->cell3);
+
         // Charger state (STATUS2 has chg_en and ichg fields).
-        if (extract_int(line, "chg_en=", &iv))   g_state.charging = (iv == 1);
-        if (extract_float(line, "ichg=", &fv))   g_state.charger_current = g_state.charging ? fv : 0.0f;
-        
+        if (SF_HAS(*f, chg_en)) g_state.charging = (f->chg_en == 1);
+        if (SF_HAS(*f, ichg))   g_state.charger_current = g_state.charging ? f->ichg : 0.0f;
+
         // Signal that voltage data is available for DISPLAY packet.
         has_status2_data = true;
-        
-        xSemaphoreGive(g_state_mtx);
-        return;
+
+        state_publish();
+        return kind;
+    }
+
+    // STATUS_DELTA (pushed on state change): only the fast state fields.
+    // welding= is the live pulse flag (not ready=); contact= only rides here.
+    if (kind == STATUS_PKT_DELTA) {
+        if (SF_HAS(*f, armed))   g_state.armed   = (f->armed == 1);
+        if (SF_HAS(*f, welding)) g_state.welding = (f->welding == 1);
+        if (SF_HAS(*f, contact)) g_state.contact = (f->contact == 1);
+        state_publish();
+        return kind;
     }
 
     // STATUS packet (main telemetry + settings).
-    if (extract_float(line, "temp=", &fv))   g_state.temperature  = fv;
+    if (SF_HAS(*f, temp))   g_state.temperature  = f->temp;
 
     // Contact / cap voltage (prefer canonical weld_v, fall back to vcap).
-    if (extract_float(line, "weld_v=", &fv)) { g_state.weld_v = g_volt_smoother.getDisplayValue(CH_VCAP, fv); weld_v = fv; }
-    else if (extract_float(line, "vcap=", &fv)) { g_state.weld_v = g_volt_smoother.getDisplayValue(CH_VCAP, fv); weld_v = fv; }
-    if (extract_float(line, "cap_v=", &fv))  { g_state.cap_v = fv;  cap_v = fv; }
+    if (SF_HAS(*f, weld_v))    { g_state.weld_v = g_volt_smoother.getDisplayValue(CH_VCAP, f->weld_v); weld_v = f->weld_v; }
+    else if (SF_HAS(*f, vcap)) { g_state.weld_v = g_volt_smoother.getDisplayValue(CH_VCAP, f->vcap);   weld_v = f->vcap; }
+    if (SF_HAS(*f, cap_v))     { g_state.cap_v = f->cap_v;  cap_v = f->cap_v; }
 
-    if (extract_int(line, "armed=", &iv))    g_state.armed   = (iv == 1);
-    if (extract_int(line, "ready=", &iv))    g_state.welding = (iv == 1);
+    if (SF_HAS(*f, armed))  g_state.armed   = (f->armed == 1);
+    if (SF_HAS(*f, welding))    g_state.welding = (f->welding == 1);
+    else if (SF_HAS(*f, ready)) g_state.welding = (f->ready == 1);  // pre-welding= firmware
 
     // Contact/probe hold time (STATUS packet). Each step = 0.5s; the UI shows
     // "Contact X.Xs" from this. Was previously unparsed -> stuck at 0.0s.
-    if (extract_int(line, "contact_hold_steps=", &iv)) {
-        g_state.contact_hold_steps = (uint8_t)iv;
+    if (SF_HAS(*f, contact_hold_steps)) {
+        g_state.contact_hold_steps = (uint8_t)f->contact_hold_steps;
         // A main STATUS packet carries the persisted controller settings; mark
         // that we've seen one so the UI can adopt them once at boot. (STATUS2
         // battery packets don't include this field, so they won't trip it.)
         g_status_received = true;
     }
-    if (extract_int(line, "contact_with_pedal=", &iv))  g_state.contact_with_pedal = (iv == 1);
+    if (SF_HAS(*f, contact_with_pedal)) g_state.contact_with_pedal = (f->contact_with_pedal == 1);
 
     // Charger telemetry (STATUS2 packet): chg_en = charger relay on/off,
     // ichg = charge current in A. Mirror the old ESP32 behaviour and only
     // report current while the charger is actually on (else show 0).
     // These were previously unparsed -> charging gauge stuck at 0.
-    if (extract_int(line, "chg_en=", &iv)) g_state.charging = (iv == 1);
-    if (extract_float(line, "ichg=", &fv)) g_state.charger_current = g_state.charging ? fv : 0.0f;
+    if (SF_HAS(*f, chg_en)) g_state.charging = (f->chg_en == 1);
+    if (SF_HAS(*f, ichg))   g_state.charger_current = g_state.charging ? f->ichg : 0.0f;
 
-    if (extract_float(line, "energy_cap_j=", &fv))  { g_state.energy_cap_j = fv;  energy_cap_j = fv; }
-    if (extract_float(line, "energy_weld_j=", &fv)) { g_state.energy_weld_j = fv; energy_weld_j = fv; }
-    if (extract_float(line, "energy_loss_j=", &fv)) { g_state.energy_loss_j = fv; energy_loss_j = fv; }
+    if (SF_HAS(*f, energy_cap_j))  { g_state.energy_cap_j = f->energy_cap_j;   energy_cap_j = f->energy_cap_j; }
+    if (SF_HAS(*f, energy_weld_j)) { g_state.energy_weld_j = f->energy_weld_j; energy_weld_j = f->energy_weld_j; }
+    if (SF_HAS(*f, energy_loss_j)) { g_state.energy_loss_j = f->energy_loss_j; energy_loss_j = f->energy_loss_j; }
 
     // Recipe sync (so Pulse/Joule tabs reflect the controller).
-    if (extract_int(line, "mode=", &iv))            g_state.weld_mode   = (uint8_t)iv;
-    if (extract_int(line, "d1=", &iv))              g_state.pulse_d1    = (uint16_t)iv;
-    if (extract_int(line, "gap1=", &iv))            g_state.pulse_gap1  = (uint16_t)iv;
-    if (extract_int(line, "d2=", &iv))              g_state.pulse_d2    = (uint16_t)iv;
-    if (extract_int(line, "gap2=", &iv))            g_state.pulse_gap2  = (uint16_t)iv;
-    if (extract_int(line, "d3=", &iv))              g_state.pulse_d3    = (uint16_t)iv;
-    if (extract_int(line, "power=", &iv))           g_state.power_pct   = (uint8_t)iv;
-    if (extract_int(line, "preheat_en=", &iv))      g_state.preheat_enabled = (iv == 1);
-    if (extract_int(line, "preheat_ms=", &iv))      g_state.preheat_ms  = (uint16_t)iv;
-    if (extract_int(line, "preheat_pct=", &iv))     g_state.preheat_pct = (uint8_t)iv;
-    if (extract_int(line, "preheat_gap_ms=", &iv))  g_state.preheat_gap_ms = (uint16_t)iv;
-    if (extract_int(line, "trigger_mode=", &iv))    g_state.trigger_mode = (uint8_t)iv;
+    if (SF_HAS(*f, mode))           g_state.weld_mode   = (uint8_t)f->mode;
+    if (SF_HAS(*f, d1))             g_state.pulse_d1    = (uint16_t)f->d1;
+    if (SF_HAS(*f, gap1))           g_state.pulse_gap1  = (uint16_t)f->gap1;
+    if (SF_HAS(*f, d2))             g_state.pulse_d2    = (uint16_t)f->d2;
+    if (SF_HAS(*f, gap2))           g_state.pulse_gap2  = (uint16_t)f->gap2;
+    if (SF_HAS(*f, d3))             g_state.pulse_d3    = (uint16_t)f->d3;
+    if (SF_HAS(*f, power))          g_state.power_pct   = (uint8_t)f->power;
+    if (SF_HAS(*f, preheat_en))     g_state.preheat_enabled = (f->preheat_en == 1);
+    if (SF_HAS(*f, preheat_ms))     g_state.preheat_ms  = (uint16_t)f->preheat_ms;
+    if (SF_HAS(*f, preheat_pct))    g_state.preheat_pct = (uint8_t)f->preheat_pct;
+    if (SF_HAS(*f, preheat_gap_ms)) g_state.preheat_gap_ms = (uint16_t)f->preheat_gap_ms;
+    if (SF_HAS(*f, trigger_mode))   g_state.trigger_mode = (uint8_t)f->trigger_mode;
 
     // Joule / dashboard mirror.
-    if (extract_int(line, "control_mode=", &iv))    g_state.control_mode = (uint8_t)iv;
-    if (extract_float(line, "joule_target_j=", &fv)) g_state.joule_target_j = fv;
-    if (extract_int(line, "joule_max_ms=", &iv))    g_state.joule_max_ms = (uint16_t)iv;
-    if (extract_float(line, "joule_actual=", &fv))  g_state.joule_actual_j = fv;
-    if (extract_float(line, "lead_r_ohm=", &fv))    g_state.lead_resistance_mohm = fv * 1000.0f;
+    if (SF_HAS(*f, control_mode))   g_state.control_mode = (uint8_t)f->control_mode;
+    if (SF_HAS(*f, joule_target_j)) g_state.joule_target_j = f->joule_target_j;
+    if (SF_HAS(*f, joule_max_ms))   g_state.joule_max_ms = (uint16_t)f->joule_max_ms;
+    if (SF_HAS(*f, joule_actual))   g_state.joule_actual_j = f->joule_actual;
+    if (SF_HAS(*f, lead_r_ohm))     g_state.lead_resistance_mohm = f->lead_r_ohm * 1000.0f;
+
+    // LINK_SPEED needs the capability bit (stm32_task).
+    if (SF_HAS(*f, caps))           s_stm32_caps = (uint32_t)f->caps;
 
-    xSemaphoreGive(g_state_mtx);
+    state_publish();
+    return kind;
 }
 
 // ============================================================
@@ -632,6 +772,7 @@ static void cb_weld_count_reset(void)
 {
     weld_count = 0;
     save_weld_count_to_nvs();
+    weld_log_note_count_reset();   // new SD log segment: ids restart at 1
     stm_send("RESET_WELD_COUNT");  // also tell STM32 (if it has its own counter)
 }
 static void cb_contact_with_pedal(bool en)       { stm_sendf("SET_CONTACT_WITH_PEDAL,%u", en ? 1 : 0); }
@@ -710,10 +851,328 @@ static void lv_tick_task(void *arg) { lv_tick_inc(2); }
 // ============================================================
 //  TASKS
 // ============================================================
+// ---- STM32 RX pipeline ----
+// stm32_task only moves bytes: it waits on the UART event queue, frames
+// lines into a persistent buffer (so a line split across reads — routine for
+// long WAVEFORM_DATA chunks — is reassembled, not cut into two fragments) and
+// posts each complete line to s_parse_rb without ever blocking. Parsing, NVS,
+// the g_state snapshot, STATUS enrichment and the console echo run in
+// stm32_parse_task; TCP relay runs in stm32_bcast_task. A slow console or client therefore backs up a
+// ring (and is counted when it overflows) instead of the UART FIFO.
+struct LineFramer {
+    char   *buf;
+    size_t  len;
+    bool    discarding;   // drop bytes up to the next terminator
+};
+
+static void framer_reset(LineFramer *f, bool discard)
+{
+    f->len = 0;
+    f->discarding = discard;
+}
+
+static void framer_push(LineFramer *f, const uint8_t *bytes, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        char c = (char)bytes[i];
+        if (c == '\r' || c == '\n') {
+            if (!f->discarding && f->len > 0) {
+                f->buf[f->len] = '\0';
+                s_rx_lines++;
+                if (strncmp(f->buf, "EVENT,WELD_DONE", 15) == 0) perf_weld_rx();
+                if (xRingbufferSend(s_parse_rb, f->buf, f->len + 1, 0) != pdTRUE) {
+                    s_rx_parse_drop++;
+                }
+            }
+            framer_reset(f, false);
+        } else if (f->discarding) {
+            continue;
+        } else if (f->len >= BUF_SIZE - 1) {
+            s_rx_overlong++;
+            framer_reset(f, true);
+        } else {
+            f->buf[f->len++] = c;
+        }
+    }
+}
+
+// Link-speed state. stm32_task only.
+static uint8_t  s_link_state       = LINK_BASE;
+static uint32_t s_link_baud        = STM32_BAUD;   // rate UART_NUM_1 runs at
+static uint32_t s_link_deadline_ms = 0;
+static uint32_t s_link_next_try_ms = 0;
+static uint8_t  s_link_attempts    = 0;
+static uint32_t s_link_probe_seq   = 0;
+static uint32_t s_link_frame_errs  = 0;            // UART_FRAME_ERR events
+
+// Retime UART_NUM_1. Anything still in flight at the old rate is junk.
+static void link_set_baud(LineFramer *f, uint32_t baud)
+{
+    uart_wait_tx_done(STM32_UART_NUM, pdMS_TO_TICKS(50));
+    uart_set_baudrate(STM32_UART_NUM, baud);
+    uart_flush_input(STM32_UART_NUM);
+    xQueueReset(s_uart_evt_q);
+    framer_reset(f, true);
+    s_link_baud = baud;
+}
+
+// Back to STM32_BAUD. While still at the fast rate, ask the STM32 to come
+// along; if that line is lost it falls back on its own (trial timeout,
+// rx errors or silence).
+static void link_fallback(LineFramer *f, const char *why, uint32_t now_ms)
+{
+    if (s_link_baud != STM32_BAUD) {
+        stm_sendf("LINK_SPEED,%d", STM32_BAUD);
+        link_set_baud(f, STM32_BAUD);
+        ESP_LOGW(TAG, "STM32 link back to %d baud (%s)", STM32_BAUD, why);
+    }
+    s_link_state = LINK_BASE;
+    s_link_next_try_ms = now_ms + LINK_RETRY_MS;
+}
+
+static void link_send_probe(void)
+{
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char payload[LINK_PROBE_PAYLOAD + 1];
+    for (int i = 0; i < LINK_PROBE_PAYLOAD; i++) payload[i] = alphabet[esp_random() & 63u];
+    payload[LINK_PROBE_PAYLOAD] = '\0';
+    stm_sendf("LINK_PROBE,%lu,%08lX,%s", (unsigned long)s_link_probe_seq,
+              (unsigned long)esp_rom_crc32_le(0, (const uint8_t *)payload, LINK_PROBE_PAYLOAD),
+              payload);
+}
+
+// One step of the LINK_SPEED handshake / committed-link watchdog.
+static void link_service(LineFramer *f, uint32_t now_ms)
+{
+    static uint32_t err_base = 0, err_window_ms = 0;
+    static uint32_t seen_lines = 0, last_line_ms = 0;
+    if (STM32_LINK_FAST_BAUD == 0) return;
+
+    uint8_t  reply = s_link_reply;
+    uint32_t arg   = s_link_reply_arg;
+    if (reply != LINK_REPLY_NONE) s_link_reply = LINK_REPLY_NONE;
+    bool timed_out = (int32_t)(now_ms - s_link_deadline_ms) >= 0;
+
+    if (reply == LINK_REPLY_FALLBACK) {
+        if (s_link_state != LINK_BASE) link_fallback(f, "STM32 fell back", now_ms);
+        return;
+    }
+
+    switch (s_link_state) {
+        case LINK_BASE:
+            if (s_stream_state != STREAM_ACTIVE || !(s_stm32_caps & STM32_CAP_LINK_SPEED) ||
+                s_link_attempts >= LINK_MAX_ATTEMPTS ||
+                (int32_t)(now_ms - s_link_next_try_ms) < 0) {
+                break;
+            }
+            s_link_attempts++;
+            stm_sendf("LINK_SPEED,%d", STM32_LINK_FAST_BAUD);
+            s_link_state = LINK_REQUESTED;
+            s_link_deadline_ms = now_ms + LINK_REPLY_TIMEOUT_MS;
+            break;
+
+        case LINK_REQUESTED:
+            if (reply == LINK_REPLY_SPEED && arg == (uint32_t)STM32_LINK_FAST_BAUD) {
+                link_set_baud(f, STM32_LINK_FAST_BAUD);
+                s_link_probe_seq = 0;
+                link_send_probe();
+                s_link_state = LINK_PROBING;
+                s_link_deadline_ms = now_ms + LINK_REPLY_TIMEOUT_MS;
+            } else if (reply == LINK_REPLY_FAIL) {
+                s_link_attempts = LINK_MAX_ATTEMPTS;   // refused: don't ask again
+                link_fallback(f, "refused", now_ms);
+                ESP_LOGW(TAG, "STM32 refused LINK_SPEED,%d", STM32_LINK_FAST_BAUD);
+            } else if (timed_out) {
+                link_fallback(f, "no LINK_SPEED ack", now_ms);
+            }
+            break;
+
+        case LINK_PROBING:
+            if (reply == LINK_REPLY_PROBE_OK && arg == s_link_probe_seq) {
+                if (++s_link_probe_seq < LINK_PROBE_COUNT) {
+                    link_send_probe();
+                } else {
+                    stm_send("LINK_SPEED,COMMIT");
+                    s_link_state = LINK_COMMITTING;
+                }
+                s_link_deadline_ms = now_ms + LINK_REPLY_TIMEOUT_MS;
+            } else if (reply == LINK_REPLY_FAIL || timed_out) {
+                link_fallback(f, "probe failed", now_ms);
+            }
+            break;
+
+        case LINK_COMMITTING:
+            if (reply == LINK_REPLY_COMMIT) {
+                s_link_state = LINK_FAST;
+                err_base = s_link_frame_errs;
+                err_window_ms = now_ms;
+                seen_lines = s_rx_lines;
+                last_line_ms = now_ms;
+                ESP_LOGI(TAG, "STM32 link at %d baud", STM32_LINK_FAST_BAUD);
+            } else if (reply == LINK_REPLY_FAIL || timed_out) {
+                link_fallback(f, "no COMMIT ack", now_ms);
+            }
+            break;
+
+        case LINK_FAST:
+            if (s_rx_lines != seen_lines) {
+                seen_lines = s_rx_lines;
+                last_line_ms = now_ms;
+            }
+            if (s_link_frame_errs - err_base >= LINK_ERR_LIMIT) {
+                link_fallback(f, "frame errors", now_ms);
+            } else if (now_ms - last_line_ms >= LINK_SILENCE_MS) {
+                link_fallback(f, "silence", now_ms);
+            } else if (now_ms - err_window_ms >= LINK_ERR_WINDOW_MS) {
+                err_base = s_link_frame_errs;
+                err_window_ms = now_ms;
+            }
+            break;
+    }
+}
+
 static void stm32_task(void *arg)
 {
-    ESP_LOGI(TAG, "STM32 comm task started");
-    uint8_t *data = (uint8_t *)malloc(BUF_SIZE);
+    ESP_LOGI(TAG, "STM32 ingest task started");
+    LineFramer framer = {};
+    framer.buf = (char *)malloc(BUF_SIZE);
+    // The first line after boot may start mid-message; drop it.
+    framer_reset(&framer, true);
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    uart_flush_input(STM32_UART_NUM);
+    xQueueReset(s_uart_evt_q);
+
+    uint32_t last_ready_ms = 0;
+    uint32_t last_poll_ms = 0;
+    uint32_t last_stream_req_ms = 0;
+    uint32_t last_health_ms = 0;
+    uint32_t logged_errs = 0;
+    uint8_t  chunk[512];
+
+    while (1) {
+        // Cooperative pause point for the STM32 firmware-flasher (stm32_flash.cpp).
+        // When a remote STM32 update starts, welder_prep_stm32_flash() raises
+        // s_stm32_pause_req and waits until we park HERE — a safe spot where this
+        // task holds no UART driver call and no stdout/state mutex. That lets the
+        // flasher take over UART_NUM_1 (delete+reinstall at 115200 8E1) without
+        // racing this loop. We never resume (the flasher reboots the ESP32
+        // when done), but the loop is written to resume cleanly anyway: the
+        // flasher's driver reinstall replaced our event queue, so reinstall ours.
+        if (s_stm32_pause_req) {
+            // The flasher talks to the application at STM32_BAUD.
+            link_fallback(&framer, "STM32 flash", (uint32_t)(esp_timer_get_time() / 1000ULL));
+            s_stm32_paused = true;
+            while (s_stm32_pause_req) vTaskDelay(pdMS_TO_TICKS(20));
+            uart_driver_delete(STM32_UART_NUM);
+            uart_init();
+            framer_reset(&framer, true);
+            s_stream_state = STREAM_IDLE;
+            s_stream_req_due = true;
+            s_stm32_paused = false;
+        }
+
+        // Wait for bytes. The short timeout keeps the heartbeat/poll timers
+        // below running when the link is quiet.
+        uart_event_t ev;
+        if (xQueueReceive(s_uart_evt_q, &ev, pdMS_TO_TICKS(20)) == pdTRUE) {
+            switch (ev.type) {
+                case UART_DATA: {
+                    size_t avail = 0;
+                    uart_get_buffered_data_len(STM32_UART_NUM, &avail);
+                    while (avail > 0) {
+                        size_t want = avail < sizeof(chunk) ? avail : sizeof(chunk);
+                        int n = uart_read_bytes(STM32_UART_NUM, chunk, want, 0);
+                        if (n <= 0) break;
+                        framer_push(&framer, chunk, (size_t)n);
+                        avail -= (size_t)n;
+                    }
+                    break;
+                }
+                case UART_FIFO_OVF:
+                case UART_BUFFER_FULL:
+                    // Bytes were lost: the line in progress is corrupt (this
+                    // is where "STATrS"-style garbage used to come from).
+                    s_rx_uart_ovf++;
+                    uart_flush_input(STM32_UART_NUM);
+                    xQueueReset(s_uart_evt_q);
+                    framer_reset(&framer, true);
+                    break;
+                case UART_FRAME_ERR:
+                    s_link_frame_errs++;
+                    framer_reset(&framer, true);
+                    break;
+                case UART_PARITY_ERR:
+                    framer_reset(&framer, true);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        // READY heartbeat: STM32 requires periodic READY,1 to keep system_ready
+        // alive (has a 10s timeout). Without this, it stays in ready=0 and
+        // refuses all commands (ARM, WELD, CAL_LEAD_START) with NOT_READY/DENY.
+        uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000ULL);
+        if (now_ms - last_ready_ms >= 1000) {
+            stm_send("READY,1");
+            last_ready_ms = now_ms;
+        }
+
+        // Push telemetry: once the STM32 ACKs STM32_STREAM_CMD it sends STATUS on
+        // its own and STATUS_DELTA the moment state changes, so we stop polling.
+        // Until then (older STM32 firmware, or the STM32 just rebooted and
+        // announced BOOT,...) keep the STATUS poll.
+        if (s_stream_state == STREAM_IDLE &&
+            (s_stream_req_due || now_ms - last_stream_req_ms >= STM32_STREAM_RETRY_MS)) {
+            stm_send(STM32_STREAM_CMD);
+            last_stream_req_ms = now_ms;
+            s_stream_req_due = false;
+        }
+        if (s_stream_state != STREAM_ACTIVE && now_ms - last_poll_ms >= STM32_POLL_MS) {
+            stm_send("STATUS");
+            last_poll_ms = now_ms;
+        }
+
+        link_service(&framer, now_ms);
+
+        // Loss report, at most every 5 s and only when something was lost.
+        uint32_t errs = s_rx_overlong + s_rx_uart_ovf + s_rx_parse_drop + s_rx_bcast_drop;
+        if (errs != logged_errs && now_ms - last_health_ms >= 5000) {
+            last_health_ms = now_ms;
+            logged_errs = errs;
+            ESP_LOGW(TAG, "STM32 RX: lines=%lu overlong=%lu uart_ovf=%lu parse_drop=%lu bcast_drop=%lu",
+                     (unsigned long)s_rx_lines, (unsigned long)s_rx_overlong,
+                     (unsigned long)s_rx_uart_ovf, (unsigned long)s_rx_parse_drop,
+                     (unsigned long)s_rx_bcast_drop);
+        }
+    }
+}
+
+// PERF report: stm32_task's loss counters (perf_stats.cpp).
+extern "C" void welder_get_rx_counters(perf_rx_counters_t *out)
+{
+    out->lines      = s_rx_lines;
+    out->overlong   = s_rx_overlong;
+    out->uart_ovf   = s_rx_uart_ovf;
+    out->parse_drop = s_rx_parse_drop;
+    out->bcast_drop = s_rx_bcast_drop;
+}
+
+// Hand a line to the broadcast stage. Waits briefly so a short TCP hiccup
+// doesn't lose waveform chunks, but never long enough to stall parsing.
+static void bcast_post(const char *line)
+{
+    if (xRingbufferSend(s_bcast_rb, line, strlen(line) + 1, pdMS_TO_TICKS(10)) != pdTRUE) {
+        s_rx_bcast_drop++;
+    }
+}
+
+static char s_enriched[2048];  // enrich_status_line() output (parse task only)
+
+static void stm32_parse_task(void *arg)
+{
+    ESP_LOGI(TAG, "STM32 parse task started");
     vTaskDelay(pdMS_TO_TICKS(1000));
 
     // Load the persistent weld counter from NVS HERE (on this task's internal-
@@ -722,7 +1181,8 @@ static void stm32_task(void *arg)
     // we also call it ourselves (idempotent: returns ESP_OK if already done) so
     // the read works even if prov_task hasn't reached it yet. nvs_flash_init and
     // nvs_get_* both disable the flash cache, so they MUST run from an internal-
-    // RAM stack — which xTaskCreate gives this task.
+    // RAM stack — which xTaskCreate gives this task. This task also increments
+    // and saves the counter (parse_weld_done), so there is a single owner.
     {
         esp_err_t r = nvs_flash_init();
         if (r == ESP_ERR_NVS_NO_FREE_PAGES || r == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -732,114 +1192,145 @@ static void stm32_task(void *arg)
         load_weld_count_from_nvs();
     }
 
-    // Console-echo throttle. The 115200 console is ~17x slower than the 2 Mbaud
-    // STM32 link, so echoing every line floods the console TX buffer, blocks
-    // this read loop, overflows the 2 Mbaud RX FIFO (-> dropped bytes /
-    // "STATrS" corruption) and starves CPU0 idle (-> flicker + task watchdog).
+    // Console-echo throttle. The 115200 console is ~5x slower than the 576k
+    // STM32 link, so echoing every line would back this stage up and starve
+    // CPU idle (-> flicker + task watchdog). It can no longer stall the UART
+    // itself (stm32_task only frames bytes), but the parse ring would fill.
     // Policy:
     //   - STATUS / STATUS2 telemetry: parsed always, but echoed at most 1 Hz.
     //   - STM32's own per-command "DBG,..." echo: never printed (pure noise).
-    //   - Everything else (EVENT / WAVEFORM / RXHEALTH / CAL / errors): printed.
+    //   - WAVEFORM_* : relayed raw; only START/END/PHASES are printed.
+    //   - Everything else (EVENT / RXHEALTH / CAL / errors): printed.
     uint32_t last_status_log_ms = 0;
-    uint32_t last_ready_ms = 0;
-    uint32_t last_display_ms = 0;
+    status_schema_check_log();
 
     while (1) {
-        // Cooperative pause point for the STM32 firmware-flasher (stm32_flash.cpp).
-        // When a remote STM32 update starts, welder_prep_stm32_flash() raises
-        // s_stm32_pause_req and waits until we park HERE — a safe spot where this
-        // task holds no UART driver call and no stdout/state mutex. That lets the
-        // flasher take over UART_NUM_1 (delete+reinstall at 115200 8E1) without
-        // racing this poll loop. We never resume (the flasher reboots the ESP32
-        // when done), but the loop is written to resume cleanly anyway.
-        if (s_stm32_pause_req) {
-            s_stm32_paused = true;
-            while (s_stm32_pause_req) vTaskDelay(pdMS_TO_TICKS(20));
-            s_stm32_paused = false;
+        size_t item_len = 0;
+        char *line = (char *)xRingbufferReceive(s_parse_rb, &item_len, portMAX_DELAY);
+        if (!line) continue;
+
+        // Waveform burst (WAVEFORM_START / _DATA / _BIN / _END /
+        // _PHASES): relay to the TCP clients byte-for-byte and keep
+        // a copy in the PSRAM waveform history. No STATUS parse (a base64 WAVEFORM_BIN
+        // payload can contain any letters) and no console echo of
+        // the bulk chunks — the 115200 console can't keep up.
+        if (strncmp(line, "WAVEFORM_", 9) == 0) {
+            bcast_post(line);
+            wf_history_feed(line, weld_count);
+            wf_plot_feed(line, weld_count);     // Wave-tab min/max decimation
+            weld_log_feed(line, weld_count);    // SD weld log record
+            if (strncmp(line, "WAVEFORM_DATA,", 14) != 0 &&
+                strncmp(line, "WAVEFORM_BIN,", 13) != 0) {
+                ESP_LOGI(TAG, "STM32: %s", line);
+            }
+            vRingbufferReturnItem(s_parse_rb, line);
+            continue;
         }
 
-        // READY heartbeat: STM32 requires periodic READY,1 to keep system_ready
-        // alive (has a 10s timeout). Without this, it stays in ready=0 and
-        // refuses all commands (ARM, WELD, CAL_LEAD_START) with NOT_READY/DENY.
-        uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000ULL);
-        if (now_ms - last_ready_ms >= 1000) {
-            stm_send("READY,1");
-            last_ready_ms = now_ms;
+        // LINK_SPEED handshake. Probe replies carry a long payload; keep
+        // them off the console and the TCP relay.
+        link_parse_reply(line);
+        if (strncmp(line, "ACK,LINK_PROBE,", 15) == 0) {
+            vRingbufferReturnItem(s_parse_rb, line);
+            continue;
+        }
+
+        // Subscription handshake (see s_stream_state).
+        if (strncmp(line, "ACK,STREAM", 10) == 0) {
+            s_stream_state = STREAM_ACTIVE;
+            ESP_LOGI(TAG, "STM32 telemetry push active: %s", line);
+        } else if (strncmp(line, "ERR,UNKNOWN_CMD,rx=STREAM", 25) == 0) {
+            s_stream_state = STREAM_UNSUPPORTED;
+            ESP_LOGW(TAG, "STM32 firmware has no STREAM; polling STATUS");
+        } else if (strncmp(line, "BOOT,", 5) == 0) {
+            // STM32 reset: subscription lost (and it may have been re-flashed).
+            s_stream_state = STREAM_IDLE;
+            s_stream_req_due = true;
+        }
+
+        StatusFields fields;
+        StatusPacketKind kind = parse_status_line(line, &fields);
+
+        bool is_status = (kind != STATUS_PKT_NONE);
+        bool is_dbg    = (strncmp(line, "DBG", 3) == 0);
+        // Lines are framed exactly and a line that lost bytes is dropped in
+        // stm32_task, but the STM32's boot-time noise can still produce a
+        // junk line with no leading command word. Real messages start with
+        // an uppercase letter (STATUS/EVENT/RXHEALTH/CAL/...).
+        bool looks_valid = isupper((unsigned char)line[0]);
+
+        // Forward every genuine STM32 line (STATUS + async events)
+        // to the Flask web client over the TCP bridge. STATUS packets
+        // are enriched with WiFi/system/energy/weld_count (Flask needs
+        // these but STM32 doesn't know them). Other packets forwarded
+        // as-is. Skips STM32's DBG echo and obvious garbage.
+        if (kind == STATUS_PKT_MAIN &&
+            enrich_status_line(line, fields, s_enriched, sizeof(s_enriched))) {
+            bcast_post(s_enriched);
+        } else if (!is_dbg && looks_valid) {
+            bcast_post(line);
+        }
+
+        // Calibration progress (CAL_STATUS / CAL_RESULT / CAL_ERROR).
+        // Update the Config tab status line and log for debugging.
+        bool is_cal = (strncmp(line, "CAL_", 4) == 0);
+        if (is_cal && looks_valid) {
+            ui_notify_cal_message(line);
+            ESP_LOGI(TAG, "STM32: %s", line);
+        }
+
+        // Weld completion: parse last-weld stats for Status dashboard.
+        bool is_weld_done = (strncmp(line, "EVENT,WELD_DONE", 15) == 0);
+        if (is_weld_done && looks_valid) {
+            perf_weld_parsed();
+            parse_weld_done(line);
+            wf_history_feed(line, weld_count);  // opens this weld's history record
+            weld_log_feed(line, weld_count);    // and its SD log record
+            ESP_LOGI(TAG, "STM32: %s", line);
+        }
+
+        if (is_status) {
+            weld_log_poll();  // commit a record whose waveform never ended
+            uint32_t now = (uint32_t)(esp_timer_get_time() / 1000ULL);
+            if (now - last_status_log_ms >= 1000) {
+                last_status_log_ms = now;
+                ESP_LOGI(TAG, "STM32: %s", line);  // 1 Hz heartbeat
+            }
+            // NOTE: no contact-hold "self-heal" here any more. The
+            // STM32 now persists settings in its own flash and is
+            // the source of truth; re-asserting an ESP32-side value
+            // would overwrite what the controller restored at boot.
+        } else if (!is_dbg && !is_cal && !is_weld_done && looks_valid) {
+            ESP_LOGI(TAG, "STM32: %s", line);  // genuine async events
+        }
+
+        vRingbufferReturnItem(s_parse_rb, line);
+    }
+}
+
+static void stm32_bcast_task(void *arg)
+{
+    uint32_t last_display_ms = 0;
+
+    while (1) {
+        size_t item_len = 0;
+        char *line = (char *)xRingbufferReceive(s_bcast_rb, &item_len, pdMS_TO_TICKS(100));
+        if (line) {
+            wifi_bridge_broadcast(line);
+            if (strncmp(line, "EVENT,WELD_DONE", 15) == 0) perf_weld_broadcast();
+            vRingbufferReturnItem(s_bcast_rb, line);
         }
 
         // DISPLAY packet: Flask frontend waits for 'display_update' events to
         // populate battery voltage divs. Send every 1s, but ONLY after STATUS2
         // has populated voltage data (matches OLD ESP32 guard at line 4463).
+        uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000ULL);
         if (now_ms - last_display_ms >= 1000) {
             if (has_status2_data) {
                 send_display_packet();
                 last_display_ms = now_ms;
             }
         }
-
-        stm_send("STATUS");
-        int len = uart_read_bytes(STM32_UART_NUM, data, BUF_SIZE - 1, pdMS_TO_TICKS(150));
-        if (len > 0) {
-            data[len] = '\0';
-            // STM32 may send multiple newline-delimited lines per poll.
-            char *save = NULL;
-            char *line = strtok_r((char *)data, "\r\n", &save);
-            while (line) {
-                parse_status_line(line);
-
-                if (line[0] != '\0') {
-                    // Tolerant prefix match: "STAT" still catches corrupted
-                    // "STATrS"/"STATre" variants so they don't slip through as
-                    // "events" and re-trigger the flood.
-                    bool is_status = (strncmp(line, "STAT", 4) == 0);
-                    bool is_dbg    = (strncmp(line, "DBG", 3) == 0);
-                    // Filter obvious garbage: boot-time dropped bytes can create
-                    // fragments like ",joule_status=..." that don't start with an
-                    // uppercase letter. Real messages start with STAT/EVENT/RXHEALTH/CAL.
-                    bool looks_valid = isupper((unsigned char)line[0]);
-
-                    // Forward every genuine STM32 line (STATUS + async events)
-                    // to the Flask web client over the TCP bridge. STATUS packets
-                    // are enriched with WiFi/system/energy/weld_count (Flask needs
-                    // these but STM32 doesn't know them). Other packets forwarded
-                    // as-is. Skips STM32's DBG echo and obvious garbage.
-                    if (!is_dbg && looks_valid) {
-                        enrich_and_broadcast(line);
-                    }
-
-                    // Calibration progress (CAL_STATUS / CAL_RESULT / CAL_ERROR).
-                    // Update the Config tab status line and log for debugging.
-                    bool is_cal = (strncmp(line, "CAL_", 4) == 0);
-                    if (is_cal && looks_valid) {
-                        ui_notify_cal_message(line);
-                        ESP_LOGI(TAG, "STM32: %s", line);
-                    }
-
-                    // Weld completion: parse last-weld stats for Status dashboard.
-                    bool is_weld_done = (strncmp(line, "EVENT,WELD_DONE", 15) == 0);
-                    if (is_weld_done && looks_valid) {
-                        parse_weld_done(line);
-                        ESP_LOGI(TAG, "STM32: %s", line);
-                    }
-
-                    if (is_status) {
-                        uint32_t now = (uint32_t)(esp_timer_get_time() / 1000ULL);
-                        if (now - last_status_log_ms >= 1000) {
-                            last_status_log_ms = now;
-                            ESP_LOGI(TAG, "STM32: %s", line);  // 1 Hz heartbeat
-                        }
-                        // NOTE: no contact-hold "self-heal" here any more. The
-                        // STM32 now persists settings in its own flash and is
-                        // the source of truth; re-asserting an ESP32-side value
-                        // would overwrite what the controller restored at boot.
-                    } else if (!is_dbg && !is_cal && !is_weld_done && looks_valid) {
-                        ESP_LOGI(TAG, "STM32: %s", line);  // genuine async events
-                    }
-                }
-                line = strtok_r(NULL, "\r\n", &save);
-            }
-        }
-        vTaskDelay(pdMS_TO_TICKS(200));
     }
 }
 
@@ -859,14 +1350,16 @@ static void lvgl_task(void *arg)
             ui_set_touch_active(st == LV_INDEV_STATE_PRESSED);
         }
 
-        // Push fresh telemetry into the UI ~10 Hz.
+        // Push fresh telemetry into the UI ~10 Hz. The snapshot is only
+        // re-copied when a new version was published; ui_update still runs
+        // every tick (uptime/heap, touch cooldown) on the cached copy.
         if (now - last_ui >= 100) {
             last_ui = now;
-            WelderDisplayState snap;
-            xSemaphoreTake(g_state_mtx, portMAX_DELAY);
-            snap = g_state;
-            xSemaphoreGive(g_state_mtx);
+            static WelderDisplayState snap;
+            static uint32_t snap_ver = UINT32_MAX;
+            if (state_version() != snap_ver) snap_ver = state_read(&snap);
             ui_update(snap);
+            perf_weld_ui();  // first refresh after a WELD_DONE: dashboard lag
 
             // One-shot "load last settings on boot": once the STM32 has sent a
             // real STATUS, adopt its flash-restored controller settings into the
@@ -893,7 +1386,9 @@ static void lvgl_task(void *arg)
         // AP setup portal came up after an erase-flash).
         ui_poll_deferred();
 
+        int64_t frame_t0 = esp_timer_get_time();
         lv_timer_handler();
+        perf_record_us(PERF_LVGL_FRAME, (uint32_t)(esp_timer_get_time() - frame_t0));
 
         // CRITICAL: this delay MUST block for at least 1 RTOS tick so the
         // IDLE0 task on CPU0 gets to run and feed the task watchdog.
@@ -935,7 +1430,7 @@ extern "C" void welder_prep_stm32_flash(void)
         ESP_LOGI(TAG, "stm32_task parked for STM32 flash");
     } else {
         // HARD FALLBACK: the task did not reach its cooperative pause point in
-        // time. If we proceed now, it keeps running its poll loop — sending
+        // time. If we proceed now, it keeps running its ingest loop — sending
         // READY,1/STATUS and calling uart_read_bytes on UART_NUM_1 — which
         // INTERLEAVES with the BOOTLOADER command (so the STM32 never sees a
         // clean token and never jumps) and STEALS the app's ACK reply. Force a
@@ -944,7 +1439,7 @@ extern "C" void welder_prep_stm32_flash(void)
         if (s_stm32_task_handle) {
             vTaskSuspend(s_stm32_task_handle);
             // CRITICAL (deadlock fix): vTaskSuspend froze the task wherever it
-            // happened to be — almost always INSIDE uart_read_bytes() or
+            // happened to be — often INSIDE uart_read_bytes() or
             // uart_write_bytes(), holding UART_NUM_1's rx_mux / tx_mux. If we
             // leave the driver installed, the flasher's NEXT UART call
             // (uart_flush_input / uart_wait_tx_done / uart_driver_delete inside
@@ -1034,11 +1529,12 @@ extern "C" void app_main(void)
     }
 
     // Shared welder state defaults.
-    g_state_mtx = xSemaphoreCreateMutex();
     memset(&g_state, 0, sizeof(g_state));
     g_state.weld_mode = 1;
     g_state.power_pct = 80;
     g_state.trigger_mode = 1;
+    memset(&g_state_pub, 0, sizeof(g_state_pub));
+    state_publish();  // version 1: the defaults, before any task runs
 
     i2c_and_backlight_init();
     uart_init();
@@ -1122,6 +1618,7 @@ extern "C" void app_main(void)
     if (!sd_flash_init()) {
         ESP_LOGW(TAG, "SD card init failed — firmware update from SD disabled");
     }
+    weld_log_init();  // SD weld log writer; idles until a card is mounted
 
     vTaskDelay(pdMS_TO_TICKS(100));
     backlight_set(100);
@@ -1148,7 +1645,7 @@ extern "C" void app_main(void)
         ESP_LOGW(TAG, "Touch init failed - UI will be display-only");
     }
 
-    // ---- Register UI callbacks + build the ported 5-tab UI ----
+    // ---- Register UI callbacks + build the ported 6-tab UI ----
     ui_set_config_cb(cb_config_change);
     ui_set_trigger_source_cb(cb_trigger_source);
     ui_set_weld_count_reset_cb(cb_weld_count_reset);
@@ -1186,6 +1683,14 @@ extern "C" void app_main(void)
 
     // ---- Tasks ----
     xTaskCreatePinnedToCore(lvgl_task, "lvgl", 16384, NULL, 5, NULL, 0);
+    // STM32 RX pipeline: ingest (stm32_task) -> parse -> broadcast. The rings
+    // hold NUL-terminated lines (NOSPLIT: each item is one contiguous line).
+    s_parse_rb = xRingbufferCreate(PARSE_RING_SIZE, RINGBUF_TYPE_NOSPLIT);
+    s_bcast_rb = xRingbufferCreate(BCAST_RING_SIZE, RINGBUF_TYPE_NOSPLIT);
+    wf_history_init();  // PSRAM store fed by stm32_parse_task (WAVEFORM_GET)
+    wf_plot_init();     // Wave-tab decimator, also fed by stm32_parse_task
+    xTaskCreatePinnedToCore(stm32_bcast_task, "stm32_bc", 6144, NULL, 3, NULL, 1);
+    xTaskCreatePinnedToCore(stm32_parse_task, "stm32_rx", 6144, NULL, 3, NULL, 1);
     xTaskCreatePinnedToCore(stm32_task, "stm32", 6144, NULL, 4,
                             &s_stm32_task_handle, 1);
 
@@ -1196,12 +1701,12 @@ extern "C" void app_main(void)
     // TCP bridge (port 8888) are forwarded straight to the STM32 via stm_send.
     wifi_bridge_start(stm_send);
 
-    // NOTE: the persistent weld counter is loaded from NVS inside stm32_task()
-    // — NOT here. On this board the app_main (main task) stack lives in PSRAM,
+    // NOTE: the persistent weld counter is loaded from NVS inside
+    // stm32_parse_task() — NOT here. On this board the app_main (main task) stack lives in PSRAM,
     // and any SPI-flash op (nvs_get_*) disables the flash cache, which makes the
     // PSRAM stack unreachable -> assert in esp_task_stack_is_sane_cache_disabled().
-    // stm32_task is created with xTaskCreate (internal-RAM stack), so the NVS
-    // read is safe there. It is also the task that increments/saves the counter,
+    // stm32_parse_task is created with xTaskCreate (internal-RAM stack), so the
+    // NVS read is safe there. It is also the task that increments/saves the counter,
     // so there is no cross-task race. (Same reasoning as wifi_bridge's prov_task.)
 
     ESP_LOGI(TAG, "System initialized - welder UI running");
@@ -16,6 +16,7 @@
 #include "esp_event.h"
 #include "esp_mac.h"
 #include "esp_timer.h"
+#include "esp_heap_caps.h"
 #include "esp_netif.h"
 #include "nvs_flash.h"
 #include "nvs.h"
@@ -28,6 +29,10 @@
 #include "ui.h"   // ui_set_wifi_info / ui_show_wifi_setup / ui_hide_wifi_setup
 #include "ota.h"  // ota_register_handler (OTA firmware update over WiFi)
 #include "stm32_flash.h"  // stm32_flash_register_handler (wireless STM32 update)
+#include "waveform_history.h"  // WAVEFORM_GET / GET /waveform (stored weld captures)
+#include "weld_log.h"   // WELDLOG / WELDLOG_GET / GET /weldlog (SD weld log)
+#include "perf_stats.h" // PERF / PERF_RESET (latency histograms)
+#include "esp_netif_sntp.h"  // wall clock for weld log timestamps
 
 static const char *TAG = "WIFI_BRIDGE";
 
@@ -37,6 +42,7 @@ static const char *TAG = "WIFI_BRIDGE";
 #define NVS_WIFI_NS              "wificfg"
 #define NVS_KEY_SSID             "ssid"
 #define NVS_KEY_PASS             "pass"
+#define NVS_KEY_MCAST            "mcast"    // u8: UDP telemetry on/off
 
 #define TCP_BRIDGE_PORT          8888       // Flask <-> P4 bridge (matches old S3 build)
 #define MDNS_HOSTNAME            "spotwelder"
@@ -46,6 +52,16 @@ static const char *TAG = "WIFI_BRIDGE";
 #define STA_CONNECT_TIMEOUT_MS   20000      // fall back to AP portal after this
 #define STA_MAX_FAST_RETRIES     5          // immediate retries inside the window
 
+// UDP telemetry (see the MULTICAST section). Administratively-scoped group,
+// TTL 1 so it stays on the welder LAN. MCAST_USE_BROADCAST=1 sends to
+// 255.255.255.255 instead (for switches/APs that drop multicast).
+#define MCAST_GROUP              "239.255.88.88"
+#define MCAST_PORT               8889
+#define MCAST_TTL                1
+#define MCAST_USE_BROADCAST      0
+#define MCAST_ANNOUNCE_MS        5000
+#define MCAST_MAX_DATAGRAM       1400       // one WiFi frame, no IP fragments
+
 #define WIFI_CONNECTED_BIT       BIT0
 #define WIFI_FAIL_BIT            BIT1
 
@@ -73,15 +89,69 @@ static uint32_t          s_sta_attempt_ms = 0;
 static int               s_fast_retries   = 0;
 static bool              s_started        = false;
 static bool              s_mdns_up        = false;
+static bool              s_sntp_up        = false;
 
 static char              s_scan_options[2048] = {0};  // cached <option> list
 
+static volatile bool     s_mcast_enabled  = false;  // NVS_KEY_MCAST
+static SemaphoreHandle_t s_mcast_mtx      = NULL;   // socket, seq, s_mcast_buf
+static int               s_mcast_sock     = -1;
+static uint32_t          s_mcast_seq      = 0;
+static uint32_t          s_mcast_drops    = 0;      // oversize / sendto failed
+static uint32_t          s_mcast_announce_ms = 0;
+static volatile bool     s_mcast_announce_due = false;
+static char              s_mcast_node[32] = {0};    // "spotwelder-AB12"
+static char              s_mcast_buf[MCAST_MAX_DATAGRAM];
+
 static wifi_bridge_cmd_cb_t s_cmd_cb = NULL;
 
 // TCP bridge: multi-client support (up to MAX_BRIDGE_CLIENTS simultaneous connections)
-#define MAX_BRIDGE_CLIENTS  5
-static int               s_clients[MAX_BRIDGE_CLIENTS];  // client sockets; -1 = unused slot
+//
+// Outbound lines are never sent from the caller's task. wifi_bridge_broadcast()
+// only copies the line into each client's queues (under s_client_mtx, no
+// socket calls); bridge_tx_task drains them, coalescing small lines into
+// ~MSS-sized send()s and keeping a short write staged until it completes, so
+// a slow client never gets a torn line. Two queues per client:
+//   - crit: EVENT / WAVEFORM_* / STATUS_DELTA / replies — never dropped. If it
+//           overflows the client is disconnected (it reconnects with clean
+//           framing) instead of silently losing a line.
+//   - tel : STATUS / STATUS2 / DISPLAY — periodic snapshots; on overflow the
+//           OLDEST are dropped (the next one supersedes them anyway).
+// Only bridge_tx_task closes client sockets; the RX task and the portal just
+// shutdown() / flag the slot, so a socket fd is never reused under a write.
+#define MAX_BRIDGE_CLIENTS     5
+#define BRIDGE_CRIT_QUEUE_SIZE (32 * 1024)
+#define BRIDGE_TEL_QUEUE_SIZE  (8 * 1024)
+#define BRIDGE_TX_STAGE_SIZE   (8 * 1024 + 64)   // > longest line (WAVEFORM_DATA)
+#define BRIDGE_TX_COALESCE     1436              // one Ethernet-MTU TCP segment
+#define BRIDGE_TX_POLL_MS      20                // retry slow (EAGAIN) clients
+#define BRIDGE_REPLAY_QUEUE_MAX (BRIDGE_CRIT_QUEUE_SIZE / 2) // room kept for live lines
+#define BRIDGE_REPLAY_STALL_MS 5000              // give up on a client that stops reading
+
+// Byte ring of length-prefixed lines ([len lo][len hi][bytes incl. '\n']).
+typedef struct {
+    uint8_t *buf;
+    size_t   size;
+    size_t   head;   // write index
+    size_t   tail;   // read index
+    size_t   used;
+} line_ring_t;
+
+typedef struct {
+    int         sock;        // client socket; -1 = unused slot
+    bool        closing;     // RX side is gone; bridge_tx_task closes the socket
+    bool        kicked;      // shutdown() issued (send error / crit overflow)
+    line_ring_t crit;
+    line_ring_t tel;
+    char       *tx_buf;      // staged bytes being written (whole lines only)
+    size_t      tx_len;
+    size_t      tx_off;
+    wifi_bridge_client_stats_t stats;
+} bridge_client_t;
+
+static bridge_client_t   s_clients[MAX_BRIDGE_CLIENTS];
 static SemaphoreHandle_t s_client_mtx     = NULL;
+static TaskHandle_t      s_bridge_tx_task = NULL;
 
 static inline uint32_t now_ms(void) { return (uint32_t)(esp_timer_get_time() / 1000ULL); }
 
@@ -97,6 +167,8 @@ static void nvs_load_creds(void)
         nvs_get_str(h, NVS_KEY_SSID, s_ssid, &n);
         n = sizeof(s_pass);
         nvs_get_str(h, NVS_KEY_PASS, s_pass, &n);
+        uint8_t mcast = 0;
+        if (nvs_get_u8(h, NVS_KEY_MCAST, &mcast) == ESP_OK) s_mcast_enabled = (mcast != 0);
         nvs_close(h);
     }
     ESP_LOGI(TAG, "Creds from NVS: ssid='%s' (%s)", s_ssid,
@@ -117,6 +189,16 @@ static void nvs_save_creds(const char *ssid, const char *pass)
     }
 }
 
+static void nvs_save_mcast(bool enable)
+{
+    nvs_handle_t h;
+    if (nvs_open(NVS_WIFI_NS, NVS_READWRITE, &h) == ESP_OK) {
+        nvs_set_u8(h, NVS_KEY_MCAST, enable ? 1 : 0);
+        nvs_commit(h);
+        nvs_close(h);
+    }
+}
+
 void wifi_bridge_factory_reset(void)
 {
     nvs_handle_t h;
@@ -161,24 +243,6 @@ static void push_wifi_info_to_ui(void)
 // ============================================================
 //  TCP BRIDGE (Flask dashboard) — port 8888
 // ============================================================
-void wifi_bridge_broadcast(const char *line)
-{
-    if (!line || !line[0] || !s_client_mtx) return;
-    xSemaphoreTake(s_client_mtx, portMAX_DELAY);
-    // Broadcast to ALL connected clients (Flask, MobaXterm, etc.)
-    for (int i = 0; i < MAX_BRIDGE_CLIENTS; i++) {
-        int sock = s_clients[i];
-        if (sock >= 0) {
-            // Append newline so the Flask side can split on lines.
-            // send() is non-blocking with MSG_DONTWAIT — if a client is slow/dead,
-            // we don't stall the broadcast for the others.
-            send(sock, line, strlen(line), MSG_DONTWAIT);
-            send(sock, "\n", 1, MSG_DONTWAIT);
-        }
-    }
-    xSemaphoreGive(s_client_mtx);
-}
-
 bool wifi_bridge_get_info(bool *out_connected, bool *out_ap_mode,
                           char *out_ssid, char *out_ip, int *out_rssi)
 {
@@ -214,6 +278,530 @@ bool wifi_bridge_get_info(bool *out_connected, bool *out_ap_mode,
     return connected;
 }
 
+// ============================================================
+//  UDP MULTICAST TELEMETRY (opt-in) — group MCAST_GROUP:MCAST_PORT
+// ============================================================
+// One datagram per STATUS / STATUS2 / STATUS_DELTA / EVENT line, sent once
+// no matter how many loggers or wall displays listen (TCP clients still each
+// get their own copy over the bridge). Each datagram is two lines:
+//   MCAST,host=<mDNS host>,node=<host>-<MAC4>,seq=<n>
+//   <the original line, unchanged>
+// seq counts every datagram from this welder (announces included), so a gap
+// means loss. ANNOUNCE lines (every MCAST_ANNOUNCE_MS) let consumers find
+// welders without scanning. Off by default; persisted in NVS (NVS_KEY_MCAST)
+// and toggled by the MCAST,<0|1> bridge command or wifi_bridge_set_multicast().
+// Only sent while STA-connected.
+static void mcast_build_node_id(void)
+{
+    if (s_mcast_node[0]) return;
+    uint8_t mac[6] = {0};
+    esp_wifi_get_mac(WIFI_IF_STA, mac);
+    snprintf(s_mcast_node, sizeof(s_mcast_node), "%s-%02X%02X", MDNS_HOSTNAME, mac[4], mac[5]);
+}
+
+// s_mcast_mtx held.
+static bool mcast_open(void)
+{
+    if (s_mcast_sock >= 0) return true;
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "mcast: socket() failed: errno %d", errno);
+        return false;
+    }
+#if MCAST_USE_BROADCAST
+    int bc = 1;
+    setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &bc, sizeof(bc));
+#else
+    uint8_t ttl = MCAST_TTL, loop = 0;
+    setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+#endif
+    s_mcast_sock = sock;
+    mcast_build_node_id();
+    return true;
+}
+
+// Send one tagged datagram. Never blocks; a full lwIP queue counts as a drop.
+static void mcast_send_line(const char *line)
+{
+    if (s_state != PROV_STA_CONNECTED || !s_mcast_mtx) return;
+    xSemaphoreTake(s_mcast_mtx, portMAX_DELAY);
+    if (!s_mcast_enabled || !mcast_open()) {
+        xSemaphoreGive(s_mcast_mtx);
+        return;
+    }
+    uint32_t seq = s_mcast_seq++;
+    int n = snprintf(s_mcast_buf, sizeof(s_mcast_buf), "MCAST,host=%s,node=%s,seq=%lu\n%s\n",
+                     MDNS_HOSTNAME, s_mcast_node, (unsigned long)seq, line);
+    if (n < 0 || n >= (int)sizeof(s_mcast_buf)) {
+        s_mcast_drops++;   // longer than one datagram: TCP-only
+    } else {
+        struct sockaddr_in dst = {};
+        dst.sin_family = AF_INET;
+        dst.sin_port   = htons(MCAST_PORT);
+#if MCAST_USE_BROADCAST
+        dst.sin_addr.s_addr = htonl(INADDR_BROADCAST);
+#else
+        dst.sin_addr.s_addr = inet_addr(MCAST_GROUP);
+#endif
+        if (sendto(s_mcast_sock, s_mcast_buf, n, MSG_DONTWAIT,
+                   (struct sockaddr *)&dst, sizeof(dst)) < 0) {
+            s_mcast_drops++;
+        }
+    }
+    xSemaphoreGive(s_mcast_mtx);
+}
+
+static bool mcast_line_is_published(const char *line)
+{
+    return strncmp(line, "STATUS", 6) == 0 || strncmp(line, "EVENT,", 6) == 0;
+}
+
+// Discovery beacon. Called from prov_task's 200 ms loop.
+static void mcast_service(uint32_t now)
+{
+    if (!s_mcast_enabled || s_state != PROV_STA_CONNECTED) return;
+    if (!s_mcast_announce_due && now - s_mcast_announce_ms < MCAST_ANNOUNCE_MS) return;
+    s_mcast_announce_due = false;
+    s_mcast_announce_ms = now;
+
+    char ip[16] = {0};
+    esp_netif_ip_info_t ipi;
+    if (s_sta_netif && esp_netif_get_ip_info(s_sta_netif, &ipi) == ESP_OK) {
+        snprintf(ip, sizeof(ip), IPSTR, IP2STR(&ipi.ip));
+    }
+    mcast_build_node_id();
+    char line[192];
+    snprintf(line, sizeof(line),
+             "ANNOUNCE,host=%s,node=%s,ip=%s,tcp_port=%d,mcast_port=%d,"
+             "uptime_s=%lu,mcast_drops=%lu",
+             MDNS_HOSTNAME, s_mcast_node, ip, TCP_BRIDGE_PORT, MCAST_PORT,
+             (unsigned long)(esp_timer_get_time() / 1000000ULL),
+             (unsigned long)s_mcast_drops);
+    mcast_send_line(line);
+}
+
+void wifi_bridge_set_multicast(bool enable)
+{
+    if (!s_mcast_mtx) return;
+    xSemaphoreTake(s_mcast_mtx, portMAX_DELAY);
+    s_mcast_enabled = enable;
+    if (!enable && s_mcast_sock >= 0) {
+        close(s_mcast_sock);
+        s_mcast_sock = -1;
+    }
+    s_mcast_announce_due = enable;
+    xSemaphoreGive(s_mcast_mtx);
+    nvs_save_mcast(enable);
+    if (s_mdns_up) mdns_service_txt_item_set("_spotwelder-tlm", "_udp", "mcast", enable ? "1" : "0");
+    ESP_LOGI(TAG, "UDP telemetry %s (%s:%d)", enable ? "ON" : "OFF",
+             MCAST_USE_BROADCAST ? "broadcast" : MCAST_GROUP, MCAST_PORT);
+}
+
+bool wifi_bridge_multicast_enabled(void) { return s_mcast_enabled; }
+
+// ---- Per-client send queues (see the TCP bridge notes in STATE) ----
+static void line_ring_copy_in(line_ring_t *r, const void *src, size_t n)
+{
+    const uint8_t *s = (const uint8_t *)src;
+    size_t first = r->size - r->head;
+    if (first > n) first = n;
+    memcpy(r->buf + r->head, s, first);
+    memcpy(r->buf, s + first, n - first);
+    r->head = (r->head + n) % r->size;
+    r->used += n;
+}
+
+static void line_ring_copy_out(line_ring_t *r, void *dst, size_t n)
+{
+    uint8_t *d = (uint8_t *)dst;
+    size_t first = r->size - r->tail;
+    if (first > n) first = n;
+    if (d) {
+        memcpy(d, r->buf + r->tail, first);
+        memcpy(d + first, r->buf, n - first);
+    }
+    r->tail = (r->tail + n) % r->size;
+    r->used -= n;
+}
+
+// Length (including the trailing '\n') of the oldest queued line.
+static size_t line_ring_peek_len(const line_ring_t *r)
+{
+    return (size_t)r->buf[r->tail] | ((size_t)r->buf[(r->tail + 1) % r->size] << 8);
+}
+
+static bool line_ring_push(line_ring_t *r, const char *line, size_t len)
+{
+    size_t n = len + 1;
+    if (r->used + 2 + n > r->size) return false;
+    uint8_t hdr[2] = { (uint8_t)(n & 0xFF), (uint8_t)(n >> 8) };
+    line_ring_copy_in(r, hdr, 2);
+    line_ring_copy_in(r, line, len);
+    line_ring_copy_in(r, "\n", 1);
+    return true;
+}
+
+// Pop the oldest line into dst (NULL = discard). Returns its length.
+static size_t line_ring_pop(line_ring_t *r, char *dst)
+{
+    size_t n = line_ring_peek_len(r);
+    line_ring_copy_out(r, NULL, 2);
+    line_ring_copy_out(r, dst, n);
+    return n;
+}
+
+static void line_ring_reset(line_ring_t *r)
+{
+    r->head = r->tail = r->used = 0;
+}
+
+// Periodic snapshots that a newer copy supersedes. Everything else (events,
+// waveform framing, replies, STATUS_DELTA) must arrive intact and in order.
+static bool bridge_line_is_telemetry(const char *line)
+{
+    return strncmp(line, "STATUS,", 7) == 0 ||
+           strncmp(line, "STATUS2,", 8) == 0 ||
+           strncmp(line, "DISPLAY,", 8) == 0;
+}
+
+// Allocate a slot's queues on first use (PSRAM; kept for reuse) and reset.
+static bool bridge_client_init(bridge_client_t *c)
+{
+    if (!c->crit.buf) {
+        c->crit.buf = (uint8_t *)heap_caps_malloc(BRIDGE_CRIT_QUEUE_SIZE, MALLOC_CAP_SPIRAM);
+        c->crit.size = BRIDGE_CRIT_QUEUE_SIZE;
+    }
+    if (!c->tel.buf) {
+        c->tel.buf = (uint8_t *)heap_caps_malloc(BRIDGE_TEL_QUEUE_SIZE, MALLOC_CAP_SPIRAM);
+        c->tel.size = BRIDGE_TEL_QUEUE_SIZE;
+    }
+    if (!c->tx_buf) {
+        c->tx_buf = (char *)heap_caps_malloc(BRIDGE_TX_STAGE_SIZE, MALLOC_CAP_SPIRAM);
+    }
+    if (!c->crit.buf || !c->tel.buf || !c->tx_buf) return false;
+    line_ring_reset(&c->crit);
+    line_ring_reset(&c->tel);
+    c->tx_len = c->tx_off = 0;
+    c->closing = false;
+    c->kicked  = false;
+    memset(&c->stats, 0, sizeof(c->stats));
+    return true;
+}
+
+// Disconnect a client without closing the fd (bridge_tx_task does that once
+// the RX task has seen the shutdown and flagged the slot). s_client_mtx held.
+static void bridge_client_kick(bridge_client_t *c)
+{
+    if (c->kicked) return;
+    shutdown(c->sock, SHUT_RDWR);
+    c->kicked = true;
+}
+
+// Queue one line for one client. s_client_mtx held.
+static void bridge_client_enqueue(bridge_client_t *c, int slot, const char *line,
+                                  size_t len, bool telemetry)
+{
+    if (len + 1 > BRIDGE_TX_STAGE_SIZE) {
+        c->stats.too_long++;
+        return;
+    }
+    if (telemetry) {
+        while (!line_ring_push(&c->tel, line, len)) {
+            if (!c->tel.used) {
+                c->stats.too_long++;
+                return;
+            }
+            line_ring_pop(&c->tel, NULL);
+            c->stats.tel_dropped++;
+        }
+    } else if (!line_ring_push(&c->crit, line, len)) {
+        ESP_LOGW(TAG, "Client slot %d: send queue full (%u B) -> disconnecting",
+                 slot, (unsigned)c->crit.used);
+        c->stats.overflows++;
+        bridge_client_kick(c);
+        return;
+    }
+    if (c->crit.used > c->stats.crit_high_water) c->stats.crit_high_water = (uint32_t)c->crit.used;
+}
+
+// Move whole queued lines into the stage buffer: telemetry first (a few
+// small lines, keeps dashboards live during a waveform dump), then the
+// critical queue, up to BRIDGE_TX_COALESCE bytes (a single longer line is
+// staged on its own). s_client_mtx held.
+static void bridge_client_stage(bridge_client_t *c)
+{
+    c->tx_len = c->tx_off = 0;
+    while (c->tel.used || c->crit.used) {
+        line_ring_t *r = c->tel.used ? &c->tel : &c->crit;
+        size_t n = line_ring_peek_len(r);
+        if (c->tx_len > 0 && c->tx_len + n > BRIDGE_TX_COALESCE) break;
+        c->tx_len += line_ring_pop(r, c->tx_buf + c->tx_len);
+    }
+}
+
+// One write attempt for one slot. Returns true if bytes were written and
+// more are pending (the caller loops until every client is idle/blocked).
+static bool bridge_client_service(int slot)
+{
+    bridge_client_t *c = &s_clients[slot];
+
+    xSemaphoreTake(s_client_mtx, portMAX_DELAY);
+    if (c->sock < 0) {
+        xSemaphoreGive(s_client_mtx);
+        return false;
+    }
+    if (c->closing) {
+        close(c->sock);
+        c->sock = -1;
+        xSemaphoreGive(s_client_mtx);
+        ESP_LOGI(TAG, "Client slot %d closed (sent %lu B in %lu writes, tel_dropped=%lu)",
+                 slot, (unsigned long)c->stats.bytes, (unsigned long)c->stats.writes,
+                 (unsigned long)c->stats.tel_dropped);
+        return false;
+    }
+    if (c->kicked) {
+        xSemaphoreGive(s_client_mtx);
+        return false;
+    }
+    if (c->tx_off >= c->tx_len) bridge_client_stage(c);
+    int sock = c->sock;
+    const char *p = c->tx_buf + c->tx_off;
+    size_t n = c->tx_len - c->tx_off;
+    xSemaphoreGive(s_client_mtx);
+
+    if (n == 0) return false;
+    // The stage buffer is only touched by this task and the socket is only
+    // closed by this task, so the write runs without the mutex.
+    int64_t t0 = esp_timer_get_time();
+    int sent = send(sock, p, n, MSG_DONTWAIT);
+    int err = errno;
+    perf_record_us(PERF_TCP_SEND, (uint32_t)(esp_timer_get_time() - t0));
+
+    xSemaphoreTake(s_client_mtx, portMAX_DELAY);
+    bool more = false;
+    if (sent > 0) {
+        c->tx_off += (size_t)sent;
+        c->stats.writes++;
+        c->stats.bytes += (uint32_t)sent;
+        more = (c->tx_off < c->tx_len) || c->crit.used || c->tel.used;
+    } else if (sent < 0 && err != EAGAIN && err != EWOULDBLOCK) {
+        ESP_LOGW(TAG, "Client slot %d: send errno %d -> disconnecting", slot, err);
+        bridge_client_kick(c);
+    }
+    xSemaphoreGive(s_client_mtx);
+    return more;
+}
+
+static void bridge_tx_task(void *arg)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(BRIDGE_TX_POLL_MS));
+        bool more;
+        do {
+            more = false;
+            for (int i = 0; i < MAX_BRIDGE_CLIENTS; i++) {
+                if (bridge_client_service(i)) more = true;
+            }
+        } while (more);
+    }
+}
+
+void wifi_bridge_broadcast(const char *line)
+{
+    if (!line || !line[0] || !s_client_mtx) return;
+    size_t len = strlen(line);
+    bool telemetry = bridge_line_is_telemetry(line);
+    xSemaphoreTake(s_client_mtx, portMAX_DELAY);
+    // Broadcast to ALL connected clients (Flask, MobaXterm, etc.)
+    for (int i = 0; i < MAX_BRIDGE_CLIENTS; i++) {
+        bridge_client_t *c = &s_clients[i];
+        if (c->sock >= 0 && !c->closing && !c->kicked) {
+            bridge_client_enqueue(c, i, line, len, telemetry);
+        }
+    }
+    xSemaphoreGive(s_client_mtx);
+    if (s_bridge_tx_task) xTaskNotifyGive(s_bridge_tx_task);
+
+    if (s_mcast_enabled && mcast_line_is_published(line)) mcast_send_line(line);
+}
+
+bool wifi_bridge_get_client_stats(int slot, wifi_bridge_client_stats_t *out)
+{
+    if (slot < 0 || slot >= MAX_BRIDGE_CLIENTS || !out || !s_client_mtx) return false;
+    bridge_client_t *c = &s_clients[slot];
+    xSemaphoreTake(s_client_mtx, portMAX_DELAY);
+    bool connected = (c->sock >= 0 && !c->closing && !c->kicked);
+    *out = c->stats;
+    if (connected) {
+        out->crit_depth = (uint32_t)c->crit.used;
+        out->tel_depth  = (uint32_t)c->tel.used;
+    } else {
+        out->crit_depth = out->tel_depth = 0;
+    }
+    xSemaphoreGive(s_client_mtx);
+    return connected;
+}
+
+// Queue a locally generated reply for one client (critical queue).
+static void bridge_reply_line(int to_slot, const char *line)
+{
+    xSemaphoreTake(s_client_mtx, portMAX_DELAY);
+    bridge_client_t *c = &s_clients[to_slot];
+    if (c->sock >= 0 && !c->closing && !c->kicked) {
+        bridge_client_enqueue(c, to_slot, line, strlen(line), false);
+    }
+    xSemaphoreGive(s_client_mtx);
+    if (s_bridge_tx_task) xTaskNotifyGive(s_bridge_tx_task);
+}
+
+// Flow-controlled variant for bulk replies (WAVEFORM_GET): waits for the
+// client's critical queue to drain below BRIDGE_REPLAY_QUEUE_MAX instead of
+// overflowing it, so a stored waveform can be pulled at whatever rate the
+// client reads, and live events queued meanwhile still have room. Returns
+// false if the client went away or stalled for BRIDGE_REPLAY_STALL_MS.
+static bool bridge_reply_line_wait(int to_slot, const char *line)
+{
+    size_t len = strlen(line);
+    bridge_client_t *c = &s_clients[to_slot];
+    uint32_t t0 = now_ms();
+    while (1) {
+        xSemaphoreTake(s_client_mtx, portMAX_DELAY);
+        bool alive = (c->sock >= 0 && !c->closing && !c->kicked);
+        bool room  = alive && c->crit.used + len + 3 <= BRIDGE_REPLAY_QUEUE_MAX;
+        if (room) bridge_client_enqueue(c, to_slot, line, len, false);
+        xSemaphoreGive(s_client_mtx);
+        if (s_bridge_tx_task) xTaskNotifyGive(s_bridge_tx_task);
+        if (room) return true;
+        if (!alive || now_ms() - t0 >= BRIDGE_REPLAY_STALL_MS) return false;
+        vTaskDelay(pdMS_TO_TICKS(BRIDGE_TX_POLL_MS));
+    }
+}
+
+static bool bridge_replay_emit(const char *line, void *ctx)
+{
+    return bridge_reply_line_wait((int)(intptr_t)ctx, line);
+}
+
+// WAVEFORM_GET,<weld_id|last> / WAVEFORM_LIST: served from the P4's PSRAM
+// waveform history (waveform_history.cpp), to the asking client only.
+static void bridge_handle_waveform_cmd(int to_slot, const char *cmd)
+{
+    void *ctx = (void *)(intptr_t)to_slot;
+    if (strcmp(cmd, "WAVEFORM_LIST") == 0) {
+        wf_history_list(bridge_replay_emit, ctx);
+        return;
+    }
+    const char *arg = cmd + 13;  // after "WAVEFORM_GET,"
+    uint32_t weld_id = 0;
+    if (strcmp(arg, "last") != 0) {
+        char *end = NULL;
+        weld_id = (uint32_t)strtoul(arg, &end, 10);
+        if (end == arg || *end != '\0' || weld_id == 0) {
+            bridge_reply_line(to_slot, "DENY,WAVEFORM_GET,BAD_ARG");
+            return;
+        }
+    }
+    wf_history_result_t res = wf_history_replay(weld_id, bridge_replay_emit, ctx);
+    if (res == WF_HISTORY_NOT_FOUND) {
+        bridge_reply_line(to_slot, "DENY,WAVEFORM_GET,NOT_FOUND");
+    } else if (res == WF_HISTORY_IN_PROGRESS) {
+        bridge_reply_line(to_slot, "DENY,WAVEFORM_GET,IN_PROGRESS");
+    } else if (res == WF_HISTORY_ABORTED) {
+        ESP_LOGW(TAG, "Client slot %d: WAVEFORM_GET aborted", to_slot);
+    }
+}
+
+// WELDLOG / WELDLOG_GET,<weld_id|t=unix_s>: SD weld log status and record
+// lookup (weld_log.cpp). The record itself is fetched over HTTP (/weldlog).
+static void bridge_handle_weldlog_cmd(int to_slot, const char *cmd)
+{
+    char line[224];
+    if (strcmp(cmd, "WELDLOG") == 0) {
+        weld_log_stats_t st;
+        weld_log_get_stats(&st);
+        snprintf(line, sizeof(line),
+                 "ACK,WELDLOG,ready=%d,segments=%lu,records=%lu,bytes=%llu,pending=%lu,"
+                 "dropped=%lu,write_errors=%lu",
+                 st.ready ? 1 : 0, (unsigned long)st.segments, (unsigned long)st.records,
+                 (unsigned long long)st.bytes, (unsigned long)st.pending,
+                 (unsigned long)st.dropped, (unsigned long)st.write_errors);
+        bridge_reply_line(to_slot, line);
+        return;
+    }
+    const char *arg = cmd + 12;  // after "WELDLOG_GET,"
+    bool by_time = (strncmp(arg, "t=", 2) == 0);
+    if (by_time) arg += 2;
+    char *end = NULL;
+    uint32_t key = (uint32_t)strtoul(arg, &end, 10);
+    if (end == arg || *end != '\0' || key == 0) {
+        bridge_reply_line(to_slot, "DENY,WELDLOG_GET,BAD_ARG");
+        return;
+    }
+    weld_log_loc_t loc;
+    if (!weld_log_find(by_time ? 0 : key, by_time ? key : 0, &loc)) {
+        bridge_reply_line(to_slot, "DENY,WELDLOG_GET,NOT_FOUND");
+        return;
+    }
+    snprintf(line, sizeof(line),
+             "WELDLOG_REC,weld_id=%lu,unix_s=%lu,uptime_ms=%lu,seg=%lu,offset=%lu,bytes=%lu,"
+             "energy_j=%.3f,peak_a=%.1f,total_ms=%u,flags=%u",
+             (unsigned long)loc.idx.weld_id, (unsigned long)loc.idx.unix_s,
+             (unsigned long)loc.idx.uptime_ms, (unsigned long)loc.seg,
+             (unsigned long)loc.idx.offset, (unsigned long)loc.idx.rec_len,
+             loc.idx.energy_j, loc.idx.peak_a, loc.idx.total_ms, loc.idx.flags);
+    bridge_reply_line(to_slot, line);
+}
+
+// PERF / PERF_RESET: the P4's own latency report to the asking client, then
+// forwarded so the STM32 answers with its stages too (to every client).
+static void bridge_handle_perf_cmd(int to_slot, const char *cmd)
+{
+    if (strcmp(cmd, "PERF_RESET") == 0) {
+        perf_reset();
+        bridge_reply_line(to_slot, "ACK,PERF_RESET,src=p4");
+    } else {
+        perf_report(bridge_replay_emit, (void *)(intptr_t)to_slot);
+    }
+    if (s_cmd_cb) s_cmd_cb(cmd);
+}
+
+// BRIDGE_STATS (typed by a TCP client): answered by the P4 itself, to that
+// client only, one line per connected slot.
+static void bridge_reply_stats(int to_slot)
+{
+    char line[160];
+    for (int i = 0; i < MAX_BRIDGE_CLIENTS; i++) {
+        wifi_bridge_client_stats_t st;
+        if (!wifi_bridge_get_client_stats(i, &st)) continue;
+        snprintf(line, sizeof(line),
+                 "BRIDGE_STATS,slot=%d,crit_q=%lu,crit_hw=%lu,tel_q=%lu,tel_drop=%lu,"
+                 "too_long=%lu,writes=%lu,bytes=%lu",
+                 i, (unsigned long)st.crit_depth, (unsigned long)st.crit_high_water,
+                 (unsigned long)st.tel_depth, (unsigned long)st.tel_dropped,
+                 (unsigned long)st.too_long, (unsigned long)st.writes,
+                 (unsigned long)st.bytes);
+        bridge_reply_line(to_slot, line);
+    }
+}
+
+// MCAST[,<0|1>]: query / set UDP telemetry. Reply to the asking client only.
+static void bridge_handle_mcast_cmd(int to_slot, const char *cmd)
+{
+    if (cmd[5] == ',') {
+        if (cmd[6] != '0' && cmd[6] != '1') {
+            bridge_reply_line(to_slot, "DENY,MCAST,BAD_ARG");
+            return;
+        }
+        wifi_bridge_set_multicast(cmd[6] == '1');
+    }
+    char line[128];
+    snprintf(line, sizeof(line), "ACK,MCAST,enabled=%d,group=%s,port=%d,seq=%lu,drops=%lu",
+             s_mcast_enabled ? 1 : 0, MCAST_USE_BROADCAST ? "255.255.255.255" : MCAST_GROUP,
+             MCAST_PORT, (unsigned long)s_mcast_seq, (unsigned long)s_mcast_drops);
+    bridge_reply_line(to_slot, line);
+}
+
 // Per-client RX handler: receives commands from one TCP client, forwards to STM32.
 // Runs as a separate task so multiple clients can send commands concurrently.
 typedef struct {
@@ -247,7 +835,23 @@ static void client_rx_task(void *arg)
             if (c == '\n' || c == '\r') {
                 if (linelen > 0) {
                     linebuf[linelen] = '\0';
-                    if (s_cmd_cb) s_cmd_cb(linebuf);  // forward to STM32
+                    if (strcmp(linebuf, "BRIDGE_STATS") == 0) {
+                        bridge_reply_stats(slot);         // answered locally
+                    } else if (strncmp(linebuf, "MCAST", 5) == 0 &&
+                               (linebuf[5] == ',' || linebuf[5] == '\0')) {
+                        bridge_handle_mcast_cmd(slot, linebuf);  // answered locally
+                    } else if (strncmp(linebuf, "WAVEFORM_GET,", 13) == 0 ||
+                               strcmp(linebuf, "WAVEFORM_LIST") == 0) {
+                        bridge_handle_waveform_cmd(slot, linebuf);  // from PSRAM history
+                    } else if (strcmp(linebuf, "WELDLOG") == 0 ||
+                               strncmp(linebuf, "WELDLOG_GET,", 12) == 0) {
+                        bridge_handle_weldlog_cmd(slot, linebuf);   // from the SD log
+                    } else if (strcmp(linebuf, "PERF") == 0 ||
+                               strcmp(linebuf, "PERF_RESET") == 0) {
+                        bridge_handle_perf_cmd(slot, linebuf);      // P4 + STM32 report
+                    } else if (s_cmd_cb) {
+                        s_cmd_cb(linebuf);                // forward to STM32
+                    }
                     linelen = 0;
                 }
             } else if (linelen < sizeof(linebuf) - 1) {
@@ -256,16 +860,14 @@ static void client_rx_task(void *arg)
         }
     }
 
-    // Client disconnected: remove from the client array.
+    // Client disconnected: hand the slot to bridge_tx_task, which closes the
+    // socket once it is not writing to it.
     xSemaphoreTake(s_client_mtx, portMAX_DELAY);
-    if (s_clients[slot] == sock) {
-        s_clients[slot] = -1;
+    if (s_clients[slot].sock == sock) {
+        s_clients[slot].closing = true;
     }
     xSemaphoreGive(s_client_mtx);
-
-    shutdown(sock, 0);
-    close(sock);
-    ESP_LOGI(TAG, "Client slot %d closed", slot);
+    if (s_bridge_tx_task) xTaskNotifyGive(s_bridge_tx_task);
     vTaskDelete(NULL);
 }
 
@@ -321,13 +923,13 @@ static void tcp_bridge_task(void *arg)
         setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &intvl, sizeof(intvl));
         setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &cnt, sizeof(cnt));
 
-        // Find a free slot for this client.
+        // Find a free slot for this client (and its send queues).
         int slot = -1;
         xSemaphoreTake(s_client_mtx, portMAX_DELAY);
         for (int i = 0; i < MAX_BRIDGE_CLIENTS; i++) {
-            if (s_clients[i] < 0) {
+            if (s_clients[i].sock < 0 && bridge_client_init(&s_clients[i])) {
                 slot = i;
-                s_clients[i] = sock;
+                s_clients[i].sock = sock;
                 break;
             }
         }
@@ -348,10 +950,8 @@ static void tcp_bridge_task(void *arg)
         if (!ctx) {
             ESP_LOGE(TAG, "Failed to allocate client context");
             xSemaphoreTake(s_client_mtx, portMAX_DELAY);
-            s_clients[slot] = -1;
+            s_clients[slot].closing = true;   // bridge_tx_task closes it
             xSemaphoreGive(s_client_mtx);
-            shutdown(sock, 0);
-            close(sock);
             continue;
         }
         ctx->sock = sock;
@@ -359,15 +959,14 @@ static void tcp_bridge_task(void *arg)
 
         char task_name[24];
         snprintf(task_name, sizeof(task_name), "bridge_rx_%d", slot);
-        BaseType_t ret = xTaskCreate(client_rx_task, task_name, 3072, ctx, 5, NULL);
+        // 5 KB: 2 KB of line buffers plus a WAVEFORM_GET / WAVEFORM_LIST replay.
+        BaseType_t ret = xTaskCreate(client_rx_task, task_name, 5120, ctx, 5, NULL);
         if (ret != pdPASS) {
             ESP_LOGE(TAG, "Failed to spawn RX task for slot %d", slot);
             free(ctx);
             xSemaphoreTake(s_client_mtx, portMAX_DELAY);
-            s_clients[slot] = -1;
+            s_clients[slot].closing = true;   // bridge_tx_task closes it
             xSemaphoreGive(s_client_mtx);
-            shutdown(sock, 0);
-            close(sock);
         }
     }
 }
@@ -764,14 +1363,15 @@ static void stop_portal_httpd(void)
 // mode (192.168.4.1). Once the device joins the home WiFi we still want the
 // firmware-update endpoints reachable on the LAN so you can flash over WiFi
 // from VS Code / curl (the ESP-IDF equivalent of PlatformIO's espota), exactly
-// like the OLD board. This lightweight server exposes ONLY /update (GET, the
-// upload page) and /ota (POST, the firmware receiver) — no captive redirect.
+// like the OLD board. This lightweight server exposes /update (GET, the
+// upload page), /ota (POST, the firmware receiver), /stm32 and /waveform
+// (GET, stored weld captures) — no captive redirect.
 static void start_lan_httpd(void)
 {
     if (s_lan_httpd) return;
     httpd_config_t cfg = HTTPD_DEFAULT_CONFIG();
     cfg.lru_purge_enable = true;
-    cfg.max_uri_handlers = 4;
+    cfg.max_uri_handlers = 8;
     // OTA pushes the whole image in one POST; allow plenty of time per recv.
     cfg.recv_wait_timeout = 20;
     cfg.send_wait_timeout = 20;
@@ -786,8 +1386,10 @@ static void start_lan_httpd(void)
     // POST /ota (password-protected firmware receiver).
     ota_register_handler(s_lan_httpd);
     stm32_flash_register_handler(s_lan_httpd);  // POST /stm32 (wireless STM32 flash)
+    wf_history_register_handler(s_lan_httpd);   // GET /waveform (weld history)
+    weld_log_register_handler(s_lan_httpd);     // GET /weldlog (SD weld log)
 
-    ESP_LOGI(TAG, "LAN OTA server up: GET /update, POST /ota");
+    ESP_LOGI(TAG, "LAN OTA server up: GET /update, POST /ota, GET /waveform");
 }
 
 static void stop_lan_httpd(void)
@@ -843,10 +1445,32 @@ static void start_mdns(void)
     mdns_hostname_set(MDNS_HOSTNAME);
     mdns_instance_name_set("SpotWelder");
     mdns_service_add(NULL, "_spotwelder", "_tcp", TCP_BRIDGE_PORT, NULL, 0);
+    // Advertise the UDP telemetry group too, for consumers that use mDNS
+    // instead of listening for ANNOUNCE. TXT "mcast" tracks on/off.
+    mdns_txt_item_t txt[] = {
+        { "mcast", s_mcast_enabled ? "1" : "0" },
+        { "mcast_group", MCAST_USE_BROADCAST ? "255.255.255.255" : MCAST_GROUP },
+    };
+    mdns_service_add(NULL, "_spotwelder-tlm", "_udp", MCAST_PORT, txt, 2);
     s_mdns_up = true;
     ESP_LOGI(TAG, "mDNS up: %s.local", MDNS_HOSTNAME);
 }
 
+// ============================================================
+//  SNTP  (weld log timestamps)
+// ============================================================
+static void start_sntp(void)
+{
+    if (s_sntp_up) return;
+    esp_sntp_config_t cfg = ESP_NETIF_SNTP_DEFAULT_CONFIG("pool.ntp.org");
+    if (esp_netif_sntp_init(&cfg) != ESP_OK) {
+        ESP_LOGW(TAG, "SNTP init failed - weld log records will carry uptime only");
+        return;
+    }
+    s_sntp_up = true;
+    ESP_LOGI(TAG, "SNTP started (pool.ntp.org)");
+}
+
 // ============================================================
 //  AP NAME
 // ============================================================
@@ -886,12 +1510,12 @@ static void start_ap_portal(void)
     // Free port 80 if the LAN OTA server was running (we're leaving STA mode).
     stop_lan_httpd();
 
-    // Drop all bridge clients.
+    // Drop all bridge clients (their RX tasks see the shutdown and release
+    // the slots; bridge_tx_task closes the sockets).
     xSemaphoreTake(s_client_mtx, portMAX_DELAY);
     for (int i = 0; i < MAX_BRIDGE_CLIENTS; i++) {
-        if (s_clients[i] >= 0) {
-            close(s_clients[i]);
-            s_clients[i] = -1;
+        if (s_clients[i].sock >= 0) {
+            bridge_client_kick(&s_clients[i]);
         }
     }
     xSemaphoreGive(s_client_mtx);
@@ -968,7 +1592,9 @@ static void wifi_event_handler(void *arg, esp_event_base_t base,
         ui_hide_wifi_setup();
         ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));  // drop the AP
         start_mdns();
+        start_sntp();
         start_lan_httpd();   // expose /update + /ota on the LAN (WiFi OTA)
+        s_mcast_announce_due = true;   // UDP telemetry: announce on every (re)join
         push_wifi_info_to_ui();
     }
 }
@@ -1046,6 +1672,7 @@ static bool wifi_stack_init(void)
     // than in wifi_bridge_start) avoids a race where it called socket() before
     // the stack existed ("Invalid mbox" assert in tcpip_send_msg_wait_sem).
     xTaskCreate(tcp_bridge_task, "tcp_bridge", 6144, NULL, 5, NULL);
+    xTaskCreate(bridge_tx_task, "bridge_tx", 4096, NULL, 5, &s_bridge_tx_task);
 
     // Boot: saved creds -> STA, else straight to the portal.
     nvs_load_creds();
@@ -1082,6 +1709,9 @@ static void prov_task(void *arg)
             push_wifi_info_to_ui();
         }
 
+        // UDP telemetry discovery beacon.
+        mcast_service(now);
+
         // Reconfigure requested from the Setup tab.
         if (s_reconfigure_req) {
             s_reconfigure_req = false;
@@ -1131,11 +1761,12 @@ void wifi_bridge_start(wifi_bridge_cmd_cb_t cmd_cb)
     s_cmd_cb  = cmd_cb;
 
     s_client_mtx  = xSemaphoreCreateMutex();
+    s_mcast_mtx   = xSemaphoreCreateMutex();
     s_wifi_events = xEventGroupCreate();
 
     // Initialize all client slots to -1 (unused).
     for (int i = 0; i < MAX_BRIDGE_CLIENTS; i++) {
-        s_clients[i] = -1;
+        s_clients[i].sock = -1;
     }
 
     // NOTE: we deliberately do NOT bring up NVS / WiFi here. app_main() runs on
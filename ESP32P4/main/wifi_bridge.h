@@ -19,6 +19,7 @@
 
 #pragma once
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -42,10 +43,35 @@ void wifi_bridge_reconfigure(void);
 // Erase the saved WiFi credentials from NVS. Caller typically reboots after.
 void wifi_bridge_factory_reset(void);
 
-// Push one line (STATUS / EVENT / WAVEFORM / ...) to the connected Flask
-// client. Thread-safe; silently drops the line if no client is connected.
+// Push one line (STATUS / EVENT / WAVEFORM / ...) to every connected client.
+// Thread-safe and non-blocking: the line is copied into per-client send
+// queues drained by the bridge writer task. Silently drops the line if no
+// client is connected.
 void wifi_bridge_broadcast(const char *line);
 
+// Per-client send-queue counters (also answered on the bridge itself as
+// BRIDGE_STATS lines when a client sends "BRIDGE_STATS").
+typedef struct {
+    uint32_t crit_depth;       // bytes queued: events / waveform / replies
+    uint32_t crit_high_water;  // peak crit_depth since connect
+    uint32_t tel_depth;        // bytes queued: STATUS / STATUS2 / DISPLAY
+    uint32_t tel_dropped;      // oldest telemetry lines evicted on overflow
+    uint32_t too_long;         // lines too long to queue (dropped)
+    uint32_t overflows;        // crit queue full -> client disconnected
+    uint32_t writes;           // send() calls that wrote data
+    uint32_t bytes;            // bytes written
+} wifi_bridge_client_stats_t;
+
+// Copy slot's counters into *out. Returns false if the slot has no live
+// client (counters of the last client on that slot are still copied).
+bool wifi_bridge_get_client_stats(int slot, wifi_bridge_client_stats_t *out);
+
+// Opt-in UDP telemetry: STATUS* / EVENT lines (plus periodic ANNOUNCE) are
+// also sent once per line to the LAN multicast group, tagged with host, node
+// and sequence number (see PROTOCOL.md). Persisted in NVS; default off.
+void wifi_bridge_set_multicast(bool enable);
+bool wifi_bridge_multicast_enabled(void);
+
 // Query current WiFi state for STATUS enrichment (Flask dashboard needs this).
 // Returns true if WiFi is up (STA connected or AP active). All out-params are
 // optional (pass NULL to skip). ssid/ip buffers must be >= 33 / 16 bytes.
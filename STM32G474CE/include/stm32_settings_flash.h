@@ -2,9 +2,14 @@
  * @file stm32_settings_flash.h
  * @brief Flash-based persistent settings for STM32G474 Spot Welder
  *
- * Uses last Flash page (0x0807F800, 2KB) for EEPROM emulation.
+ * Uses the last four Flash pages (0x0807E000..0x0807FFFF, 4 x 2KB) as an
+ * append-only log for EEPROM emulation. Every save programs one 48-byte slot
+ * (PersistentSettings + sequence number) into the next blank slot; a page is
+ * erased only when the log wraps back onto it, so each page sees one erase per
+ * SETTINGS_LOG_SLOTS_PER_PAGE * SETTINGS_LOG_PAGES saves instead of one per
+ * save. Boot takes the valid slot with the highest sequence number.
  * Survives power cycles, watchdog resets, and firmware updates (as long as
- * the page isn't erased during reflash).
+ * the pages aren't erased during reflash).
  */
 
 #ifndef STM32_SETTINGS_FLASH_H
@@ -15,8 +20,17 @@
 
 /* Flash page configuration for STM32G474CE (512KB Flash, 2KB pages) */
 #define SETTINGS_FLASH_PAGE_SIZE 2048U
-#define SETTINGS_FLASH_PAGE_NUMBER 255U       /* Last page */
-#define SETTINGS_FLASH_BASE_ADDR 0x0807F800UL /* Page 255 start */
+#define SETTINGS_FLASH_PAGE_NUMBER 252U       /* First log page */
+#define SETTINGS_FLASH_BASE_ADDR 0x0807E000UL /* Page 252 start */
+
+/* Log layout. A slot is written in doublewords, sequence number last, so a
+ * save cut short by a reset leaves a slot that is skipped, never loaded.
+ * The pre-log single record at 0x0807F800 (page 255, slot 0, zero padding)
+ * reads as a valid slot with sequence 0, so existing settings carry over. */
+#define SETTINGS_LOG_PAGES 4U
+#define SETTINGS_LOG_SLOT_BYTES 48U
+#define SETTINGS_LOG_SLOTS_PER_PAGE \
+    (SETTINGS_FLASH_PAGE_SIZE / SETTINGS_LOG_SLOT_BYTES) /* 42 */
 
 /* Magic number for settings validity check */
 #define SETTINGS_MAGIC 0x53504F54UL /* "SPOT" in ASCII */
@@ -74,23 +88,38 @@ bool settings_flash_load(PersistentSettings* settings);
 
 /**
  * Save settings to Flash.
- * Erases page and writes new data with CRC.
+ * Appends one slot with CRC; erases the next page first when the current one
+ * is full. Returns true without writing when the newest slot already matches.
  * @param settings Pointer to settings struct to save
  * @return true on success
  */
 bool settings_flash_save(const PersistentSettings* settings);
 
+/**
+ * True when the next settings_flash_save() that writes has to erase a page
+ * first (~20 ms) rather than only append a slot.
+ */
+bool settings_flash_save_needs_erase(void);
+
 /**
  * Erase all settings from Flash (factory reset).
  * @return true on success
  */
 bool settings_flash_erase(void);
 
+/**
+ * Diagnostic line sink (no CR/LF). The weak default transmits on huart1 with
+ * HAL_UART_Transmit; the application overrides it to use its own TX path.
+ * @param line NUL-terminated text line
+ */
+void settings_flash_debug(const char* line);
+
 /* Backward-compatible aliases expected by main.c patch */
 #define lead_r lead_resistance_ohms
 #define flash_settings_init settings_flash_init
 #define flash_settings_load settings_flash_load
 #define flash_settings_save settings_flash_save
+#define flash_settings_save_needs_erase settings_flash_save_needs_erase
 #define flash_settings_erase settings_flash_erase
 
 #endif  // STM32_SETTINGS_FLASH_H
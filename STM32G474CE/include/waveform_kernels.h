@@ -0,0 +1,253 @@
+/**
+ * @file waveform_kernels.h
+ * @brief Hardware-independent weld waveform kernels
+ *
+ * The capture-buffer storage format and the post-weld passes over it: phase
+ * edge search, polled-capture Vcap interpolation, tip-energy integration
+ * and the one-pass post-weld analytics, the WAVEFORM_DATA / WAVEFORM_BIN
+ * chunk encoders and the summary-mode envelope / per-phase statistics. main.c owns the buffers
+ * and hands the kernels a WaveformView; nothing here touches a peripheral
+ * (the WAVEFORM_BIN CRC stays on the hardware CRC unit in main.c), so the
+ * host benchmark in bench/ builds this same file.
+ */
+
+#ifndef WAVEFORM_KERNELS_H
+#define WAVEFORM_KERNELS_H
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Sample storage:
+ * 1 = packed raw counts, one 32-bit word per sample (12-bit current, 12-bit
+ *     Vcap, 8-bit dt); converted to amps/volts only when analysed or sent.
+ *     Same 48 KB holds 3x the samples of the float layout.
+ * 0 = legacy {float amps, float volts, uint32 timestamp} (12 bytes). */
+#ifndef WAVEFORM_PACKED_STORAGE
+#define WAVEFORM_PACKED_STORAGE 1
+#endif
+
+#define WAVEFORM_CHUNK_SAMPLES 100U
+
+/* ADC full scale; also the packed-field limit. */
+#define WAVEFORM_PACK_COUNT_MAX 0xFFFU
+
+/* WAVEFORM_BIN sample packing (see WAVEFORM_FMT_BIN in main.c):
+ * {int16 current (0.1A), uint16 Vcap (1mV), uint8 dt (us since previous)}. */
+#define WAVEFORM_BIN_BYTES_PER_SAMPLE 5U
+#define WAVEFORM_BIN_AMPS_SCALE 10.0f    /* LSB = 0.1 A */
+#define WAVEFORM_BIN_VOLTS_SCALE 1000.0f /* LSB = 1 mV */
+#define WAVEFORM_BIN_MAX_DT_US 0xFFU     /* larger gap starts a new chunk */
+#define WAVEFORM_BIN_PAYLOAD_SIZE \
+    (WAVEFORM_CHUNK_SAMPLES * WAVEFORM_BIN_BYTES_PER_SAMPLE)
+
+/* Summary mode (WAVEFORM_MODE,SUMMARY in main.c): the capture is reduced to
+ * at most WAVEFORM_SUMMARY_BUCKETS equal sample windows, sent
+ * WAVEFORM_ENV_CHUNK_BUCKETS per WAVEFORM_ENV line in BIN units (0.1 A,
+ * 1 mV). */
+#define WAVEFORM_SUMMARY_BUCKETS 256U
+#define WAVEFORM_ENV_CHUNK_BUCKETS 32U
+
+#if WAVEFORM_PACKED_STORAGE
+/* Packed word: [11:0] current counts (shunt P-N, >= 0), [23:12] Vcap counts
+ * (Vcap+ - Vcap-), [31:24] us since the previous sample. Absolute time is
+ * kept in a block table: a block starts every WAVEFORM_TS_BLOCK_SAMPLES
+ * samples, or early when dt does not fit in 8 bits (its dt field is 0). */
+#define WAVEFORM_PACK_DT_MAX 0xFFU
+#define WAVEFORM_TS_BLOCK_SAMPLES 128U
+
+typedef struct {
+    uint16_t first_index;
+    uint32_t t0_us;
+} WaveformTsBlock;
+#else
+typedef struct {
+    float current_amps;
+    float voltage_volts;
+    uint32_t timestamp_us;
+} WaveformSample;
+#endif
+
+/* One capture as the kernels see it: count samples starting at index 0.
+ * Count -> engineering-unit scales are latched when the capture starts. */
+typedef struct {
+#if WAVEFORM_PACKED_STORAGE
+    uint32_t* words;
+    const WaveformTsBlock* blocks;
+    uint16_t block_count;
+#else
+    WaveformSample* samples;
+#endif
+    uint16_t count;
+    float amps_per_count;
+    float volts_per_count;
+} WaveformView;
+
+/* Pulse statistics over a [start, end) sample window (see
+ * wf_integrate_pulse). */
+typedef struct {
+    float energy_j;    /* sum of 0.5 * (P[i] + P[i+1]) * dt[i] at the tips */
+    float duration_s;  /* sum of the dt[i] the energy was integrated over */
+    float sum_amps;    /* for the window average */
+    float sum_volts;
+    uint32_t samples;
+} WaveformPulseStats;
+
+/* One-pass post-weld analytics over a [start, end) window (see
+ * wf_analyze_pulse). */
+typedef struct {
+    WaveformPulseStats pulse; /* as wf_integrate_pulse */
+    float rms_amps;
+    float peak_amps;
+    uint16_t peak_index;      /* start for an empty window */
+    float didt_a_per_us;      /* start - 1 -> first sample >= 90 % of peak */
+    float r_start_ohms;       /* V_cap / I - lead_r_ohms, first quarter */
+    float r_end_ohms;         /* same, last quarter */
+} WaveformPulseAnalytics;
+
+/* Envelope of one summary bucket (see wf_envelope_bucket). */
+typedef struct {
+    float min_amps;
+    float max_amps;
+    float mean_amps;
+    float mean_volts;
+} WaveformEnvBucket;
+
+/* Summary statistics of one phase window (see wf_phase_stats). */
+typedef struct {
+    float energy_j;      /* tip energy, as wf_integrate_pulse */
+    float rms_amps;
+    float peak_amps;
+    uint16_t peak_index; /* start for an empty window */
+    uint32_t samples;
+} WaveformPhaseStats;
+
+/* ---- Per-sample accessors (hot: inline) ---- */
+
+static inline float wf_sample_amps(const WaveformView* w, uint16_t idx) {
+#if WAVEFORM_PACKED_STORAGE
+    return (float)(w->words[idx] & WAVEFORM_PACK_COUNT_MAX) *
+           w->amps_per_count;
+#else
+    return w->samples[idx].current_amps;
+#endif
+}
+
+static inline float wf_sample_volts(const WaveformView* w, uint16_t idx) {
+#if WAVEFORM_PACKED_STORAGE
+    return (float)((w->words[idx] >> 12) & WAVEFORM_PACK_COUNT_MAX) *
+           w->volts_per_count;
+#else
+    return w->samples[idx].voltage_volts;
+#endif
+}
+
+static inline uint32_t wf_volts_to_counts(float volts, float volts_per_count) {
+    if (!isfinite(volts) || volts <= 0.0f || volts_per_count <= 0.0f) {
+        return 0U;
+    }
+    const float counts = (volts / volts_per_count) + 0.5f;
+    if (counts >= (float)WAVEFORM_PACK_COUNT_MAX) {
+        return WAVEFORM_PACK_COUNT_MAX;
+    }
+    return (uint32_t)counts;
+}
+
+static inline void wf_set_sample_volts(WaveformView* w, uint16_t idx,
+                                       float volts) {
+#if WAVEFORM_PACKED_STORAGE
+    w->words[idx] = (w->words[idx] & ~(WAVEFORM_PACK_COUNT_MAX << 12)) |
+                    (wf_volts_to_counts(volts, w->volts_per_count) << 12);
+#else
+    w->samples[idx].voltage_volts = volts;
+#endif
+}
+
+/* Capture-relative timestamp. Packed: binary-search the block, then sum at
+ * most WAVEFORM_TS_BLOCK_SAMPLES-1 dt fields. */
+uint32_t wf_sample_ts_us(const WaveformView* w, uint16_t idx);
+
+/* us from sample idx-1 to idx; 0 for idx 0 or non-increasing time. */
+uint32_t wf_sample_dt_us(const WaveformView* w, uint16_t idx);
+
+/* ---- Post-weld kernels ---- */
+
+/* First (last = false) or last (last = true) sample in [start, end) whose
+ * current reaches max(peak * peak_ratio, min_amps), peak being the window's
+ * peak current. end is clamped to w->count. False if the window is empty or
+ * carries no current. */
+bool wf_find_phase_edge(const WaveformView* w, uint16_t start, uint16_t end,
+                        bool last, float peak_ratio, float min_amps,
+                        uint16_t* out_idx);
+
+/* Polled capture (no Vcap per sample): hold vcap_start before the pulse,
+ * ramp linearly to vcap_end over [pulse_start, pulse_end), hold after. */
+void wf_interpolate_volts(WaveformView* w, float vcap_start, float vcap_end,
+                          uint16_t pulse_start, uint16_t pulse_end);
+
+/* Window sums and trapezoidal tip energy over [start, end), with
+ * V_tip = V_cap - I * lead_r_ohms and dt from the timestamps (nominal_dt_s
+ * when the capture has no usable dt). Negative / non-finite samples count as
+ * zero. A one-sample window integrates nothing and reports nominal_dt_s. */
+void wf_integrate_pulse(const WaveformView* w, uint16_t start, uint16_t end,
+                        float lead_r_ohms, float nominal_dt_s,
+                        WaveformPulseStats* out);
+
+/* wf_integrate_pulse plus RMS / peak current, the rise rate at the window
+ * start (a lower bound when the current rises within one sample interval)
+ * and the contact resistance (current-weighted, 0 if negative) over
+ * its first and last quarters, in one pass. Packed storage works on the raw
+ * counts: integer sums, one float multiply-add chain per sample, no per-sample
+ * range checks (a 12-bit count is always valid). Windows shorter than 4
+ * samples report no resistance. */
+void wf_analyze_pulse(const WaveformView* w, uint16_t start, uint16_t end,
+                      float lead_r_ohms, float nominal_dt_s,
+                      WaveformPulseAnalytics* out);
+
+/* Phase summary over [start, end) (end clamped to w->count): the
+ * wf_analyze_pulse tip energy, RMS and peak current. */
+void wf_phase_stats(const WaveformView* w, uint16_t start, uint16_t end,
+                    float lead_r_ohms, float nominal_dt_s,
+                    WaveformPhaseStats* out);
+
+/* Bucket b of w split into `buckets` windows, bucket b covering samples
+ * [b * count / buckets, (b + 1) * count / buckets). buckets must be in
+ * 1..w->count; an empty window reports zeros. */
+void wf_envelope_bucket(const WaveformView* w, uint16_t buckets, uint16_t b,
+                        WaveformEnvBucket* out);
+
+/* "WAVEFORM_ENV,<first>,<count>,min,max,mean,vmean,..." for buckets
+ * [first, first + count), current in 0.1 A and Vcap in mV. Returns the line
+ * length, or -1 if it did not fit. */
+int wf_format_env_chunk(const WaveformView* w, uint16_t buckets,
+                        uint16_t first, uint16_t count, char* line,
+                        size_t line_size);
+
+/* "WAVEFORM_DATA,<start>,<count>,t_us,volts,amps,..." into line. Returns the
+ * line length, or -1 if it did not fit (the chunk is then skipped). */
+int wf_format_csv_chunk(const WaveformView* w, uint16_t start, uint16_t count,
+                        char* line, size_t line_size);
+
+/* Pack up to WAVEFORM_CHUNK_SAMPLES samples from start into payload
+ * (WAVEFORM_BIN_PAYLOAD_SIZE bytes). The chunk ends early where dt no longer
+ * fits in 8 bits, so the next one re-bases t0. Returns the sample count
+ * (>= 1 while start < w->count); *out_len = bytes, *out_t0_us = first
+ * sample's timestamp. */
+uint16_t wf_pack_bin_chunk(const WaveformView* w, uint16_t start,
+                           uint8_t* payload, size_t* out_len,
+                           uint32_t* out_t0_us);
+
+/* Returns chars written (excluding NUL), or 0 if out_size is too small. */
+size_t wf_base64_encode(const uint8_t* in, size_t len, char* out,
+                        size_t out_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WAVEFORM_KERNELS_H */
@@ -0,0 +1,155 @@
+/**
+ * @file weld_control.h
+ * @brief Hardware-independent weld control decisions
+ *
+ * The parts of fireRecipe() that decide when the FET goes off, separated from
+ * the TIM2 / PWM / ADC plumbing that carries the decision out:
+ *  - the power % -> PWM duty calibration curve (pctToDuty),
+ *  - the JOULE mode controller: fixed-point energy integrator, predictive
+ *    cutoff and the target / timeout / bad-contact stops, fed one
+ *    (current, Vcap) sample at a time by capturePulseAmpsForDurationUs().
+ * main.c programs TIM2 with what the controller asks for; the weld replay
+ * simulator in tools/weld_sim drives the same code against a plant model.
+ */
+
+#ifndef WELD_CONTROL_H
+#define WELD_CONTROL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* PWM compare full scale (100 % duty). */
+#define WELD_PWM_MAX 1023U
+
+/* Joules - compensate for FET turn-off delay. */
+#define JOULE_OVERSHOOT_COMP 0.2f
+
+/* Predictive joule cutoff:
+ * 1 = near the target, project the instant the workpiece energy will be met
+ *     from the filtered power and its slope, and move TIM2->ARR so the
+ *     hardware FET kill lands on that instant.  The software cutoff then
+ *     backs it up at the full target (no JOULE_OVERSHOOT_COMP).
+ * 0 = legacy cutoff: stop on the first sample past target - comp.
+ * Only full-duty pulses are predicted; chopped (duty < WELD_PWM_MAX) pulses
+ * keep the legacy cutoff because their sampled power is not the average
+ * power. */
+#ifndef JOULE_PREDICTIVE_CUTOFF
+#define JOULE_PREDICTIVE_CUTOFF 1
+#endif
+#define JOULE_PREDICT_KILL_LEAD_US 1U /* TIM2 ISR + gate turn-off */
+#define JOULE_PREDICT_MIN_ARM_US 2U   /* closer than this: kill in software */
+
+/* Joule mode: current below joule_min_current_a this long = bad contact. */
+#define JOULE_BAD_CONTACT_LIMIT_US 5000U
+
+/* Empirical power % -> duty (0..WELD_PWM_MAX) curve: 0-50 % power maps
+ * linearly to 0-74 % duty, 50-100 % to 74-100 % (see weld_control.c). */
+uint16_t weld_pct_to_duty(uint8_t pct);
+
+/* ---- JOULE mode controller ---- */
+
+/* Fixed-point Joule integrator.
+ * The sampling loop accumulates raw ADC products (vcap_counts * i_counts *
+ * dt_us) in uint64 "units"; one unit = kv * ki * 1 us Joules.  The scale is
+ * derived once per pulse from the current calibration, and the float
+ * joule_* globals in main.c are published from the integer accumulators only
+ * when someone needs to read them. */
+typedef struct {
+    uint32_t lead_q16;           /* R_lead * ki / kv in Q16 (counts -> counts) */
+    uint32_t min_current_counts; /* joule_min_current_a in i_counts      */
+    uint64_t cutoff_units;       /* (target - overshoot comp) in units   */
+    uint64_t target_units;       /* full target in units (predictive)    */
+    float joules_per_unit;
+} JouleFixedScale;
+
+typedef enum {
+    JOULE_STOP_NONE = 0,
+    JOULE_STOP_TARGET,      /* workpiece energy reached the cutoff */
+    JOULE_STOP_TIMEOUT,     /* joule_max_ms elapsed first */
+    JOULE_STOP_BAD_CONTACT, /* JOULE_BAD_CONTACT_LIMIT_US of low current */
+} JouleStop;
+
+/* One weld's controller state. Accumulators and the stop reason span every
+ * pulse of the weld (preheat energy counts toward the target); the rest is
+ * per pulse (joule_pulse_begin). */
+typedef struct {
+    JouleFixedScale scale;
+    uint64_t total_units; /* V_cap * I */
+    uint64_t loss_units;  /* I^2 * R_lead */
+    uint64_t work_units;  /* total - loss: the controlled variable */
+    uint32_t duration_us; /* FET-on time integrated so far (all pulses) */
+    JouleStop stop;
+
+    /* Per pulse */
+    uint64_t cutoff_units;
+    uint32_t duration_offset_us;
+    uint32_t last_sample_elapsed_us;
+    uint32_t low_current_streak_us;
+    uint32_t nominal_dt_us;
+    uint32_t horizon_us;
+    bool predict;
+    int32_t p_filt;   /* workpiece power, units/µs (EMA 1/4) */
+    int32_t slope_q4; /* d(power)/dt, units/µs² Q4 (EMA 1/8) */
+    bool have_p;
+    bool predict_armed;
+    bool predict_clamped;
+    uint32_t kill_elapsed_us;
+    uint32_t last_total_p;
+    uint64_t last_loss_p;
+} JouleControl;
+
+/* What the sampling loop must do after a sample. */
+typedef struct {
+    JouleStop stop;       /* != NONE: kill the FET now and leave the loop */
+    uint32_t dt_us;       /* dt integrated for this sample */
+    bool rearm;           /* predictive: move the hardware kill ... */
+    uint32_t kill_in_us;  /* ... this many µs after the sample (lead applied) */
+    float pred_units;     /* workpiece energy projected at that kill */
+} JouleStep;
+
+/* Scale from the ADC calibration (ki = A/count, kv = V/count) and settings.
+ * Unusable calibration leaves cutoff/target at UINT64_MAX (never reached). */
+void joule_build_scale(float ki, float kv, float lead_r_ohms,
+                       float min_current_a, float target_j,
+                       JouleFixedScale* out);
+
+/* Weld start: clear the accumulators and the stop reason. */
+void joule_reset(JouleControl* jc);
+
+/* Pulse start. predict = predictive cutoff for this pulse (full duty only);
+ * nominal_dt_us stands in for a zero sample dt; horizon_us is how close to
+ * the target (in µs at the filtered power) prediction starts. */
+void joule_pulse_begin(JouleControl* jc, const JouleFixedScale* scale,
+                       bool predict, uint32_t nominal_dt_us,
+                       uint32_t horizon_us);
+
+/* One sample elapsed_us after FET-on: integrate, update the prediction and
+ * decide. max_us is the joule_max_ms safety limit. */
+void joule_sample(JouleControl* jc, uint32_t i_counts, uint32_t vcap_counts,
+                  uint32_t elapsed_us, uint32_t max_us, JouleStep* out);
+
+/* The caller moved the hardware kill to kill_elapsed_us after FET-on
+ * (clamped = it had to stop at the pulse's own end instead). */
+void joule_kill_programmed(JouleControl* jc, uint32_t kill_elapsed_us,
+                           bool clamped);
+
+/* Pulse end. A predicted kill ends the loop without a final sample: the
+ * stretch from the last sample to the kill is integrated at the last
+ * sampled power. Returns true if that kill met the target (stop becomes
+ * JOULE_STOP_TARGET). */
+bool joule_pulse_end(JouleControl* jc);
+
+/* Energy units (accumulators, JouleStep.pred_units) -> Joules. */
+static inline float joule_units_to_j(const JouleControl* jc, float units) {
+    return units * jc->scale.joules_per_unit;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WELD_CONTROL_H */
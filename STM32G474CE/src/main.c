@@ -6,6 +6,8 @@
 
 #include "stm32_settings_flash.h"
 #include "stm32g4xx_hal.h"
+#include "waveform_kernels.h"
+#include "weld_control.h"
 
 /* ===== Forward decls ===== */
 static void SystemClock_Config(void);
@@ -20,6 +22,7 @@ static void MX_IWDG_Init(void);
 static void i2c_bus_recovery(void);
 
 static void uartSend(const char* s);
+static void uartFlush(uint32_t timeout_ms);
 static void jumpToBootloader(void);
 static void requestBootloaderReset(void);
 static void requestKatapultReset(void);
@@ -28,7 +31,6 @@ static inline void pwmOnDuty(uint16_t duty);
 static void clampParams(void);
 static void applyArmTimeout(void);
 static void applyReadyTimeout(void);
-static uint16_t pctToDuty(uint8_t pct);
 static uint32_t doPulseMsPwm(uint16_t ms, uint16_t duty, uint32_t* pwm_on_us,
                              uint32_t* pwm_off_us,
                              uint16_t* pwm_off_waveform_index);
@@ -68,12 +70,15 @@ static void capturePulseAmpsForDurationUs(uint32_t pulse_duration_us,
 /* NEW: INA226 Forward Decl */
 static bool ina226_write_reg(uint8_t addr, uint8_t reg, uint16_t val);
 static bool ina226_read_reg(uint8_t addr, uint8_t reg, uint16_t* val);
-static bool ina226_read_bus_voltage(uint8_t addr, float* voltage);
-static bool ina226_read_shunt_current(uint8_t addr, float* current);
+static float ina226_bus_volts(uint16_t raw);
+static float ina226_shunt_amps(uint16_t raw);
 static bool ina226_health_check(void);
 static void ina226_read_all(void);
+static void ina226_seq_start(void);
+static bool ina226_seq_poll(void);
 static void chargerStateMachine(void);
 static void sendStatusPacket(void);
+static void streamCheckDelta(void);
 
 /* Waveform capture helpers (Phase 3) */
 static inline uint32_t micros_now(void);
@@ -91,14 +96,20 @@ static void start_weld_pulse_capture(void);
 static void capture_waveform_samples(uint16_t sample_count);
 static uint16_t capture_waveform_until_deadline(uint32_t deadline_us);
 static void end_weld_pulse_capture(void);
-static void apply_waveform_voltage_interpolation(float vcap_start,
-                                                 float vcap_end,
-                                                 uint16_t pulse_start_index,
-                                                 uint16_t pulse_end_index);
-static void send_waveform_data(void);
+static void init_crc32_engine(void);
+static uint32_t crc32_compute(const uint8_t* data, size_t len);
 static uint16_t get_planned_active_pulse_ms(void);
-static bool waveform_push_sample(float current_amps, float voltage_volts,
-                                 uint32_t timestamp_us);
+static uint32_t get_planned_total_samples(uint16_t planned_pulse_ms,
+                                          uint32_t interval_us);
+static bool waveform_push_sample(uint32_t current_counts,
+                                 uint32_t vcap_counts, uint32_t timestamp_us);
+static float waveform_sample_amps(uint16_t idx);
+static float waveform_sample_volts(uint16_t idx);
+static uint32_t waveform_sample_ts_us(uint16_t idx);
+static uint32_t waveform_sample_dt_us(uint16_t idx);
+static void waveform_set_sample_volts(uint16_t idx, float volts);
+static uint32_t waveform_volts_to_counts(float volts);
+static WaveformView waveform_view(void);
 static bool resolve_phase_start_from_waveform(uint16_t start_index,
                                               uint16_t end_index,
                                               uint32_t* out_abs_us);
@@ -140,8 +151,10 @@ static bool resolve_phase_end_from_waveform(uint16_t start_index,
  * C = (t × 1.4427) / R = 413F
  * Config: 6× 1000F/3V caps, 3S2P */
 #define CAP_FARADS 413.0f
-#define JOULE_OVERSHOOT_COMP \
-    0.2f /* Joules - compensate for FET turn-off delay */
+/* Joule controller tuning (JOULE_OVERSHOOT_COMP, JOULE_PREDICTIVE_CUTOFF,
+ * ...) lives in weld_control.h.  Predictive cutoff starts projecting once the
+ * remaining energy fits inside this many µs at the filtered power. */
+#define JOULE_PREDICT_HORIZON_US (3U * waveform_interval_us)
 
 /* ============ Thermistor / ADC ============ */
 #define THERM_SERIES_R 10000.0f
@@ -149,6 +162,7 @@ static bool resolve_phase_end_from_waveform(uint16_t start_index,
 #define THERM_NOMINAL_T 25.0f
 #define THERM_BETA 3950.0f
 #define THERM_OFFSET_C 0.0f
+#define OVERHEAT_TEMP_C 65.0f /* weld / calibration refused above this */
 
 #define V_CAP_DIVIDER 6.0f
 
@@ -196,13 +210,15 @@ static const uint32_t CONTACT_DEBOUNCE_MS = 50;
 static const float PHASE_START_MIN_CURRENT_A = 50.0f;
 static const float PHASE_START_PEAK_RATIO = 0.10f;
 
-/* UART TX pacing for long WAVEFORM lines.
- * 1024 bytes @2Mbps is ~4ms on wire, so 250ms timeout is generous. */
+/* UART TX pacing for long WAVEFORM lines (blocking fallback only).
+ * 1024 bytes @576kbaud is ~18ms on wire, so 250ms timeout is generous.
+ * With the DMA queue, UART_TX_TIMEOUT_MS is the longest a bulk line waits
+ * for ring space before it is dropped. */
 static const uint32_t UART_TX_CHUNK_SIZE = 1024U;
 static const uint32_t UART_TX_TIMEOUT_MS = 250U;
 
 /* ============ PWM Settings ============ */
-static const uint16_t PWM_MAX = 1023;
+static const uint16_t PWM_MAX = WELD_PWM_MAX;
 static const uint16_t TIM1_PSC = 0;
 static const uint32_t TIM1_ARR = 16999;
 
@@ -317,6 +333,16 @@ bool joule_timeout_abort = false;
 bool joule_bad_contact_abort = false;
 uint32_t joule_actual_duration_us = 0;
 
+/* Fixed-point Joule integrator and cutoff decisions (see weld_control.h).
+ * The scale is rebuilt per pulse; joule_ctl spans the whole weld. */
+static JouleFixedScale joule_fx_scale;
+static JouleControl joule_ctl;
+
+/* Predictive cutoff result for WELD_DONE: projected workpiece energy at the
+ * programmed kill and the kill instant in µs after FET-on (0 = not armed). */
+float joule_predicted_j = 0.0f;
+uint32_t joule_predict_kill_us = 0U;
+
 /* ============ Trigger Settings ============ */
 static volatile uint8_t trigger_mode = 1;        // 1 = pedal, 2 = contact
 static volatile uint8_t contact_hold_steps = 2;  // each step = 500 ms
@@ -325,6 +351,9 @@ static volatile uint8_t contact_with_pedal =
 
 /* ============ State ============ */
 static volatile bool welding_now = false;
+/* A weld (or lead calibration pulse) ran this loop pass: the scheduler
+ * leaves the pass out of its timing statistics. */
+static volatile bool sched_weld_fired = false;
 static uint32_t last_weld_ms = 0;
 
 static bool armed = false;
@@ -334,9 +363,16 @@ static uint32_t boot_ms = 0;
 static bool system_ready = false;
 static uint32_t ready_until_ms = 0;
 
-static GPIO_PinState pedal_last_raw = GPIO_PIN_SET;
-static GPIO_PinState pedal_stable = GPIO_PIN_SET;
-static uint32_t pedal_last_change_ms = 0;
+/* Pedal: EXTI edge + TIM7 debounce (see Pedal Trigger). Written in ISRs. */
+static volatile GPIO_PinState pedal_stable = GPIO_PIN_SET;
+static volatile uint32_t pedal_burst_cyc = 0U; /* first edge of a bounce */
+static volatile uint32_t pedal_press_edge_cyc = 0U;
+static volatile bool pedal_press_ready = false; /* debounced press queued */
+static bool pedal_exti_remapped = false; /* EXTICR was not on port B */
+/* Pedal-triggered weld: press edge (DWT) and edge -> first FET on. */
+static bool weld_pedal_edge_valid = false;
+static uint32_t weld_pedal_edge_cyc = 0U;
+static uint32_t weld_pedal_fet_us = 0U;
 
 static float temp_filtered_c = 25.0f;
 static float current_peak_amps = 0.0f;  // Track peak of recipe
@@ -352,14 +388,44 @@ static float cal_current_avg = 0.0f;
  * 41% improvement over previous leads (1.87 mΩ → 1.1 mΩ). */
 static float lead_resistance_ohms = 0.0011f;  // 1.1 mΩ measured
 static PersistentSettings g_persistent_settings = {0};
+/* SET_* handlers only mark the settings dirty; jobSettings() writes one
+ * coalesced log slot once they have been quiet for SETTINGS_COMMIT_QUIET_MS. */
+#define SETTINGS_COMMIT_QUIET_MS 1500U
+static bool settings_dirty = false;
+static uint32_t settings_dirty_ms = 0;
+static uint32_t settings_commit_fails = 0;
 static const float LEAD_RESISTANCE_MIN_OHMS = 0.0001f; /* 0.1 mΩ */
 static const float LEAD_RESISTANCE_MAX_OHMS = 0.0100f; /* 10.0 mΩ */
 
 /* ============ Waveform Capture (Phase 3) ============ */
+/* Sample storage format (WAVEFORM_PACKED_STORAGE) and the post-weld kernels
+ * live in waveform_kernels.h/.c; this file owns the buffers. */
+#if WAVEFORM_PACKED_STORAGE
+#define WAVEFORM_BUFFER_SIZE 12288
+#else
 #define WAVEFORM_BUFFER_SIZE 4096
-#define WAVEFORM_CHUNK_SAMPLES 100U
+#endif
 #define WAVEFORM_LINE_BUFFER_SIZE (WAVEFORM_CHUNK_SAMPLES * 18 + 256)
-#define WAVEFORM_SAMPLE_INTERVAL_US 100U
+
+/* Waveform capture engine:
+ * 1 = TIM6 TRGO triggers ADC1+ADC2 in dual regular-simultaneous mode and DMA
+ *     moves every conversion pair into a circular ring; the weld loops only
+ *     drain the ring (no ADC start/poll/stop per sample). Gives true
+ *     simultaneous shunt P/N and measured Vcap+/Vcap- on every sample.
+ * 0 = legacy polled path (adcReadFastCurrentPair/Triplet every 100us).
+ * If the DMA engine fails to start, fireRecipe() falls back to the polled
+ * path (and its interval, see waveform_interval_us) for that weld. */
+#define WAVEFORM_DMA_CAPTURE 1
+
+#define WAVEFORM_POLLED_INTERVAL_US 100U
+#if WAVEFORM_DMA_CAPTURE
+/* 20us = 50 kS/s per channel. A dual conversion pair at 47.5 cycles takes
+ * ~2.8us (ADC clock 42.5MHz), so 10U also works at half the capture
+ * window. */
+#define WAVEFORM_SAMPLE_INTERVAL_US 20U
+#else
+#define WAVEFORM_SAMPLE_INTERVAL_US WAVEFORM_POLLED_INTERVAL_US
+#endif
 /*
  * Gap timing compensation: scope-measured overhead from preheat-FET-off
  * to gap-timer-start plus gap-timer-end to main-FET-on.  This fixed cost
@@ -373,9 +439,36 @@ static const float LEAD_RESISTANCE_MAX_OHMS = 0.0100f; /* 10.0 mΩ */
 #define PWM_PERIOD_US 100U
 #define WAVEFORM_PWM_PHASE_SWEEP_STEP_US 12U
 #define WAVEFORM_PWM_PHASE_SWEEP_SAMPLES 6U
-#define WAVEFORM_PRE_SAMPLES 10U  /* 1ms pre-buffer */
-#define WAVEFORM_POST_SAMPLES 10U /* 1ms post-buffer */
+#if WAVEFORM_PACKED_STORAGE
+/* Packed storage has room for a longer baseline before the first pulse and
+ * for the cap-bank recovery after the last one. */
+#define WAVEFORM_PRE_MS 2U
+#define WAVEFORM_POST_MS 5U
+#else
+#define WAVEFORM_PRE_MS 1U
+#define WAVEFORM_POST_MS 1U
+#endif
+#define WAVEFORM_PRE_SAMPLES_AT(interval_us) \
+    ((WAVEFORM_PRE_MS * 1000U) / (interval_us))
+#define WAVEFORM_POST_SAMPLES_AT(interval_us) \
+    ((WAVEFORM_POST_MS * 1000U) / (interval_us))
+#define WAVEFORM_PRE_SAMPLES \
+    WAVEFORM_PRE_SAMPLES_AT(WAVEFORM_SAMPLE_INTERVAL_US)
+#define WAVEFORM_POST_SAMPLES \
+    WAVEFORM_POST_SAMPLES_AT(WAVEFORM_SAMPLE_INTERVAL_US)
+#if WAVEFORM_DMA_CAPTURE && WAVEFORM_PACKED_STORAGE
+/* 12288 x 20us = 245ms of buffer: the whole MAX_WELD_MS recipe. */
+#define WAVEFORM_MAX_PULSE_MS 200U
+#elif WAVEFORM_DMA_CAPTURE
+/* 4096 x 20us = 81.9ms of buffer; recipes longer than this keep welding and
+ * integrating joules but stop recording once the buffer is full. */
+#define WAVEFORM_MAX_PULSE_MS 75U
+#elif WAVEFORM_PACKED_STORAGE
+/* 12288 x 100us covers the longest joule_max_ms. */
+#define WAVEFORM_MAX_PULSE_MS 500U
+#else
 #define WAVEFORM_MAX_PULSE_MS 100U
+#endif
 #define WAVEFORM_MAX_ACTIVE_SAMPLES \
     ((WAVEFORM_MAX_PULSE_MS * 1000U) / WAVEFORM_SAMPLE_INTERVAL_US)
 
@@ -388,29 +481,82 @@ static const float LEAD_RESISTANCE_MAX_OHMS = 0.0100f; /* 10.0 mΩ */
 #define ADC_FAST_CURRENT_P_CHANNEL ADC_CHANNEL_2
 #define ADC_FAST_CURRENT_N_CHANNEL ADC_CHANNEL_3
 
-/* Capture capacity supports up to 1ms pre + 100ms pulse + 1ms post = 1020
- * samples. Keep a larger ring (4096) for debug headroom and future longer
- * windows. */
+/* Capture capacity supports pre + WAVEFORM_MAX_PULSE_MS + post
+ * (packed: DMA 10350 / polled 5070 samples; float: DMA 3850 / polled 1020). */
 _Static_assert(WAVEFORM_BUFFER_SIZE >=
                    (WAVEFORM_PRE_SAMPLES + WAVEFORM_MAX_ACTIVE_SAMPLES +
                     WAVEFORM_POST_SAMPLES),
-               "WAVEFORM_BUFFER_SIZE too small for 100ms capture window");
+               "WAVEFORM_BUFFER_SIZE too small for the capture window");
 
-/* Safety check: each sample adds ~14 chars (",AAAA.AA,VV.VV") to WAVEFORM line.
- */
+/* Safety check: buffer indices are uint16_t and the buffer must stay within
+ * the 48 KB RAM budget of the original float layout. */
 _Static_assert(
-    WAVEFORM_BUFFER_SIZE <= 4096,
+    WAVEFORM_BUFFER_SIZE <= ((48U * 1024U) / 4U),
     "Unexpected waveform buffer growth; re-check RAM/UART line budget");
 _Static_assert(WAVEFORM_LINE_BUFFER_SIZE >= (WAVEFORM_CHUNK_SAMPLES * 18 + 256),
                "WAVEFORM_LINE_BUFFER_SIZE too small for waveform CSV payload");
 
-typedef struct {
-    float current_amps;
-    float voltage_volts;
-    uint32_t timestamp_us;
-} WaveformSample;
-
-static WaveformSample waveform_buffer[WAVEFORM_BUFFER_SIZE];
+/* Waveform wire format, negotiated by the host with WAVEFORM_FMT,CSV|BIN.
+ * Not persisted: every boot starts in CSV so hosts that never ask keep
+ * working. BIN sends each chunk as one WAVEFORM_BIN line carrying packed
+ * little-endian samples {int16 current (0.1A), uint16 Vcap (1mV), uint8 dt
+ * (us since previous sample)} base64-encoded, with a sequence number and a
+ * CRC-32 of the packed bytes. Base64 keeps the newline framing the ESP32
+ * relay and TCP clients rely on; ~6.7 chars/sample vs ~20 for CSV. */
+#define WAVEFORM_FMT_CSV 0U
+#define WAVEFORM_FMT_BIN 1U
+#define WAVEFORM_BIN_HEADER_MAX 64U
+
+_Static_assert(WAVEFORM_LINE_BUFFER_SIZE >=
+                   (WAVEFORM_BIN_HEADER_MAX +
+                    ((WAVEFORM_BIN_PAYLOAD_SIZE + 2U) / 3U) * 4U + 1U),
+               "WAVEFORM_LINE_BUFFER_SIZE too small for WAVEFORM_BIN payload");
+
+/* STATUS caps= bitmask: features this firmware supports. Hosts must test
+ * bits, never compare the whole value. */
+#define STATUS_CAP_WAVEFORM_BIN (1UL << 0)
+#define STATUS_CAP_STREAM (1UL << 1)
+#define STATUS_CAP_LINK_SPEED (1UL << 2)
+#define STATUS_CAP_WAVEFORM_SUMMARY (1UL << 3)
+#define STATUS_CAPS                                                      \
+    (STATUS_CAP_WAVEFORM_BIN | STATUS_CAP_STREAM | STATUS_CAP_LINK_SPEED | \
+     STATUS_CAP_WAVEFORM_SUMMARY)
+
+static uint8_t waveform_wire_format = WAVEFORM_FMT_CSV;
+/* WAVEFORM_MODE,SUMMARY: send each weld as a WAVEFORM_SUMMARY envelope and
+ * per-phase statistics (~5 KB) instead of the full burst, which stays
+ * on-chip for WAVEFORM_GET until the next weld. Not persisted, like the
+ * wire format. */
+static bool waveform_summary_mode = false;
+
+/* waveform_store holds up to WELD_SLOT_COUNT captures at once (see Post-weld
+ * pipeline): a new weld records into the largest stretch the previous one,
+ * still being analysed or sent, leaves free. waveform_buffer / _capacity
+ * (and the block table) are the slot being captured. */
+#define WELD_SLOT_COUNT 2U
+
+#if WAVEFORM_PACKED_STORAGE
+/* Timestamp blocks (see WAVEFORM_TS_BLOCK_SAMPLES); +32 for blocks started
+ * early by a dt that does not fit in 8 bits. One table per slot. */
+#define WAVEFORM_TS_MAX_BLOCKS \
+    (WAVEFORM_BUFFER_SIZE / WAVEFORM_TS_BLOCK_SAMPLES + 32U)
+
+static uint32_t waveform_store[WAVEFORM_BUFFER_SIZE];
+static WaveformTsBlock
+    waveform_ts_store[WELD_SLOT_COUNT][WAVEFORM_TS_MAX_BLOCKS];
+static uint32_t* waveform_buffer = waveform_store;
+static WaveformTsBlock* waveform_ts_blocks = waveform_ts_store[0];
+static uint16_t waveform_ts_block_count = 0U;
+static uint32_t waveform_prev_ts_us = 0U;
+#else
+static WaveformSample waveform_store[WAVEFORM_BUFFER_SIZE];
+static WaveformSample* waveform_buffer = waveform_store;
+#endif
+static uint16_t waveform_capacity = WAVEFORM_BUFFER_SIZE;
+/* Count -> engineering-unit scales, latched from measured_vdda when the
+ * capture starts (VDDA is not re-measured during a weld). */
+static float waveform_amps_per_count = 0.0f;
+static float waveform_volts_per_count = 0.0f;
 static volatile uint16_t waveform_index = 0;
 static volatile bool waveform_capture_active = false;
 static uint32_t waveform_capture_start_us = 0;
@@ -448,6 +594,46 @@ static bool adc2_fast_vcap_mode = false;
 static uint32_t adc1_fast_rank1_channel = 0U;
 static uint32_t adc1_fast_rank2_channel = 0U;
 
+#if WAVEFORM_DMA_CAPTURE
+/* Dual-ADC DMA ring. Each sample is two 32-bit CDR words (MDMA=12-bit:
+ * ADC1 master in [15:0], ADC2 slave in [31:16]):
+ *   word 0: ADC1 rank1 = IN3 (PA2, shunt N) | ADC2 rank1 = IN2 (PA1, shunt P)
+ *   word 1: ADC1 rank2 = IN4 (PA3, Vcap+)   | ADC2 rank2 = IN17 (PA4, Vcap-)
+ * PA1 is ADC12_IN2, so ADC2 can take shunt P while ADC1 takes shunt N at the
+ * same instant. 512 samples = ~10ms of slack at 20us before the weld loops
+ * must drain it (UART debug lines during a weld take ~4ms). */
+#define WAVEFORM_DMA_RING_SAMPLES 512U
+#define WAVEFORM_DMA_WORDS_PER_SAMPLE 2U
+#define WAVEFORM_DMA_RING_WORDS \
+    (WAVEFORM_DMA_RING_SAMPLES * WAVEFORM_DMA_WORDS_PER_SAMPLE)
+static volatile uint32_t waveform_dma_ring[WAVEFORM_DMA_RING_WORDS];
+static bool waveform_dma_running = false;
+static uint16_t waveform_dma_read_pos = 0U;    /* ring sample index */
+static uint32_t waveform_dma_consumed = 0U;    /* samples since start */
+static uint32_t waveform_dma_overruns = 0U;    /* ring laps lost (per weld) */
+#endif
+
+/* True when the last capture stored measured Vcap per sample (DMA engine),
+ * so weldReportAnalyze() must not overwrite it with the pre/post
+ * interpolation. */
+static bool waveform_vcap_measured = false;
+
+/* Sample interval of the capture path this weld actually runs:
+ * WAVEFORM_SAMPLE_INTERVAL_US, or WAVEFORM_POLLED_INTERVAL_US after a DMA
+ * start failure. Paces the polled loops and sizes the pre/gap/post windows;
+ * the report latches it for integration and wf_interval_us. */
+static uint32_t waveform_interval_us = WAVEFORM_SAMPLE_INTERVAL_US;
+
+#if WAVEFORM_DMA_CAPTURE
+static void init_waveform_dma_engine(void);
+static bool waveform_dma_start(uint32_t* out_start_us);
+static void waveform_dma_stop(void);
+static bool waveform_dma_pop(uint32_t* out_p, uint32_t* out_n,
+                             uint32_t* out_vp, uint32_t* out_vn,
+                             uint32_t* out_ts_us);
+static uint16_t waveform_dma_service(uint16_t max_samples);
+#endif
+
 /* ============ Contact trigger state ============ */
 static bool contact_hold_active = false;
 static uint32_t contact_hold_start_ms = 0;
@@ -461,6 +647,15 @@ static uint32_t g_contact_pending_since_ms = 0;
 static uint32_t g_contact_last_sample_ms = 0;
 static float g_contact_last_vcap = 0.0f;
 
+/* Contact watch: ADC2 analog watchdog on OUTN (see Contact Watch). The
+ * transition fields are written in ADC1_2_IRQHandler. */
+static volatile bool contact_watch_running = false;
+static volatile bool contact_watch_raw = false; /* vcap over threshold */
+static volatile uint32_t contact_watch_make_ms = 0;
+static uint16_t contact_watch_make_counts = 0U;  /* OUTN below: contact  */
+static uint16_t contact_watch_break_counts = 0U; /* OUTN above: released */
+static float contact_watch_cm_v = 1.44f; /* AMC1311B output common mode */
+
 /* ============ INA226 state (CONTROL SYSTEM) ============ */
 static volatile bool ina226_ok = false;
 static float ina_vpack = 0.0f;
@@ -478,13 +673,30 @@ static bool charger_enabled = false;
 static bool charger_lockout = false;
 static uint32_t charger_lockout_until = 0;
 
-/* ============ UART RX Buffer ============ */
+/* ============ UART RX (DMA + idle line) ============
+ * DMA1 channel 3 writes USART1_RX into a circular byte ring with no CPU
+ * involvement. The USART IDLE interrupt (end of a burst) and the DMA
+ * half/full-transfer interrupts drain it: bytes are assembled into lines and
+ * complete lines go into a queue the main loop empties, so back-to-back
+ * commands are no longer lost while one is being dispatched. The ring covers
+ * ~35 ms at 576 kbaud, longer than a settings-page erase stalls the IRQs. */
 #define RX_LINE_MAX 128
-static uint8_t rx_byte;
+#define UART_RX_DMA_RING_SIZE 2048U
+#define RX_LINE_QUEUE_DEPTH 16U
+_Static_assert((RX_LINE_QUEUE_DEPTH & (RX_LINE_QUEUE_DEPTH - 1U)) == 0U,
+               "RX_LINE_QUEUE_DEPTH must be a power of two");
+static uint8_t uart_rx_dma_ring[UART_RX_DMA_RING_SIZE];
+static uint16_t uart_rx_dma_tail = 0U; /* next ring byte to assemble */
 static char rx_build[RX_LINE_MAX];
 static uint8_t rx_idx = 0;
-static char rx_ready[RX_LINE_MAX];
-static volatile bool rx_line_ready = false;
+static bool rx_discarding = false; /* overlong line: drop until EOL */
+static char rx_queue[RX_LINE_QUEUE_DEPTH][RX_LINE_MAX];
+static volatile uint8_t rx_queue_head = 0U; /* free-running, RX IRQs only */
+static volatile uint8_t rx_queue_tail = 0U; /* free-running, main loop only */
+static uint8_t rx_queue_high_water = 0U;
+static volatile uint32_t uart_rx_line_drops = 0U;
+static volatile uint32_t uart_rx_line_overlong = 0U;
+static volatile uint32_t uart_rx_dma_errors = 0U;
 
 /* ============ UART debug ============ */
 #define DEBUG_UART_RX 1
@@ -492,6 +704,189 @@ static volatile uint32_t uart_rx_bytes = 0;
 static volatile uint32_t uart_rx_errors = 0;
 static volatile uint32_t uart_rx_overruns = 0;
 
+/* ============ UART link speed ============
+ * The application link boots at LINK_BASE_BAUD, the rate the UART3-IN
+ * level shifters are known to pass. A host may opt in to a faster rate
+ * with LINK_SPEED,<baud> (see PROTOCOL.md): the switch is a trial that
+ * reverts on its own after LINK_SPEED_TRIAL_MS unless the host proves the
+ * rate with CRC'd LINK_PROBE lines and sends LINK_SPEED,COMMIT. A committed
+ * rate drops back to LINK_BASE_BAUD on LINK_SPEED_ERR_LIMIT framing/noise
+ * errors inside LINK_SPEED_ERR_WINDOW_MS, or when no line has arrived for
+ * LINK_SPEED_SILENCE_MS (the P4 sends READY every second). */
+#define LINK_BASE_BAUD 576000UL
+#define LINK_SPEED_TRIAL_MS 1500U
+#define LINK_SPEED_ERR_LIMIT 8U
+#define LINK_SPEED_ERR_WINDOW_MS 1000U
+#define LINK_SPEED_SILENCE_MS 3000U
+#define LINK_PROBE_REPLY_LEN 384U
+
+#define LINK_STATE_BASE 0U
+#define LINK_STATE_TRIAL 1U  /* switched, waiting for LINK_SPEED,COMMIT */
+#define LINK_STATE_FAST 2U   /* committed */
+
+static uint32_t link_baud = LINK_BASE_BAUD;
+static uint8_t link_state = LINK_STATE_BASE;
+static uint32_t link_switch_ms = 0U;
+static uint32_t link_err_window_ms = 0U;
+static uint32_t link_err_base = 0U;
+static uint32_t link_last_rx_ms = 0U;
+
+/* ============ UART TX Queue (DMA) ============
+ * uartSend() copies the line (+CRLF) into one of two byte rings and returns;
+ * DMA1 channel 2 drains them into USART1->TDR and its transfer-complete IRQ
+ * starts the next segment. The priority lane (ACK/DENY/ERR/EVENT/CAL/BOOT)
+ * is always served first, but only at a line boundary, so lanes never
+ * interleave inside a line. Bulk lines (STATUS, WAVEFORM_*, DBG) wait for
+ * ring space up to UART_TX_TIMEOUT_MS with the IWDG fed; priority lines
+ * never wait. Lines that don't fit are dropped and counted in RXHEALTH. */
+#define UART_TX_LANE_PRIO 0U
+#define UART_TX_LANE_BULK 1U
+#define UART_TX_PRIO_RING_SIZE 1024U
+#define UART_TX_BULK_RING_SIZE 16384U
+
+_Static_assert((UART_TX_PRIO_RING_SIZE & (UART_TX_PRIO_RING_SIZE - 1U)) == 0U &&
+                   (UART_TX_BULK_RING_SIZE & (UART_TX_BULK_RING_SIZE - 1U)) ==
+                       0U,
+               "UART TX ring sizes must be powers of two");
+
+typedef struct {
+    uint8_t* buf;
+    uint16_t mask;
+    volatile uint16_t head; /* advanced by uartSend() only */
+    volatile uint16_t tail; /* advanced by the DMA TC IRQ only */
+    volatile uint32_t dropped;
+    uint16_t high_water;
+} UartTxLane;
+
+static uint8_t uart_tx_prio_buf[UART_TX_PRIO_RING_SIZE];
+static uint8_t uart_tx_bulk_buf[UART_TX_BULK_RING_SIZE];
+static UartTxLane uart_tx_lanes[2] = {
+    {uart_tx_prio_buf, UART_TX_PRIO_RING_SIZE - 1U, 0U, 0U, 0U, 0U},
+    {uart_tx_bulk_buf, UART_TX_BULK_RING_SIZE - 1U, 0U, 0U, 0U, 0U},
+};
+static bool uart_tx_dma_ready = false;
+static volatile bool uart_tx_busy = false;
+static volatile uint8_t uart_tx_active_lane = 0U;
+static volatile uint16_t uart_tx_active_len = 0U;
+/* A bulk line wrapped the ring end and only its first part has gone out;
+ * the priority lane must wait for the rest. */
+static volatile bool uart_tx_bulk_mid_line = false;
+static volatile uint32_t uart_tx_dma_errors = 0U;
+
+/* ============ Latency Instrumentation (PERF) ============
+ * DWT->CYCCNT timestamps along the weld path, folded into one histogram per
+ * stage. "PERF" reports min/avg/p99/max per stage plus the UART loss
+ * counters; "PERF_RESET" clears them. Stages:
+ *   pedal_fire  pedal EXTI edge -> fireRecipe() called (includes the
+ *               PEDAL_DEBOUNCE_MS debounce)
+ *   fire_fet    fireRecipe() entry -> first FET on (includes charger settle)
+ *   kill_isr    TIM2 expiry -> TIM2_IRQHandler FET kill (per pulse)
+ *   fet_done    last FET off -> EVENT,WELD_DONE queued by jobPostWeld()
+ *               (Vcap settle, energy math, the previous weld's burst)
+ *   done_wire   EVENT,WELD_DONE queued -> its last byte handed to the UART
+ *   trig_done   trigger (pedal edge / contact hold / CMD,FIRE) -> WELD_DONE
+ *   loop        main-loop iteration, iterations that fired a weld excluded
+ *   analyze     weldReportAnalyze() Vcap overlay + wf_analyze_pulse()
+ * Everything is recorded on the main thread; the ISRs only store a
+ * timestamp. Bins are log-linear (exact below 16 cycles, then 4 per
+ * power of two), so p99 is the upper edge of its bin: within 25 %. */
+#define PERF_STATS 1
+#if PERF_STATS
+#define PERF_CYC_PER_US 170U /* matches micros_now() */
+#define PERF_BINS 128U
+
+enum {
+    PERF_PEDAL_FIRE = 0,
+    PERF_FIRE_FET,
+    PERF_KILL_ISR,
+    PERF_FET_DONE,
+    PERF_DONE_WIRE,
+    PERF_TRIG_DONE,
+    PERF_LOOP,
+    PERF_ANALYZE,
+    PERF_STAGE_COUNT
+};
+
+static const char* const perf_stage_names[PERF_STAGE_COUNT] = {
+    "pedal_fire", "fire_fet", "kill_isr", "fet_done",
+    "done_wire",  "trig_done", "loop",     "analyze"};
+
+typedef struct {
+    uint32_t n;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint16_t bin[PERF_BINS]; /* saturating counts */
+} PerfHist;
+
+static PerfHist perf_hist[PERF_STAGE_COUNT];
+static uint32_t perf_trigger_cyc = 0U;    /* start of the current weld */
+static bool perf_trigger_valid = false;
+static bool perf_fire_pending = false;    /* fire_fet not yet recorded */
+static uint32_t perf_fire_cyc = 0U;
+static uint32_t perf_fet_off_cyc = 0U;    /* end of the latest pulse */
+static bool perf_fet_off_valid = false;
+static bool perf_loop_fired = false;      /* skip this loop iteration */
+static volatile uint32_t tim2_kill_cyc = 0U; /* TIM2_IRQHandler */
+/* done_wire: bytes of the priority lane still ahead of the end of the
+ * WELD_DONE line, counted down by the TX DMA IRQ. */
+static volatile bool perf_tx_arm = false; /* next priority line is it */
+static volatile int32_t perf_tx_left = 0;
+static volatile uint32_t perf_tx_start_cyc = 0U;
+static volatile uint32_t perf_tx_done_cyc = 0U;
+static volatile bool perf_tx_done = false;
+
+static inline uint32_t perf_cyc(void) { return DWT->CYCCNT; }
+
+static uint32_t perf_bin(uint32_t v) {
+    if (v < 16U) {
+        return v;
+    }
+    const uint32_t msb = 31U - (uint32_t)__CLZ(v); /* >= 4 */
+    return 16U + (msb - 4U) * 4U + ((v >> (msb - 2U)) & 3U);
+}
+
+static uint32_t perf_bin_upper(uint32_t b) {
+    if (b < 16U) {
+        return b;
+    }
+    const uint32_t msb = (b - 16U) / 4U + 4U;
+    const uint32_t sub = (b - 16U) % 4U;
+    return ((4U + sub) << (msb - 2U)) + ((1U << (msb - 2U)) - 1U);
+}
+
+static void perf_record(uint8_t stage, uint32_t cycles) {
+    PerfHist* h = &perf_hist[stage];
+    if (h->n == 0U || cycles < h->min) h->min = cycles;
+    if (cycles > h->max) h->max = cycles;
+    h->n++;
+    h->sum += cycles;
+    uint16_t* b = &h->bin[perf_bin(cycles)];
+    if (*b != 0xFFFFU) (*b)++;
+}
+
+static uint32_t perf_p99(const PerfHist* h) {
+    const uint32_t want = h->n - h->n / 100U; /* ceil(0.99 n) */
+    uint32_t seen = 0U;
+    for (uint32_t b = 0U; b < PERF_BINS; b++) {
+        seen += h->bin[b];
+        if (seen >= want) {
+            const uint32_t up = perf_bin_upper(b);
+            return (up < h->max) ? up : h->max;
+        }
+    }
+    return h->max; /* a bin saturated */
+}
+
+/* Main loop: fold the IRQ-side timestamps into their histograms. */
+static void perf_service(void) {
+    if (perf_tx_done) {
+        perf_tx_done = false;
+        perf_record(PERF_DONE_WIRE, perf_tx_done_cyc - perf_tx_start_cyc);
+    }
+}
+#endif /* PERF_STATS */
+
 /* ============ INA226 Bare-Metal I2C Driver ============ */
 
 static bool ina226_write_reg(uint8_t addr, uint8_t reg, uint16_t val) {
@@ -512,23 +907,18 @@ static bool ina226_read_reg(uint8_t addr, uint8_t reg, uint16_t* val) {
     return true;
 }
 
-static bool ina226_read_bus_voltage(uint8_t addr, float* voltage) {
-    uint16_t raw;
-    if (!ina226_read_reg(addr, INA226_REG_BUS_V, &raw)) return false;
-    *voltage = raw * 0.00125f; /* 1.25 mV/bit */
-    return true;
+static float ina226_bus_volts(uint16_t raw) {
+    return raw * 0.00125f; /* 1.25 mV/bit */
 }
 
-static bool ina226_read_shunt_current(uint8_t addr, float* current) {
-    uint16_t raw;
-    if (!ina226_read_reg(addr, INA226_REG_SHUNT_V, &raw)) return false;
+static float ina226_shunt_amps(uint16_t raw) {
     int16_t signed_raw = (int16_t)raw;
     float shunt_voltage_v = signed_raw * 0.0000025f; /* 2.5 µV/bit */
     float calculated_current = shunt_voltage_v / INA226_SHUNT_R;
-    *current = (-calculated_current) * CHARGE_CURRENT_CORRECTION;
-    if (fabsf(*current) < 0.010f) *current = 0.0f;
-    if (*current > 50.0f) *current = 50.0f;
-    return true;
+    float current = (-calculated_current) * CHARGE_CURRENT_CORRECTION;
+    if (fabsf(current) < 0.010f) current = 0.0f;
+    if (current > 50.0f) current = 50.0f;
+    return current;
 }
 
 static bool ina226_health_check(void) {
@@ -546,46 +936,174 @@ static bool ina226_health_check(void) {
     return true;
 }
 
+/* One poll = these four register reads, in this order. */
+#define INA226_SEQ_LEN 4U
+static const struct {
+    uint8_t addr;
+    uint8_t reg;
+} ina226_seq[INA226_SEQ_LEN] = {
+    {INA226_ADDR_PACK, INA226_REG_BUS_V},
+    {INA226_ADDR_NODE1, INA226_REG_BUS_V},
+    {INA226_ADDR_NODE2, INA226_REG_BUS_V},
+    {INA226_ADDR_PACK, INA226_REG_SHUNT_V},
+};
+
+static void ina226_fail(void) {
+    ina226_ok = false;
+    /* Safety: disable charger if any sensor is missing or a read failed */
+    HAL_GPIO_WritePin(CHARGER_EN_PORT, CHARGER_EN_PIN, GPIO_PIN_RESET);
+    charger_enabled = false;
+}
+
+/* raw[] in ina226_seq order. */
+static void ina226_commit(const uint16_t* raw) {
+    ina226_ok = true;
+
+    ina_vpack = ina226_bus_volts(raw[0]) * VPACK_SCALE;
+    vlow = ina226_bus_volts(raw[1]) * V_NODE1_SCALE;
+    vmid = ina226_bus_volts(raw[2]) * V_NODE2_SCALE;
+
+    /* Correct cell voltage math:
+     * [Pack-] ── Cell_Bot ── (vlow/0x41) ── Cell_Mid ── (vmid/0x44) ── Cell_Top
+     * ── [Pack+]
+     */
+    ina_cell1 = vlow;             /* Bottom cell */
+    ina_cell2 = vmid - vlow;      /* Middle cell */
+    ina_cell3 = ina_vpack - vmid; /* Top cell    */
+
+    ina_ichg = ina226_shunt_amps(raw[3]);
+}
+
+/* Blocking read of all sensors. Boot only: the main loop uses the
+ * interrupt-driven sequence below. */
 static void ina226_read_all(void) {
     /* Step 1: Verify all three sensors are present on the bus */
     if (!ina226_health_check()) {
-        ina226_ok = false;
-        /* Safety: disable charger if any sensor missing */
-        HAL_GPIO_WritePin(CHARGER_EN_PORT, CHARGER_EN_PIN, GPIO_PIN_RESET);
-        charger_enabled = false;
+        ina226_fail();
         return;
     }
 
-    float vp = 0, vl = 0, vm = 0, ichg = 0;
-    bool ok = true;
+    uint16_t raw[INA226_SEQ_LEN];
+    for (uint8_t k = 0U; k < INA226_SEQ_LEN; k++) {
+        if (!ina226_read_reg(ina226_seq[k].addr, ina226_seq[k].reg, &raw[k])) {
+            ina226_fail();
+            return;
+        }
+    }
+    ina226_commit(raw);
+}
 
-    if (!ina226_read_bus_voltage(INA226_ADDR_PACK, &vp)) ok = false;
-    if (!ina226_read_bus_voltage(INA226_ADDR_NODE1, &vl)) ok = false;
-    if (!ina226_read_bus_voltage(INA226_ADDR_NODE2, &vm)) ok = false;
-    if (!ina226_read_shunt_current(INA226_ADDR_PACK, &ichg)) ok = false;
+/* ---- Interrupt-driven polling ----
+ * ina226_seq_start() queues the first register read with
+ * HAL_I2C_Mem_Read_IT(); each completion (I2C1 event IRQ) starts the next
+ * one, so the main loop never waits on the bus (~3 ms per sequence at
+ * 100 kHz). ina226_seq_poll() commits a finished sequence. A NACK or bus
+ * error (I2C1 error IRQ), or a sequence still running after
+ * INA226_SEQ_TIMEOUT_MS, fails the poll exactly like the blocking read did:
+ * ina226_ok = false and the charger OFF. A wedged bus is re-initialised
+ * (and, when disarmed, unstuck with i2c_bus_recovery()). The chain stops
+ * while welding_now is set so the bus stays quiet during a weld. */
+#define INA226_SEQ_TIMEOUT_MS 20U
+
+typedef enum {
+    INA_SEQ_IDLE = 0,
+    INA_SEQ_BUSY,
+    INA_SEQ_DONE,
+    INA_SEQ_ERROR,
+    INA_SEQ_SKIPPED /* stopped for a weld, not a sensor fault */
+} InaSeqState;
+
+static volatile uint8_t ina226_seq_state = INA_SEQ_IDLE;
+static volatile uint8_t ina226_seq_step = 0U;
+static uint8_t ina226_seq_buf[INA226_SEQ_LEN][2];
+static uint32_t ina226_seq_start_ms = 0U;
+static uint32_t ina226_seq_errors = 0U;
+static uint32_t ina226_seq_timeouts = 0U;
+
+static bool ina226_seq_read_step(uint8_t step) {
+    return HAL_I2C_Mem_Read_IT(&hi2c1, (uint16_t)(ina226_seq[step].addr << 1),
+                               ina226_seq[step].reg, I2C_MEMADD_SIZE_8BIT,
+                               ina226_seq_buf[step], 2) == HAL_OK;
+}
 
-    ina226_ok = ok;
+static void ina226_seq_start(void) {
+    if (ina226_seq_state == INA_SEQ_BUSY) {
+        return; /* previous sequence still on the bus: poll times it out */
+    }
+    ina226_seq_step = 0U;
+    ina226_seq_start_ms = HAL_GetTick();
+    ina226_seq_state = INA_SEQ_BUSY;
+    if (!ina226_seq_read_step(0U)) {
+        ina226_seq_state = INA_SEQ_ERROR;
+    }
+}
 
-    if (!ok) {
-        /* Safety: disable charger on read failure */
-        HAL_GPIO_WritePin(CHARGER_EN_PORT, CHARGER_EN_PIN, GPIO_PIN_RESET);
-        charger_enabled = false;
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef* hi2c) {
+    if (hi2c->Instance != I2C1 || ina226_seq_state != INA_SEQ_BUSY) {
         return;
     }
+    const uint8_t next = (uint8_t)(ina226_seq_step + 1U);
+    if (next >= INA226_SEQ_LEN) {
+        ina226_seq_state = INA_SEQ_DONE;
+    } else if (welding_now) {
+        ina226_seq_state = INA_SEQ_SKIPPED;
+    } else {
+        ina226_seq_step = next;
+        if (!ina226_seq_read_step(next)) {
+            ina226_seq_state = INA_SEQ_ERROR;
+        }
+    }
+}
 
-    ina_vpack = vp * VPACK_SCALE;
-    vlow = vl * V_NODE1_SCALE;
-    vmid = vm * V_NODE2_SCALE;
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c) {
+    if (hi2c->Instance == I2C1 && ina226_seq_state == INA_SEQ_BUSY) {
+        ina226_seq_state = INA_SEQ_ERROR;
+    }
+}
 
-    /* Correct cell voltage math:
-     * [Pack-] ── Cell_Bot ── (vlow/0x41) ── Cell_Mid ── (vmid/0x44) ── Cell_Top
-     * ── [Pack+]
-     */
-    ina_cell1 = vlow;             /* Bottom cell */
-    ina_cell2 = vmid - vlow;      /* Middle cell */
-    ina_cell3 = ina_vpack - vmid; /* Top cell    */
+/* Returns true when a sequence finished (committed or failed). */
+static bool ina226_seq_poll(void) {
+    switch (ina226_seq_state) {
+        case INA_SEQ_BUSY:
+            if ((HAL_GetTick() - ina226_seq_start_ms) < INA226_SEQ_TIMEOUT_MS) {
+                return false;
+            }
+            ina226_seq_timeouts++;
+            HAL_NVIC_DisableIRQ(I2C1_EV_IRQn);
+            HAL_NVIC_DisableIRQ(I2C1_ER_IRQn);
+            ina226_seq_state = INA_SEQ_IDLE;
+            HAL_I2C_DeInit(&hi2c1);
+            if (!armed) {
+                i2c_bus_recovery(); /* ~22 ms blocking: never while armed */
+            }
+            MX_I2C1_Init();
+            ina226_fail();
+            return true;
+
+        case INA_SEQ_DONE: {
+            uint16_t raw[INA226_SEQ_LEN];
+            for (uint8_t k = 0U; k < INA226_SEQ_LEN; k++) {
+                raw[k] = ((uint16_t)ina226_seq_buf[k][0] << 8) |
+                         ina226_seq_buf[k][1];
+            }
+            ina226_seq_state = INA_SEQ_IDLE;
+            ina226_commit(raw);
+            return true;
+        }
+
+        case INA_SEQ_ERROR:
+            ina226_seq_errors++;
+            ina226_seq_state = INA_SEQ_IDLE;
+            ina226_fail();
+            return true;
 
-    ina_ichg = ichg;
+        case INA_SEQ_SKIPPED:
+            ina226_seq_state = INA_SEQ_IDLE;
+            return false;
+
+        default:
+            return false;
+    }
 }
 
 /* ============ Charger State Machine (INA226 ONLY) ============ */
@@ -635,10 +1153,98 @@ static void chargerStateMachine(void) {
     }
 }
 
+/* ============ Telemetry Stream (STREAM command) ============
+ * STREAM,<rate_hz>,<mask> subscribes the host to pushed telemetry:
+ *   rate_hz  1..50 = periodic packet rate, 0 = no periodic packets
+ *   mask     bit0 = periodic STATUS, bit1 = periodic STATUS2,
+ *            bit2 = STATUS_DELTA as soon as armed/ready/welding/contact/
+ *                   fault change (priority TX lane).
+ * Boot default is the legacy 2 Hz STATUS+STATUS2 without deltas, so a host
+ * that never sends STREAM sees the old behaviour. */
+#define STREAM_MASK_STATUS (1UL << 0)
+#define STREAM_MASK_STATUS2 (1UL << 1)
+#define STREAM_MASK_DELTA (1UL << 2)
+#define STREAM_MASK_ALL \
+    (STREAM_MASK_STATUS | STREAM_MASK_STATUS2 | STREAM_MASK_DELTA)
+#define STREAM_RATE_MAX_HZ 50U
+#define STREAM_DEFAULT_RATE_HZ 2U
+
+/* STATUS_DELTA fault= bitmask. */
+#define STATUS_FAULT_OVERHEAT (1UL << 0)    /* temp > OVERHEAT_TEMP_C      */
+#define STATUS_FAULT_THERMISTOR (1UL << 1)  /* thermistor open/short       */
+#define STATUS_FAULT_INA226 (1UL << 2)      /* INA226 bus not responding   */
+#define STATUS_FAULT_CHG_LOCKOUT (1UL << 3) /* post-weld charger lockout   */
+
+static uint8_t stream_rate_hz = STREAM_DEFAULT_RATE_HZ;
+static uint32_t stream_mask = STREAM_MASK_STATUS | STREAM_MASK_STATUS2;
+static uint32_t stream_delta_seq = 0U;
+static uint32_t stream_last_state = 0xFFFFFFFFUL; /* forces a first delta */
+
+static uint32_t statusFaultBits(void) {
+    uint32_t f = 0U;
+    if (temp_filtered_c > OVERHEAT_TEMP_C) f |= STATUS_FAULT_OVERHEAT;
+    if (temp_filtered_c <= -50.0f) f |= STATUS_FAULT_THERMISTOR;
+    if (!ina226_ok) f |= STATUS_FAULT_INA226;
+    if (charger_lockout) f |= STATUS_FAULT_CHG_LOCKOUT;
+    return f;
+}
+
+/* armed | ready | welding | contact in bits 0..3, faults from bit 8. */
+static uint32_t streamStateWord(void) {
+    return (armed ? 1UL : 0UL) | (system_ready ? 2UL : 0UL) |
+           (welding_now ? 4UL : 0UL) | (g_contact_state ? 8UL : 0UL) |
+           (statusFaultBits() << 8);
+}
+
+/* Emit STATUS_DELTA if a subscribed host has not seen the current state.
+ * Cheap enough for every main-loop pass and the weld start. */
+static void streamCheckDelta(void) {
+    if ((stream_mask & STREAM_MASK_DELTA) == 0U) {
+        return;
+    }
+    const uint32_t state = streamStateWord();
+    if (state == stream_last_state) {
+        return;
+    }
+    stream_last_state = state;
+    stream_delta_seq++;
+
+    char buf[96];
+    snprintf(buf, sizeof(buf),
+             "STATUS_DELTA,seq=%lu,armed=%d,ready=%d,welding=%d,contact=%d,"
+             "fault=%lu",
+             (unsigned long)stream_delta_seq, (state & 1UL) ? 1 : 0,
+             (state & 2UL) ? 1 : 0, (state & 4UL) ? 1 : 0,
+             (state & 8UL) ? 1 : 0, (unsigned long)(state >> 8));
+    uartSend(buf);
+}
+
 /* ============ UART Status Packets (split into two for ESP32 parsing)
  * ============ */
 
+static void sendStatusPackets(uint32_t mask);
+
+/* Full STATUS + STATUS2 (command replies, STATUS request, after SET_*). */
 static void sendStatusPacket(void) {
+    sendStatusPackets(STREAM_MASK_STATUS | STREAM_MASK_STATUS2);
+}
+
+/* Periodic push at the STREAM rate (main loop). */
+static void streamService(void) {
+    static uint32_t last_push_ms = 0;
+    const uint32_t mask =
+        stream_mask & (STREAM_MASK_STATUS | STREAM_MASK_STATUS2);
+    if (stream_rate_hz > 0U && mask != 0U) {
+        const uint32_t now = HAL_GetTick();
+        if ((now - last_push_ms) >= (1000U / stream_rate_hz)) {
+            last_push_ms = now;
+            sendStatusPackets(mask);
+        }
+    }
+    streamCheckDelta();
+}
+
+static void sendStatusMain(void) {
     char buf[512];
 
     /* --- Packet 1: STATUS (system state + full runtime recipe/settings) --- */
@@ -667,7 +1273,8 @@ static void sendStatusPacket(void) {
                  "control_mode=%u,joule_target_j=%.1f,joule_target=%.1f,joule_"
                  "actual=%.1f,"
                  "joule_total=%.1f,joule_lead_loss=%.1f,"
-                 "joule_duration_ms=%lu,joule_status=%s,joule_max_ms=%lu",
+                 "joule_duration_ms=%lu,joule_status=%s,joule_max_ms=%lu,"
+                 "caps=%lu,wf_fmt=%u,link_baud=%lu,wf_mode=%u",
                  armed ? 1 : 0, system_ready ? 1 : 0, welding_now ? 1 : 0, vcap,
                  temp_filtered_c, (int)weld_mode, (unsigned)weld_d1_ms,
                  (unsigned)weld_gap1_ms, (unsigned)weld_d2_ms,
@@ -680,7 +1287,9 @@ static void sendStatusPacket(void) {
                  joule_target_j, joule_accumulated, joule_total_accumulated,
                  joule_lead_loss_accumulated,
                  (unsigned long)(joule_actual_duration_us / 1000U),
-                 joule_status, (unsigned long)joule_max_ms);
+                 joule_status, (unsigned long)joule_max_ms,
+                 (unsigned long)STATUS_CAPS, (unsigned)waveform_wire_format,
+                 (unsigned long)link_baud, waveform_summary_mode ? 1U : 0U);
     } else {
         snprintf(buf, sizeof(buf),
                  "STATUS,armed=%d,ready=%d,welding=%d,vcap=%.2f,"
@@ -688,7 +1297,8 @@ static void sendStatusPacket(void) {
                  "power=%.2f,preheat_en=%d,preheat_ms=%u,preheat_pct=%u,"
                  "preheat_gap_ms=%u,trigger_mode=%u,contact_hold_steps=%u,"
                  "contact_with_pedal=%u,vdda=%.3f,lead_r_ohm=%.6f,"
-                 "control_mode=%u,joule_target_j=%.1f,joule_max_ms=%lu",
+                 "control_mode=%u,joule_target_j=%.1f,joule_max_ms=%lu,"
+                 "caps=%lu,wf_fmt=%u,link_baud=%lu,wf_mode=%u",
                  armed ? 1 : 0, system_ready ? 1 : 0, welding_now ? 1 : 0, vcap,
                  temp_filtered_c, (int)weld_mode, (unsigned)weld_d1_ms,
                  (unsigned)weld_gap1_ms, (unsigned)weld_d2_ms,
@@ -698,9 +1308,15 @@ static void sendStatusPacket(void) {
                  (unsigned)trigger_mode, (unsigned)contact_hold_steps,
                  (unsigned)contact_with_pedal, measured_vdda,
                  lead_resistance_ohms, (unsigned)control_mode, joule_target_j,
-                 (unsigned long)joule_max_ms);
+                 (unsigned long)joule_max_ms, (unsigned long)STATUS_CAPS,
+                 (unsigned)waveform_wire_format, (unsigned long)link_baud,
+                 waveform_summary_mode ? 1U : 0U);
     }
     uartSend(buf);
+}
+
+static void sendStatus2(void) {
+    char buf[192];
 
     /* --- Packet 2: STATUS2 (INA226 telemetry) --- */
     snprintf(buf, sizeof(buf),
@@ -711,6 +1327,11 @@ static void sendStatusPacket(void) {
     uartSend(buf);
 }
 
+static void sendStatusPackets(uint32_t mask) {
+    if (mask & STREAM_MASK_STATUS) sendStatusMain();
+    if (mask & STREAM_MASK_STATUS2) sendStatus2();
+}
+
 /* ============ Shunt Sensing Functions ============ */
 static uint32_t adcReadSingleConfigured(ADC_HandleTypeDef* hadc,
                                         uint32_t timeout_ms) {
@@ -1110,11 +1731,30 @@ static bool adcReadFastTriplet(uint32_t* out_p, uint32_t* out_n,
     return true;
 }
 
+/* Rebuild the integer Joule scale from the current calibration.  Cheap
+ * (a handful of float ops) but kept out of the per-sample path. */
+static void joule_fixed_build_scale(void) {
+    const float v_per_count = measured_vdda / 4095.0f;
+    const float ki =
+        (v_per_count / SHUNT_GAIN / SHUNT_EFF_OHMS) * CURRENT_CAL_FACTOR;
+    const float kv = v_per_count * V_CAP_DIVIDER;
+    joule_build_scale(ki, kv, lead_resistance_ohms, joule_min_current_a,
+                      joule_target_j, &joule_fx_scale);
+}
+
+/* Publish the integer accumulators into the float joule_* globals. */
+static void joule_fixed_publish(void) {
+    const float jpu = joule_ctl.scale.joules_per_unit;
+    joule_total_accumulated = (float)joule_ctl.total_units * jpu;
+    joule_lead_loss_accumulated = (float)joule_ctl.loss_units * jpu;
+    joule_accumulated = (float)joule_ctl.work_units * jpu;
+    joule_actual_duration_us = joule_ctl.duration_us;
+}
+
 static void capturePulseAmpsForDurationUs(uint32_t pulse_duration_us,
                                           uint16_t duty) {
     uint32_t peak_raw = 0;
-    float peak_current = 0.0f;
-    float sum_current = 0.0f;
+    uint64_t sum_counts = 0U;
     uint32_t sample_count = 0;
 
     if (pulse_duration_us == 0U) {
@@ -1124,6 +1764,9 @@ static void capturePulseAmpsForDurationUs(uint32_t pulse_duration_us,
     }
 
     const float v_per_count = measured_vdda / 4095.0f;
+    const float amps_per_count =
+        (v_per_count / SHUNT_GAIN / SHUNT_EFF_OHMS) * CURRENT_CAL_FACTOR;
+    const uint32_t cached_vcap_counts = waveform_volts_to_counts(cached_vcap);
 
     /*
      * IMPORTANT (preheat fix): when PWM duty < 100%, sampling exactly every
@@ -1134,17 +1777,30 @@ static void capturePulseAmpsForDurationUs(uint32_t pulse_duration_us,
      */
     const bool pulse_uses_pwm_window =
         (duty > 0U) && (duty < PWM_MAX) &&
-        (WAVEFORM_SAMPLE_INTERVAL_US == PWM_PERIOD_US);
+        (waveform_interval_us == PWM_PERIOD_US);
+
+    /* DMA engine: samples are paced by TIM6, the loop only pops them. */
+#if WAVEFORM_DMA_CAPTURE
+    const bool dma_capture = waveform_dma_running;
+#else
+    const bool dma_capture = false;
+#endif
 
     uint32_t pulse_start_us = micros_now();
+#if JOULE_PREDICTIVE_CUTOFF
+    /* TIM2 counts µs since FET-on; it was started just before this call. */
+    const uint32_t tim2_cnt_at_start = TIM2->CNT;
+    const uint32_t tim2_arr_limit = TIM2->ARR;
+#endif
     uint32_t pulse_end_estimate_us = pulse_start_us + pulse_duration_us;
     uint32_t next_sample_us = pulse_start_us;
 
     const bool joule_mode_active = (control_mode == 1U);
-    const uint32_t joule_bad_contact_limit_us = 5000U;
-    uint32_t joule_low_current_streak_us = 0U;
-    uint32_t joule_duration_offset_us = joule_actual_duration_us;
-    uint32_t joule_last_sample_elapsed_us = 0U;
+    if (joule_mode_active) {
+        joule_fixed_build_scale();
+        joule_pulse_begin(&joule_ctl, &joule_fx_scale, duty >= PWM_MAX,
+                          waveform_interval_us, JOULE_PREDICT_HORIZON_US);
+    }
 
     /*
      * ── BRICK SHITHOUSE TIMING ──────────────────────────────────────────
@@ -1170,19 +1826,36 @@ static void capturePulseAmpsForDurationUs(uint32_t pulse_duration_us,
      */
     while (!tim2_fet_killed) {
         uint32_t now_us = micros_now();
-        if ((int32_t)(now_us - next_sample_us) < 0) {
+        if (!dma_capture && (int32_t)(now_us - next_sample_us) < 0) {
             continue;
         }
 
         int32_t diff = 0;
-        float amps = 0.0f;
-        float v_cap_live = cached_vcap;
+        uint32_t vcap_counts = cached_vcap_counts;
         uint32_t sample_capture_us = now_us;
 
+#if WAVEFORM_DMA_CAPTURE
+        if (dma_capture) {
+            uint32_t p = 0U;
+            uint32_t n = 0U;
+            uint32_t v_p = 0U;
+            uint32_t v_n = 0U;
+            uint32_t ts_us = 0U;
+            if (!waveform_dma_pop(&p, &n, &v_p, &v_n, &ts_us)) {
+                continue;
+            }
+            sample_capture_us = waveform_capture_start_us + ts_us;
+
+            diff = (int32_t)p - (int32_t)n;
+            if (diff < 0) {
+                diff = 0;
+            }
+            vcap_counts = (v_p > v_n) ? (v_p - v_n) : 0U;
+        } else
+#endif
         if (pulse_uses_pwm_window) {
             int32_t best_diff = 0;
-            float best_amps = 0.0f;
-            float best_v_cap_live = cached_vcap;
+            uint32_t best_vcap_counts = cached_vcap_counts;
             uint32_t best_sample_us = now_us;
             uint32_t slot_anchor_us = next_sample_us;
             bool have_sweep_sample = false;
@@ -1220,25 +1893,10 @@ static void capturePulseAmpsForDurationUs(uint32_t pulse_duration_us,
                     sweep_diff = 0;
                 }
 
-                float sweep_v_adc = (float)sweep_diff * v_per_count;
-                float sweep_v_shunt = sweep_v_adc / SHUNT_GAIN;
-                float sweep_amps =
-                    (sweep_v_shunt / SHUNT_EFF_OHMS) * CURRENT_CAL_FACTOR;
-                if (!isfinite(sweep_amps) || sweep_amps < 0.0f) {
-                    sweep_amps = 0.0f;
-                }
-
-                float sweep_v_cap_live = ((float)v_p - (float)v_n) *
-                                         (measured_vdda / 4095.0f) *
-                                         V_CAP_DIVIDER;
-                if (!isfinite(sweep_v_cap_live) || sweep_v_cap_live < 0.0f) {
-                    sweep_v_cap_live = 0.0f;
-                }
-
-                if (!have_sweep_sample || sweep_amps >= best_amps) {
-                    best_amps = sweep_amps;
+                /* Amps are linear in counts: keep the largest diff. */
+                if (!have_sweep_sample || sweep_diff >= best_diff) {
                     best_diff = sweep_diff;
-                    best_v_cap_live = sweep_v_cap_live;
+                    best_vcap_counts = (v_p > v_n) ? (v_p - v_n) : 0U;
                     best_sample_us = sweep_sample_us;
                     have_sweep_sample = true;
                 }
@@ -1249,8 +1907,7 @@ static void capturePulseAmpsForDurationUs(uint32_t pulse_duration_us,
             }
 
             diff = best_diff;
-            amps = best_amps;
-            v_cap_live = best_v_cap_live;
+            vcap_counts = best_vcap_counts;
             sample_capture_us = best_sample_us;
         } else {
             uint32_t p = 0U;
@@ -1268,67 +1925,78 @@ static void capturePulseAmpsForDurationUs(uint32_t pulse_duration_us,
             if (diff < 0) {
                 diff = 0;
             }
-
-            float v_adc = (float)diff * v_per_count;
-            float v_shunt = v_adc / SHUNT_GAIN;
-            amps = (v_shunt / SHUNT_EFF_OHMS) * CURRENT_CAL_FACTOR;
-            if (!isfinite(amps) || amps < 0.0f) amps = 0.0f;
-
-            v_cap_live = ((float)v_p - (float)v_n) * (measured_vdda / 4095.0f) *
-                         V_CAP_DIVIDER;
-            if (!isfinite(v_cap_live) || v_cap_live < 0.0f) {
-                v_cap_live = 0.0f;
-            }
+            vcap_counts = (v_p > v_n) ? (v_p - v_n) : 0U;
         }
 
         if ((uint32_t)diff > peak_raw) peak_raw = (uint32_t)diff;
-        if (amps > peak_current) peak_current = amps;
-        sum_current += amps;
+        sum_counts += (uint32_t)diff;
         sample_count++;
 
         (void)waveform_push_sample(
-            amps, v_cap_live,
+            (uint32_t)diff, vcap_counts,
             (uint32_t)(sample_capture_us - waveform_capture_start_us));
 
         if (joule_mode_active) {
-            uint32_t elapsed_us = sample_capture_us - pulse_start_us;
-            uint32_t dt_us = elapsed_us - joule_last_sample_elapsed_us;
-            if (dt_us == 0U) {
-                dt_us = WAVEFORM_SAMPLE_INTERVAL_US;
-            }
-            joule_last_sample_elapsed_us = elapsed_us;
-            joule_actual_duration_us = joule_duration_offset_us + elapsed_us;
-            float joule_dt_sec = (float)dt_us * 1.0e-6f;
-
-            /* Real-time Joule integration (lead-compensated):
-             * Total power = Vcap * I
-             * Lead loss power = I^2 * R_lead
-             * Workpiece power = Total - Lead losses */
-            float total_power_w = v_cap_live * amps;
-            if (!isfinite(total_power_w) || total_power_w < 0.0f) {
-                total_power_w = 0.0f;
-            }
-
-            float lead_loss_power_w = amps * amps * lead_resistance_ohms;
-            if (!isfinite(lead_loss_power_w) || lead_loss_power_w < 0.0f) {
-                lead_loss_power_w = 0.0f;
-            }
+            /* DMA samples converted just before FET-on count as t=0. */
+            uint32_t elapsed_us =
+                ((int32_t)(sample_capture_us - pulse_start_us) > 0)
+                    ? (sample_capture_us - pulse_start_us)
+                    : 0U;
+            JouleStep js;
+            joule_sample(&joule_ctl, (uint32_t)diff, vcap_counts, elapsed_us,
+                         joule_max_ms * 1000U, &js);
+
+#if JOULE_PREDICTIVE_CUTOFF
+            /* 0) Predictive cutoff: (re)program TIM2 so the hardware kill
+             * lands on the projected instant. */
+            if (js.rearm) {
+                uint32_t kill_cnt =
+                    tim2_cnt_at_start + elapsed_us + js.kill_in_us;
+                bool clamped = false;
+                if (kill_cnt == 0U || (kill_cnt - 1U) > tim2_arr_limit) {
+                    kill_cnt = tim2_arr_limit + 1U;
+                    clamped = true;
+                }
 
-            float workpiece_power_w = total_power_w - lead_loss_power_w;
-            if (!isfinite(workpiece_power_w) || workpiece_power_w < 0.0f) {
-                workpiece_power_w = 0.0f;
+                /* ARR is not preloaded: if CNT is already past the new
+                 * value the update would be missed, so kill in software
+                 * instead.  IRQs off so the ISR cannot race the check. */
+                bool programmed = false;
+                __disable_irq();
+                if (!tim2_fet_killed && !(TIM2->SR & TIM_SR_UIF)) {
+                    programmed = true;
+                    if (TIM2->CNT + JOULE_PREDICT_MIN_ARM_US >= kill_cnt) {
+                        pwmOff();
+                        tim2_fet_killed = true;
+                        kill_cnt = TIM2->CNT;
+                    } else {
+                        TIM2->ARR = kill_cnt - 1U;
+                        if (TIM2->CNT >= kill_cnt - 1U) {
+                            pwmOff();
+                            tim2_fet_killed = true;
+                        }
+                    }
+                }
+                __enable_irq();
+
+                if (programmed) {
+                    joule_kill_programmed(&joule_ctl,
+                                          kill_cnt - tim2_cnt_at_start,
+                                          clamped);
+                    joule_predict_kill_us = kill_cnt;
+                    joule_predicted_j =
+                        joule_units_to_j(&joule_ctl, js.pred_units);
+                }
             }
-
-            joule_total_accumulated += total_power_w * joule_dt_sec;
-            joule_lead_loss_accumulated += lead_loss_power_w * joule_dt_sec;
-            joule_accumulated += workpiece_power_w * joule_dt_sec;
+#endif
 
             /* 1) Highest priority: stop immediately when workpiece target is
              * met. */
-            if (joule_accumulated >= (joule_target_j - JOULE_OVERSHOOT_COMP)) {
+            if (js.stop == JOULE_STOP_TARGET) {
                 joule_target_reached = true;
                 pwmOff();
                 tim2_fet_killed = true;
+                joule_fixed_publish();
                 char jdbg[196];
                 snprintf(jdbg, sizeof(jdbg),
                          "DBG,JOULE_TARGET_REACHED,target_j=%.2f,cutoff_j=%.2f,"
@@ -1337,16 +2005,17 @@ static void capturePulseAmpsForDurationUs(uint32_t pulse_duration_us,
                          joule_target_j, joule_target_j - JOULE_OVERSHOOT_COMP,
                          joule_accumulated, joule_total_accumulated,
                          joule_lead_loss_accumulated, (unsigned long)elapsed_us,
-                         (unsigned long)dt_us);
+                         (unsigned long)js.dt_us);
                 uartSend(jdbg);
                 break;
             }
 
             /* 2) Safety backup timeout (only if energy target did not fire). */
-            if (elapsed_us >= (joule_max_ms * 1000U)) {
+            if (js.stop == JOULE_STOP_TIMEOUT) {
                 joule_timeout_abort = true;
                 pwmOff();
                 tim2_fet_killed = true;
+                joule_fixed_publish();
                 char jdbg[176];
                 snprintf(jdbg, sizeof(jdbg),
                          "DBG,JOULE_TIMEOUT,target_j=%.2f,actual_j=%.2f,max_ms="
@@ -1358,34 +2027,29 @@ static void capturePulseAmpsForDurationUs(uint32_t pulse_duration_us,
                 break;
             }
 
-            /* 3) Bad contact: current too low continuously for >5 ms */
-            if (amps < joule_min_current_a) {
-                joule_low_current_streak_us += dt_us;
-            } else {
-                joule_low_current_streak_us = 0U;
-            }
-
-            if (joule_low_current_streak_us >= joule_bad_contact_limit_us) {
+            /* 3) Bad contact: current too low continuously for too long */
+            if (js.stop == JOULE_STOP_BAD_CONTACT) {
                 joule_bad_contact_abort = true;
                 pwmOff();
                 tim2_fet_killed = true;
+                joule_fixed_publish();
                 char jdbg[176];
                 snprintf(jdbg, sizeof(jdbg),
                          "DBG,JOULE_BAD_CONTACT,target_j=%.2f,actual_j=%.2f,"
                          "low_current_us=%lu",
                          joule_target_j, joule_accumulated,
-                         (unsigned long)joule_low_current_streak_us);
+                         (unsigned long)joule_ctl.low_current_streak_us);
                 uartSend(jdbg);
                 break;
             }
         }
 
         waveform_last_sample_us = sample_capture_us;
-        next_sample_us += WAVEFORM_SAMPLE_INTERVAL_US;
+        next_sample_us += waveform_interval_us;
 
         now_us = micros_now();
         while ((int32_t)(now_us - next_sample_us) >= 0) {
-            next_sample_us += WAVEFORM_SAMPLE_INTERVAL_US;
+            next_sample_us += waveform_interval_us;
         }
     }
 
@@ -1394,10 +2058,46 @@ static void capturePulseAmpsForDurationUs(uint32_t pulse_duration_us,
     TIM2->CR1 = 0U;
     TIM2->SR = 0U;
 
+#if JOULE_PREDICTIVE_CUTOFF
+    /* A predicted kill ends the loop without a final sample (the controller
+     * integrates the stretch up to the kill); it counts as the target unless
+     * it had to be clamped to the pulse end. */
+    if (joule_mode_active && joule_pulse_end(&joule_ctl)) {
+        joule_target_reached = true;
+        joule_fixed_publish();
+        char jdbg[176];
+        snprintf(jdbg, sizeof(jdbg),
+                 "DBG,JOULE_PREDICT_KILL,target_j=%.2f,pred_j=%.2f,"
+                 "actual_j=%.2f,kill_us=%lu",
+                 joule_target_j, joule_predicted_j, joule_accumulated,
+                 (unsigned long)joule_predict_kill_us);
+        uartSend(jdbg);
+    }
+#endif
+
+#if WAVEFORM_DMA_CAPTURE
+    /* Samples converted up to FET-off are still in the ring; file them under
+     * this phase so the phase-end index includes the falling edge. */
+    if (dma_capture) {
+        (void)waveform_dma_service((uint16_t)WAVEFORM_DMA_RING_SAMPLES);
+    }
+#endif
+
+    if (joule_mode_active) {
+        joule_fixed_publish();
+    }
+
+    float peak_current = (float)peak_raw * amps_per_count;
+    if (!isfinite(peak_current) || peak_current < 0.0f) peak_current = 0.0f;
+    float avg_current =
+        (sample_count > 0U)
+            ? ((float)sum_counts / (float)sample_count) * amps_per_count
+            : 0.0f;
+    if (!isfinite(avg_current) || avg_current < 0.0f) avg_current = 0.0f;
+
     cal_adc_peak_raw = peak_raw;
     if (peak_current > current_peak_amps) current_peak_amps = peak_current;
-    cal_current_avg =
-        (sample_count > 0U) ? (sum_current / (float)sample_count) : 0.0f;
+    cal_current_avg = avg_current;
 }
 
 /* ============ Waveform Capture Helpers (Phase 3) ============ */
@@ -1464,139 +2164,485 @@ static void tim2_delay_us(uint32_t delay_us) {
 
     while (!(TIM2->SR & TIM_SR_UIF)) {
         /* spin — gap timing, no ADC sampling needed */
+#if WAVEFORM_DMA_CAPTURE
+        /* DMA keeps sampling through the gap; drain one sample per spin so
+         * long gaps cannot lap the ring (<1us of added jitter). */
+        if (waveform_dma_running) {
+            (void)waveform_dma_service(1U);
+        }
+#endif
     }
 
     TIM2->CR1 = 0;
     TIM2->SR = 0;
 }
 
-static void start_weld_pulse_capture(void) {
-    waveform_index = 0;
-    waveform_pulse_start_index = 0;
-    waveform_pulse_end_index = 0;
-    waveform_preheat_start_index = 0;
-    waveform_preheat_end_index = 0;
-    waveform_gap_start_index = 0;
-    waveform_gap_end_index = 0;
-    waveform_main_start_index = 0;
-    waveform_main_end_index = 0;
-    waveform_capture_start_us = micros_now();
-    waveform_last_sample_us = waveform_capture_start_us;
-    waveform_capture_active = true;
-#if ADC_PAIR_VERBOSE_DEBUG
-    uartSend("DBG,WAVEFORM_CAPTURE_START");
-#endif
+#if WAVEFORM_DMA_CAPTURE
+/* ============ Dual-ADC DMA Capture Engine ============ */
+/**
+ * One-time boot setup for the timer-triggered capture path.
+ *
+ * TIM6 (basic timer, 170 MHz, PSC=0) emits TRGO on every update. ADC1 (dual
+ * master) converts one regular sequence per TRGO and ADC2 (slave) converts
+ * its sequence in lockstep. DMA1 channel 1 (DMAMUX request ADC1) copies
+ * ADC12_COMMON->CDR into waveform_dma_ring in circular mode. The ADCs are
+ * only switched into dual mode for the duration of a weld capture (see
+ * waveform_dma_start / waveform_dma_stop).
+ */
+static void init_waveform_dma_engine(void) {
+    __HAL_RCC_TIM6_CLK_ENABLE();
+    __HAL_RCC_DMAMUX1_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    TIM6->CR1 = 0U;
+    TIM6->PSC = 0U;
+    TIM6->ARR = (170U * WAVEFORM_SAMPLE_INTERVAL_US) - 1U;
+    TIM6->CR2 = TIM_CR2_MMS_1; /* MMS=010: update event -> TRGO          */
+    TIM6->DIER = 0U;
+    TIM6->EGR = TIM_EGR_UG;    /* load PSC/ARR (ADC trigger not armed)   */
+    TIM6->SR = 0U;
+
+    DMA1_Channel1->CCR = 0U;
+    DMAMUX1_Channel0->CCR = DMA_REQUEST_ADC1; /* DMA1 ch1 <- DMAMUX ch0 */
 }
 
-static bool waveform_push_sample(float current_amps, float voltage_volts,
-                                 uint32_t timestamp_us) {
-    uint16_t sample_idx = 0U;
-
-    __disable_irq();
-    if (!waveform_capture_active || waveform_index >= WAVEFORM_BUFFER_SIZE) {
-        __enable_irq();
-        return false;
+static bool adcEnableRaw(ADC_TypeDef* adc) {
+    if (adc->CR & ADC_CR_ADEN) {
+        return true;
+    }
+    adc->ISR = ADC_ISR_ADRDY;
+    adc->CR |= ADC_CR_ADEN;
+    uint32_t timeout = 100000U;
+    while (!(adc->ISR & ADC_ISR_ADRDY)) {
+        if (--timeout == 0U) {
+            return false;
+        }
     }
-
-    sample_idx = waveform_index;
-    waveform_index++;
-    __enable_irq();
-
-    waveform_buffer[sample_idx].current_amps = current_amps;
-    waveform_buffer[sample_idx].voltage_volts = voltage_volts;
-    waveform_buffer[sample_idx].timestamp_us = timestamp_us;
     return true;
 }
 
-static bool resolve_phase_start_from_waveform(uint16_t start_index,
-                                              uint16_t end_index,
-                                              uint32_t* out_abs_us) {
-    if (out_abs_us == NULL) {
-        return false;
+static void adcStopRaw(ADC_TypeDef* adc) {
+    if (adc->CR & ADC_CR_ADSTART) {
+        adc->CR |= ADC_CR_ADSTP;
+        uint32_t timeout = 100000U;
+        while (adc->CR & ADC_CR_ADSTP) {
+            if (--timeout == 0U) {
+                break;
+            }
+        }
     }
+}
 
-    if (end_index > waveform_index) {
-        end_index = waveform_index;
-    }
-    if (start_index >= end_index) {
-        return false;
-    }
+/* Put ADC1/ADC2 back to independent, software-started single conversions so
+ * readCapVoltage(), measureVDDA() and adcPrepareFastCurrentChannels() work
+ * exactly as before the capture. */
+static void adcRestoreIndependentMode(void) {
+    HAL_ADC_Stop(&hadc1);
+    HAL_ADC_Stop(&hadc2);
 
-    float phase_peak_amps = 0.0f;
-    for (uint16_t i = start_index; i < end_index; i++) {
-        float amps = waveform_buffer[i].current_amps;
-        if (isfinite(amps) && amps > phase_peak_amps) {
-            phase_peak_amps = amps;
-        }
-    }
-    if (phase_peak_amps <= 0.0f) {
-        return false;
-    }
+    ADC_MultiModeTypeDef multimode = {0};
+    multimode.Mode = ADC_MODE_INDEPENDENT;
+    (void)HAL_ADCEx_MultiModeConfigChannel(&hadc1, &multimode);
 
-    float threshold_amps = phase_peak_amps * PHASE_START_PEAK_RATIO;
-    if (threshold_amps < PHASE_START_MIN_CURRENT_A) {
-        threshold_amps = PHASE_START_MIN_CURRENT_A;
-    }
+    hadc1.Init.ScanConvMode = ADC_SCAN_DISABLE;
+    hadc1.Init.EOCSelection = ADC_EOC_SINGLE_CONV;
+    hadc1.Init.NbrOfConversion = 1;
+    hadc1.Init.ExternalTrigConv = ADC_SOFTWARE_START;
+    hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
+    hadc1.Init.DMAContinuousRequests = DISABLE;
+    (void)HAL_ADC_Init(&hadc1);
 
-    for (uint16_t i = start_index; i < end_index; i++) {
-        float amps = waveform_buffer[i].current_amps;
-        if (!isfinite(amps)) {
-            continue;
-        }
-        if (amps >= threshold_amps) {
-            *out_abs_us =
-                waveform_capture_start_us + waveform_buffer[i].timestamp_us;
-            return true;
-        }
-    }
+    hadc2.Init.ScanConvMode = ADC_SCAN_DISABLE;
+    hadc2.Init.EOCSelection = ADC_EOC_SINGLE_CONV;
+    hadc2.Init.NbrOfConversion = 1;
+    hadc2.Init.ExternalTrigConv = ADC_SOFTWARE_START;
+    hadc2.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
+    hadc2.Init.DMAContinuousRequests = DISABLE;
+    (void)HAL_ADC_Init(&hadc2);
 
-    return false;
+    adc1_fast_current_mode = false;
+    adc2_fast_vcap_mode = false;
 }
 
-static bool resolve_phase_end_from_waveform(uint16_t start_index,
-                                            uint16_t end_index,
-                                            uint32_t* out_abs_us) {
-    if (out_abs_us == NULL) {
-        return false;
-    }
+/**
+ * Switch ADC1+ADC2 to dual regular-simultaneous mode and start TIM6.
+ * On success *out_start_us is the micros_now() timestamp of TIM6 start;
+ * sample k is converted at out_start_us + (k+1) * WAVEFORM_SAMPLE_INTERVAL_US.
+ * On failure the ADCs are restored to independent mode and false is
+ * returned (caller falls back to the polled path).
+ */
+static bool waveform_dma_start(uint32_t* out_start_us) {
+    waveform_dma_running = false;
+    waveform_dma_read_pos = 0U;
+    waveform_dma_consumed = 0U;
+    waveform_dma_overruns = 0U;
 
-    if (end_index > waveform_index) {
-        end_index = waveform_index;
-    }
-    if (start_index >= end_index) {
+    TIM6->CR1 = 0U;
+    HAL_ADC_Stop(&hadc1);
+    HAL_ADC_Stop(&hadc2);
+    adc1_fast_current_mode = false;
+    adc2_fast_vcap_mode = false;
+
+    /* Master: 2-rank sequence per TIM6 TRGO. CCR.DMACFG=1 (circular). */
+    hadc1.Init.ScanConvMode = ADC_SCAN_ENABLE;
+    hadc1.Init.ContinuousConvMode = DISABLE;
+    hadc1.Init.DiscontinuousConvMode = DISABLE;
+    hadc1.Init.NbrOfConversion = 2;
+    hadc1.Init.EOCSelection = ADC_EOC_SEQ_CONV;
+    hadc1.Init.ExternalTrigConv = ADC_EXTERNALTRIG_T6_TRGO;
+    hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_RISING;
+    hadc1.Init.DMAContinuousRequests = ENABLE;
+
+    /* Slave: same sequence length; trigger comes from the master. */
+    hadc2.Init.ScanConvMode = ADC_SCAN_ENABLE;
+    hadc2.Init.ContinuousConvMode = DISABLE;
+    hadc2.Init.DiscontinuousConvMode = DISABLE;
+    hadc2.Init.NbrOfConversion = 2;
+    hadc2.Init.EOCSelection = ADC_EOC_SEQ_CONV;
+    hadc2.Init.ExternalTrigConv = ADC_SOFTWARE_START;
+    hadc2.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
+    hadc2.Init.DMAContinuousRequests = ENABLE;
+
+    if (HAL_ADC_Init(&hadc1) != HAL_OK || HAL_ADC_Init(&hadc2) != HAL_OK) {
+        adcRestoreIndependentMode();
         return false;
     }
 
-    float phase_peak_amps = 0.0f;
-    for (uint16_t i = start_index; i < end_index; i++) {
-        float amps = waveform_buffer[i].current_amps;
-        if (isfinite(amps) && amps > phase_peak_amps) {
-            phase_peak_amps = amps;
-        }
+    /* Both ADCs must use identical sampling times in simultaneous mode. */
+    ADC_ChannelConfTypeDef sConfig = {0};
+    sConfig.SamplingTime = ADC_SAMPLETIME_47CYCLES_5;
+    sConfig.SingleDiff = ADC_SINGLE_ENDED;
+    sConfig.OffsetNumber = ADC_OFFSET_NONE;
+    sConfig.Offset = 0;
+
+    bool cfg_ok = true;
+    sConfig.Channel = ADC_FAST_CURRENT_N_CHANNEL; /* PA2, shunt N */
+    sConfig.Rank = ADC_REGULAR_RANK_1;
+    cfg_ok &= (HAL_ADC_ConfigChannel(&hadc1, &sConfig) == HAL_OK);
+    sConfig.Channel = ADC_CHANNEL_4; /* PA3, Vcap+ */
+    sConfig.Rank = ADC_REGULAR_RANK_2;
+    cfg_ok &= (HAL_ADC_ConfigChannel(&hadc1, &sConfig) == HAL_OK);
+    sConfig.Channel = ADC_FAST_CURRENT_P_CHANNEL; /* PA1, shunt P */
+    sConfig.Rank = ADC_REGULAR_RANK_1;
+    cfg_ok &= (HAL_ADC_ConfigChannel(&hadc2, &sConfig) == HAL_OK);
+    sConfig.Channel = ADC_CHANNEL_17; /* PA4, Vcap- */
+    sConfig.Rank = ADC_REGULAR_RANK_2;
+    cfg_ok &= (HAL_ADC_ConfigChannel(&hadc2, &sConfig) == HAL_OK);
+
+    ADC_MultiModeTypeDef multimode = {0};
+    multimode.Mode = ADC_DUALMODE_REGSIMULT;
+    multimode.DMAAccessMode = ADC_DMAACCESSMODE_12_10_BITS;
+    multimode.TwoSamplingDelay = ADC_TWOSAMPLINGDELAY_1CYCLE;
+    if (!cfg_ok ||
+        HAL_ADCEx_MultiModeConfigChannel(&hadc1, &multimode) != HAL_OK) {
+        adcRestoreIndependentMode();
+        return false;
     }
-    if (phase_peak_amps <= 0.0f) {
+
+    DMA1_Channel1->CCR = 0U;
+    DMA1->IFCR = DMA_IFCR_CGIF1;
+    DMA1_Channel1->CPAR = (uint32_t)&ADC12_COMMON->CDR;
+    DMA1_Channel1->CMAR = (uint32_t)waveform_dma_ring;
+    DMA1_Channel1->CNDTR = WAVEFORM_DMA_RING_WORDS;
+    DMA1_Channel1->CCR = DMA_CCR_PL_1 | DMA_CCR_PL_0 | /* very high */
+                         DMA_CCR_MSIZE_1 | DMA_CCR_PSIZE_1 | /* 32-bit */
+                         DMA_CCR_MINC | DMA_CCR_CIRC;
+    DMA1_Channel1->CCR |= DMA_CCR_EN;
+
+    if (!adcEnableRaw(ADC1) || !adcEnableRaw(ADC2)) {
+        DMA1_Channel1->CCR = 0U;
+        adcRestoreIndependentMode();
         return false;
     }
 
-    float threshold_amps = phase_peak_amps * PHASE_START_PEAK_RATIO;
-    if (threshold_amps < PHASE_START_MIN_CURRENT_A) {
-        threshold_amps = PHASE_START_MIN_CURRENT_A;
+    ADC1->ISR = ADC_ISR_EOC | ADC_ISR_EOS | ADC_ISR_OVR;
+    ADC2->ISR = ADC_ISR_EOC | ADC_ISR_EOS | ADC_ISR_OVR;
+    ADC1->CR |= ADC_CR_ADSTART; /* arms the pair; slave follows master */
+
+    TIM6->CNT = 0U;
+    TIM6->SR = 0U;
+    const uint32_t start_us = micros_now();
+    TIM6->CR1 = TIM_CR1_CEN;
+
+    waveform_dma_running = true;
+    if (out_start_us != NULL) {
+        *out_start_us = start_us;
     }
+    return true;
+}
 
-    for (uint16_t i = end_index; i > start_index; i--) {
-        uint16_t idx = (uint16_t)(i - 1U);
-        float amps = waveform_buffer[idx].current_amps;
-        if (!isfinite(amps)) {
-            continue;
+static void waveform_dma_stop(void) {
+    TIM6->CR1 = 0U;
+    adcStopRaw(ADC1);
+    adcStopRaw(ADC2);
+    DMA1_Channel1->CCR = 0U;
+    DMA1->IFCR = DMA_IFCR_CGIF1;
+    waveform_dma_running = false;
+
+    adcRestoreIndependentMode();
+}
+
+/**
+ * Pop the oldest completed sample from the DMA ring (raw 12-bit counts).
+ * *out_ts_us is relative to waveform_capture_start_us.
+ *
+ * The DMA position alone cannot tell an empty ring from one full lap, so the
+ * elapsed time is used as a cross-check: if the consumer is a whole ring
+ * behind, the unread samples were overwritten. They are dropped, the
+ * overrun is counted and timestamps are re-aligned to the current position.
+ */
+static bool waveform_dma_pop(uint32_t* out_p, uint32_t* out_n,
+                             uint32_t* out_vp, uint32_t* out_vn,
+                             uint32_t* out_ts_us) {
+    if (!waveform_dma_running) {
+        return false;
+    }
+
+    const uint32_t produced = (micros_now() - waveform_capture_start_us) /
+                              WAVEFORM_SAMPLE_INTERVAL_US;
+    const uint32_t written_words =
+        WAVEFORM_DMA_RING_WORDS - DMA1_Channel1->CNDTR;
+    const uint16_t write_pos =
+        (uint16_t)((written_words / WAVEFORM_DMA_WORDS_PER_SAMPLE) %
+                   WAVEFORM_DMA_RING_SAMPLES);
+
+    if ((produced - waveform_dma_consumed) >=
+        (WAVEFORM_DMA_RING_SAMPLES - 1U)) {
+        waveform_dma_overruns++;
+        waveform_dma_read_pos = write_pos;
+        waveform_dma_consumed = produced;
+        return false;
+    }
+
+    if (waveform_dma_read_pos == write_pos) {
+        return false;
+    }
+
+    const uint32_t w = (uint32_t)waveform_dma_read_pos *
+                       WAVEFORM_DMA_WORDS_PER_SAMPLE;
+    const uint32_t w0 = waveform_dma_ring[w];
+    const uint32_t w1 = waveform_dma_ring[w + 1U];
+
+    *out_n = w0 & 0xFFFFU;
+    *out_p = w0 >> 16;
+    *out_vp = w1 & 0xFFFFU;
+    *out_vn = w1 >> 16;
+
+    waveform_dma_consumed++;
+    *out_ts_us = waveform_dma_consumed * WAVEFORM_SAMPLE_INTERVAL_US;
+    waveform_dma_read_pos =
+        (uint16_t)((waveform_dma_read_pos + 1U) % WAVEFORM_DMA_RING_SAMPLES);
+    return true;
+}
+
+/* Move up to max_samples pending ring entries into waveform_buffer (raw
+ * counts). Returns the number of samples taken from the ring. */
+static uint16_t waveform_dma_service(uint16_t max_samples) {
+    uint16_t captured = 0U;
+
+    while (captured < max_samples) {
+        uint32_t p = 0U;
+        uint32_t n = 0U;
+        uint32_t v_p = 0U;
+        uint32_t v_n = 0U;
+        uint32_t ts_us = 0U;
+        if (!waveform_dma_pop(&p, &n, &v_p, &v_n, &ts_us)) {
+            break;
         }
-        if (amps >= threshold_amps) {
-            *out_abs_us =
-                waveform_capture_start_us + waveform_buffer[idx].timestamp_us;
-            return true;
+
+        int32_t diff = (int32_t)p - (int32_t)n;
+        if (diff < 0) {
+            diff = 0;
         }
+
+        (void)waveform_push_sample((uint32_t)diff,
+                                   (v_p > v_n) ? (v_p - v_n) : 0U, ts_us);
+        waveform_last_sample_us = waveform_capture_start_us + ts_us;
+        captured++;
     }
 
-    return false;
+    return captured;
+}
+#endif /* WAVEFORM_DMA_CAPTURE */
+
+static void start_weld_pulse_capture(void) {
+    waveform_index = 0;
+    waveform_pulse_start_index = 0;
+    waveform_pulse_end_index = 0;
+    waveform_preheat_start_index = 0;
+    waveform_preheat_end_index = 0;
+    waveform_gap_start_index = 0;
+    waveform_gap_end_index = 0;
+    waveform_main_start_index = 0;
+    waveform_main_end_index = 0;
+    waveform_capture_start_us = micros_now();
+    waveform_vcap_measured = false;
+    waveform_interval_us = WAVEFORM_SAMPLE_INTERVAL_US;
+#if WAVEFORM_PACKED_STORAGE
+    waveform_ts_block_count = 0U;
+#endif
+    {
+        const float v_per_count = measured_vdda / 4095.0f;
+        waveform_amps_per_count =
+            (v_per_count / SHUNT_GAIN / SHUNT_EFF_OHMS) * CURRENT_CAL_FACTOR;
+        waveform_volts_per_count = v_per_count * V_CAP_DIVIDER;
+        if (!isfinite(waveform_amps_per_count) ||
+            waveform_amps_per_count < 0.0f) {
+            waveform_amps_per_count = 0.0f;
+        }
+        if (!isfinite(waveform_volts_per_count) ||
+            waveform_volts_per_count < 0.0f) {
+            waveform_volts_per_count = 0.0f;
+        }
+    }
+#if WAVEFORM_DMA_CAPTURE
+    {
+        uint32_t dma_start_us = 0U;
+        if (waveform_dma_start(&dma_start_us)) {
+            waveform_capture_start_us = dma_start_us;
+            waveform_vcap_measured = true;
+        } else {
+            uartSend("DBG,WAVEFORM_DMA_START_FAIL,fallback=polled");
+            waveform_interval_us = WAVEFORM_POLLED_INTERVAL_US;
+            adcPrepareFastCurrentChannels();
+        }
+    }
+#endif
+    waveform_last_sample_us = waveform_capture_start_us;
+    waveform_capture_active = true;
+#if ADC_PAIR_VERBOSE_DEBUG
+    uartSend("DBG,WAVEFORM_CAPTURE_START");
+#endif
+}
+
+static bool waveform_push_sample(uint32_t current_counts,
+                                 uint32_t vcap_counts, uint32_t timestamp_us) {
+    uint16_t sample_idx = 0U;
+
+    __disable_irq();
+    if (!waveform_capture_active || waveform_index >= waveform_capacity) {
+        __enable_irq();
+        return false;
+    }
+
+    sample_idx = waveform_index;
+#if WAVEFORM_PACKED_STORAGE
+    const uint32_t dt_us = timestamp_us - waveform_prev_ts_us;
+    const bool new_block = (sample_idx % WAVEFORM_TS_BLOCK_SAMPLES) == 0U ||
+                           dt_us > WAVEFORM_PACK_DT_MAX;
+    if (new_block && waveform_ts_block_count >= WAVEFORM_TS_MAX_BLOCKS) {
+        __enable_irq();
+        return false;
+    }
+#endif
+    waveform_index++;
+    __enable_irq();
+
+#if WAVEFORM_PACKED_STORAGE
+    if (new_block) {
+        waveform_ts_blocks[waveform_ts_block_count].first_index = sample_idx;
+        waveform_ts_blocks[waveform_ts_block_count].t0_us = timestamp_us;
+        waveform_ts_block_count++;
+    }
+    if (current_counts > WAVEFORM_PACK_COUNT_MAX) {
+        current_counts = WAVEFORM_PACK_COUNT_MAX;
+    }
+    if (vcap_counts > WAVEFORM_PACK_COUNT_MAX) {
+        vcap_counts = WAVEFORM_PACK_COUNT_MAX;
+    }
+    waveform_buffer[sample_idx] = current_counts | (vcap_counts << 12) |
+                                  ((new_block ? 0U : dt_us) << 24);
+    waveform_prev_ts_us = timestamp_us;
+#else
+    waveform_buffer[sample_idx].current_amps =
+        (float)current_counts * waveform_amps_per_count;
+    waveform_buffer[sample_idx].voltage_volts =
+        (float)vcap_counts * waveform_volts_per_count;
+    waveform_buffer[sample_idx].timestamp_us = timestamp_us;
+#endif
+    return true;
+}
+
+/* The capture as the waveform kernels see it. Cheap to build: the compiler
+ * folds it into direct buffer accesses in the wrappers below. */
+static WaveformView waveform_view(void) {
+    WaveformView w;
+#if WAVEFORM_PACKED_STORAGE
+    w.words = waveform_buffer;
+    w.blocks = waveform_ts_blocks;
+    w.block_count = waveform_ts_block_count;
+#else
+    w.samples = waveform_buffer;
+#endif
+    w.count = waveform_index;
+    w.amps_per_count = waveform_amps_per_count;
+    w.volts_per_count = waveform_volts_per_count;
+    return w;
+}
+
+static float waveform_sample_amps(uint16_t idx) {
+    const WaveformView w = waveform_view();
+    return wf_sample_amps(&w, idx);
+}
+
+static float waveform_sample_volts(uint16_t idx) {
+    const WaveformView w = waveform_view();
+    return wf_sample_volts(&w, idx);
+}
+
+static uint32_t waveform_sample_ts_us(uint16_t idx) {
+    const WaveformView w = waveform_view();
+    return wf_sample_ts_us(&w, idx);
+}
+
+static uint32_t waveform_sample_dt_us(uint16_t idx) {
+    const WaveformView w = waveform_view();
+    return wf_sample_dt_us(&w, idx);
+}
+
+static void waveform_set_sample_volts(uint16_t idx, float volts) {
+    WaveformView w = waveform_view();
+    wf_set_sample_volts(&w, idx, volts);
+}
+
+static uint32_t waveform_volts_to_counts(float volts) {
+    return wf_volts_to_counts(volts, waveform_volts_per_count);
+}
+
+static bool resolve_phase_start_from_waveform(uint16_t start_index,
+                                              uint16_t end_index,
+                                              uint32_t* out_abs_us) {
+    if (out_abs_us == NULL) {
+        return false;
+    }
+
+    const WaveformView w = waveform_view();
+    uint16_t idx = 0U;
+    if (!wf_find_phase_edge(&w, start_index, end_index, false,
+                            PHASE_START_PEAK_RATIO, PHASE_START_MIN_CURRENT_A,
+                            &idx)) {
+        return false;
+    }
+    *out_abs_us = waveform_capture_start_us + wf_sample_ts_us(&w, idx);
+    return true;
+}
+
+static bool resolve_phase_end_from_waveform(uint16_t start_index,
+                                            uint16_t end_index,
+                                            uint32_t* out_abs_us) {
+    if (out_abs_us == NULL) {
+        return false;
+    }
+
+    const WaveformView w = waveform_view();
+    uint16_t idx = 0U;
+    if (!wf_find_phase_edge(&w, start_index, end_index, true,
+                            PHASE_START_PEAK_RATIO, PHASE_START_MIN_CURRENT_A,
+                            &idx)) {
+        return false;
+    }
+    *out_abs_us = waveform_capture_start_us + wf_sample_ts_us(&w, idx);
+    return true;
 }
 
 static void capture_waveform_samples(uint16_t sample_count) {
@@ -1604,12 +2650,32 @@ static void capture_waveform_samples(uint16_t sample_count) {
         return;
     }
 
-    const float v_per_count = measured_vdda / 4095.0f;
+#if WAVEFORM_DMA_CAPTURE
+    if (waveform_dma_running) {
+        /* Hardware paces the samples; just drain them. Never wait longer
+         * than the samples should take plus 1ms. */
+        const uint32_t guard_us =
+            micros_now() +
+            (uint32_t)sample_count * WAVEFORM_SAMPLE_INTERVAL_US + 1000U;
+        uint16_t captured = 0U;
+        while (captured < sample_count &&
+               waveform_index < waveform_capacity) {
+            captured += waveform_dma_service(
+                (uint16_t)(sample_count - captured));
+            if ((int32_t)(micros_now() - guard_us) >= 0) {
+                break;
+            }
+        }
+        return;
+    }
+#endif
+
+    const uint32_t cached_vcap_counts = waveform_volts_to_counts(cached_vcap);
     uint32_t next_sample_us =
-        waveform_last_sample_us + WAVEFORM_SAMPLE_INTERVAL_US;
+        waveform_last_sample_us + waveform_interval_us;
 
     for (uint16_t captured = 0; captured < sample_count;) {
-        if (waveform_index >= WAVEFORM_BUFFER_SIZE) {
+        if (waveform_index >= waveform_capacity) {
             break;
         }
 
@@ -1635,24 +2701,17 @@ static void capture_waveform_samples(uint16_t sample_count) {
             diff = 0;
         }
 
-        float v_adc = (float)diff * v_per_count;
-        float v_shunt = v_adc / SHUNT_GAIN;
-        float amps = (v_shunt / SHUNT_EFF_OHMS) * CURRENT_CAL_FACTOR;
-        if (!isfinite(amps) || amps < 0.0f) {
-            amps = 0.0f;
-        }
-
         waveform_push_sample(
-            amps, cached_vcap,
+            (uint32_t)diff, cached_vcap_counts,
             (uint32_t)(sample_time_us - waveform_capture_start_us));
 
         captured++;
         waveform_last_sample_us = sample_time_us;
-        next_sample_us += WAVEFORM_SAMPLE_INTERVAL_US;
+        next_sample_us += waveform_interval_us;
 
         now_us = micros_now();
         while ((int32_t)(now_us - next_sample_us) >= 0) {
-            next_sample_us += WAVEFORM_SAMPLE_INTERVAL_US;
+            next_sample_us += waveform_interval_us;
         }
     }
 
@@ -1662,8 +2721,8 @@ static void capture_waveform_samples(uint16_t sample_count) {
         char wf_debug[120];
         snprintf(wf_debug, sizeof(wf_debug),
                  "DBG,WAVEFORM_RAW,samples=%u,first_i=%.2f,last_i=%.2f",
-                 (unsigned int)waveform_index, waveform_buffer[0].current_amps,
-                 waveform_buffer[waveform_index - 1U].current_amps);
+                 (unsigned int)waveform_index, waveform_sample_amps(0U),
+                 waveform_sample_amps((uint16_t)(waveform_index - 1U)));
         uartSend(wf_debug);
     }
 #endif
@@ -1674,13 +2733,27 @@ static uint16_t capture_waveform_until_deadline(uint32_t deadline_us) {
         return 0U;
     }
 
-    const float v_per_count = measured_vdda / 4095.0f;
+#if WAVEFORM_DMA_CAPTURE
+    if (waveform_dma_running) {
+        uint16_t drained = 0U;
+        while ((int32_t)(micros_now() - deadline_us) < 0) {
+            if (waveform_index >= waveform_capacity) {
+                break;
+            }
+            drained +=
+                waveform_dma_service((uint16_t)WAVEFORM_DMA_RING_SAMPLES);
+        }
+        return drained;
+    }
+#endif
+
+    const uint32_t cached_vcap_counts = waveform_volts_to_counts(cached_vcap);
     uint16_t captured = 0U;
     uint32_t next_sample_us =
-        waveform_last_sample_us + WAVEFORM_SAMPLE_INTERVAL_US;
+        waveform_last_sample_us + waveform_interval_us;
 
     while ((int32_t)(micros_now() - deadline_us) < 0) {
-        if (waveform_index >= WAVEFORM_BUFFER_SIZE) {
+        if (waveform_index >= waveform_capacity) {
             break;
         }
 
@@ -1703,24 +2776,17 @@ static uint16_t capture_waveform_until_deadline(uint32_t deadline_us) {
             diff = 0;
         }
 
-        float v_adc = (float)diff * v_per_count;
-        float v_shunt = v_adc / SHUNT_GAIN;
-        float amps = (v_shunt / SHUNT_EFF_OHMS) * CURRENT_CAL_FACTOR;
-        if (!isfinite(amps) || amps < 0.0f) {
-            amps = 0.0f;
-        }
-
         waveform_push_sample(
-            amps, cached_vcap,
+            (uint32_t)diff, cached_vcap_counts,
             (uint32_t)(sample_time_us - waveform_capture_start_us));
 
         captured++;
         waveform_last_sample_us = sample_time_us;
-        next_sample_us += WAVEFORM_SAMPLE_INTERVAL_US;
+        next_sample_us += waveform_interval_us;
 
         now_us = micros_now();
         while ((int32_t)(now_us - next_sample_us) >= 0) {
-            next_sample_us += WAVEFORM_SAMPLE_INTERVAL_US;
+            next_sample_us += waveform_interval_us;
         }
     }
 
@@ -1729,6 +2795,17 @@ static uint16_t capture_waveform_until_deadline(uint32_t deadline_us) {
 
 static void end_weld_pulse_capture(void) {
     waveform_capture_active = false;
+#if WAVEFORM_DMA_CAPTURE
+    if (waveform_dma_running) {
+        waveform_dma_stop();
+        if (waveform_dma_overruns > 0U) {
+            char odbg[64];
+            snprintf(odbg, sizeof(odbg), "DBG,WAVEFORM_DMA_OVERRUN,laps=%lu",
+                     (unsigned long)waveform_dma_overruns);
+            uartSend(odbg);
+        }
+    }
+#endif
 #if ADC_PAIR_VERBOSE_DEBUG
     char dbg[96];
     snprintf(dbg, sizeof(dbg),
@@ -1741,176 +2818,382 @@ static void end_weld_pulse_capture(void) {
 #endif
 }
 
-static void apply_waveform_voltage_interpolation(float vcap_start,
-                                                 float vcap_end,
-                                                 uint16_t pulse_start_index,
-                                                 uint16_t pulse_end_index) {
-    if (waveform_index == 0U) {
-        return;
-    }
+/* ============ Post-weld pipeline ============
+ * fireRecipe() returns as soon as the FET is off and the post-pulse window
+ * is recorded. Its capture is handed to a WeldReport slot and jobPostWeld()
+ * finishes it in the background, one step per scheduler pass:
+ *   SETTLE  wait WELD_VCAP_SETTLE_MS after FET off, read vcap_after
+ *   QUEUED  settled: Vcap overlay, energy integration, phase stats and the
+ *           formatted EVENT,WELD_DONE line, on the next pass
+ *   READY   wait for the older weld's burst; then queue the WELD_DONE line
+ *   TX      WAVEFORM_START .. WAVEFORM_PHASES, one line per pass and only
+ *           when it fits the bulk TX ring without waiting
+ * Weld N+1 can therefore fire into the second slot while weld N is still
+ * being sent. Reports go out strictly in weld order so each WELD_DONE stays
+ * in front of its own burst. The accounting does not wait for that turn:
+ * WELD_COOLDOWN_MS is far longer than the settle, so by the next trigger a
+ * report is READY and a weld that finds both slots busy only has to queue a
+ * finished line and cut the older burst short (WAVEFORM_END,...,aborted=1):
+ * telemetry never delays a trigger.
+ * In summary mode (WAVEFORM_MODE,SUMMARY) TX sends WAVEFORM_SUMMARY /
+ * WAVEFORM_ENV / WAVEFORM_PHASE_STATS instead of the burst, and the slot is
+ * then HELD: the full capture stays in waveform_store until the next weld,
+ * and WAVEFORM_GET puts it back into TX as a normal burst. */
+#define WELD_VCAP_SETTLE_MS 30U
+/* Bulk-ring space a waveform line must leave free, so STATUS / DBG lines
+ * never have to wait behind a burst. */
+#define WF_TX_HEADROOM 2048U
+/* EVENT,WELD_DONE is formatted when the slot settles and sent at its turn. */
+#define WELD_DONE_LINE_SIZE 768U
+
+typedef enum {
+    WELD_SLOT_FREE = 0,
+    WELD_SLOT_HELD, /* reported; full capture kept for WAVEFORM_GET */
+    WELD_SLOT_CAPTURE,
+    WELD_SLOT_SETTLE,
+    WELD_SLOT_QUEUED,
+    WELD_SLOT_READY, /* analysed; WELD_DONE waits for its turn */
+    WELD_SLOT_TX,
+} WeldSlotState;
+
+typedef enum {
+    WF_TX_SUMMARY = 0, /* summary mode: WAVEFORM_SUMMARY, _ENV, _PHASE_STATS */
+    WF_TX_ENV,
+    WF_TX_PHASE_STATS,
+    WF_TX_START, /* full burst: WAVEFORM_START .. WAVEFORM_PHASES */
+    WF_TX_CHUNKS,
+    WF_TX_END,
+    WF_TX_PHASES,
+    WF_TX_DONE,
+} WaveformTxStage;
 
-    if (pulse_start_index > waveform_index) {
-        pulse_start_index = waveform_index;
-    }
-
-    if (pulse_end_index < pulse_start_index) {
-        pulse_end_index = pulse_start_index;
-    }
+typedef struct {
+    WeldSlotState state;
+    uint32_t seq; /* weld order: lower is reported first */
+    uint16_t base; /* first sample in waveform_store */
+    WaveformView view;
+    uint32_t capture_start_us;
+    uint32_t interval_us; /* waveform_interval_us of this capture */
+    bool vcap_measured;
+    bool preheat_on; /* recipe had a preheat (and a gap) phase */
+    bool gap_on;
+    /* WAVEFORM_START markers (end exclusive) and WAVEFORM_PHASES times
+     * (absolute micros_now()): preheat, gap, main. */
+    uint16_t mark_start[3];
+    uint16_t mark_end[3];
+    uint32_t phase_start_us[3];
+    uint32_t phase_end_us[3];
+    uint16_t pulse_start_index;
+    uint16_t pulse_end_index;
+    /* EVENT,WELD_DONE inputs latched when the FET went off. */
+    uint32_t off_ms;
+    uint32_t pulse_duration_us;
+    uint8_t mode;
+    uint16_t d_ms[3];
+    uint16_t gap_ms[2];
+    uint8_t power_pct;
+    bool preheat_en;
+    uint16_t preheat_ms;
+    float lead_r_ohms;
+    float peak_a;
+    uint32_t adc_peak_raw;
+    float vcap_before;
+    float vcap_after;
+    float joule_total_j;
+    float joule_work_j;
+    float joule_loss_j;
+    float joule_pred_j;
+    uint32_t joule_kill_us;
+    uint32_t pedal_fet_us;
+#if PERF_STATS
+    uint32_t perf_trigger_cyc;
+    uint32_t perf_fet_off_cyc;
+    bool perf_fet_off_valid;
+#endif
+    /* weldReportAnalyze() results, sent in weld order. */
+    char done_line[WELD_DONE_LINE_SIZE];
+    WaveformPhaseStats phase_stats[3];
+    /* Burst cursor. */
+    WaveformTxStage tx_stage;
+    uint8_t tx_fmt; /* waveform_wire_format when the burst started */
+    uint16_t tx_index;
+    uint16_t tx_seq;
+    bool tx_started; /* first line is on the wire */
+    bool tx_aborted; /* cut short by weldSlotAcquire() */
+    bool tx_summary; /* this TX is the summary, not the burst */
+    bool hold;       /* summary mode: keep the capture until the next weld */
+} WeldReport;
+
+static WeldReport weld_reports[WELD_SLOT_COUNT];
+static uint32_t weld_report_seq = 0U;
+static char wf_tx_line[WAVEFORM_LINE_BUFFER_SIZE];
+static bool wf_tx_line_ready = false; /* formatted, waiting for ring room */
+
+/* WAVEFORM_PHASES time of phase `i` relative to the capture start. */
+static uint32_t weldReportPhaseRel(const WeldReport* r, uint32_t abs_us) {
+    return (abs_us >= r->capture_start_us) ? (abs_us - r->capture_start_us)
+                                           : 0U;
+}
 
-    if (pulse_end_index > waveform_index) {
-        pulse_end_index = waveform_index;
-    }
+/* Summary phase i (0 preheat, 1 gap, 2 main) as
+ * WAVEFORM_PHASE_STATS,phase=<name>,start=,end=,start_us=,end_us=,
+ * energy_j=,rms_a=,peak_a=,peak_idx= (all zero for a phase the recipe
+ * did not have). */
+static int weldReportPhaseStatsLine(const WeldReport* r, uint8_t i,
+                                    char* line, size_t line_size) {
+    static const char* const names[3] = {"preheat", "gap", "main"};
+    const bool on = (i == 0U) ? r->preheat_on
+                              : ((i == 1U) ? r->gap_on : true);
+    uint16_t start = 0U;
+    uint16_t end = 0U;
+    uint32_t start_us = 0U;
+    uint32_t end_us = 0U;
+    WaveformPhaseStats ps = {0};
+    if (on) {
+        start = r->mark_start[i];
+        end = r->mark_end[i];
+        start_us = weldReportPhaseRel(r, r->phase_start_us[i]);
+        end_us = weldReportPhaseRel(r, r->phase_end_us[i]);
+        ps = r->phase_stats[i];
+    }
+    return snprintf(line, line_size,
+                    "WAVEFORM_PHASE_STATS,phase=%s,start=%u,end=%u,"
+                    "start_us=%lu,end_us=%lu,energy_j=%.3f,rms_a=%.1f,"
+                    "peak_a=%.1f,peak_idx=%u",
+                    names[i], (unsigned int)start, (unsigned int)end,
+                    (unsigned long)start_us, (unsigned long)end_us,
+                    ps.energy_j, ps.rms_amps, ps.peak_amps,
+                    (unsigned int)(on ? ps.peak_index : 0U));
+}
 
-    for (uint16_t i = 0; i < pulse_start_index; i++) {
-        waveform_buffer[i].voltage_volts = vcap_start;
-    }
+/* Format the next line of r's report into line[]; false when it is
+ * complete. Summary mode:
+ *   WAVEFORM_SUMMARY,samples=<n>,buckets=<b>,chunks=<env lines>
+ *   WAVEFORM_ENV,... (see wf_format_env_chunk)
+ *   WAVEFORM_PHASE_STATS,phase=preheat|gap|main,...
+ * Full burst, in order:
+ *   WAVEFORM_START,<total>,<pre_start>,<pre_end>,<gap_start>,<gap_end>,
+ *                  <main_start>,<main_end>
+ *   WAVEFORM_DATA,... (CSV) or WAVEFORM_BIN,... chunks (see WAVEFORM_FMT_BIN)
+ *   WAVEFORM_END (CSV) / WAVEFORM_END,chunks=<n> (BIN)
+ *   WAVEFORM_PHASES,...
+ * A BIN chunk ends early when the next sample's dt does not fit in 8 bits;
+ * the next chunk re-bases t0, so timestamps stay exact. BIN is integer only:
+ * no float formatting on the post-weld path. */
+static bool weldReportTxLine(WeldReport* r, char* line, size_t line_size) {
+    static uint8_t payload[WAVEFORM_BIN_PAYLOAD_SIZE];
+    const WaveformView* w = &r->view;
+    int n = 0;
+
+    while (r->tx_stage != WF_TX_DONE) {
+        const uint16_t buckets = (w->count < WAVEFORM_SUMMARY_BUCKETS)
+                                     ? w->count
+                                     : (uint16_t)WAVEFORM_SUMMARY_BUCKETS;
+        switch (r->tx_stage) {
+            case WF_TX_SUMMARY:
+                r->tx_stage = WF_TX_ENV;
+                r->tx_index = 0U;
+                n = snprintf(line, line_size,
+                             "WAVEFORM_SUMMARY,samples=%u,buckets=%u,"
+                             "chunks=%u",
+                             (unsigned int)w->count, (unsigned int)buckets,
+                             (unsigned int)((buckets +
+                                             WAVEFORM_ENV_CHUNK_BUCKETS - 1U) /
+                                            WAVEFORM_ENV_CHUNK_BUCKETS));
+                if (n > 0 && n < (int)line_size) {
+                    return true;
+                }
+                break;
 
-    if (pulse_end_index > pulse_start_index) {
-        const float dv = vcap_start - vcap_end;
-        const float denom = (float)(pulse_end_index - pulse_start_index);
+            case WF_TX_ENV: {
+                if (r->tx_index >= buckets) {
+                    r->tx_stage = WF_TX_PHASE_STATS;
+                    r->tx_index = 0U;
+                    break;
+                }
+                const uint16_t first = r->tx_index;
+                const uint16_t left = (uint16_t)(buckets - first);
+                const uint16_t count =
+                    (left > (uint16_t)WAVEFORM_ENV_CHUNK_BUCKETS)
+                        ? (uint16_t)WAVEFORM_ENV_CHUNK_BUCKETS
+                        : left;
+                r->tx_index = (uint16_t)(r->tx_index + count);
+                if (wf_format_env_chunk(w, buckets, first, count, line,
+                                        line_size) >= 0) {
+                    return true;
+                }
+                break;
+            }
 
-        for (uint16_t i = pulse_start_index; i < pulse_end_index; i++) {
-            const float t = (float)(i - pulse_start_index) / denom;
-            waveform_buffer[i].voltage_volts = vcap_start - (dv * t);
-        }
-    }
+            case WF_TX_PHASE_STATS: {
+                const uint8_t phase = (uint8_t)r->tx_index;
+                r->tx_index++;
+                if (r->tx_index >= 3U) {
+                    r->tx_stage = WF_TX_DONE;
+                }
+                n = weldReportPhaseStatsLine(r, phase, line, line_size);
+                if (n > 0 && n < (int)line_size) {
+                    return true;
+                }
+                break;
+            }
 
-    for (uint16_t i = pulse_end_index; i < waveform_index; i++) {
-        waveform_buffer[i].voltage_volts = vcap_end;
-    }
-}
+            case WF_TX_START: {
+                r->tx_stage = WF_TX_CHUNKS;
+                const uint16_t pre_start = r->preheat_on ? r->mark_start[0] : 0U;
+                const uint16_t pre_end = r->preheat_on ? r->mark_end[0] : 0U;
+                const uint16_t gap_start = r->preheat_on ? r->mark_start[1] : 0U;
+                const uint16_t gap_end = r->preheat_on ? r->mark_end[1] : 0U;
+                n = snprintf(line, line_size,
+                             "WAVEFORM_START,%u,%u,%u,%u,%u,%u,%u",
+                             (unsigned int)w->count, (unsigned int)pre_start,
+                             (unsigned int)pre_end, (unsigned int)gap_start,
+                             (unsigned int)gap_end,
+                             (unsigned int)r->mark_start[2],
+                             (unsigned int)r->mark_end[2]);
+                if (n > 0 && n < (int)line_size) {
+                    return true;
+                }
+                break;
+            }
 
-static void send_waveform_data(void) {
-    if (waveform_index == 0) {
+            case WF_TX_CHUNKS: {
+                if (r->tx_index >= w->count) {
+                    r->tx_stage = WF_TX_END;
+                    break;
+                }
+                const uint16_t chunk_start = r->tx_index;
+                if (r->tx_fmt == WAVEFORM_FMT_BIN) {
+                    uint32_t t0_us = 0U;
+                    size_t len = 0U;
+                    const uint16_t count =
+                        wf_pack_bin_chunk(w, chunk_start, payload, &len, &t0_us);
+                    r->tx_index = (uint16_t)(r->tx_index + count);
+                    const uint16_t seq = r->tx_seq++;
+                    n = snprintf(line, line_size,
+                                 "WAVEFORM_BIN,%u,%u,%u,%lu,%08lX,",
+                                 (unsigned int)seq, (unsigned int)chunk_start,
+                                 (unsigned int)count, (unsigned long)t0_us,
+                                 (unsigned long)crc32_compute(payload, len));
+                    if (n > 0 && n < (int)line_size &&
+                        wf_base64_encode(payload, len, line + n,
+                                         line_size - (size_t)n) != 0U) {
+                        return true;
+                    }
 #if ADC_PAIR_VERBOSE_DEBUG
-        uartSend("DBG,WAVEFORM_EMPTY");
+                    uartSend("DBG,WAVEFORM_BIN_CHUNK_TRUNCATED");
 #endif
-        return;
-    }
-
-    /* Static to avoid allocating 25KB on stack each call. */
-    static char line[WAVEFORM_LINE_BUFFER_SIZE];
-
-    uint16_t pre_start = waveform_preheat_start_index;
-    uint16_t pre_end = waveform_preheat_end_index;
-    uint16_t gap_start = waveform_gap_start_index;
-    uint16_t gap_end = waveform_gap_end_index;
-    uint16_t main_start = waveform_main_start_index;
-    uint16_t main_end = waveform_main_end_index;
-
-    if (!preheat_enabled || preheat_ms == 0U) {
-        pre_start = 0U;
-        pre_end = 0U;
-        gap_start = 0U;
-        gap_end = 0U;
-    }
-
-    int n = snprintf(line, sizeof(line), "WAVEFORM_START,%u,%u,%u,%u,%u,%u,%u",
-                     (unsigned int)waveform_index, (unsigned int)pre_start,
-                     (unsigned int)pre_end, (unsigned int)gap_start,
-                     (unsigned int)gap_end, (unsigned int)main_start,
-                     (unsigned int)main_end);
-    if (n > 0 && n < (int)sizeof(line)) {
-        uartSend(line);
-    }
-
-    for (uint16_t chunk_start = 0; chunk_start < waveform_index;
-         chunk_start += (uint16_t)WAVEFORM_CHUNK_SAMPLES) {
-        uint16_t remaining = (uint16_t)(waveform_index - chunk_start);
-        uint16_t chunk_count = (remaining > (uint16_t)WAVEFORM_CHUNK_SAMPLES)
-                                   ? (uint16_t)WAVEFORM_CHUNK_SAMPLES
-                                   : remaining;
-
-        n = snprintf(line, sizeof(line), "WAVEFORM_DATA,%u,%u",
-                     (unsigned int)chunk_start, (unsigned int)chunk_count);
-
-        for (uint16_t i = 0; i < chunk_count; i++) {
-            uint16_t sample_idx = (uint16_t)(chunk_start + i);
-            if (n <= 0 || n >= (int)sizeof(line)) break;
-            n += snprintf(
-                line + n, sizeof(line) - (size_t)n, ",%lu,%.2f,%.2f",
-                (unsigned long)waveform_buffer[sample_idx].timestamp_us,
-                waveform_buffer[sample_idx].voltage_volts,
-                waveform_buffer[sample_idx].current_amps);
-            if (n >= (int)sizeof(line)) break;
-        }
+                    break;
+                }
 
-        if (n <= 0 || n >= (int)sizeof(line)) {
+                const uint16_t remaining = (uint16_t)(w->count - chunk_start);
+                const uint16_t chunk_count =
+                    (remaining > (uint16_t)WAVEFORM_CHUNK_SAMPLES)
+                        ? (uint16_t)WAVEFORM_CHUNK_SAMPLES
+                        : remaining;
+                r->tx_index = (uint16_t)(r->tx_index + chunk_count);
+                if (wf_format_csv_chunk(w, chunk_start, chunk_count, line,
+                                        line_size) >= 0) {
+                    return true;
+                }
 #if ADC_PAIR_VERBOSE_DEBUG
-            char warn[96];
-            snprintf(warn, sizeof(warn),
-                     "DBG,WAVEFORM_CHUNK_TRUNCATED,start=%u,count=%u,buf=%u",
-                     (unsigned int)chunk_start, (unsigned int)chunk_count,
-                     (unsigned int)sizeof(line));
-            uartSend(warn);
+                {
+                    char warn[96];
+                    snprintf(warn, sizeof(warn),
+                             "DBG,WAVEFORM_CHUNK_TRUNCATED,start=%u,count=%u,"
+                             "buf=%u",
+                             (unsigned int)chunk_start,
+                             (unsigned int)chunk_count,
+                             (unsigned int)line_size);
+                    uartSend(warn);
+                }
 #endif
-            continue;
-        }
-
-        uartSend(line);
-    }
-
-    uartSend("WAVEFORM_END");
-
-    {
-        uint32_t preheat_start_rel =
-            (wf_preheat_start_us >= waveform_capture_start_us)
-                ? (wf_preheat_start_us - waveform_capture_start_us)
-                : 0U;
-        uint32_t preheat_end_rel =
-            (wf_preheat_end_us >= waveform_capture_start_us)
-                ? (wf_preheat_end_us - waveform_capture_start_us)
-                : 0U;
-        uint32_t gap_start_rel =
-            (wf_gap_start_us >= waveform_capture_start_us)
-                ? (wf_gap_start_us - waveform_capture_start_us)
-                : 0U;
-        uint32_t gap_end_rel = (wf_gap_end_us >= waveform_capture_start_us)
-                                   ? (wf_gap_end_us - waveform_capture_start_us)
-                                   : 0U;
-        uint32_t main_start_rel =
-            (wf_main_start_us >= waveform_capture_start_us)
-                ? (wf_main_start_us - waveform_capture_start_us)
-                : 0U;
-        uint32_t main_end_rel =
-            (wf_main_end_us >= waveform_capture_start_us)
-                ? (wf_main_end_us - waveform_capture_start_us)
-                : 0U;
+                break;
+            }
 
-        if (!preheat_enabled || preheat_ms == 0U) {
-            preheat_start_rel = 0U;
-            preheat_end_rel = 0U;
-        }
+            case WF_TX_END:
+                r->tx_stage = WF_TX_PHASES;
+                if (r->tx_fmt == WAVEFORM_FMT_BIN) {
+                    n = snprintf(line, line_size, "WAVEFORM_END,chunks=%u",
+                                 (unsigned int)r->tx_seq);
+                } else {
+                    n = snprintf(line, line_size, "WAVEFORM_END");
+                }
+                if (r->tx_aborted) {
+                    n += snprintf(line + n, line_size - (size_t)n,
+                                  ",aborted=1");
+                }
+                if (n > 0 && n < (int)line_size) {
+                    return true;
+                }
+                break;
 
-        if (!preheat_enabled || preheat_ms == 0U || preheat_gap_ms == 0U) {
-            gap_start_rel = 0U;
-            gap_end_rel = 0U;
-        }
+            case WF_TX_PHASES: {
+                r->tx_stage = WF_TX_DONE;
+                uint32_t rel[6];
+                for (uint8_t i = 0U; i < 3U; i++) {
+                    rel[2U * i] = weldReportPhaseRel(r, r->phase_start_us[i]);
+                    rel[2U * i + 1U] = weldReportPhaseRel(r, r->phase_end_us[i]);
+                }
+                if (!r->preheat_on) {
+                    rel[0] = 0U;
+                    rel[1] = 0U;
+                }
+                if (!r->gap_on) {
+                    rel[2] = 0U;
+                    rel[3] = 0U;
+                }
+                n = snprintf(
+                    line, line_size,
+                    "WAVEFORM_PHASES,preheat_start=%lu,preheat_end=%lu,"
+                    "gap_start=%lu,gap_end=%lu,main_start=%lu,main_end=%lu",
+                    (unsigned long)rel[0], (unsigned long)rel[1],
+                    (unsigned long)rel[2], (unsigned long)rel[3],
+                    (unsigned long)rel[4], (unsigned long)rel[5]);
+                if (n > 0 && n < (int)line_size) {
+                    return true;
+                }
+                break;
+            }
 
-        char phases_line[220];
-        int phases_n = snprintf(
-            phases_line, sizeof(phases_line),
-            "WAVEFORM_PHASES,preheat_start=%lu,preheat_end=%lu,gap_start=%lu,"
-            "gap_end=%lu,main_start=%lu,main_end=%lu",
-            (unsigned long)preheat_start_rel, (unsigned long)preheat_end_rel,
-            (unsigned long)gap_start_rel, (unsigned long)gap_end_rel,
-            (unsigned long)main_start_rel, (unsigned long)main_end_rel);
-        if (phases_n > 0 && phases_n < (int)sizeof(phases_line)) {
-            uartSend(phases_line);
+            case WF_TX_DONE:
+            default:
+                break;
         }
     }
 
 #if ADC_PAIR_VERBOSE_DEBUG
-    char dbg[96];
-    snprintf(
-        dbg, sizeof(dbg),
-        "DBG,WAVEFORM_TX,count=%u,chunks=%u,chunk_size=%u,format=CHUNKED_TVI",
-        (unsigned int)waveform_index,
-        (unsigned int)((waveform_index + WAVEFORM_CHUNK_SAMPLES - 1U) /
-                       WAVEFORM_CHUNK_SAMPLES),
-        (unsigned int)WAVEFORM_CHUNK_SAMPLES);
-    uartSend(dbg);
+    if (!r->tx_summary) {
+        char dbg[96];
+        snprintf(dbg, sizeof(dbg),
+                 "DBG,WAVEFORM_TX,count=%u,chunks=%u,chunk_size=%u,"
+                 "format=CHUNKED_TVI",
+                 (unsigned int)w->count,
+                 (unsigned int)((w->count + WAVEFORM_CHUNK_SAMPLES - 1U) /
+                                WAVEFORM_CHUNK_SAMPLES),
+                 (unsigned int)WAVEFORM_CHUNK_SAMPLES);
+        uartSend(dbg);
+    }
 #endif
+    return false;
+}
+
+/* ============ CRC-32 (hardware CRC unit) ============
+ * Configured to match zlib/Ethernet CRC-32 (poly 0x04C11DB7 reflected,
+ * init 0xFFFFFFFF, final XOR) so hosts can check with binascii.crc32(). */
+static void init_crc32_engine(void) {
+    __HAL_RCC_CRC_CLK_ENABLE();
+    CRC->POL = 0x04C11DB7U;
+    CRC->INIT = 0xFFFFFFFFU;
+    CRC->CR = CRC_CR_REV_IN_0 | CRC_CR_REV_OUT; /* byte-reflected in/out */
+}
+
+static uint32_t crc32_compute(const uint8_t* data, size_t len) {
+    CRC->CR |= CRC_CR_RESET;
+    for (size_t i = 0; i < len; i++) {
+        *(__IO uint8_t*)&CRC->DR = data[i];
+    }
+    return CRC->DR ^ 0xFFFFFFFFU;
 }
 
 static uint16_t get_planned_active_pulse_ms(void) {
@@ -1955,36 +3238,261 @@ static uint16_t get_planned_active_pulse_ms(void) {
     return (uint16_t)active_ms;
 }
 
+/* Pre-buffer + active + post-buffer samples for a planned_pulse_ms capture
+ * at interval_us, capped at the whole store. */
+static uint32_t get_planned_total_samples(uint16_t planned_pulse_ms,
+                                          uint32_t interval_us) {
+    uint32_t total = (uint32_t)WAVEFORM_PRE_SAMPLES_AT(interval_us) +
+                     ((uint32_t)planned_pulse_ms * 1000U) / interval_us +
+                     (uint32_t)WAVEFORM_POST_SAMPLES_AT(interval_us);
+    if (total > WAVEFORM_BUFFER_SIZE) {
+        total = WAVEFORM_BUFFER_SIZE;
+    }
+    return total;
+}
+
 /* ============ Helpers ============ */
+static void uartSendBlocking(const char* s) {
+    const uint8_t* msg = (const uint8_t*)s;
+    size_t remaining = strlen(s);
+
+    while (remaining > 0U) {
+        uint16_t chunk = (remaining > UART_TX_CHUNK_SIZE)
+                             ? (uint16_t)UART_TX_CHUNK_SIZE
+                             : (uint16_t)remaining;
+
+        HAL_StatusTypeDef st = HAL_UART_Transmit(&huart1, (uint8_t*)msg, chunk,
+                                                 UART_TX_TIMEOUT_MS);
+        if (st != HAL_OK) {
+            break;
+        }
+
+        msg += chunk;
+        remaining -= chunk;
+
+        if (remaining > 0U) {
+            HAL_Delay(1);
+        }
+    }
+
+    static const uint8_t crlf[2] = {'\r', '\n'};
+    (void)HAL_UART_Transmit(&huart1, (uint8_t*)crlf, 2U, UART_TX_TIMEOUT_MS);
+}
+
+static inline uint16_t uartTxUsed(const UartTxLane* lane) {
+    return (uint16_t)((lane->head - lane->tail) & lane->mask);
+}
+
+static inline uint16_t uartTxFree(const UartTxLane* lane) {
+    return (uint16_t)(lane->mask - uartTxUsed(lane));
+}
+
+static uint8_t uartTxLaneFor(const char* s) {
+    static const char* const prio_prefixes[] = {
+        "ACK", "DENY", "ERR", "NAK", "EVENT", "CAL_", "BOOT", "STATUS_DELTA"};
+    for (size_t i = 0; i < sizeof(prio_prefixes) / sizeof(prio_prefixes[0]);
+         i++) {
+        if (strncmp(s, prio_prefixes[i], strlen(prio_prefixes[i])) == 0) {
+            return UART_TX_LANE_PRIO;
+        }
+    }
+    return UART_TX_LANE_BULK;
+}
+
+/* Start the next DMA segment if the channel is idle. Runs in the DMA IRQ or
+ * from uartSend() with that IRQ masked. */
+static void uartTxKick(void) {
+    if (uart_tx_busy) {
+        return;
+    }
+
+    uint8_t id;
+    if (!uart_tx_bulk_mid_line &&
+        uartTxUsed(&uart_tx_lanes[UART_TX_LANE_PRIO]) > 0U) {
+        id = UART_TX_LANE_PRIO;
+    } else if (uartTxUsed(&uart_tx_lanes[UART_TX_LANE_BULK]) > 0U) {
+        id = UART_TX_LANE_BULK;
+    } else {
+        return;
+    }
+
+    UartTxLane* lane = &uart_tx_lanes[id];
+    const uint16_t tail = lane->tail;
+    const uint16_t head = lane->head;
+    uint16_t len = (head > tail) ? (uint16_t)(head - tail)
+                                 : (uint16_t)(lane->mask + 1U - tail);
+
+    if (id == UART_TX_LANE_BULK) {
+        /* One bulk line per segment so a priority line can go next. */
+        const uint8_t* nl = memchr(&lane->buf[tail], '\n', len);
+        if (nl != NULL) {
+            len = (uint16_t)(nl - &lane->buf[tail] + 1);
+            uart_tx_bulk_mid_line = false;
+        } else {
+            uart_tx_bulk_mid_line = true; /* line continues after the wrap */
+        }
+    }
+
+    uart_tx_active_lane = id;
+    uart_tx_active_len = len;
+    uart_tx_busy = true;
+
+    DMA1_Channel2->CCR &= ~DMA_CCR_EN;
+    DMA1->IFCR = DMA_IFCR_CGIF2;
+    DMA1_Channel2->CMAR = (uint32_t)&lane->buf[tail];
+    DMA1_Channel2->CNDTR = len;
+    DMA1_Channel2->CCR |= DMA_CCR_EN;
+}
+
 static void uartSend(const char* s) {
     if (s == NULL) {
         return;
     }
 
-    const uint8_t* msg = (const uint8_t*)s;
-    size_t remaining = strlen(s);
+    if (!uart_tx_dma_ready) {
+        uartSendBlocking(s);
+        return;
+    }
+
+    const size_t len = strlen(s);
+    const uint8_t id = uartTxLaneFor(s);
+    UartTxLane* lane = &uart_tx_lanes[id];
+    const size_t need = len + 2U;
+
+    /* Bulk lines may wait for the DMA to make room; never with IRQs masked
+     * (the TC IRQ could not run and HAL_GetTick() would not advance). */
+    if (need > uartTxFree(lane) && id == UART_TX_LANE_BULK &&
+        __get_PRIMASK() == 0U) {
+        const uint32_t start_ms = HAL_GetTick();
+        while (need > uartTxFree(lane) &&
+               (HAL_GetTick() - start_ms) < UART_TX_TIMEOUT_MS) {
+            HAL_IWDG_Refresh(&hiwdg);
+        }
+    }
+
+    if (need > uartTxFree(lane)) {
+        lane->dropped++;
+        return;
+    }
+
+    uint16_t head = lane->head;
+    for (size_t i = 0; i < len; i++) {
+        lane->buf[head] = (uint8_t)s[i];
+        head = (uint16_t)((head + 1U) & lane->mask);
+    }
+    lane->buf[head] = '\r';
+    head = (uint16_t)((head + 1U) & lane->mask);
+    lane->buf[head] = '\n';
+    head = (uint16_t)((head + 1U) & lane->mask);
+
+    __DMB(); /* line bytes visible before the DMA IRQ can see the head */
+    lane->head = head;
+
+    const uint16_t used = uartTxUsed(lane);
+    if (used > lane->high_water) {
+        lane->high_water = used;
+    }
+
+    NVIC_DisableIRQ(DMA1_Channel2_IRQn);
+#if PERF_STATS
+    if (perf_tx_arm && id == UART_TX_LANE_PRIO) {
+        perf_tx_arm = false;
+        perf_tx_left = (int32_t)uartTxUsed(lane); /* this line + ahead */
+        perf_tx_start_cyc = perf_cyc();
+        perf_tx_done = false;
+    }
+#endif
+    uartTxKick();
+    NVIC_EnableIRQ(DMA1_Channel2_IRQn);
+}
+
+/* Wait until both TX lanes have drained and the last stop bit is out (used
+ * before resets into a bootloader). */
+static void uartFlush(uint32_t timeout_ms) {
+    if (!uart_tx_dma_ready) {
+        return;
+    }
+
+    const uint32_t start_ms = HAL_GetTick();
+    while ((uart_tx_busy ||
+            uartTxUsed(&uart_tx_lanes[UART_TX_LANE_PRIO]) > 0U ||
+            uartTxUsed(&uart_tx_lanes[UART_TX_LANE_BULK]) > 0U) &&
+           (HAL_GetTick() - start_ms) < timeout_ms) {
+        HAL_IWDG_Refresh(&hiwdg);
+    }
+    while ((USART1->ISR & USART_ISR_TC) == 0U &&
+           (HAL_GetTick() - start_ms) < timeout_ms) {
+    }
+}
+
+/* Retime USART1 once everything queued at the old rate is out. RX DMA keeps
+ * running; a byte caught mid-switch is a framing error like any other. */
+static void linkSetBaud(uint32_t baud) {
+    uartFlush(500U);
+    USART1->CR1 &= ~USART_CR1_UE;
+    USART1->BRR =
+        UART_DIV_SAMPLING16(HAL_RCC_GetPCLK2Freq(), baud, UART_PRESCALER_DIV1);
+    USART1->CR1 |= USART_CR1_UE;
+    huart1.Init.BaudRate = baud;
+    link_baud = baud;
+    link_err_base = uart_rx_errors;
+    link_err_window_ms = HAL_GetTick();
+    link_last_rx_ms = link_err_window_ms;
+}
 
-    while (remaining > 0U) {
-        uint16_t chunk = (remaining > UART_TX_CHUNK_SIZE)
-                             ? (uint16_t)UART_TX_CHUNK_SIZE
-                             : (uint16_t)remaining;
+static void linkFallback(const char* reason) {
+    char buf[80];
+    linkSetBaud(LINK_BASE_BAUD);
+    link_state = LINK_STATE_BASE;
+    snprintf(buf, sizeof(buf), "EVENT,LINK_SPEED,baud=%lu,reason=%s",
+             (unsigned long)LINK_BASE_BAUD, reason);
+    uartSend(buf);
+}
 
-        HAL_StatusTypeDef st = HAL_UART_Transmit(&huart1, (uint8_t*)msg, chunk,
-                                                 UART_TX_TIMEOUT_MS);
-        if (st != HAL_OK) {
-            break;
-        }
+static bool linkBaudAllowed(uint32_t baud) {
+    static const uint32_t allowed[] = {LINK_BASE_BAUD, 1000000UL, 2000000UL,
+                                       3000000UL};
+    for (size_t i = 0U; i < sizeof(allowed) / sizeof(allowed[0]); i++) {
+        if (allowed[i] == baud) return true;
+    }
+    return false;
+}
 
-        msg += chunk;
-        remaining -= chunk;
+/* Probe reply payload: base64-alphabet characters (no ',' or '=') from a
+ * xorshift32 seeded by the probe sequence number. */
+static void linkProbeFill(uint32_t seq, char* out, size_t len) {
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    uint32_t x = (seq * 0x9E3779B9UL) ^ 0x55AA55AAUL;
+    for (size_t i = 0U; i < len; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        out[i] = alphabet[x & 63U];
+    }
+    out[len] = '\0';
+}
 
-        if (remaining > 0U) {
-            HAL_Delay(1);
+/* Trial timeout and committed-link health. */
+static void jobLink(void) {
+    const uint32_t now = HAL_GetTick();
+    if (link_state == LINK_STATE_TRIAL) {
+        if ((now - link_switch_ms) >= LINK_SPEED_TRIAL_MS) {
+            linkFallback("trial_timeout");
         }
+        return;
+    }
+    if (link_state != LINK_STATE_FAST) {
+        return;
+    }
+    if ((uart_rx_errors - link_err_base) >= LINK_SPEED_ERR_LIMIT) {
+        linkFallback("rx_errors");
+    } else if ((now - link_last_rx_ms) >= LINK_SPEED_SILENCE_MS) {
+        linkFallback("silence");
+    } else if ((now - link_err_window_ms) >= LINK_SPEED_ERR_WINDOW_MS) {
+        link_err_window_ms = now;
+        link_err_base = uart_rx_errors;
     }
-
-    static const uint8_t crlf[2] = {'\r', '\n'};
-    (void)HAL_UART_Transmit(&huart1, (uint8_t*)crlf, 2U, UART_TX_TIMEOUT_MS);
 }
 
 static inline void pwmOff(void) {
@@ -2001,6 +3509,121 @@ static inline void pwmOnDuty(uint16_t duty) {
     __HAL_TIM_SET_COMPARE(&htim1, WELD_TIM_CH, ccr);
 }
 
+/* ============ Contact Watch (ADC2 analog watchdog) ============
+ * Instead of a full differential readCapVoltage() every CONTACT_SAMPLE_MS,
+ * ADC2 converts OUTN (PA4, ch17) continuously and its analog watchdog 1
+ * raises an interrupt only when contact makes or breaks. The AMC1311B output
+ * is symmetric about its common mode, so vcap > g_contact_threshold_v is
+ * OUTN < CM - threshold / (2 * V_CAP_DIVIDER). The ISR timestamps each
+ * make and flips the window, with CONTACT_WATCH_HYST_V of hysteresis
+ * and a 4-conversion hardware filter. contactDetected() debounces from the
+ * make timestamp and pollContactTrigger() times the hold from it, so neither
+ * depends on loop speed, and idle polling costs no ADC time.
+ *
+ * Runs while contact matters (contact trigger mode, or pedal + contact) and
+ * no weld is running. fireRecipe() and the lead calibration stop it because
+ * they take over ADC2; contactWatchService() re-arms it. While it runs,
+ * readCapVoltage() takes OUTN from the running conversion. */
+#define CONTACT_WATCH_HYST_V 0.1f /* vcap volts below threshold to release */
+#define CONTACT_WATCH_CH 17U       /* ADC2_IN17 = PA4 = AMC1311B OUTN */
+#define CONTACT_WATCH_SMP 6U       /* 247.5 cycles, as adcReadChannel2() */
+#define CONTACT_WATCH_FILT 3U      /* flag after AWDFILT + 1 = 4 samples */
+
+static uint16_t contactWatchCounts(float vcap_v) {
+    float vn = contact_watch_cm_v - vcap_v / (2.0f * V_CAP_DIVIDER);
+    float counts = vn * 4095.0f / measured_vdda;
+    if (!isfinite(counts) || counts < 0.0f) counts = 0.0f;
+    if (counts > 4095.0f) counts = 4095.0f;
+    return (uint16_t)counts;
+}
+
+static uint32_t contactWatchTr1(uint16_t lt, uint16_t ht) {
+    return (CONTACT_WATCH_FILT << ADC_TR1_AWDFILT_Pos) |
+           ((uint32_t)ht << ADC_TR1_HT1_Pos) | ((uint32_t)lt << ADC_TR1_LT1_Pos);
+}
+
+/* Recompute the thresholds (VDDA, common mode or threshold changed) and
+ * re-arm the window for the current state. Thresholds may be written while
+ * conversions run. */
+static void contactWatchRetune(void) {
+    contact_watch_make_counts = contactWatchCounts(g_contact_threshold_v);
+    contact_watch_break_counts =
+        contactWatchCounts(g_contact_threshold_v - CONTACT_WATCH_HYST_V);
+    if (contact_watch_running) {
+        ADC2->TR1 = contact_watch_raw
+                        ? contactWatchTr1(0U, contact_watch_break_counts)
+                        : contactWatchTr1(contact_watch_make_counts, 4095U);
+    }
+}
+
+static void contactWatchStart(void) {
+    HAL_ADC_Stop(&hadc2);
+    adcStopRaw(ADC2);
+    if (!adcEnableRaw(ADC2)) {
+        return;
+    }
+    adc2_fast_vcap_mode = false; /* SQR1/SMPR2 are ours now */
+    contactWatchRetune();
+
+    ADC2->IER &= ~ADC_IER_AWD1IE;
+    ADC2->SQR1 = CONTACT_WATCH_CH << ADC_SQR1_SQ1_Pos; /* L = 0: 1 rank */
+    ADC2->SMPR2 = (ADC2->SMPR2 & ~ADC_SMPR2_SMP17) |
+                  (CONTACT_WATCH_SMP << ADC_SMPR2_SMP17_Pos);
+    ADC2->CFGR = (ADC2->CFGR & ~ADC_CFGR_AWD1CH) | ADC_CFGR_CONT |
+                 ADC_CFGR_AWD1SGL | ADC_CFGR_AWD1EN |
+                 (CONTACT_WATCH_CH << ADC_CFGR_AWD1CH_Pos);
+    /* Both sides armed: the first conversion reports the current state
+     * (inside the hysteresis band the previous state is kept). */
+    ADC2->TR1 = contactWatchTr1(contact_watch_make_counts,
+                                contact_watch_break_counts);
+    /* Start from "no contact": a state left over from before the stop would
+     * survive a first conversion inside the band, with a stale make time
+     * that already satisfies CONTACT_DEBOUNCE_MS. */
+    contact_watch_raw = false;
+    contact_watch_make_ms = 0U;
+    ADC2->ISR = ADC_ISR_AWD1 | ADC_ISR_EOC | ADC_ISR_OVR;
+    ADC2->IER |= ADC_IER_AWD1IE;
+
+    HAL_NVIC_SetPriority(ADC1_2_IRQn, 2, 0);
+    HAL_NVIC_EnableIRQ(ADC1_2_IRQn);
+    contact_watch_running = true;
+    ADC2->CR |= ADC_CR_ADSTART;
+}
+
+static void contactWatchStop(void) {
+    if (!contact_watch_running) {
+        return;
+    }
+    ADC2->IER &= ~ADC_IER_AWD1IE;
+    adcStopRaw(ADC2);
+    ADC2->CFGR &= ~(ADC_CFGR_CONT | ADC_CFGR_AWD1SGL | ADC_CFGR_AWD1EN |
+                    ADC_CFGR_AWD1CH);
+    ADC2->ISR = ADC_ISR_AWD1;
+    contact_watch_running = false;
+}
+
+static void contactWatchService(void) {
+    const bool want =
+        (trigger_mode == 2 || contact_with_pedal != 0) && !welding_now;
+    if (want && !contact_watch_running) {
+        contactWatchStart();
+    } else if (!want && contact_watch_running) {
+        contactWatchStop();
+    }
+}
+
+/* Next OUTN sample from the running conversion (0xFFFF on timeout). */
+static uint32_t contactWatchReadN(void) {
+    ADC2->ISR = ADC_ISR_EOC;
+    uint32_t timeout = 100000U;
+    while ((ADC2->ISR & ADC_ISR_EOC) == 0U) {
+        if (--timeout == 0U) {
+            return 0xFFFF;
+        }
+    }
+    return ADC2->DR;
+}
+
 static bool contactDetectedRaw(float* out_vcap) {
     float vcap = readCapVoltage();
     if (out_vcap != NULL) {
@@ -2013,6 +3636,12 @@ static bool contactDetectedRaw(float* out_vcap) {
 static bool contactDetected(void) {
     uint32_t now = HAL_GetTick();
 
+    if (contact_watch_running) {
+        g_contact_state = contact_watch_raw &&
+                          (now - contact_watch_make_ms) >= CONTACT_DEBOUNCE_MS;
+        return g_contact_state;
+    }
+
     if ((now - g_contact_last_sample_ms) < CONTACT_SAMPLE_MS) {
         return g_contact_state;
     }
@@ -2123,6 +3752,37 @@ static void apply_loaded_settings(const PersistentSettings* in) {
     persistent_from_runtime(&g_persistent_settings);
 }
 
+/* Snapshot the runtime settings and (re)start the quiet period. */
+static void settingsMarkDirty(void) {
+    persistent_from_runtime(&g_persistent_settings);
+    settings_dirty = true;
+    settings_dirty_ms = HAL_GetTick();
+}
+
+/* Write the pending snapshot now (one log slot, no-op if unchanged). On
+ * failure the snapshot stays dirty and is retried after another quiet
+ * period. */
+static bool settingsCommit(void) {
+    if (!settings_dirty) {
+        return true;
+    }
+    if (!flash_settings_save(&g_persistent_settings)) {
+        settings_commit_fails++;
+        settings_dirty_ms = HAL_GetTick();
+        char ev[64];
+        snprintf(ev, sizeof(ev), "EVENT,SETTINGS_SAVE_FAILED,fails=%lu",
+                 (unsigned long)settings_commit_fails);
+        uartSend(ev);
+        return false;
+    }
+    settings_dirty = false;
+    return true;
+}
+
+/* stm32_settings_flash.c diagnostics go through the TX lanes; its weak
+ * default (blocking HAL_UART_Transmit) would race the TX DMA. */
+void settings_flash_debug(const char* line) { uartSend(line); }
+
 static void clampParams(void) {
     if (weld_mode < 1) weld_mode = 1;
     if (weld_mode > 3) weld_mode = 3;
@@ -2176,139 +3836,566 @@ static void applyReadyTimeout(void) {
         ready_until_ms = 0;
         uartSend("EVENT,READY_TIMEOUT");
     }
-}
+}
+
+static uint32_t doPulseMsPwm(uint16_t ms, uint16_t duty, uint32_t* pwm_on_us,
+                             uint32_t* pwm_off_us,
+                             uint16_t* pwm_off_waveform_index) {
+    if (ms == 0U) {
+        const uint32_t now_us = micros_now();
+        if (pwm_on_us != NULL) {
+            *pwm_on_us = now_us;
+        }
+        if (pwm_off_us != NULL) {
+            *pwm_off_us = now_us;
+        }
+        if (pwm_off_waveform_index != NULL) {
+            *pwm_off_waveform_index = waveform_index;
+        }
+        return 0U;
+    }
+    if (ms > MAX_WELD_MS) ms = MAX_WELD_MS;
+
+    const uint32_t pulse_start_us = micros_now();
+    uint32_t duration_us = (uint32_t)ms * 1000U;
+
+    /*
+     * ── CRITICAL TIMING SEQUENCE ─────────────────────────────────────────
+     *
+     * TIM2 must start SIMULTANEOUSLY with FET-on so the scope-measured
+     * pulse width equals the configured duration.  Previous code had
+     * ~30-80 µs of setup between pwmOn and TIM2 start (float division,
+     * variable init, function-call overhead) which the scope saw as
+     * overshoot.
+     *
+     * New sequence:
+     *   1. Arm TIM2 (ARR, UIE, one-pulse) — but do NOT start yet
+     *   2. Start TIM2 (write CEN)
+     *   3. IMMEDIATELY pwmOnDuty()  — ~1 instruction later
+     *   4. capturePulseAmpsForDurationUs() just samples ADC; timer is
+     *      already running and ISR will kill FET at expiry.
+     *
+     * Net FET-on-to-TIM2-start skew: ~1 CPU cycle ≈ 6 ns.
+     * ─────────────────────────────────────────────────────────────────────
+     */
+    tim2_fet_killed = false;
+
+    TIM2->CR1 = 0U; /* stop timer              */
+    TIM2->CNT = 0U; /* reset counter           */
+    TIM2->ARR =
+        duration_us > 0U ? (duration_us - 1U) : 0U; /* N µs = ARR+1 ticks     */
+    TIM2->SR = 0U;             /* clear flags             */
+    TIM2->DIER = TIM_DIER_UIE; /* arm FET-kill interrupt  */
+#if PERF_STATS
+    const uint32_t go_cyc = perf_cyc(); /* before GO: no added skew */
+#endif
+
+    /* --- TIM2 start + FET on: back-to-back register writes --- */
+    TIM2->CR1 = TIM_CR1_CEN | TIM_CR1_OPM; /* GO                     */
+    pwmOnDuty(duty);                       /* FET ON ~6 ns later     */
+
+    const uint32_t pulse_on_us = micros_now();
+    if (weld_pedal_edge_valid) {
+        weld_pedal_fet_us = (DWT->CYCCNT - weld_pedal_edge_cyc) / 170U;
+        weld_pedal_edge_valid = false; /* first pulse only */
+    }
+    if (pwm_on_us != NULL) {
+        *pwm_on_us = pulse_on_us;
+    }
+    capturePulseAmpsForDurationUs(duration_us, duty);
+    /*
+     * FET is already OFF - TIM2_IRQHandler killed it within ~70 ns
+     * of timer expiry.  No manual pwmOff() needed here.
+     * Belt-and-suspenders: call pwmOff() anyway as a safety net.
+     * If the ISR already ran, this is a harmless no-op (CCR already 0).
+     */
+    pwmOff();
+    const uint16_t pulse_off_index = waveform_index;
+    const uint32_t pulse_off_us = micros_now();
+
+#if PERF_STATS
+    if (perf_fire_pending) {
+        perf_fire_pending = false;
+        perf_record(PERF_FIRE_FET, go_cyc - perf_fire_cyc);
+    }
+    if (tim2_fet_killed) {
+        /* TIM2 runs ARR+1 = duration_us ticks of 1 us from GO. A negative
+         * result is prescaler phase (< 1 us), not a real early kill. */
+        const int32_t late = (int32_t)(tim2_kill_cyc - go_cyc -
+                                       duration_us * PERF_CYC_PER_US);
+        perf_record(PERF_KILL_ISR, (late > 0) ? (uint32_t)late : 0U);
+        perf_fet_off_cyc = tim2_kill_cyc;
+    } else {
+        perf_fet_off_cyc = perf_cyc();
+    }
+    perf_fet_off_valid = true;
+#endif
+
+    if (pwm_off_waveform_index != NULL) {
+        *pwm_off_waveform_index = pulse_off_index;
+    }
+    if (pwm_off_us != NULL) {
+        *pwm_off_us = pulse_off_us;
+    }
+
+    return (uint32_t)(pulse_off_us - pulse_start_us);
+}
+
+static void captureGapMsWithWaveform(uint16_t ms) {
+    if (ms == 0U) {
+        return;
+    }
+
+    if (ms > MAX_WELD_MS) {
+        ms = MAX_WELD_MS;
+    }
+
+    pwmOff();
+
+    /*
+     * Legacy helper retained for compatibility with existing call sites.
+     * Gap timing now uses TIM2 one-shot for deterministic delay, matching
+     * the hardware-timed pulse duration path.
+     */
+    tim2_delay_us((uint32_t)ms * 1000U);
+}
+
+/* ---- Post-weld pipeline (see WeldReport) ---- */
+_Static_assert(WAVEFORM_LINE_BUFFER_SIZE + 2U + WF_TX_HEADROOM <
+                   UART_TX_BULK_RING_SIZE,
+               "a waveform line must fit the bulk TX ring with headroom");
+/* weldSlotAcquire() places a capture beside the one busy slot. */
+_Static_assert(WELD_SLOT_COUNT == 2U, "slot placement assumes two slots");
+
+/* Queue a bulk line only if it fits, with `reserve` bytes to spare, without
+ * waiting for the TX DMA; false leaves it for a later pass. */
+static bool wfTxTrySend(const char* line, uint16_t reserve) {
+    const size_t need = strlen(line) + 2U + reserve;
+    if (uart_tx_dma_ready &&
+        need > uartTxFree(&uart_tx_lanes[UART_TX_LANE_BULK])) {
+        return false;
+    }
+    uartSend(line);
+    return true;
+}
+
+/* Oldest slot still owed a report (NULL if none). */
+static WeldReport* weldReportOldest(void) {
+    WeldReport* oldest = NULL;
+    for (uint8_t i = 0U; i < WELD_SLOT_COUNT; i++) {
+        WeldReport* r = &weld_reports[i];
+        if (r->state < WELD_SLOT_SETTLE) {
+            continue;
+        }
+        if (oldest == NULL || (int32_t)(r->seq - oldest->seq) < 0) {
+            oldest = r;
+        }
+    }
+    return oldest;
+}
+
+/* Latch everything the report needs from the weld that just ended: the
+ * next weld overwrites the globals. */
+static void weldReportHandoff(WeldReport* r, uint32_t pulse_duration_us) {
+    r->view = waveform_view();
+    r->capture_start_us = waveform_capture_start_us;
+    r->interval_us = waveform_interval_us;
+    r->vcap_measured = waveform_vcap_measured;
+    r->preheat_on = preheat_enabled && preheat_ms != 0U;
+    r->gap_on = r->preheat_on && preheat_gap_ms != 0U;
+    r->mark_start[0] = waveform_preheat_start_index;
+    r->mark_end[0] = waveform_preheat_end_index;
+    r->mark_start[1] = waveform_gap_start_index;
+    r->mark_end[1] = waveform_gap_end_index;
+    r->mark_start[2] = waveform_main_start_index;
+    r->mark_end[2] = waveform_main_end_index;
+    r->phase_start_us[0] = wf_preheat_start_us;
+    r->phase_end_us[0] = wf_preheat_end_us;
+    r->phase_start_us[1] = wf_gap_start_us;
+    r->phase_end_us[1] = wf_gap_end_us;
+    r->phase_start_us[2] = wf_main_start_us;
+    r->phase_end_us[2] = wf_main_end_us;
+    r->pulse_start_index = waveform_pulse_start_index;
+    r->pulse_end_index = waveform_pulse_end_index;
+
+    r->off_ms = last_weld_ms;
+    r->pulse_duration_us = pulse_duration_us;
+    r->mode = weld_mode;
+    r->d_ms[0] = weld_d1_ms;
+    r->d_ms[1] = weld_d2_ms;
+    r->d_ms[2] = weld_d3_ms;
+    r->gap_ms[0] = weld_gap1_ms;
+    r->gap_ms[1] = weld_gap2_ms;
+    r->power_pct = weld_power_pct;
+    r->preheat_en = preheat_enabled;
+    r->preheat_ms = preheat_ms;
+    r->lead_r_ohms = lead_resistance_ohms;
+    r->peak_a = current_peak_amps;
+    r->adc_peak_raw = cal_adc_peak_raw;
+    r->vcap_before = cal_vcap_before;
+    r->vcap_after = 0.0f;
+    r->joule_total_j = joule_total_accumulated;
+    r->joule_work_j = joule_accumulated;
+    r->joule_loss_j = joule_lead_loss_accumulated;
+    r->joule_pred_j = joule_predicted_j;
+    r->joule_kill_us = joule_predict_kill_us;
+    r->pedal_fet_us = weld_pedal_fet_us;
+#if PERF_STATS
+    r->perf_trigger_cyc = perf_trigger_cyc;
+    r->perf_fet_off_cyc = perf_fet_off_cyc;
+    r->perf_fet_off_valid = perf_fet_off_valid;
+#endif
+    r->state = WELD_SLOT_SETTLE;
+}
+
+/* Step 5: wait for the post-pulse voltage to settle before V_after.
+ * An immediate reading includes transient ESR/lead bounce and biases dV
+ * high; 20-50 ms works, 30 ms is a good compromise. `force` reads it now
+ * (a new weld needs the slot). */
+static void weldReportSettle(WeldReport* r, bool force) {
+    if (r->state != WELD_SLOT_SETTLE) {
+        return;
+    }
+    if (!force && (HAL_GetTick() - r->off_ms) < WELD_VCAP_SETTLE_MS) {
+        return;
+    }
+    /* Step 6: ADC diagnostic snapshot AFTER weld (settled) */
+    r->vcap_after = readCapVoltage();
+    cal_vcap_after = r->vcap_after;
+    r->state = WELD_SLOT_QUEUED;
+}
+
+/* Step 7: energy accounting for a settled weld, into r->done_line and
+ * r->phase_stats (QUEUED -> READY). Nothing is sent: weldReportSendDone()
+ * queues the line when the older reports are out. */
+static void weldReportAnalyze(WeldReport* r) {
+    const uint16_t count = r->view.count;
+#if PERF_STATS
+    const uint32_t analyze_cyc = perf_cyc();
+#endif
+
+    /* Voltage overlay (polled capture only; the DMA engine measures Vcap on
+     * every sample): hold pre-pulse at vcap_before, interpolate during active
+     * pulse window, then hold post-pulse at vcap_after. */
+    if (!r->vcap_measured) {
+        wf_interpolate_volts(&r->view, r->vcap_before, r->vcap_after,
+                             r->pulse_start_index, r->pulse_end_index);
+    }
+#if ADC_PAIR_VERBOSE_DEBUG
+    {
+        char vdbg[160];
+        snprintf(
+            vdbg, sizeof(vdbg),
+            "DBG,WAVEFORM_VOLTAGE,method=pre_hold_pulse_interp_post_hold,start="
+            "%.3f,end=%.3f,count=%u,pulse_start_idx=%u,pulse_end_idx=%u",
+            r->vcap_before, r->vcap_after, (unsigned int)count,
+            (unsigned int)r->pulse_start_index,
+            (unsigned int)r->pulse_end_index);
+        uartSend(vdbg);
+    }
+#endif
+
+    /* Recompute pulse statistics from actual captured pulse window.
+     * pulse_* indices are [start, end) (end is exclusive). */
+    uint16_t pulse_start_sample = r->pulse_start_index;
+    uint16_t pulse_end_sample = r->pulse_end_index;
+    if (pulse_start_sample > count) {
+        pulse_start_sample = count;
+    }
+    if (pulse_end_sample > count) {
+        pulse_end_sample = count;
+    }
+    if (pulse_end_sample < pulse_start_sample) {
+        pulse_end_sample = pulse_start_sample;
+    }
+
+    /* Integrate TRUE weld energy at tips using timestamp-based trapezoids
+     * (wf_analyze_pulse, one pass that also yields dI/dt and the contact
+     * resistance trend):
+     *
+     * E_weld = Σ(0.5 * (P[i] + P[i+1]) * dt[i]),
+     * P[i]   = V_tip[i] * I[i],
+     * V_tip  = V_cap - I*R_lead
+     *
+     * Lead-loss energy is computed separately from main-pulse avg current and
+     * pulse duration to keep it aligned with the commanded main pulse window.
+     */
+    float energy_leads_joules = 0.0f;
+    const float nominal_dt_s = (float)r->interval_us * 1.0e-6f;
+    WaveformPulseAnalytics analytics;
+    wf_analyze_pulse(&r->view, pulse_start_sample, pulse_end_sample,
+                     r->lead_r_ohms, nominal_dt_s, &analytics);
+#if PERF_STATS
+    perf_record(PERF_ANALYZE, perf_cyc() - analyze_cyc);
+#endif
+    const WaveformPulseStats pulse_stats = analytics.pulse;
+    const float energy_weld_joules = pulse_stats.energy_j;
+    const float integrated_duration_s = pulse_stats.duration_s;
+    const float pulse_sum_current = pulse_stats.sum_amps;
+    const float pulse_sum_voltage = pulse_stats.sum_volts;
+    const uint32_t pulse_count = pulse_stats.samples;
+
+    cal_current_avg =
+        (pulse_count > 0U) ? (pulse_sum_current / (float)pulse_count) : 0.0f;
+    float avg_vcap_pulse = (pulse_count > 0U)
+                               ? (pulse_sum_voltage / (float)pulse_count)
+                               : r->vcap_before;
+
+    /* Main pulse duration source-of-truth: deadline-controlled ON-window.
+     * Fall back to integrated waveform timing if needed. */
+    float pulse_time_s = (r->pulse_duration_us > 0U)
+                             ? ((float)r->pulse_duration_us * 1.0e-6f)
+                             : integrated_duration_s;
+    if (!isfinite(pulse_time_s) || pulse_time_s < 0.0f) {
+        pulse_time_s = 0.0f;
+    }
+    if (pulse_time_s <= 0.0f && integrated_duration_s > 0.0f) {
+        pulse_time_s = integrated_duration_s;
+    }
+
+    /* Lead loss uses main-pulse avg current and main-pulse duration only. */
+    energy_leads_joules =
+        cal_current_avg * cal_current_avg * r->lead_r_ohms * pulse_time_s;
+    if (!isfinite(energy_leads_joules) || energy_leads_joules < 0.0f) {
+        energy_leads_joules = 0.0f;
+    }
+
+    const uint32_t total_ms = (uint32_t)(pulse_time_s * 1000.0f + 0.5f);
+    float pulse_duration_ms = pulse_time_s * 1000.0f;
+
+    float delta_v = r->vcap_before - r->vcap_after;
+
+    /* Cap-bank ΔV method kept as energy_j source-of-truth for compatibility. */
+    float energy_cap_joules =
+        0.5f * CAP_FARADS *
+        (r->vcap_before * r->vcap_before - r->vcap_after * r->vcap_after);
+    if (!isfinite(energy_cap_joules) || energy_cap_joules < 0.0f) {
+        energy_cap_joules = 0.0f;
+    }
 
-static uint16_t pctToDuty(uint8_t pct) {
-    float duty_pct;
-
-    // Empirical calibration from measured 50% power data at constant charge
-    // level:
-    // - duty=723 (70.7%) -> 1502A (~37% of 4033A)
-    // - duty=788 (77.0%) -> 2378A (~59% of 4033A)
-    // - duty=870 (85.0%) -> 2656A (~66% of 4033A)
-    // Target: ~2017A (50% of 4033A)
-    // Linear interpolation between duty=723 and duty=788 gives ~duty=761,
-    // which is ~74% duty at 50% power. Use piecewise-linear mapping around 74%.
-    // Expected duty checkpoints: 25%->379, 50%->757, 75%->890, 100%->1023.
-    if (pct == 0U) {
-        return 0U;
-    } else if (pct <= 50U) {
-        // 0-50% power -> 0-74% duty (linear)
-        duty_pct = ((float)pct / 50.0f) * 0.74f;
-    } else if (pct < 100U) {
-        // 50-100% power -> 74-100% duty (linear)
-        duty_pct = 0.74f + (((float)pct - 50.0f) / 50.0f) * 0.26f;
-    } else {
-        duty_pct = 1.0f;
+    /* Physics guardrail: lead dissipation cannot exceed capacitor energy. */
+    if (energy_cap_joules > 0.0f && energy_leads_joules > energy_cap_joules) {
+        energy_leads_joules = energy_cap_joules * 0.95f;
     }
 
-    uint16_t duty = (uint16_t)lroundf(duty_pct * (float)PWM_MAX);
+    /* Tip voltage from average pulse voltage minus lead drop (diagnostic). */
+    float v_drop_leads = cal_current_avg * r->lead_r_ohms;
+    float v_at_tips = avg_vcap_pulse - v_drop_leads;
+    if (!isfinite(v_at_tips) || v_at_tips < 0.0f) v_at_tips = 0.0f;
 
-    // Clamp to valid range
-    if (duty > PWM_MAX) duty = PWM_MAX;
+    snprintf(
+        r->done_line, sizeof(r->done_line),
+        "EVENT,WELD_DONE,total_ms=%lu,mode=%d,d1=%d,gap1=%d,d2=%d,gap2=%d,"
+        "d3=%d,power_pct=%d,preheat_en=%d,preheat_ms=%d,"
+        "peak_a=%.1f,adc_raw=%lu,vcap_b=%.3f,vcap_a=%.3f,delta_v=%.3f,"
+        "avg_a=%.1f,v_tips=%.3f,energy_j=%.2f,energy_cap_j=%.2f,energy_"
+        "lead_j=%.2f,energy_weld_j=%.2f,joule_total_j=%.2f,"
+        "joule_workpiece_j=%.2f,joule_loss_j=%.2f,pulse_ms=%.2f,"
+        "pulse_start_sample=%u,pulse_end_sample=%u,wf_samples=%u,"
+        "wf_interval_us=%u,wf_vcap=%d,joule_pred_j=%.2f,joule_kill_us=%lu,"
+        "pedal_fet_us=%lu,didt_a_us=%.2f,r_start_mohm=%.3f,r_end_mohm=%.3f",
+        (unsigned long)total_ms, r->mode, r->d_ms[0], r->gap_ms[0], r->d_ms[1],
+        r->gap_ms[1], r->d_ms[2], r->power_pct, r->preheat_en ? 1 : 0,
+        r->preheat_ms, r->peak_a, (unsigned long)r->adc_peak_raw,
+        r->vcap_before, r->vcap_after, delta_v, cal_current_avg, v_at_tips,
+        energy_weld_joules, energy_cap_joules, energy_leads_joules,
+        energy_weld_joules, r->joule_total_j, r->joule_work_j, r->joule_loss_j,
+        pulse_duration_ms, (unsigned int)r->pulse_start_index,
+        (unsigned int)r->pulse_end_index, (unsigned int)count,
+        (unsigned int)r->interval_us, r->vcap_measured ? 1 : 0,
+        r->joule_pred_j, (unsigned long)r->joule_kill_us,
+        (unsigned long)r->pedal_fet_us, analytics.didt_a_per_us,
+        analytics.r_start_ohms * 1000.0f, analytics.r_end_ohms * 1000.0f);
+
+    /* Summary-mode WAVEFORM_PHASE_STATS, whether or not the mode is on when
+     * this report's turn comes. */
+    for (uint8_t i = 0U; i < 3U; i++) {
+        wf_phase_stats(&r->view, r->mark_start[i], r->mark_end[i],
+                       r->lead_r_ohms, nominal_dt_s, &r->phase_stats[i]);
+    }
+    r->state = WELD_SLOT_READY;
+}
 
-    return duty;
+/* Queue r's EVENT,WELD_DONE (READY -> its burst or summary next). */
+static void weldReportSendDone(WeldReport* r) {
+#if PERF_STATS
+    {
+        const uint32_t done_cyc = perf_cyc();
+        if (r->perf_fet_off_valid) {
+            perf_record(PERF_FET_DONE, done_cyc - r->perf_fet_off_cyc);
+        }
+        perf_record(PERF_TRIG_DONE, done_cyc - r->perf_trigger_cyc);
+    }
+    perf_tx_arm = true;
+    uartSend(r->done_line);
+    perf_tx_arm = false; /* not queued (dropped): nothing to time */
+#else
+    uartSend(r->done_line);
+#endif
 }
 
-static uint32_t doPulseMsPwm(uint16_t ms, uint16_t duty, uint32_t* pwm_on_us,
-                             uint32_t* pwm_off_us,
-                             uint16_t* pwm_off_waveform_index) {
-    if (ms == 0U) {
-        const uint32_t now_us = micros_now();
-        if (pwm_on_us != NULL) {
-            *pwm_on_us = now_us;
+/* Give r's region to the next capture. A READY report only queues its
+ * WELD_DONE line (its burst is skipped). A burst already on the wire is
+ * closed with WAVEFORM_END,...,aborted=1 so the host drops the partial
+ * capture; a summary skips its remaining WAVEFORM_ENV lines. SETTLE /
+ * QUEUED are finished here only if jobPostWeld() has not had a pass since
+ * (the cooldown leaves it hundreds of them). */
+static void weldReportRetire(WeldReport* r) {
+    weldReportSettle(r, true);
+    if (r->state == WELD_SLOT_QUEUED) {
+        weldReportAnalyze(r);
+    }
+    if (r->state == WELD_SLOT_READY) {
+        weldReportSendDone(r);
+    } else if (r->state == WELD_SLOT_TX && r->tx_started) {
+        if (r->tx_stage == WF_TX_SUMMARY || r->tx_stage == WF_TX_ENV) {
+            wf_tx_line_ready = false; /* pending ENV line is dropped */
+            r->tx_stage = WF_TX_PHASE_STATS;
+            r->tx_index = 0U;
         }
-        if (pwm_off_us != NULL) {
-            *pwm_off_us = now_us;
+        if (r->tx_stage == WF_TX_CHUNKS) {
+            if (wf_tx_line_ready && r->tx_fmt == WAVEFORM_FMT_BIN) {
+                r->tx_seq--; /* pending chunk is dropped */
+            }
+            r->tx_aborted = wf_tx_line_ready || r->tx_index < r->view.count;
+            wf_tx_line_ready = false;
+            r->tx_stage = WF_TX_END;
         }
-        if (pwm_off_waveform_index != NULL) {
-            *pwm_off_waveform_index = waveform_index;
+        if (wf_tx_line_ready) {
+            (void)wfTxTrySend(wf_tx_line, 0U);
+        }
+        while (weldReportTxLine(r, wf_tx_line, sizeof(wf_tx_line))) {
+            (void)wfTxTrySend(wf_tx_line, 0U);
         }
-        return 0U;
     }
-    if (ms > MAX_WELD_MS) ms = MAX_WELD_MS;
+    wf_tx_line_ready = false;
+    r->state = WELD_SLOT_FREE;
+}
 
-    const uint32_t pulse_start_us = micros_now();
-    uint32_t duration_us = (uint32_t)ms * 1000U;
+/* Start sending r: its summary (summary mode) or its full burst (normal
+ * mode, or WAVEFORM_GET of a HELD capture). */
+static void weldReportTxBegin(WeldReport* r, bool summary) {
+    r->state = WELD_SLOT_TX;
+    r->tx_stage = summary ? WF_TX_SUMMARY : WF_TX_START;
+    r->tx_fmt = waveform_wire_format;
+    r->tx_index = 0U;
+    r->tx_seq = 0U;
+    r->tx_started = false;
+    r->tx_aborted = false;
+    r->tx_summary = summary;
+}
 
-    /*
-     * ── CRITICAL TIMING SEQUENCE ─────────────────────────────────────────
-     *
-     * TIM2 must start SIMULTANEOUSLY with FET-on so the scope-measured
-     * pulse width equals the configured duration.  Previous code had
-     * ~30-80 µs of setup between pwmOn and TIM2 start (float division,
-     * variable init, function-call overhead) which the scope saw as
-     * overshoot.
-     *
-     * New sequence:
-     *   1. Arm TIM2 (ARR, UIE, one-pulse) — but do NOT start yet
-     *   2. Start TIM2 (write CEN)
-     *   3. IMMEDIATELY pwmOnDuty()  — ~1 instruction later
-     *   4. capturePulseAmpsForDurationUs() just samples ADC; timer is
-     *      already running and ISR will kill FET at expiry.
-     *
-     * Net FET-on-to-TIM2-start skew: ~1 CPU cycle ≈ 6 ns.
-     * ─────────────────────────────────────────────────────────────────────
-     */
-    tim2_fet_killed = false;
+/* Claim a slot for a capture of up to `need_samples`, retiring the oldest
+ * report when both slots are busy or the free stretch is too short. Points
+ * the capture (waveform_buffer / _capacity / block table) at it. A HELD
+ * capture is only kept until this next weld. */
+static WeldReport* weldSlotAcquire(uint16_t need_samples) {
+    for (uint8_t i = 0U; i < WELD_SLOT_COUNT; i++) {
+        if (weld_reports[i].state == WELD_SLOT_HELD) {
+            weld_reports[i].state = WELD_SLOT_FREE;
+        }
+        weld_reports[i].hold = false;
+    }
 
-    TIM2->CR1 = 0U; /* stop timer              */
-    TIM2->CNT = 0U; /* reset counter           */
-    TIM2->ARR =
-        duration_us > 0U ? (duration_us - 1U) : 0U; /* N µs = ARR+1 ticks     */
-    TIM2->SR = 0U;             /* clear flags             */
-    TIM2->DIER = TIM_DIER_UIE; /* arm FET-kill interrupt  */
+    for (;;) {
+        WeldReport* slot = NULL;
+        WeldReport* busy = NULL;
+        for (uint8_t i = 0U; i < WELD_SLOT_COUNT; i++) {
+            if (weld_reports[i].state == WELD_SLOT_FREE) {
+                slot = &weld_reports[i];
+            } else {
+                busy = &weld_reports[i];
+            }
+        }
 
-    /* --- TIM2 start + FET on: back-to-back register writes --- */
-    TIM2->CR1 = TIM_CR1_CEN | TIM_CR1_OPM; /* GO                     */
-    pwmOnDuty(duty);                       /* FET ON ~6 ns later     */
+        uint16_t base = 0U;
+        uint16_t capacity = WAVEFORM_BUFFER_SIZE;
+        if (busy != NULL) {
+            const uint16_t busy_end = (uint16_t)(busy->base + busy->view.count);
+            const uint16_t high_gap =
+                (uint16_t)(WAVEFORM_BUFFER_SIZE - busy_end);
+            if (high_gap >= busy->base) {
+                base = busy_end;
+                capacity = high_gap;
+            } else {
+                capacity = busy->base;
+            }
+        }
 
-    const uint32_t pulse_on_us = micros_now();
-    if (pwm_on_us != NULL) {
-        *pwm_on_us = pulse_on_us;
+        if (slot != NULL && capacity >= need_samples) {
+            slot->state = WELD_SLOT_CAPTURE;
+            slot->seq = weld_report_seq++;
+            slot->base = base;
+            waveform_buffer = &waveform_store[base];
+            waveform_capacity = capacity;
+#if WAVEFORM_PACKED_STORAGE
+            waveform_ts_blocks = waveform_ts_store[slot - weld_reports];
+#endif
+            return slot;
+        }
+        weldReportRetire(weldReportOldest());
     }
-    capturePulseAmpsForDurationUs(duration_us, duty);
-    /*
-     * FET is already OFF - TIM2_IRQHandler killed it within ~70 ns
-     * of timer expiry.  No manual pwmOff() needed here.
-     * Belt-and-suspenders: call pwmOff() anyway as a safety net.
-     * If the ISR already ran, this is a harmless no-op (CCR already 0).
-     */
-    pwmOff();
-    const uint16_t pulse_off_index = waveform_index;
-    const uint32_t pulse_off_us = micros_now();
+}
 
-    if (pwm_off_waveform_index != NULL) {
-        *pwm_off_waveform_index = pulse_off_index;
-    }
-    if (pwm_off_us != NULL) {
-        *pwm_off_us = pulse_off_us;
+/* Scheduler job: advance the oldest report by one step. Settling and
+ * accounting run for every slot, so V_after is read on time and the numbers
+ * are final even behind a long burst. */
+static void jobPostWeld(void) {
+    for (uint8_t i = 0U; i < WELD_SLOT_COUNT; i++) {
+        weldReportSettle(&weld_reports[i], false);
+    }
+    /* Account a settled weld at once, not at its TX turn, so a retire from
+     * the trigger path never has to. One capture per pass. */
+    for (uint8_t i = 0U; i < WELD_SLOT_COUNT; i++) {
+        if (weld_reports[i].state == WELD_SLOT_QUEUED) {
+            weldReportAnalyze(&weld_reports[i]);
+            return;
+        }
     }
 
-    return (uint32_t)(pulse_off_us - pulse_start_us);
-}
-
-static void captureGapMsWithWaveform(uint16_t ms) {
-    if (ms == 0U) {
+    WeldReport* r = weldReportOldest();
+    if (r == NULL) {
         return;
     }
 
-    if (ms > MAX_WELD_MS) {
-        ms = MAX_WELD_MS;
+    if (r->state == WELD_SLOT_READY) {
+        weldReportSendDone(r);
+        r->hold = waveform_summary_mode;
+        weldReportTxBegin(r, r->hold);
+        if (r->view.count == 0U) {
+#if ADC_PAIR_VERBOSE_DEBUG
+            uartSend("DBG,WAVEFORM_EMPTY");
+#endif
+            r->state = WELD_SLOT_FREE;
+        }
+        return;
     }
 
-    pwmOff();
-
-    /*
-     * Legacy helper retained for compatibility with existing call sites.
-     * Gap timing now uses TIM2 one-shot for deterministic delay, matching
-     * the hardware-timed pulse duration path.
-     */
-    tim2_delay_us((uint32_t)ms * 1000U);
+    if (r->state != WELD_SLOT_TX) {
+        return; /* oldest is still settling or being analysed */
+    }
+    if (!wf_tx_line_ready) {
+        if (!weldReportTxLine(r, wf_tx_line, sizeof(wf_tx_line))) {
+            r->state = r->hold ? WELD_SLOT_HELD : WELD_SLOT_FREE;
+            return;
+        }
+        wf_tx_line_ready = true;
+    }
+    if (wfTxTrySend(wf_tx_line, WF_TX_HEADROOM)) {
+        wf_tx_line_ready = false;
+        r->tx_started = true;
+    }
 }
 
 static void fireRecipe(void) {
     uint32_t now_ms = HAL_GetTick();
+#if PERF_STATS
+    perf_fire_cyc = perf_cyc();
+    if (!perf_trigger_valid) {
+        perf_trigger_cyc = perf_fire_cyc; /* contact hold / CMD,FIRE */
+    }
+    perf_trigger_valid = false;
+#endif
 
     if (now_ms - boot_ms < BOOT_INHIBIT_MS) {
         char buf[64];
@@ -2331,7 +4418,7 @@ static void fireRecipe(void) {
         return;
     }
 
-    if (temp_filtered_c > 65.0f) {
+    if (temp_filtered_c > OVERHEAT_TEMP_C) {
         uartSend("DENY,OVERHEAT");
         return;
     }
@@ -2371,17 +4458,20 @@ static void fireRecipe(void) {
     }
 
     const uint16_t planned_pulse_ms = get_planned_active_pulse_ms();
-    uint32_t planned_active_samples =
-        ((uint32_t)planned_pulse_ms * 1000U) / WAVEFORM_SAMPLE_INTERVAL_US;
-    uint32_t planned_total_samples = (uint32_t)WAVEFORM_PRE_SAMPLES +
-                                     planned_active_samples +
-                                     (uint32_t)WAVEFORM_POST_SAMPLES;
-    if (planned_total_samples > WAVEFORM_BUFFER_SIZE) {
-        planned_total_samples = WAVEFORM_BUFFER_SIZE;
+    /* Sized for the DMA interval; a polled fallback needs fewer samples and
+     * is re-sized once start_weld_pulse_capture() has picked the path. */
+    uint32_t planned_total_samples = get_planned_total_samples(
+        planned_pulse_ms, WAVEFORM_SAMPLE_INTERVAL_US);
+    /* May finish an older report first: a trigger never waits on it. */
+    WeldReport* const report = weldSlotAcquire((uint16_t)planned_total_samples);
+    if (planned_total_samples > waveform_capacity) {
+        planned_total_samples = waveform_capacity;
     }
 
     /* === WELD SEQUENCE (modified per refactor plan) === */
 
+    contactWatchStop(); /* the capture takes over ADC2 */
+
     /* Step 1: Disable charger */
     HAL_GPIO_WritePin(CHARGER_EN_PORT, CHARGER_EN_PIN, GPIO_PIN_RESET);
     charger_enabled = false;
@@ -2390,12 +4480,23 @@ static void fireRecipe(void) {
     HAL_Delay(50);
 
     welding_now = true;
+    sched_weld_fired = true;
+    weld_pedal_fet_us = 0U;
     current_peak_amps = 0.0f;
+#if PERF_STATS
+    perf_fire_pending = true;
+    perf_fet_off_valid = false;
+    perf_loop_fired = true;
+#endif
+    streamCheckDelta(); /* welding=1 goes out before the pulse, not after */
 
     /* Reset Joule runtime tracking at weld start. */
     joule_accumulated = 0.0f;
     joule_total_accumulated = 0.0f;
     joule_lead_loss_accumulated = 0.0f;
+    joule_reset(&joule_ctl);
+    joule_predicted_j = 0.0f;
+    joule_predict_kill_us = 0U;
     joule_target_reached = false;
     joule_timeout_abort = false;
     joule_bad_contact_abort = false;
@@ -2416,6 +4517,7 @@ static void fireRecipe(void) {
     /* Verify fast mode configured successfully */
     if (!adc1_fast_current_mode) {
         welding_now = false;
+        report->state = WELD_SLOT_FREE;
         uartSend("DENY,ADC_FAST_CFG_FAIL");
         return;
     }
@@ -2448,6 +4550,7 @@ static void fireRecipe(void) {
 
     if (!warmup_ok) {
         welding_now = false;
+        report->state = WELD_SLOT_FREE;
         uartSend("DENY,ADC_WARMUP_FAIL");
         return;
     }
@@ -2477,7 +4580,13 @@ static void fireRecipe(void) {
      */
 
     start_weld_pulse_capture();
-    capture_waveform_samples((uint16_t)WAVEFORM_PRE_SAMPLES);
+    planned_total_samples =
+        get_planned_total_samples(planned_pulse_ms, waveform_interval_us);
+    if (planned_total_samples > waveform_capacity) {
+        planned_total_samples = waveform_capacity;
+    }
+    capture_waveform_samples(
+        (uint16_t)WAVEFORM_PRE_SAMPLES_AT(waveform_interval_us));
 
     /* Pulse window metadata reported to host/UI must refer to MAIN weld pulse
      * only (not preheat and not preheat gap). Initialize to current index and
@@ -2506,10 +4615,6 @@ static void fireRecipe(void) {
     bool main_pulse_started = false;
     uint32_t main_pulse_elapsed_us = 0U;
 
-    /* Measure weld duration with microsecond precision to avoid +1ms skew from
-     * HAL tick quantization while preserving waveform alignment. */
-    uint32_t weld_start_us = micros_now();
-
     bool preheat_debug_ready = false;
     uint16_t preheat_debug_cfg_ms = 0U;
     uint16_t preheat_debug_duty = 0U;
@@ -2528,7 +4633,7 @@ static void fireRecipe(void) {
     if (preheat_enabled && preheat_ms > 0) {
         uint16_t preheat_start_idx = waveform_index;
         waveform_preheat_start_index = preheat_start_idx;
-        uint16_t preheat_duty = pctToDuty(preheat_pct);
+        uint16_t preheat_duty = weld_pct_to_duty(preheat_pct);
         uint16_t preheat_linear_duty =
             (uint16_t)(((uint32_t)preheat_pct * PWM_MAX) / 100U);
 
@@ -2588,7 +4693,7 @@ static void fireRecipe(void) {
             waveform_gap_start_index = gap_start_idx;
             uint16_t planned_gap_samples =
                 (uint16_t)(((uint32_t)preheat_gap_ms * 1000U) /
-                           WAVEFORM_SAMPLE_INTERVAL_US);
+                           waveform_interval_us);
 
             /*
              * Hardware timer delay for inter-pulse gap control.
@@ -2625,7 +4730,7 @@ static void fireRecipe(void) {
      * gap-timer-expiry → main-pulse-FET-on is as short as possible.
      * (Moved out of the critical timing path.)
      */
-    uint16_t mainDuty = pctToDuty(weld_power_pct);
+    uint16_t mainDuty = weld_pct_to_duty(weld_power_pct);
     uint16_t main_linear_duty =
         (uint16_t)(((uint32_t)weld_power_pct * PWM_MAX) / 100U);
     bool joule_stop_requested =
@@ -2810,10 +4915,6 @@ static void fireRecipe(void) {
         waveform_main_end_index = waveform_index;
     }
 
-    uint32_t weld_end_us = micros_now();
-    uint32_t total_ms =
-        (uint32_t)((weld_end_us - weld_start_us + 500U) / 1000U);
-
     pwmOff();
 
     /* Use ACTUAL captured pulse end index (exclusive), not ms-planned index.
@@ -2827,13 +4928,14 @@ static void fireRecipe(void) {
         waveform_pulse_end_index = pulse_end_index;
         waveform_main_end_index = pulse_end_index;
     }
-    if (waveform_index < WAVEFORM_BUFFER_SIZE) {
+    if (waveform_index < waveform_capacity) {
         uint16_t remaining_samples =
-            (uint16_t)(WAVEFORM_BUFFER_SIZE - waveform_index);
-        uint16_t post_samples =
-            (remaining_samples < (uint16_t)WAVEFORM_POST_SAMPLES)
-                ? remaining_samples
-                : (uint16_t)WAVEFORM_POST_SAMPLES;
+            (uint16_t)(waveform_capacity - waveform_index);
+        const uint16_t planned_post_samples =
+            (uint16_t)WAVEFORM_POST_SAMPLES_AT(waveform_interval_us);
+        uint16_t post_samples = (remaining_samples < planned_post_samples)
+                                    ? remaining_samples
+                                    : planned_post_samples;
         capture_waveform_samples(post_samples);
     }
 
@@ -2862,20 +4964,20 @@ static void fireRecipe(void) {
                 uint16_t pulse_last_index =
                     (uint16_t)(pulse_end_index_exclusive - 1U);
                 uint32_t pulse_start_us =
-                    waveform_buffer[pulse_start_index].timestamp_us;
+                    waveform_sample_ts_us(pulse_start_index);
                 uint32_t pulse_end_us =
-                    waveform_buffer[pulse_last_index].timestamp_us;
+                    waveform_sample_ts_us(pulse_last_index);
 
                 if (pulse_end_index_exclusive < waveform_index) {
                     uint32_t next_us =
-                        waveform_buffer[pulse_end_index_exclusive].timestamp_us;
+                        waveform_sample_ts_us(pulse_end_index_exclusive);
                     if (next_us > pulse_end_us) {
                         pulse_end_us = next_us;
                     } else {
-                        pulse_end_us += WAVEFORM_SAMPLE_INTERVAL_US;
+                        pulse_end_us += waveform_interval_us;
                     }
                 } else {
-                    pulse_end_us += WAVEFORM_SAMPLE_INTERVAL_US;
+                    pulse_end_us += waveform_interval_us;
                 }
 
                 uint32_t waveform_window_us =
@@ -2888,16 +4990,17 @@ static void fireRecipe(void) {
             }
         }
 
-        total_ms = (pulse_duration_us + 500U) / 1000U;
-
         uint32_t capture_ms =
-            ((uint32_t)WAVEFORM_PRE_SAMPLES * WAVEFORM_SAMPLE_INTERVAL_US +
+            ((uint32_t)WAVEFORM_PRE_SAMPLES_AT(waveform_interval_us) *
+                 waveform_interval_us +
              (uint32_t)planned_pulse_ms * 1000U +
-             (uint32_t)WAVEFORM_POST_SAMPLES * WAVEFORM_SAMPLE_INTERVAL_US +
+             (uint32_t)WAVEFORM_POST_SAMPLES_AT(waveform_interval_us) *
+                 waveform_interval_us +
              500U) /
             1000U;
 
 #if ADC_PAIR_VERBOSE_DEBUG
+        const uint32_t total_ms = (pulse_duration_us + 500U) / 1000U;
         char tdbg[224];
         snprintf(tdbg, sizeof(tdbg),
                  "DBG,WAVEFORM_TIMING,pulse_ms=%lu,pulse_us=%lu,capture_ms=%lu,"
@@ -2922,7 +5025,7 @@ static void fireRecipe(void) {
         float preheat_sum_amps = 0.0f;
         for (uint16_t i = preheat_debug_start_idx; i < preheat_debug_end_idx;
              i++) {
-            float a = waveform_buffer[i].current_amps;
+            float a = waveform_sample_amps(i);
             if (a > preheat_max_amps) preheat_max_amps = a;
             preheat_sum_amps += a;
         }
@@ -2938,264 +5041,74 @@ static void fireRecipe(void) {
                  (unsigned int)preheat_debug_duty,
                  (unsigned int)preheat_samples,
                  (unsigned int)preheat_debug_start_idx,
-                 (unsigned int)preheat_debug_end_idx, preheat_avg_amps,
-                 preheat_max_amps);
-        uartSend(pdbg);
-    }
-#endif
-
-#if ADC_PAIR_VERBOSE_DEBUG
-    if (gap_debug_ready) {
-        uint16_t captured_gap_samples =
-            (gap_debug_end_idx >= gap_debug_start_idx)
-                ? (uint16_t)(gap_debug_end_idx - gap_debug_start_idx)
-                : 0U;
-
-        float gap_max_amps = 0.0f;
-        float gap_sum_amps = 0.0f;
-        for (uint16_t i = gap_debug_start_idx; i < gap_debug_end_idx; i++) {
-            float a = waveform_buffer[i].current_amps;
-            if (a > gap_max_amps) gap_max_amps = a;
-            gap_sum_amps += a;
-        }
-        float gap_avg_amps = (captured_gap_samples > 0U)
-                                 ? (gap_sum_amps / (float)captured_gap_samples)
-                                 : 0.0f;
-
-        char gdbg_start[140];
-        snprintf(gdbg_start, sizeof(gdbg_start),
-                 "DBG,PREHEAT_GAP_START,cfg_ms=%u,start_us=%lu,mosfet=OFF,"
-                 "planned_samples=%u",
-                 (unsigned int)gap_debug_cfg_ms,
-                 (unsigned long)gap_debug_start_us,
-                 (unsigned int)gap_debug_planned_samples);
-        uartSend(gdbg_start);
-
-        char gdbg_end[196];
-        snprintf(gdbg_end, sizeof(gdbg_end),
-                 "DBG,PREHEAT_GAP_END,cfg_ms=%u,actual_us=%lu,captured_samples="
-                 "%u,avg_a=%.2f,max_a=%.2f,mosfet=OFF",
-                 (unsigned int)gap_debug_cfg_ms,
-                 (unsigned long)(gap_debug_end_us - gap_debug_start_us),
-                 (unsigned int)captured_gap_samples, gap_avg_amps,
-                 gap_max_amps);
-        uartSend(gdbg_end);
-    }
-#endif
-
-#if ADC_PAIR_VERBOSE_DEBUG
-    {
-        char cdbg[160];
-        snprintf(cdbg, sizeof(cdbg),
-                 "DBG,PWM_COMP,phase=main,pct=%u,linear_duty=%u,comp_duty=%u",
-                 (unsigned int)weld_power_pct, (unsigned int)main_linear_duty,
-                 (unsigned int)mainDuty);
-        uartSend(cdbg);
-    }
-#endif
-
-    welding_now = false;
-    last_weld_ms = HAL_GetTick();
-
-    /* 🔴 Engage post-weld lockout (atomic pair update) */
-    __disable_irq();
-    charger_lockout = true;
-    charger_lockout_until = HAL_GetTick() + 500;
-    __enable_irq();
-
-    /* Step 5: Wait for post-pulse voltage to settle before V_after capture.
-     * Immediate reading includes transient ESR/lead bounce and biases ΔV high.
-     * Use 20-50ms window; 30ms is a good compromise for stable settled value.
-     */
-    const uint32_t vcap_settle_delay_ms = 30U;
-    HAL_Delay(vcap_settle_delay_ms);
-
-    /* Step 6: ADC diagnostic snapshot AFTER weld (settled) */
-    cal_vcap_after = readCapVoltage();
-
-    /* Voltage overlay: hold pre-pulse at vcap_before, interpolate during active
-     * pulse window, then hold post-pulse at vcap_after. */
-    apply_waveform_voltage_interpolation(cal_vcap_before, cal_vcap_after,
-                                         waveform_pulse_start_index,
-                                         waveform_pulse_end_index);
-#if ADC_PAIR_VERBOSE_DEBUG
-    {
-        char vdbg[160];
-        snprintf(
-            vdbg, sizeof(vdbg),
-            "DBG,WAVEFORM_VOLTAGE,method=pre_hold_pulse_interp_post_hold,start="
-            "%.3f,end=%.3f,count=%u,pulse_start_idx=%u,pulse_end_idx=%u",
-            cal_vcap_before, cal_vcap_after, (unsigned int)waveform_index,
-            (unsigned int)waveform_pulse_start_index,
-            (unsigned int)waveform_pulse_end_index);
-        uartSend(vdbg);
-    }
-#endif
-
-    /* Recompute pulse statistics from actual captured pulse window.
-     * waveform_pulse_* indices are [start, end) (end is exclusive). */
-    uint16_t pulse_start_sample = waveform_pulse_start_index;
-    uint16_t pulse_end_sample = waveform_pulse_end_index;
-    if (pulse_start_sample > waveform_index) {
-        pulse_start_sample = waveform_index;
-    }
-    if (pulse_end_sample > waveform_index) {
-        pulse_end_sample = waveform_index;
-    }
-    if (pulse_end_sample < pulse_start_sample) {
-        pulse_end_sample = pulse_start_sample;
-    }
-
-    float pulse_sum_current = 0.0f;
-    float pulse_sum_voltage = 0.0f;
-    uint32_t pulse_count = 0U;
-
-    /* Integrate TRUE weld energy at tips using timestamp-based trapezoids.
-     *
-     * E_weld = Σ(0.5 * (P[i] + P[i+1]) * dt[i]),
-     * P[i]   = V_tip[i] * I[i],
-     * V_tip  = V_cap - I*R_lead
-     *
-     * Lead-loss energy is computed separately from main-pulse avg current and
-     * pulse duration to keep it aligned with the commanded main pulse window.
-     */
-    float energy_weld_joules = 0.0f;
-    float energy_leads_joules = 0.0f;
-    float integrated_duration_s = 0.0f;
-    const float nominal_dt_s = (float)WAVEFORM_SAMPLE_INTERVAL_US * 1.0e-6f;
-
-    for (uint16_t i = pulse_start_sample; i < pulse_end_sample; i++) {
-        float i_shunt = waveform_buffer[i].current_amps;
-        float v_cap = waveform_buffer[i].voltage_volts;
-
-        if (!isfinite(i_shunt) || i_shunt < 0.0f) i_shunt = 0.0f;
-        if (!isfinite(v_cap) || v_cap < 0.0f) v_cap = 0.0f;
-
-        pulse_sum_current += i_shunt;
-        pulse_sum_voltage += v_cap;
-        pulse_count++;
-    }
-
-    if ((pulse_end_sample - pulse_start_sample) >= 2U) {
-        for (uint16_t i = pulse_start_sample;
-             (uint16_t)(i + 1U) < pulse_end_sample; i++) {
-            float i0 = waveform_buffer[i].current_amps;
-            float v0 = waveform_buffer[i].voltage_volts;
-            float i1 = waveform_buffer[i + 1U].current_amps;
-            float v1 = waveform_buffer[i + 1U].voltage_volts;
-
-            if (!isfinite(i0) || i0 < 0.0f) i0 = 0.0f;
-            if (!isfinite(v0) || v0 < 0.0f) v0 = 0.0f;
-            if (!isfinite(i1) || i1 < 0.0f) i1 = 0.0f;
-            if (!isfinite(v1) || v1 < 0.0f) v1 = 0.0f;
-
-            float dt_s = nominal_dt_s;
-            uint32_t t_us = waveform_buffer[i].timestamp_us;
-            uint32_t t_next_us = waveform_buffer[i + 1U].timestamp_us;
-            if (t_next_us > t_us) {
-                dt_s = (float)(t_next_us - t_us) * 1.0e-6f;
-            }
-            if (!isfinite(dt_s) || dt_s <= 0.0f) dt_s = nominal_dt_s;
-
-            float v_tip0 = v0 - (i0 * lead_resistance_ohms);
-            float v_tip1 = v1 - (i1 * lead_resistance_ohms);
-            if (!isfinite(v_tip0) || v_tip0 < 0.0f) v_tip0 = 0.0f;
-            if (!isfinite(v_tip1) || v_tip1 < 0.0f) v_tip1 = 0.0f;
-
-            float p0_watts = v_tip0 * i0;
-            float p1_watts = v_tip1 * i1;
-            if (!isfinite(p0_watts) || p0_watts < 0.0f) p0_watts = 0.0f;
-            if (!isfinite(p1_watts) || p1_watts < 0.0f) p1_watts = 0.0f;
-
-            energy_weld_joules += 0.5f * (p0_watts + p1_watts) * dt_s;
-
-            integrated_duration_s += dt_s;
-        }
-    } else if ((pulse_end_sample - pulse_start_sample) == 1U) {
-        /* Degenerate case: one in-window sample only. */
-        integrated_duration_s = nominal_dt_s;
-    }
-
-    if (!isfinite(energy_weld_joules) || energy_weld_joules < 0.0f) {
-        energy_weld_joules = 0.0f;
-    }
-    if (!isfinite(integrated_duration_s) || integrated_duration_s < 0.0f) {
-        integrated_duration_s = 0.0f;
-    }
-
-    cal_current_avg =
-        (pulse_count > 0U) ? (pulse_sum_current / (float)pulse_count) : 0.0f;
-    float avg_vcap_pulse = (pulse_count > 0U)
-                               ? (pulse_sum_voltage / (float)pulse_count)
-                               : cal_vcap_before;
-
-    /* Main pulse duration source-of-truth: deadline-controlled ON-window.
-     * Fall back to integrated waveform timing if needed. */
-    float pulse_time_s = (pulse_duration_us > 0U)
-                             ? ((float)pulse_duration_us * 1.0e-6f)
-                             : integrated_duration_s;
-    if (!isfinite(pulse_time_s) || pulse_time_s < 0.0f) {
-        pulse_time_s = 0.0f;
-    }
-    if (pulse_time_s <= 0.0f && integrated_duration_s > 0.0f) {
-        pulse_time_s = integrated_duration_s;
+                 (unsigned int)preheat_debug_end_idx, preheat_avg_amps,
+                 preheat_max_amps);
+        uartSend(pdbg);
     }
+#endif
 
-    /* Lead loss uses main-pulse avg current and main-pulse duration only. */
-    energy_leads_joules =
-        cal_current_avg * cal_current_avg * lead_resistance_ohms * pulse_time_s;
-    if (!isfinite(energy_leads_joules) || energy_leads_joules < 0.0f) {
-        energy_leads_joules = 0.0f;
-    }
+#if ADC_PAIR_VERBOSE_DEBUG
+    if (gap_debug_ready) {
+        uint16_t captured_gap_samples =
+            (gap_debug_end_idx >= gap_debug_start_idx)
+                ? (uint16_t)(gap_debug_end_idx - gap_debug_start_idx)
+                : 0U;
 
-    pulse_duration_us = (uint32_t)(pulse_time_s * 1000000.0f + 0.5f);
-    total_ms = (uint32_t)(pulse_time_s * 1000.0f + 0.5f);
-    float pulse_duration_ms = pulse_time_s * 1000.0f;
+        float gap_max_amps = 0.0f;
+        float gap_sum_amps = 0.0f;
+        for (uint16_t i = gap_debug_start_idx; i < gap_debug_end_idx; i++) {
+            float a = waveform_sample_amps(i);
+            if (a > gap_max_amps) gap_max_amps = a;
+            gap_sum_amps += a;
+        }
+        float gap_avg_amps = (captured_gap_samples > 0U)
+                                 ? (gap_sum_amps / (float)captured_gap_samples)
+                                 : 0.0f;
 
-    float delta_v = cal_vcap_before - cal_vcap_after;
+        char gdbg_start[140];
+        snprintf(gdbg_start, sizeof(gdbg_start),
+                 "DBG,PREHEAT_GAP_START,cfg_ms=%u,start_us=%lu,mosfet=OFF,"
+                 "planned_samples=%u",
+                 (unsigned int)gap_debug_cfg_ms,
+                 (unsigned long)gap_debug_start_us,
+                 (unsigned int)gap_debug_planned_samples);
+        uartSend(gdbg_start);
 
-    /* Cap-bank ΔV method kept as energy_j source-of-truth for compatibility. */
-    float energy_cap_joules =
-        0.5f * CAP_FARADS *
-        (cal_vcap_before * cal_vcap_before - cal_vcap_after * cal_vcap_after);
-    if (!isfinite(energy_cap_joules) || energy_cap_joules < 0.0f) {
-        energy_cap_joules = 0.0f;
+        char gdbg_end[196];
+        snprintf(gdbg_end, sizeof(gdbg_end),
+                 "DBG,PREHEAT_GAP_END,cfg_ms=%u,actual_us=%lu,captured_samples="
+                 "%u,avg_a=%.2f,max_a=%.2f,mosfet=OFF",
+                 (unsigned int)gap_debug_cfg_ms,
+                 (unsigned long)(gap_debug_end_us - gap_debug_start_us),
+                 (unsigned int)captured_gap_samples, gap_avg_amps,
+                 gap_max_amps);
+        uartSend(gdbg_end);
     }
+#endif
 
-    /* Physics guardrail: lead dissipation cannot exceed capacitor energy. */
-    if (energy_cap_joules > 0.0f && energy_leads_joules > energy_cap_joules) {
-        energy_leads_joules = energy_cap_joules * 0.95f;
+#if ADC_PAIR_VERBOSE_DEBUG
+    {
+        char cdbg[160];
+        snprintf(cdbg, sizeof(cdbg),
+                 "DBG,PWM_COMP,phase=main,pct=%u,linear_duty=%u,comp_duty=%u",
+                 (unsigned int)weld_power_pct, (unsigned int)main_linear_duty,
+                 (unsigned int)mainDuty);
+        uartSend(cdbg);
     }
+#endif
 
-    /* Tip voltage from average pulse voltage minus lead drop (diagnostic). */
-    float v_drop_leads = cal_current_avg * lead_resistance_ohms;
-    float v_at_tips = avg_vcap_pulse - v_drop_leads;
-    if (!isfinite(v_at_tips) || v_at_tips < 0.0f) v_at_tips = 0.0f;
+    welding_now = false;
+    last_weld_ms = HAL_GetTick();
 
-    char buf[576];
-    snprintf(
-        buf, sizeof(buf),
-        "EVENT,WELD_DONE,total_ms=%lu,mode=%d,d1=%d,gap1=%d,d2=%d,gap2=%d,"
-        "d3=%d,power_pct=%d,preheat_en=%d,preheat_ms=%d,"
-        "peak_a=%.1f,adc_raw=%lu,vcap_b=%.3f,vcap_a=%.3f,delta_v=%.3f,"
-        "avg_a=%.1f,v_tips=%.3f,energy_j=%.2f,energy_cap_j=%.2f,energy_"
-        "lead_j=%.2f,energy_weld_j=%.2f,joule_total_j=%.2f,"
-        "joule_workpiece_j=%.2f,joule_loss_j=%.2f,pulse_ms=%.2f,"
-        "pulse_start_sample=%u,pulse_end_sample=%u,wf_samples=%u",
-        (unsigned long)total_ms, weld_mode, weld_d1_ms, weld_gap1_ms,
-        weld_d2_ms, weld_gap2_ms, weld_d3_ms, weld_power_pct,
-        preheat_enabled ? 1 : 0, preheat_ms, current_peak_amps,
-        (unsigned long)cal_adc_peak_raw, cal_vcap_before, cal_vcap_after,
-        delta_v, cal_current_avg, v_at_tips, energy_weld_joules,
-        energy_cap_joules, energy_leads_joules, energy_weld_joules,
-        joule_total_accumulated, joule_accumulated, joule_lead_loss_accumulated,
-        pulse_duration_ms, (unsigned int)waveform_pulse_start_index,
-        (unsigned int)waveform_pulse_end_index, (unsigned int)waveform_index);
-    uartSend(buf);
+    /* 🔴 Engage post-weld lockout (atomic pair update) */
+    __disable_irq();
+    charger_lockout = true;
+    charger_lockout_until = HAL_GetTick() + 500;
+    __enable_irq();
 
-    /* Phase 3: transmit waveform CSV burst right after weld completion event.
-     */
-    send_waveform_data();
+    /* Steps 5-7 (Vcap settle, energy, EVENT,WELD_DONE) and the waveform
+     * burst run in jobPostWeld(), so the next trigger is served at once. */
+    weldReportHandoff(report, pulse_duration_us);
 }
 
 /* ============================================================================
@@ -3261,7 +5174,7 @@ static void performLeadCalibration(void) {
         uartSend("CAL_ERROR=BUSY");
         return;
     }
-    if (temp_filtered_c > 65.0f) {
+    if (temp_filtered_c > OVERHEAT_TEMP_C) {
         uartSend("CAL_ERROR=OVERHEAT");
         return;
     }
@@ -3394,11 +5307,13 @@ static void performLeadCalibration(void) {
     uartSend("CAL_STATUS=MEASURING");
 
     /* ---- Prepare exactly like a weld: charger off, fast ADC ---- */
+    contactWatchStop();
     HAL_GPIO_WritePin(CHARGER_EN_PORT, CHARGER_EN_PIN, GPIO_PIN_RESET);
     charger_enabled = false;
     HAL_Delay(20); /* let charger node settle */
 
     welding_now = true;
+    sched_weld_fired = true;
     cached_vcap = v_before;
 
     HAL_ADC_Stop(&hadc1);
@@ -3416,8 +5331,10 @@ static void performLeadCalibration(void) {
     const uint32_t duration_us = (uint32_t)CAL_PULSE_MS * 1000U;
     const float v_per_count = measured_vdda / 4095.0f;
 
-    double sum_i = 0.0;
-    double sum_v = 0.0;
+    /* Raw-count sums: both scales are linear, so they are applied once to
+     * the averages instead of in soft-float double per sample. */
+    uint32_t sum_i_counts = 0U; /* 12-bit counts: ~1e6 samples fit */
+    uint32_t sum_v_counts = 0U;
     uint32_t n = 0U;
 
     tim2_fet_killed = false;
@@ -3445,18 +5362,10 @@ static void performLeadCalibration(void) {
         int32_t diff = (int32_t)p - (int32_t)nn;
         if (diff < 0) diff = 0;
 
-        float v_adc = (float)diff * v_per_count;
-        float v_shunt = v_adc / SHUNT_GAIN;
-        float amps = (v_shunt / SHUNT_EFF_OHMS) * CURRENT_CAL_FACTOR;
-        if (!isfinite(amps) || amps < 0.0f) amps = 0.0f;
-
         /* adc2_fast_vcap_mode is not enabled on this path (matches weld path),
          * so the negative leg is treated as 0 just like capturePulseAmps. */
-        float v_cap = (float)v_p * v_per_count * V_CAP_DIVIDER;
-        if (!isfinite(v_cap) || v_cap < 0.0f) v_cap = 0.0f;
-
-        sum_i += (double)amps;
-        sum_v += (double)v_cap;
+        sum_i_counts += (uint32_t)diff;
+        sum_v_counts += v_p;
         n++;
     }
 
@@ -3479,8 +5388,13 @@ static void performLeadCalibration(void) {
         return;
     }
 
-    float i_avg = (float)(sum_i / (double)n);
-    float v_avg = (float)(sum_v / (double)n);
+    const float i_counts_avg = (float)sum_i_counts / (float)n;
+    const float v_counts_avg = (float)sum_v_counts / (float)n;
+    float i_avg = ((i_counts_avg * v_per_count / SHUNT_GAIN) / SHUNT_EFF_OHMS) *
+                  CURRENT_CAL_FACTOR;
+    float v_avg = v_counts_avg * v_per_count * V_CAP_DIVIDER;
+    if (!isfinite(i_avg) || i_avg < 0.0f) i_avg = 0.0f;
+    if (!isfinite(v_avg) || v_avg < 0.0f) v_avg = 0.0f;
 
     /* Not enough current => tips were not actually shorted. */
     if (i_avg < CAL_MIN_CURRENT_A) {
@@ -3502,8 +5416,8 @@ static void performLeadCalibration(void) {
 
     /* ---- Persist using the exact same path as the SET_LEAD_R handler ---- */
     lead_resistance_ohms = r;
-    persistent_from_runtime(&g_persistent_settings);
-    bool saved = flash_settings_save(&g_persistent_settings);
+    settingsMarkDirty();
+    bool saved = settingsCommit();
 
     /* Terminal success line (resistance in Ohms, parsed as bare float). */
     char ok[48];
@@ -3568,6 +5482,9 @@ static void MX_GPIO_Init(void) {
     __HAL_RCC_GPIOA_CLK_ENABLE();
     __HAL_RCC_GPIOB_CLK_ENABLE();
     __HAL_RCC_GPIOC_CLK_ENABLE();
+    /* HAL_GPIO_Init() routes an EXTI line to its port through SYSCFG->EXTICR;
+     * without this clock the write is lost and EXTI12 stays on PA12. */
+    __HAL_RCC_SYSCFG_CLK_ENABLE();
 
     GPIO_InitTypeDef GPIO_InitStruct = {0};
 
@@ -3578,7 +5495,7 @@ static void MX_GPIO_Init(void) {
     HAL_GPIO_Init(LED_PORT, &GPIO_InitStruct);
 
     GPIO_InitStruct.Pin = PEDAL_PIN;
-    GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+    GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING_FALLING; /* Pedal Trigger */
     GPIO_InitStruct.Pull = GPIO_PULLUP;
     HAL_GPIO_Init(PEDAL_PORT, &GPIO_InitStruct);
 
@@ -3619,7 +5536,7 @@ static void MX_USART1_UART_Init(void) {
     __HAL_RCC_USART1_CLK_ENABLE();
 
     huart1.Instance = USART1;
-    huart1.Init.BaudRate = 576000;  // 576 kbaud — safe through UART3-IN level shifters
+    huart1.Init.BaudRate = LINK_BASE_BAUD;  // safe through UART3-IN level shifters
     huart1.Init.WordLength = UART_WORDLENGTH_8B;
     huart1.Init.StopBits = UART_STOPBITS_1;
     huart1.Init.Parity = UART_PARITY_NONE;
@@ -3632,8 +5549,28 @@ static void MX_USART1_UART_Init(void) {
         }
     }
 
-    HAL_NVIC_SetPriority(USART1_IRQn, 0, 0);
+    /* RX is DMA-driven (uart_rx_dma_start), so the USART IRQ only sees
+     * IDLE/error events and can sit below TIM2's FET kill. */
+    HAL_NVIC_SetPriority(USART1_IRQn, 1, 0);
     HAL_NVIC_EnableIRQ(USART1_IRQn);
+
+    /* TX queue: DMA1 ch2 <- DMAMUX1 ch1 <- USART1_TX, memory -> TDR, byte
+     * wide. IRQ below TIM2/USART1 so it never delays the FET kill. */
+    __HAL_RCC_DMAMUX1_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    DMA1_Channel2->CCR = 0U;
+    DMAMUX1_Channel1->CCR = DMA_REQUEST_USART1_TX;
+    DMA1_Channel2->CPAR = (uint32_t)&USART1->TDR;
+    DMA1_Channel2->CCR =
+        DMA_CCR_DIR | DMA_CCR_MINC | DMA_CCR_TCIE | DMA_CCR_TEIE | DMA_CCR_PL_0;
+    DMA1->IFCR = DMA_IFCR_CGIF2;
+    USART1->CR3 |= USART_CR3_DMAT;
+    HAL_NVIC_SetPriority(DMA1_Channel2_IRQn, 2, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel2_IRQn);
+    uart_tx_dma_ready = true;
+
+    /* RX ring IRQs share USART1's priority so the drains never nest. */
+    HAL_NVIC_SetPriority(DMA1_Channel3_IRQn, 1, 0);
 }
 
 static void MX_TIM1_Init(void) {
@@ -3929,6 +5866,13 @@ static void MX_I2C1_Init(void) {
         ina226_ok = false;
         return;
     }
+
+    /* Interrupt-driven INA226 polling (ina226_seq_*). Lowest priority in the
+     * system: it must never delay the TIM kill ISRs or the UART DMA. */
+    HAL_NVIC_SetPriority(I2C1_EV_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(I2C1_EV_IRQn);
+    HAL_NVIC_SetPriority(I2C1_ER_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(I2C1_ER_IRQn);
 }
 
 static void MX_IWDG_Init(void) {
@@ -3995,7 +5939,9 @@ static float readCapVoltage(void) {
 
     for (int i = 0; i < samples; i++) {
         uint32_t p = adcReadChannel(ADC_CHANNEL_4);    // PA3
-        uint32_t n = adcReadChannel2(ADC_CHANNEL_17);  // PA4
+        uint32_t n = contact_watch_running
+                         ? contactWatchReadN()           // PA4, running
+                         : adcReadChannel2(ADC_CHANNEL_17);  // PA4
 
         if (p == 0xFFFF || n == 0xFFFF) continue;
 
@@ -4010,6 +5956,7 @@ static float readCapVoltage(void) {
 
     float vP = ((float)sumP / valid) * (vdda / 4095.0f);
     float vN = ((float)sumN / valid) * (vdda / 4095.0f);
+    contact_watch_cm_v = 0.5f * (vP + vN); /* Contact Watch thresholds */
 
     float v = (vP - vN) * V_CAP_DIVIDER;
 
@@ -4022,535 +5969,1125 @@ static float readCapVoltage(void) {
     return v;
 }
 
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef* huart) {
-    if (huart->Instance == USART1) {
-        char c = (char)rx_byte;
-        uart_rx_bytes++;
+/* Assemble one received byte; runs in the USART1 / DMA1 ch3 IRQs. */
+static void uart_rx_push_byte(char c) {
+    if (c == '\n' || c == '\r') {
+        if (rx_discarding) {
+            rx_discarding = false;
+            rx_idx = 0;
+            return;
+        }
+        if (rx_idx == 0) {
+            return;
+        }
+        rx_build[rx_idx] = '\0';
 
-        if (c == '\n' || c == '\r') {
-            if (rx_idx > 0) {
-                rx_build[rx_idx] = '\0';
-                if (!rx_line_ready) {
-                    memcpy(rx_ready, rx_build, rx_idx + 1);
-                    rx_line_ready = true;
-                }
-                rx_idx = 0;
-            }
-        } else if (rx_idx < RX_LINE_MAX - 1) {
-            rx_build[rx_idx++] = c;
+        const uint8_t head = rx_queue_head;
+        const uint8_t used = (uint8_t)(head - rx_queue_tail);
+        if (used >= RX_LINE_QUEUE_DEPTH) {
+            uart_rx_line_drops++;
         } else {
-            rx_idx = 0;
+            memcpy(rx_queue[head & (RX_LINE_QUEUE_DEPTH - 1U)], rx_build,
+                   (size_t)rx_idx + 1U);
+            __DMB(); /* line visible before the main loop sees the head */
+            rx_queue_head = (uint8_t)(head + 1U);
+            if ((uint8_t)(used + 1U) > rx_queue_high_water) {
+                rx_queue_high_water = (uint8_t)(used + 1U);
+            }
         }
+        rx_idx = 0;
+    } else if (rx_discarding) {
+        /* drop the rest of an overlong line */
+    } else if (rx_idx < RX_LINE_MAX - 1) {
+        rx_build[rx_idx++] = c;
+    } else {
+        rx_discarding = true;
+        rx_idx = 0;
+        uart_rx_line_overlong++;
+    }
+}
 
-        HAL_UART_Receive_IT(&huart1, &rx_byte, 1);
+/* Consume everything the DMA has written since the last call. */
+static void uart_rx_dma_drain(void) {
+    const uint16_t head =
+        (uint16_t)((UART_RX_DMA_RING_SIZE - DMA1_Channel3->CNDTR) %
+                   UART_RX_DMA_RING_SIZE);
+    while (uart_rx_dma_tail != head) {
+        uart_rx_push_byte((char)uart_rx_dma_ring[uart_rx_dma_tail]);
+        uart_rx_dma_tail =
+            (uint16_t)((uart_rx_dma_tail + 1U) % UART_RX_DMA_RING_SIZE);
+        uart_rx_bytes++;
     }
 }
 
-void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart) {
-    if (huart->Instance == USART1) {
-        uint32_t err = huart->ErrorCode;
-        uart_rx_errors++;
+/* (Re)start circular RX: DMA1 ch3 <- DMAMUX1 ch2 <- USART1_RX, RDR -> ring.
+ * Also used by the RXHEALTH self-heal if a transfer error disabled the
+ * channel. Drops any partially assembled line. */
+static void uart_rx_dma_start(void) {
+    NVIC_DisableIRQ(USART1_IRQn);
+    NVIC_DisableIRQ(DMA1_Channel3_IRQn);
+
+    USART1->CR3 &= ~USART_CR3_DMAR;
+    DMA1_Channel3->CCR = 0U;
+    DMAMUX1_Channel2->CCR = DMA_REQUEST_USART1_RX;
+    DMA1_Channel3->CPAR = (uint32_t)&USART1->RDR;
+    DMA1_Channel3->CMAR = (uint32_t)uart_rx_dma_ring;
+    DMA1_Channel3->CNDTR = UART_RX_DMA_RING_SIZE;
+    DMA1->IFCR = DMA_IFCR_CGIF3;
+    DMA1_Channel3->CCR = DMA_CCR_MINC | DMA_CCR_CIRC | DMA_CCR_HTIE |
+                         DMA_CCR_TCIE | DMA_CCR_TEIE | DMA_CCR_PL_1;
+    DMA1_Channel3->CCR |= DMA_CCR_EN;
+
+    uart_rx_dma_tail = 0U;
+    rx_idx = 0;
+    rx_discarding = false;
+
+    USART1->ICR = USART_ICR_IDLECF | USART_ICR_ORECF | USART_ICR_FECF |
+                  USART_ICR_NECF | USART_ICR_PECF;
+    USART1->CR3 |= USART_CR3_DMAR | USART_CR3_EIE;
+    USART1->CR1 |= USART_CR1_IDLEIE;
+
+    NVIC_EnableIRQ(DMA1_Channel3_IRQn);
+    NVIC_EnableIRQ(USART1_IRQn);
+}
 
-        if (err & HAL_UART_ERROR_ORE) uart_rx_overruns++;
+/* Main loop side of the line queue. */
+static bool uart_rx_pop_line(char* out) {
+    const uint8_t tail = rx_queue_tail;
+    if (tail == rx_queue_head) {
+        return false;
+    }
+    __DMB();
+    memcpy(out, rx_queue[tail & (RX_LINE_QUEUE_DEPTH - 1U)], RX_LINE_MAX);
+    rx_queue_tail = (uint8_t)(tail + 1U);
+    return true;
+}
 
-        __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_OREF);
-        __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_FEF);
-        __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_NEF);
-        __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_PEF);
-        huart->ErrorCode = HAL_UART_ERROR_NONE;
+/* ============ Cooperative Scheduler ============
+ * The periodic housekeeping the main loop used to run from ad-hoc
+ * HAL_GetTick() deltas, as a table of jobs with a declared period and
+ * deadline. period_ms = 0 runs the job on every loop pass. A periodic job is
+ * released every period_ms; its response time is (start - release) +
+ * execution time, and a response over deadline_us counts as a miss. The
+ * trigger inputs (pedal, contact) are re-polled before every job, so trigger
+ * jitter is bounded by the longest single job (see "SCHED" WCETs), not by
+ * the whole pass. None of the jobs block on I2C any more: INA226 reads are
+ * interrupt-driven (ina226_seq_*).
+ *
+ * A weld blocks the loop by design, so a pass in which one fired (trigger
+ * poll or a CMD,FIRE line) is left out of the timing statistics. */
+typedef struct {
+    const char* name;
+    uint16_t period_ms;   /* 0 = every pass */
+    uint32_t deadline_us; /* max response time */
+    void (*fn)(void);
+    uint32_t next_ms; /* next release */
+    uint32_t runs;
+    uint32_t misses;
+    uint32_t wcet_cyc;
+    uint32_t max_resp_us;
+} SchedJob;
+
+/* Refresh VDDA calibration every 1s alongside temperature */
+static void jobTemp(void) {
+    measured_vdda = measureVDDA();
+    contactWatchRetune();
 
-        HAL_UART_Receive_IT(&huart1, &rx_byte, 1);
+    float t = readThermistor();
+    if (t > -50.0f && t < 200.0f) {
+        /* Valid reading: apply exponential filter */
+        temp_filtered_c = (0.1f * t) + (0.9f * temp_filtered_c);
+    } else {
+        /* Sensor fault (-99) or out-of-range: propagate immediately
+         * instead of ignoring, so UI shows error state */
+        temp_filtered_c = t;
     }
 }
 
-static void parseCommand(char* line) {
-    char response[256];
+/* 150ms matches AVG=64 conversion time */
+static void jobInaStart(void) { ina226_seq_start(); }
 
-    /* Sanitise the incoming line BEFORE any strcmp(). The RX ISR normally
-     * splits on \r/\n, but be defensive: skip leading whitespace (and actually
-     * advance 'line' past it), then trim any trailing \r, \n or spaces. This
-     * guarantees "BOOTLOADER\r\n" (or " BOOTLOADER ") becomes exactly
-     * "BOOTLOADER" so the comparisons below match. */
-    {
-        char* p = line;
-        while (*p == ' ' || *p == '\t') p++;  /* skip leading whitespace */
-        line = p;
+static void jobInaPoll(void) {
+    if (ina226_seq_poll()) {
+        chargerStateMachine();
+    }
+}
 
-        size_t len = strlen(line);
-        while (len > 0 &&
-               (line[len - 1] == '\r' || line[len - 1] == '\n' ||
-                line[len - 1] == ' ' || line[len - 1] == '\t')) {
-            line[--len] = '\0';
+/* Dispatch every line queued so far (bounded so a flood cannot starve the
+ * rest of the loop). */
+static void jobRxDispatch(void) {
+    char local_line[RX_LINE_MAX];
+    for (uint8_t n = 0U; n < RX_LINE_QUEUE_DEPTH; n++) {
+        if (!uart_rx_pop_line(local_line)) {
+            break;
         }
+        link_last_rx_ms = HAL_GetTick();
+        parseCommand(local_line);
+    }
+}
 
-        if (len == 0) return;  /* nothing left after trimming */
+/* Deferred settings commit. Appending a slot takes well under 1 ms; the
+ * page erase every SETTINGS_LOG_SLOTS_PER_PAGE commits blocks the main loop
+ * for ~20 ms. It hits bank 2 only, so interrupts fetching from bank 1 still
+ * run (dual-bank read-while-write), but a pedal press latched by TIM7 would
+ * not fire until the erase ends. So while armed only appends are committed;
+ * an erasing commit waits for disarm. */
+static void jobSettings(void) {
+    if (settings_dirty && !welding_now &&
+        (HAL_GetTick() - settings_dirty_ms) >= SETTINGS_COMMIT_QUIET_MS &&
+        !(armed && flash_settings_save_needs_erase())) {
+        (void)settingsCommit();
     }
+}
+
+#if DEBUG_UART_RX
+static void jobRxHealth(void) {
+    char hb[288];
+    snprintf(hb, sizeof(hb),
+             "RXHEALTH,bytes=%lu,errors=%lu,overruns=%lu,"
+             "tx_drop_prio=%lu,tx_drop_bulk=%lu,tx_hw_prio=%u,"
+             "tx_hw_bulk=%u,tx_dma_err=%lu,rx_line_drop=%lu,"
+             "rx_overlong=%lu,rx_q_hw=%u,rx_dma_err=%lu",
+             (unsigned long)uart_rx_bytes,
+             (unsigned long)uart_rx_errors,
+             (unsigned long)uart_rx_overruns,
+             (unsigned long)uart_tx_lanes[UART_TX_LANE_PRIO].dropped,
+             (unsigned long)uart_tx_lanes[UART_TX_LANE_BULK].dropped,
+             (unsigned)uart_tx_lanes[UART_TX_LANE_PRIO].high_water,
+             (unsigned)uart_tx_lanes[UART_TX_LANE_BULK].high_water,
+             (unsigned long)uart_tx_dma_errors,
+             (unsigned long)uart_rx_line_drops,
+             (unsigned long)uart_rx_line_overlong,
+             (unsigned)rx_queue_high_water,
+             (unsigned long)uart_rx_dma_errors);
+    uartSend(hb);
+
+    /* A DMA transfer error disables the channel: restart it. */
+    if ((DMA1_Channel3->CCR & DMA_CCR_EN) == 0U) {
+        uart_rx_dma_start();
+        uartSend("RXHEALTH,REARM");
+    }
+}
+#endif
+
+/* Table order is run order within a pass. */
+static SchedJob sched_jobs[] = {
+    {"ina_poll", 0U, 1000U, jobInaPoll, 0U, 0U, 0U, 0U, 0U},
+    {"rx", 0U, 5000U, jobRxDispatch, 0U, 0U, 0U, 0U, 0U},
+    {"ina", 150U, 10000U, jobInaStart, 0U, 0U, 0U, 0U, 0U},
+    /* STATUS + STATUS2 at the STREAM rate (500 ms by default) plus
+     * change-driven STATUS_DELTA when subscribed; rate-limited inside. */
+    {"stream", 0U, 2000U, streamService, 0U, 0U, 0U, 0U, 0U},
+    {"temp", 1000U, 50000U, jobTemp, 0U, 0U, 0U, 0U, 0U},
+    {"settings", 100U, 25000U, jobSettings, 0U, 0U, 0U, 0U, 0U},
+    /* Settle, WELD_DONE and one waveform line per pass (see WeldReport). */
+    {"postweld", 0U, 10000U, jobPostWeld, 0U, 0U, 0U, 0U, 0U},
+    /* A fallback flushes the TX queue before retiming the USART. */
+    {"link", 100U, 500000U, jobLink, 0U, 0U, 0U, 0U, 0U},
+#if DEBUG_UART_RX
+    {"rxhealth", 5000U, 100000U, jobRxHealth, 0U, 0U, 0U, 0U, 0U},
+#endif
+};
+#define SCHED_JOB_COUNT (sizeof(sched_jobs) / sizeof(sched_jobs[0]))
+
+static void sched_init(uint32_t now_ms) {
+    for (size_t i = 0U; i < SCHED_JOB_COUNT; i++) {
+        sched_jobs[i].next_ms = now_ms + sched_jobs[i].period_ms;
+    }
+}
+
+static void sched_run(void) {
+    for (size_t i = 0U; i < SCHED_JOB_COUNT; i++) {
+        SchedJob* j = &sched_jobs[i];
+        uint32_t now = HAL_GetTick();
+        if (j->period_ms != 0U && (int32_t)(now - j->next_ms) < 0) {
+            continue;
+        }
+
+        pollPedal();
+        pollContactTrigger();
+
+        now = HAL_GetTick();
+        const uint32_t release_ms = (j->period_ms != 0U) ? j->next_ms : now;
+        const uint32_t start_cyc = DWT->CYCCNT;
+        j->fn();
+        const uint32_t exec_cyc = DWT->CYCCNT - start_cyc;
+
+        if (j->period_ms != 0U) {
+            j->next_ms += j->period_ms;
+            if ((int32_t)(now - j->next_ms) >= 0) {
+                j->next_ms = now + j->period_ms; /* overran: re-phase */
+            }
+        }
+        j->runs++;
+        if (sched_weld_fired) {
+            continue;
+        }
+        const uint32_t resp_us =
+            (now - release_ms) * 1000U + exec_cyc / 170U; /* 170 MHz */
+        if (exec_cyc > j->wcet_cyc) j->wcet_cyc = exec_cyc;
+        if (resp_us > j->max_resp_us) j->max_resp_us = resp_us;
+        if (resp_us > j->deadline_us) j->misses++;
+    }
+
+    if (sched_weld_fired) {
+        /* Jobs released during the weld start their clock now. */
+        const uint32_t now = HAL_GetTick();
+        for (size_t i = 0U; i < SCHED_JOB_COUNT; i++) {
+            if ((int32_t)(now - sched_jobs[i].next_ms) > 0) {
+                sched_jobs[i].next_ms = now;
+            }
+        }
+        sched_weld_fired = false;
+    }
+}
+
+/* ============ Command Dispatcher ============
+ * One handler per command, looked up by binary search in a table sorted by
+ * name (strcmp order). The lookup key is the first token of the line up to
+ * ',' or '='; "CMD," and "CMD,SET," prefixes extend it by one token so
+ * "CMD,SET,PULSE,5" resolves to "CMD,SET,PULSE". `args` points just past
+ * the delimiter ("" for bare commands). */
+typedef void (*UartCommandHandler)(char* line, const char* args);
+
+typedef struct {
+    const char* name;
+    char delim; /* '\0' = bare command, ',' or '=' = arguments follow */
+    UartCommandHandler handler;
+} UartCommand;
+
+/* Remote firmware update: re-enter the factory ROM bootloader so the ESP32
+ * can flash a new image over UART (AN3155).
+ *
+ * HARDWARE BOOT0 ENTRY (rock-solid, ST-supported):
+ * The ESP32 has a dedicated control wire from its GPIO38 to the STM32 BOOT0
+ * pin (PB8). Before sending this command the ESP32 drives BOOT0 HIGH and
+ * holds it for the whole flash. All we do here is ACK and issue a clean
+ * NVIC_SystemReset(). On the ensuing reset the chip samples BOOT0=1 and
+ * starts the factory ROM bootloader exactly as it would on a hardware reset
+ * with BOOT0 asserted - fully USART-responsive on PA9/PA10 at 8E1. The ESP32
+ * drops BOOT0 LOW again after flashing so the next reset boots the app.
+ * Accept both the bare and CMD-prefixed command forms. */
+static void cmdBootloader(char* line, const char* args) {
+    (void)line;
+    (void)args;
+    /* SOFTWARE (BOOT0-independent) ROM-bootloader entry.
+     * Earlier this did a bare NVIC_SystemReset() and relied entirely on the
+     * ESP32 holding the hardware BOOT0 pin high. Field testing proved that
+     * strap is NOT effective on this board (after the reset the chip lands
+     * back in the application, broadcasting STATUS at 1 Mbaud, instead of
+     * the silent ROM bootloader) - whether due to the GPIO31->BOOT0 wiring
+     * or an option byte (nBOOT_SEL) that makes BOOT0 ignored.
+     *
+     * requestBootloaderReset() instead stashes BOOTLOADER_REQUEST_MAGIC in a
+     * TAMP backup register and resets. The magic survives the warm reset and
+     * is detected at the very top of main() (before the IWDG is re-armed),
+     * which then calls jumpToBootloader() to remap system memory and jump to
+     * the ROM at 0x1FFF0000. This reaches the ROM bootloader with NO reliance
+     * on the BOOT0 pin at all. */
+    uartSend("DBG,BOOTLOADER command received -> requesting KATAPULT bootloader "
+             "entry (2-wire flash on USART1 PA9/PA10, no BOOT0/NRST needed)");
+    HAL_Delay(20);
+    uartSend("ACK,BOOTLOADER");
+    uartFlush(500U);            /* drain the DMA TX queue */
+    HAL_Delay(50);              /* ensure the ACK is fully transmitted */
+    requestKatapultReset();     /* sets Katapult request signature + reset; no return */
+}
+
+/* FW_CRC,<len>: CRC-32 (zlib) of the first <len> bytes of this image, so the
+ * P4 can check a Katapult upload end to end without reading it back. */
+#define APP_IMAGE_BASE 0x08002000UL
+#define APP_IMAGE_MAX 0x7C000UL /* FLASH length in STM32G474CETX_FLASH.ld */
+
+static void cmdFwCrc(char* line, const char* args) {
+    (void)line;
+    char* end = NULL;
+    unsigned long len = strtoul(args, &end, 10);
+    if (end == args || *end != '\0' || len == 0UL || len > APP_IMAGE_MAX) {
+        uartSend("DENY,FW_CRC,RANGE");
+        return;
+    }
+    char buf[64];
+    snprintf(buf, sizeof(buf), "ACK,FW_CRC,len=%lu,crc32=%08lX", len,
+             (unsigned long)crc32_compute((const uint8_t*)APP_IMAGE_BASE,
+                                          (size_t)len));
+    uartSend(buf);
+}
+
+static void cmdReady(char* line, const char* args) {
+    (void)line;
+    int v = atoi(args);
+    if (v == 1) {
+        system_ready = true;
+        ready_until_ms = HAL_GetTick() + READY_TIMEOUT_MS;
+        uartSend("ACK,READY,1");
+    } else {
+        system_ready = false;
+        ready_until_ms = 0;
+        uartSend("ACK,READY,0");
+    }
+}
+
+static void cmdArm(char* line, const char* args) {
+    (void)line;
+    int v = atoi(args);
+    if (v == 1) {
+        armed = true;
+        armed_until_ms =
+            (ARM_TIMEOUT_MS == 0) ? 0 : (HAL_GetTick() + ARM_TIMEOUT_MS);
+        uartSend("ACK,ARM,1");
+    } else {
+        armed = false;
+        armed_until_ms = 0;
+        uartSend("ACK,ARM,0");
+    }
+}
+
+static void cmdSetPulseLegacy(char* line, const char* args) {
+    (void)line;
+    char response[48];
+    int val = atoi(args);
+    if (val > 0 && val <= MAX_WELD_MS) {
+        weld_d1_ms = (uint16_t)val;
+        snprintf(response, sizeof(response), "ACK,PULSE=%d", weld_d1_ms);
+        uartSend(response);
+    } else {
+        uartSend("ERR,PULSE_RANGE");
+    }
+}
+
+static void cmdSetPulse(char* line, const char* args) {
+    (void)line;
+    int v_mode = 1, v_d1 = 0, v_gap1 = 0, v_d2 = 0, v_gap2 = 0, v_d3 = 0;
+    int n = sscanf(args, "%d,%d,%d,%d,%d,%d", &v_mode, &v_d1, &v_gap1, &v_d2,
+                   &v_gap2, &v_d3);
+    if (n == 6) {
+        weld_mode = (uint8_t)v_mode;
+        weld_d1_ms = (uint16_t)v_d1;
+        weld_gap1_ms = (uint16_t)v_gap1;
+        weld_d2_ms = (uint16_t)v_d2;
+        weld_gap2_ms = (uint16_t)v_gap2;
+        weld_d3_ms = (uint16_t)v_d3;
+        clampParams();
+
+        settingsMarkDirty();
+
+        uartSend("ACK,SET_PULSE");
+        sendStatusPacket();
+    } else {
+        uartSend("DENY,BAD_SET_PULSE");
+    }
+}
+
+static void cmdSetPowerLegacy(char* line, const char* args) {
+    (void)line;
+    char response[48];
+    int val = atoi(args);
+    if (val >= 50 && val <= 100) {
+        weld_power_pct = (uint8_t)val;
+        snprintf(response, sizeof(response), "ACK,POWER=%d", weld_power_pct);
+        uartSend(response);
+    } else {
+        uartSend("ERR,POWER_RANGE");
+    }
+}
+
+static void cmdSetPower(char* line, const char* args) {
+    (void)line;
+    char response[48];
+    weld_power_pct = (uint8_t)atoi(args);
+    clampParams();
+    settingsMarkDirty();
+    snprintf(response, sizeof(response), "ACK,SET_POWER,pct=%d",
+             weld_power_pct);
+    uartSend(response);
+    sendStatusPacket();
+}
+
+static void cmdSetMode(char* line, const char* args) {
+    (void)line;
+    char response[48];
+    int new_mode_i = atoi(args);
+    if (new_mode_i >= 0 && new_mode_i <= 1) {
+        control_mode = (uint8_t)new_mode_i;
+        clampParams();
+        settingsMarkDirty();
+        snprintf(response, sizeof(response), "ACK,SET_MODE,mode=%u",
+                 (unsigned)control_mode);
+        uartSend(response);
+        sendStatusPacket();
+    } else {
+        uartSend("DENY,SET_MODE,RANGE");
+    }
+}
+
+static void cmdSetJouleTarget(char* line, const char* args) {
+    (void)line;
+    char response[80];
+    char* endptr = NULL;
+    float new_target = strtof(args, &endptr);
+    if (endptr == args || (endptr && *endptr != '\0') ||
+        !isfinite(new_target)) {
+        uartSend("DENY,SET_JOULE_TARGET,PARSE");
+        return;
+    }
+
+    if (new_target >= 0.0f && new_target <= 300.0f) {
+        float old_target = joule_target_j;
+        snprintf(response, sizeof(response),
+                 "DBG,SET_JOULE_TARGET,old=%.1f,new=%.1f", old_target,
+                 new_target);
+        uartSend(response);
+
+        joule_target_j = new_target;
+        clampParams();
+        settingsMarkDirty();
+        snprintf(response, sizeof(response), "ACK,SET_JOULE_TARGET,j=%.1f",
+                 joule_target_j);
+        uartSend(response);
+        sendStatusPacket();
+    } else {
+        uartSend("DENY,SET_JOULE_TARGET,RANGE");
+    }
+}
+
+static void cmdSetJouleMax(char* line, const char* args) {
+    (void)line;
+    char response[48];
+    int new_max_i = atoi(args);
+    if (new_max_i >= 5 && new_max_i <= 500) {
+        joule_max_ms = (uint32_t)new_max_i;
+        clampParams();
+        settingsMarkDirty();
+        snprintf(response, sizeof(response), "ACK,SET_JOULE_MAX,ms=%lu",
+                 (unsigned long)joule_max_ms);
+        uartSend(response);
+        sendStatusPacket();
+    } else {
+        uartSend("DENY,SET_JOULE_MAX,RANGE");
+    }
+}
+
+static void cmdSetPreheat(char* line, const char* args) {
+    (void)line;
+    char response[80];
+    int v_en = 0, v_ms = 0, v_pct = 0, v_gap = 0;
+    int n = sscanf(args, "%d,%d,%d,%d", &v_en, &v_ms, &v_pct, &v_gap);
+    if (n >= 3) {
+        preheat_enabled = (v_en == 1);
+        preheat_ms = (uint16_t)v_ms;
+        preheat_pct = (uint8_t)v_pct;
+        if (n >= 4) preheat_gap_ms = (uint16_t)v_gap;
+        clampParams();
+        settingsMarkDirty();
+        snprintf(response, sizeof(response),
+                 "ACK,SET_PREHEAT,en=%d,ms=%u,pct=%u,gap=%u",
+                 preheat_enabled ? 1 : 0, (unsigned)preheat_ms,
+                 (unsigned)preheat_pct, (unsigned)preheat_gap_ms);
+        uartSend(response);
+        sendStatusPacket();
+    } else {
+        uartSend("DENY,BAD_SET_PREHEAT");
+    }
+}
+
+static void cmdSetTriggerMode(char* line, const char* args) {
+    (void)line;
+    char response[48];
+    int v = atoi(args);
+    if (v < 1) v = 1;
+    if (v > 2) v = 2;
+    trigger_mode = (uint8_t)v;
+
+    settingsMarkDirty();
+
+    snprintf(response, sizeof(response), "ACK,SET_TRIGGER_MODE,mode=%d",
+             trigger_mode);
+    uartSend(response);
+    sendStatusPacket();
+}
+
+static void cmdSetContactWithPedal(char* line, const char* args) {
+    (void)line;
+    char response[48];
+    int v = atoi(args);
+    contact_with_pedal = (v == 0) ? 0 : 1;
+    settingsMarkDirty();
+    snprintf(response, sizeof(response), "ACK,SET_CONTACT_WITH_PEDAL,%d",
+             contact_with_pedal);
+    uartSend(response);
+    sendStatusPacket();
+}
+
+/* CONTACT_THRESH=<v> (legacy, replies OK,...) and SET_CONTACT_THRESH,<v>. */
+static void applyContactThreshold(const char* args) {
+    float v = strtof(args, NULL);
+    if (v < 0.1f) v = 0.1f;
+    if (v > 9.0f) v = 9.0f;
+    g_contact_threshold_v = v;
+    g_contact_state = false;
+    g_contact_pending_high = false;
+    g_contact_pending_since_ms = 0;
+    contactWatchRetune();
+}
+
+static void cmdContactThreshLegacy(char* line, const char* args) {
+    (void)line;
+    char response[48];
+    applyContactThreshold(args);
+    snprintf(response, sizeof(response), "OK,CONTACT_THRESH=%.2f",
+             g_contact_threshold_v);
+    uartSend(response);
+}
 
-    /* Remote firmware update: re-enter the factory ROM bootloader so the ESP32
-     * can flash a new image over UART (AN3155).
-     *
-     * HARDWARE BOOT0 ENTRY (rock-solid, ST-supported):
-     * The ESP32 has a dedicated control wire from its GPIO38 to the STM32 BOOT0
-     * pin (PB8). Before sending this command the ESP32 drives BOOT0 HIGH and
-     * holds it for the whole flash. All we do here is ACK and issue a clean
-     * NVIC_SystemReset(). On the ensuing reset the chip samples BOOT0=1 and
-     * starts the factory ROM bootloader exactly as it would on a hardware reset
-     * with BOOT0 asserted - fully USART-responsive on PA9/PA10 at 8E1. The ESP32
-     * drops BOOT0 LOW again after flashing so the next reset boots the app.
-     * Accept both the bare and CMD-prefixed command forms. */
-    if (strcmp(line, "BOOTLOADER") == 0 || strcmp(line, "CMD,BOOTLOADER") == 0) {
-        /* SOFTWARE (BOOT0-independent) ROM-bootloader entry.
-         * Earlier this did a bare NVIC_SystemReset() and relied entirely on the
-         * ESP32 holding the hardware BOOT0 pin high. Field testing proved that
-         * strap is NOT effective on this board (after the reset the chip lands
-         * back in the application, broadcasting STATUS at 1 Mbaud, instead of
-         * the silent ROM bootloader) - whether due to the GPIO31->BOOT0 wiring
-         * or an option byte (nBOOT_SEL) that makes BOOT0 ignored.
-         *
-         * requestBootloaderReset() instead stashes BOOTLOADER_REQUEST_MAGIC in a
-         * TAMP backup register and resets. The magic survives the warm reset and
-         * is detected at the very top of main() (before the IWDG is re-armed),
-         * which then calls jumpToBootloader() to remap system memory and jump to
-         * the ROM at 0x1FFF0000. This reaches the ROM bootloader with NO reliance
-         * on the BOOT0 pin at all. */
-        uartSend("DBG,BOOTLOADER command received -> requesting KATAPULT bootloader "
-                 "entry (2-wire flash on USART1 PA9/PA10, no BOOT0/NRST needed)");
-        HAL_Delay(20);
-        uartSend("ACK,BOOTLOADER");
-        HAL_Delay(50);              /* ensure the ACK is fully transmitted */
-        requestKatapultReset();     /* sets Katapult request signature + reset; no return */
-        return;                     /* unreachable */
-    }
-
-    if (strncmp(line, "READY,", 6) == 0) {
-        int v = atoi(line + 6);
-        if (v == 1) {
-            system_ready = true;
-            ready_until_ms = HAL_GetTick() + READY_TIMEOUT_MS;
-            uartSend("ACK,READY,1");
-        } else {
-            system_ready = false;
-            ready_until_ms = 0;
-            uartSend("ACK,READY,0");
-        }
-        return;
-    }
+static void cmdSetContactThresh(char* line, const char* args) {
+    (void)line;
+    char response[48];
+    applyContactThreshold(args);
+    snprintf(response, sizeof(response), "ACK,SET_CONTACT_THRESH,%.2f",
+             g_contact_threshold_v);
+    uartSend(response);
+}
 
-    if (strncmp(line, "ARM,", 4) == 0) {
-        int v = atoi(line + 4);
-        if (v == 1) {
-            armed = true;
-            armed_until_ms =
-                (ARM_TIMEOUT_MS == 0) ? 0 : (HAL_GetTick() + ARM_TIMEOUT_MS);
-            uartSend("ACK,ARM,1");
-        } else {
-            armed = false;
-            armed_until_ms = 0;
-            uartSend("ACK,ARM,0");
-        }
-        return;
-    }
+static void cmdSetContactHold(char* line, const char* args) {
+    (void)line;
+    char response[48];
+    int v = atoi(args);
+    if (v < 1) v = 1;
+    if (v > 10) v = 10;
+    contact_hold_steps = (uint8_t)v;
 
-    if (strncmp(line, "CMD,SET,PULSE,", 14) == 0) {
-        int val = atoi(line + 14);
-        if (val > 0 && val <= MAX_WELD_MS) {
-            weld_d1_ms = (uint16_t)val;
-            snprintf(response, sizeof(response), "ACK,PULSE=%d", weld_d1_ms);
-            uartSend(response);
-        } else {
-            uartSend("ERR,PULSE_RANGE");
-        }
-        return;
-    }
+    settingsMarkDirty();
 
-    if (strncmp(line, "SET_PULSE,", 10) == 0) {
-        int v_mode = 1, v_d1 = 0, v_gap1 = 0, v_d2 = 0, v_gap2 = 0, v_d3 = 0;
-        int n = sscanf(line, "SET_PULSE,%d,%d,%d,%d,%d,%d", &v_mode, &v_d1,
-                       &v_gap1, &v_d2, &v_gap2, &v_d3);
-        if (n == 6) {
-            weld_mode = (uint8_t)v_mode;
-            weld_d1_ms = (uint16_t)v_d1;
-            weld_gap1_ms = (uint16_t)v_gap1;
-            weld_d2_ms = (uint16_t)v_d2;
-            weld_gap2_ms = (uint16_t)v_gap2;
-            weld_d3_ms = (uint16_t)v_d3;
-            clampParams();
-
-            persistent_from_runtime(&g_persistent_settings);
-            if (!flash_settings_save(&g_persistent_settings)) {
-                uartSend("DENY,SET_PULSE,FLASH_FAIL");
-                return;
-            }
+    snprintf(response, sizeof(response), "ACK,SET_CONTACT_HOLD,steps=%d",
+             contact_hold_steps);
+    uartSend(response);
+    sendStatusPacket();
+}
 
-            uartSend("ACK,SET_PULSE");
-            sendStatusPacket();
-        } else {
-            uartSend("DENY,BAD_SET_PULSE");
-        }
+/* UI save flakiness root cause: some clients send lead_r_mohm while
+ * firmware only accepted LEAD_R in ohms. Accept both ohm and mΩ command
+ * variants. */
+static void applyLeadResistance(const char* value_str, bool value_is_mohm) {
+    char response[80];
+    char* endptr = NULL;
+    float v = strtof(value_str, &endptr);
+
+    if (endptr == value_str || (endptr && *endptr != '\0') || !isfinite(v)) {
+        uartSend("ERR,LEAD_R_PARSE");
         return;
     }
 
-    if (strncmp(line, "CMD,SET,POWER,", 14) == 0) {
-        int val = atoi(line + 14);
-        if (val >= 50 && val <= 100) {
-            weld_power_pct = (uint8_t)val;
-            snprintf(response, sizeof(response), "ACK,POWER=%d",
-                     weld_power_pct);
-            uartSend(response);
-        } else {
-            uartSend("ERR,POWER_RANGE");
-        }
-        return;
+    if (value_is_mohm) {
+        v *= 0.001f;
     }
 
-    if (strncmp(line, "SET_POWER,", 10) == 0) {
-        weld_power_pct = (uint8_t)atoi(line + 10);
-        clampParams();
-        persistent_from_runtime(&g_persistent_settings);
-        if (!flash_settings_save(&g_persistent_settings)) {
-            uartSend("DENY,SET_POWER,FLASH_SAVE_FAILED");
-            return;
-        }
-        snprintf(response, sizeof(response), "ACK,SET_POWER,pct=%d",
-                 weld_power_pct);
+    if (v < LEAD_RESISTANCE_MIN_OHMS || v > LEAD_RESISTANCE_MAX_OHMS) {
+        snprintf(response, sizeof(response),
+                 "ERR,LEAD_R_RANGE,min=%.6f,max=%.6f",
+                 LEAD_RESISTANCE_MIN_OHMS, LEAD_RESISTANCE_MAX_OHMS);
         uartSend(response);
-        sendStatusPacket();
         return;
     }
 
-    if (strncmp(line, "SET_MODE,", 9) == 0) {
-        int new_mode_i = atoi(line + 9);
-        if (new_mode_i >= 0 && new_mode_i <= 1) {
-            control_mode = (uint8_t)new_mode_i;
-            clampParams();
-            persistent_from_runtime(&g_persistent_settings);
-            if (!flash_settings_save(&g_persistent_settings)) {
-                uartSend("DENY,SET_MODE,FLASH_SAVE_FAILED");
-                return;
-            }
-            snprintf(response, sizeof(response), "ACK,SET_MODE,mode=%u",
-                     (unsigned)control_mode);
-            uartSend(response);
-            sendStatusPacket();
-        } else {
-            uartSend("DENY,SET_MODE,RANGE");
-        }
-        return;
-    }
+    lead_resistance_ohms = v;
+    settingsMarkDirty();
 
-    if (strncmp(line, "SET_JOULE_TARGET,", 17) == 0) {
-        char* endptr = NULL;
-        float new_target = strtof(line + 17, &endptr);
-        if (endptr == (line + 17) || (endptr && *endptr != '\0') ||
-            !isfinite(new_target)) {
-            uartSend("DENY,SET_JOULE_TARGET,PARSE");
-            return;
-        }
+    snprintf(response, sizeof(response), "ACK,LEAD_R,ohm=%.6f,mohm=%.3f",
+             lead_resistance_ohms, lead_resistance_ohms * 1000.0f);
+    uartSend(response);
+    sendStatusPacket();  // Immediate broadcast so UI updates right away
+}
 
-        if (new_target >= 0.0f && new_target <= 300.0f) {
-            float old_target = joule_target_j;
-            snprintf(response, sizeof(response),
-                     "DBG,SET_JOULE_TARGET,old=%.1f,new=%.1f", old_target,
-                     new_target);
-            uartSend(response);
+static void cmdLeadROhm(char* line, const char* args) {
+    (void)line;
+    applyLeadResistance(args, false);
+}
 
-            joule_target_j = new_target;
-            clampParams();
-            persistent_from_runtime(&g_persistent_settings);
-            if (!flash_settings_save(&g_persistent_settings)) {
-                uartSend("DENY,SET_JOULE_TARGET,FLASH_SAVE_FAILED");
-                return;
-            }
-            snprintf(response, sizeof(response), "ACK,SET_JOULE_TARGET,j=%.1f",
-                     joule_target_j);
-            uartSend(response);
-            sendStatusPacket();
-        } else {
-            uartSend("DENY,SET_JOULE_TARGET,RANGE");
-        }
+static void cmdLeadRMohm(char* line, const char* args) {
+    (void)line;
+    applyLeadResistance(args, true);
+}
+
+static void cmdGetLeadR(char* line, const char* args) {
+    (void)line;
+    (void)args;
+    char response[64];
+    snprintf(response, sizeof(response), "LEAD_R,ohm=%.6f,mohm=%.3f",
+             lead_resistance_ohms, lead_resistance_ohms * 1000.0f);
+    uartSend(response);
+}
+
+static void cmdCalLeadStart(char* line, const char* args) {
+    (void)line;
+    (void)args;
+    performLeadCalibration();
+}
+
+static void cmdFire(char* line, const char* args) {
+    (void)line;
+    (void)args;
+    fireRecipe();
+}
+
+static void cmdEnable(char* line, const char* args) {
+    (void)line;
+    (void)args;
+    armed = true;
+    uartSend("ACK,ENABLED");
+}
+
+static void cmdDisable(char* line, const char* args) {
+    (void)line;
+    (void)args;
+    armed = false;
+    uartSend("ACK,DISABLED");
+}
+
+/* Waveform wire format negotiation: WAVEFORM_FMT,BIN | WAVEFORM_FMT,CSV
+ * (also 1 | 0). Applies to the next weld's waveform burst. */
+static void cmdWaveformFmt(char* line, const char* args) {
+    (void)line;
+    char response[48];
+    if (strcmp(args, "BIN") == 0 || strcmp(args, "1") == 0) {
+        waveform_wire_format = WAVEFORM_FMT_BIN;
+    } else if (strcmp(args, "CSV") == 0 || strcmp(args, "0") == 0) {
+        waveform_wire_format = WAVEFORM_FMT_CSV;
+    } else {
+        uartSend("DENY,WAVEFORM_FMT,BAD_ARG");
         return;
     }
+    snprintf(response, sizeof(response), "ACK,WAVEFORM_FMT,fmt=%s",
+             (waveform_wire_format == WAVEFORM_FMT_BIN) ? "BIN" : "CSV");
+    uartSend(response);
+}
 
-    if (strncmp(line, "SET_JOULE_MAX,", 14) == 0) {
-        int new_max_i = atoi(line + 14);
-        if (new_max_i >= 5 && new_max_i <= 500) {
-            joule_max_ms = (uint32_t)new_max_i;
-            clampParams();
-            persistent_from_runtime(&g_persistent_settings);
-            if (!flash_settings_save(&g_persistent_settings)) {
-                uartSend("DENY,SET_JOULE_MAX,FLASH_SAVE_FAILED");
-                return;
-            }
-            snprintf(response, sizeof(response), "ACK,SET_JOULE_MAX,ms=%lu",
-                     (unsigned long)joule_max_ms);
-            uartSend(response);
-            sendStatusPacket();
-        } else {
-            uartSend("DENY,SET_JOULE_MAX,RANGE");
-        }
+/* Waveform report mode: WAVEFORM_MODE,SUMMARY | WAVEFORM_MODE,FULL
+ * (see waveform_summary_mode). */
+static void cmdWaveformMode(char* line, const char* args) {
+    (void)line;
+    char response[48];
+    if (strcmp(args, "SUMMARY") == 0) {
+        waveform_summary_mode = true;
+    } else if (strcmp(args, "FULL") == 0) {
+        waveform_summary_mode = false;
+    } else {
+        uartSend("DENY,WAVEFORM_MODE,BAD_ARG");
         return;
     }
+    snprintf(response, sizeof(response), "ACK,WAVEFORM_MODE,mode=%s",
+             waveform_summary_mode ? "SUMMARY" : "FULL");
+    uartSend(response);
+}
 
-    if (strncmp(line, "SET_PREHEAT,", 12) == 0) {
-        int v_en = 0, v_ms = 0, v_pct = 0, v_gap = 0;
-        int n = sscanf(line, "SET_PREHEAT,%d,%d,%d,%d", &v_en, &v_ms, &v_pct,
-                       &v_gap);
-        if (n >= 3) {
-            preheat_enabled = (v_en == 1);
-            preheat_ms = (uint16_t)v_ms;
-            preheat_pct = (uint8_t)v_pct;
-            if (n >= 4) preheat_gap_ms = (uint16_t)v_gap;
-            clampParams();
-            persistent_from_runtime(&g_persistent_settings);
-            if (!flash_settings_save(&g_persistent_settings)) {
-                uartSend("DENY,SET_PREHEAT,FLASH_SAVE_FAILED");
-                return;
-            }
-            snprintf(response, sizeof(response),
-                     "ACK,SET_PREHEAT,en=%d,ms=%u,pct=%u,gap=%u",
-                     preheat_enabled ? 1 : 0, (unsigned)preheat_ms,
-                     (unsigned)preheat_pct, (unsigned)preheat_gap_ms);
+/* WAVEFORM_GET: send the capture kept after the last summary as a normal
+ * WAVEFORM_START .. WAVEFORM_PHASES burst, in the current wire format. */
+static void cmdWaveformGet(char* line, const char* args) {
+    (void)line;
+    (void)args;
+    bool pending = false;
+    for (uint8_t i = 0U; i < WELD_SLOT_COUNT; i++) {
+        WeldReport* r = &weld_reports[i];
+        if (r->state == WELD_SLOT_HELD) {
+            char response[48];
+            snprintf(response, sizeof(response), "ACK,WAVEFORM_GET,samples=%u",
+                     (unsigned int)r->view.count);
             uartSend(response);
-            sendStatusPacket();
-        } else {
-            uartSend("DENY,BAD_SET_PREHEAT");
+            weldReportTxBegin(r, false);
+            return;
         }
-        return;
+        pending = pending || (r->hold && r->state != WELD_SLOT_FREE);
     }
+    /* IN_PROGRESS: the summary (or an earlier WAVEFORM_GET) is still being
+     * sent. */
+    uartSend(pending ? "DENY,WAVEFORM_GET,IN_PROGRESS"
+                     : "DENY,WAVEFORM_GET,NOT_FOUND");
+}
 
-    if (strncmp(line, "SET_TRIGGER_MODE,", 17) == 0) {
-        int v = atoi(line + 17);
-        if (v < 1) v = 1;
-        if (v > 2) v = 2;
-        trigger_mode = (uint8_t)v;
-
-        persistent_from_runtime(&g_persistent_settings);
-        if (!flash_settings_save(&g_persistent_settings)) {
-            uartSend("DENY,SET_TRIGGER_MODE,FLASH_SAVE_FAILED");
+/* LINK_SPEED,<baud> | LINK_SPEED,COMMIT: see the UART link speed banner.
+ * The ACK goes out at the old rate, then USART1 switches. */
+static void cmdLinkSpeed(char* line, const char* args) {
+    (void)line;
+    char response[64];
+    if (strcmp(args, "COMMIT") == 0) {
+        if (link_state != LINK_STATE_TRIAL) {
+            uartSend("DENY,LINK_SPEED,NO_TRIAL");
             return;
         }
-
-        snprintf(response, sizeof(response), "ACK,SET_TRIGGER_MODE,mode=%d",
-                 trigger_mode);
+        link_state = LINK_STATE_FAST;
+        link_err_base = uart_rx_errors;
+        link_err_window_ms = HAL_GetTick();
+        snprintf(response, sizeof(response), "ACK,LINK_SPEED,COMMIT,baud=%lu",
+                 (unsigned long)link_baud);
         uartSend(response);
-        sendStatusPacket();
         return;
     }
 
-    const char* cwp_prefix = "SET_CONTACT_WITH_PEDAL,";
-    if (strncmp(line, cwp_prefix, strlen(cwp_prefix)) == 0) {
-        int v = atoi(line + strlen(cwp_prefix));
-        contact_with_pedal = (v == 0) ? 0 : 1;
-        persistent_from_runtime(&g_persistent_settings);
-        if (!flash_settings_save(&g_persistent_settings)) {
-            uartSend("DENY,SET_CONTACT_WITH_PEDAL,FLASH_SAVE_FAILED");
-            return;
-        }
-        snprintf(response, sizeof(response), "ACK,SET_CONTACT_WITH_PEDAL,%d",
-                 contact_with_pedal);
-        uartSend(response);
-        sendStatusPacket();
+    char* end = NULL;
+    const unsigned long baud = strtoul(args, &end, 10);
+    if (end == args || *end != '\0' || !linkBaudAllowed((uint32_t)baud)) {
+        uartSend("DENY,LINK_SPEED,BAD_ARG");
         return;
     }
+    snprintf(response, sizeof(response), "ACK,LINK_SPEED,baud=%lu", baud);
+    uartSend(response);
+    linkSetBaud((uint32_t)baud);
+    link_state =
+        (baud == LINK_BASE_BAUD) ? LINK_STATE_BASE : LINK_STATE_TRIAL;
+    link_switch_ms = HAL_GetTick();
+}
 
-    if (strncmp(line, "CONTACT_THRESH=", 15) == 0) {
-        float v = strtof(line + 15, NULL);
-        if (v < 0.1f) v = 0.1f;
-        if (v > 9.0f) v = 9.0f;
-        g_contact_threshold_v = v;
-        g_contact_state = false;
-        g_contact_pending_high = false;
-        g_contact_pending_since_ms = 0;
-        snprintf(response, sizeof(response), "OK,CONTACT_THRESH=%.2f",
-                 g_contact_threshold_v);
-        uartSend(response);
+/* LINK_PROBE,<seq>,<crc32 hex>,<payload>: check the host's payload, answer
+ * with LINK_PROBE_REPLY_LEN characters of our own for the other direction. */
+static void cmdLinkProbe(char* line, const char* args) {
+    (void)line;
+    unsigned seq = 0U;
+    unsigned long want = 0UL;
+    int n = 0;
+    if (sscanf(args, "%u,%lx,%n", &seq, &want, &n) != 2 || n <= 0) {
+        uartSend("DENY,LINK_PROBE,BAD_ARG");
         return;
     }
-
-    if (strncmp(line, "SET_CONTACT_THRESH,", 19) == 0) {
-        float v = strtof(line + 19, NULL);
-        if (v < 0.1f) v = 0.1f;
-        if (v > 9.0f) v = 9.0f;
-        g_contact_threshold_v = v;
-        g_contact_state = false;
-        g_contact_pending_high = false;
-        g_contact_pending_since_ms = 0;
-        snprintf(response, sizeof(response), "ACK,SET_CONTACT_THRESH,%.2f",
-                 g_contact_threshold_v);
+    const char* payload = args + n;
+    const uint32_t got = crc32_compute((const uint8_t*)payload, strlen(payload));
+    if (got != (uint32_t)want) {
+        char response[64];
+        snprintf(response, sizeof(response), "DENY,LINK_PROBE,BAD_CRC,seq=%u",
+                 seq);
         uartSend(response);
         return;
     }
 
-    if (strncmp(line, "SET_CONTACT_HOLD,", 17) == 0) {
-        int v = atoi(line + 17);
-        if (v < 1) v = 1;
-        if (v > 10) v = 10;
-        contact_hold_steps = (uint8_t)v;
-
-        persistent_from_runtime(&g_persistent_settings);
-        if (!flash_settings_save(&g_persistent_settings)) {
-            uartSend("DENY,SET_CONTACT_HOLD,FLASH_SAVE_FAILED");
-            return;
-        }
+    static char data[LINK_PROBE_REPLY_LEN + 1U];
+    static char response[LINK_PROBE_REPLY_LEN + 64U];
+    linkProbeFill(seq, data, LINK_PROBE_REPLY_LEN);
+    snprintf(response, sizeof(response),
+             "ACK,LINK_PROBE,seq=%u,len=%u,crc=%08lX,data=%s", seq,
+             (unsigned)LINK_PROBE_REPLY_LEN,
+             (unsigned long)crc32_compute((const uint8_t*)data,
+                                          LINK_PROBE_REPLY_LEN),
+             data);
+    uartSend(response);
+}
 
-        snprintf(response, sizeof(response), "ACK,SET_CONTACT_HOLD,steps=%d",
-                 contact_hold_steps);
-        uartSend(response);
-        sendStatusPacket();
+/* STREAM,<rate_hz>,<mask>: see the Telemetry Stream banner. */
+static void cmdStream(char* line, const char* args) {
+    (void)line;
+    char response[64];
+    unsigned rate = 0U;
+    unsigned long mask = 0UL;
+    if (sscanf(args, "%u,%lu", &rate, &mask) != 2 ||
+        rate > STREAM_RATE_MAX_HZ || (mask & ~STREAM_MASK_ALL) != 0UL) {
+        uartSend("DENY,STREAM,BAD_ARG");
         return;
     }
+    stream_rate_hz = (uint8_t)rate;
+    stream_mask = (uint32_t)mask;
+    stream_last_state = 0xFFFFFFFFUL; /* send the current state as a delta */
+    snprintf(response, sizeof(response), "ACK,STREAM,rate_hz=%u,mask=%lu",
+             (unsigned)stream_rate_hz, (unsigned long)stream_mask);
+    uartSend(response);
+}
 
-    /* UI save flakiness root cause: some clients send lead_r_mohm while
-     * firmware only accepted LEAD_R in ohms. Accept both ohm and mΩ command
-     * variants. */
-    if (strncmp(line, "LEAD_R,", 7) == 0 ||
-        strncmp(line, "SET_LEAD_R,", 11) == 0 ||
-        strncmp(line, "LEAD_R_MOHM,", 12) == 0 ||
-        strncmp(line, "SET_LEAD_R_MOHM,", 16) == 0 ||
-        strncmp(line, "lead_r_mohm,", 12) == 0 ||
-        strncmp(line, "set_lead_r_mohm,", 16) == 0) {
-        bool value_is_mohm = false;
-        const char* value_str = NULL;
-
-        if (strncmp(line, "LEAD_R,", 7) == 0) {
-            value_str = line + 7;
-        } else if (strncmp(line, "SET_LEAD_R,", 11) == 0) {
-            value_str = line + 11;
-        } else if (strncmp(line, "LEAD_R_MOHM,", 12) == 0) {
-            value_is_mohm = true;
-            value_str = line + 12;
-        } else if (strncmp(line, "SET_LEAD_R_MOHM,", 16) == 0) {
-            value_is_mohm = true;
-            value_str = line + 16;
-        } else if (strncmp(line, "lead_r_mohm,", 12) == 0) {
-            value_is_mohm = true;
-            value_str = line + 12;
-        } else {
-            value_is_mohm = true;
-            value_str = line + 16;
-        }
-
-        char* endptr = NULL;
-        float v = strtof(value_str, &endptr);
+static void cmdStatus(char* line, const char* args) {
+    (void)line;
+    (void)args;
+    /* Send both STATUS and STATUS2 packets on demand */
+    sendStatusPacket();
+}
 
-        if (endptr == value_str || (endptr && *endptr != '\0') ||
-            !isfinite(v)) {
-            uartSend("ERR,LEAD_R_PARSE");
-            return;
-        }
+static void cmdDbgShunt(char* line, const char* args) {
+    (void)line;
+    (void)args;
+    adcPrepareFastCurrentChannels();
 
-        if (value_is_mohm) {
-            v *= 0.001f;
-        }
+    uint32_t p = 0U;
+    uint32_t n = 0U;
+    if (!adcReadFastCurrentPair(&p, &n)) {
+        uartSend("ERR,DBG_SHUNT_ADC_FAIL");
+        return;
+    }
 
-        if (v < LEAD_RESISTANCE_MIN_OHMS || v > LEAD_RESISTANCE_MAX_OHMS) {
-            snprintf(response, sizeof(response),
-                     "ERR,LEAD_R_RANGE,min=%.6f,max=%.6f",
-                     LEAD_RESISTANCE_MIN_OHMS, LEAD_RESISTANCE_MAX_OHMS);
-            uartSend(response);
-            return;
-        }
+    char buf[128];
+    snprintf(buf, sizeof(buf), "DBG,SHUNT,p=%lu,n=%lu,diff=%ld,vdda=%.3f",
+             (unsigned long)p, (unsigned long)n,
+             (long)((int32_t)p - (int32_t)n), measured_vdda);
 
-        lead_resistance_ohms = v;
-        persistent_from_runtime(&g_persistent_settings);
-        if (!flash_settings_save(&g_persistent_settings)) {
-            uartSend("DENY,LEAD_R,FLASH_SAVE_FAILED");
-            return;
-        }
+    uartSend(buf);
+}
 
-        char ack[80];
-        snprintf(ack, sizeof(ack), "ACK,LEAD_R,ohm=%.6f,mohm=%.3f",
-                 lead_resistance_ohms, lead_resistance_ohms * 1000.0f);
-        uartSend(ack);
-        sendStatusPacket();  // Immediate broadcast so UI updates right away
-        return;
+/* SCHED: one line per scheduler job, then the INA226 bus counters. See the
+ * Cooperative Scheduler banner; times are microseconds. */
+static void cmdSched(char* line, const char* args) {
+    (void)line;
+    (void)args;
+    char buf[160];
+    for (size_t i = 0U; i < SCHED_JOB_COUNT; i++) {
+        const SchedJob* j = &sched_jobs[i];
+        snprintf(buf, sizeof(buf),
+                 "SCHED,job=%s,period_ms=%u,deadline_us=%lu,runs=%lu,"
+                 "wcet_us=%lu,max_resp_us=%lu,misses=%lu",
+                 j->name, (unsigned)j->period_ms,
+                 (unsigned long)j->deadline_us, (unsigned long)j->runs,
+                 (unsigned long)(j->wcet_cyc / 170U),
+                 (unsigned long)j->max_resp_us, (unsigned long)j->misses);
+        uartSend(buf);
     }
+    snprintf(buf, sizeof(buf),
+             "SCHED_END,jobs=%u,ina_errors=%lu,ina_timeouts=%lu,uptime_ms=%lu",
+             (unsigned)SCHED_JOB_COUNT, (unsigned long)ina226_seq_errors,
+             (unsigned long)ina226_seq_timeouts, (unsigned long)HAL_GetTick());
+    uartSend(buf);
+}
 
-    if (strcmp(line, "GET_LEAD_R") == 0 || strcmp(line, "LEAD_R?") == 0 ||
-        strcmp(line, "GET_LEAD_R_MOHM") == 0 ||
-        strcmp(line, "lead_r_mohm?") == 0) {
-        snprintf(response, sizeof(response), "LEAD_R,ohm=%.6f,mohm=%.3f",
-                 lead_resistance_ohms, lead_resistance_ohms * 1000.0f);
-        uartSend(response);
-        return;
-    }
+static void cmdSchedReset(char* line, const char* args) {
+    (void)line;
+    (void)args;
+    for (size_t i = 0U; i < SCHED_JOB_COUNT; i++) {
+        sched_jobs[i].runs = 0U;
+        sched_jobs[i].misses = 0U;
+        sched_jobs[i].wcet_cyc = 0U;
+        sched_jobs[i].max_resp_us = 0U;
+    }
+    ina226_seq_errors = 0U;
+    ina226_seq_timeouts = 0U;
+    uartSend("ACK,SCHED_RESET");
+}
 
-    if (strcmp(line, "CAL_LEAD_START") == 0 ||
-        strcmp(line, "CMD,CAL_LEAD_START") == 0) {
-        performLeadCalibration();
-        return;
+#if PERF_STATS
+/* PERF: one line per latency stage, then the UART loss counters. See the
+ * Latency Instrumentation banner; times are microseconds. */
+static void cmdPerf(char* line, const char* args) {
+    (void)line;
+    (void)args;
+    char buf[192];
+    for (uint8_t s = 0U; s < PERF_STAGE_COUNT; s++) {
+        const PerfHist* h = &perf_hist[s];
+        const float k = 1.0f / (float)PERF_CYC_PER_US;
+        snprintf(buf, sizeof(buf),
+                 "PERF,src=stm32,stage=%s,n=%lu,min_us=%.1f,avg_us=%.1f,"
+                 "p99_us=%.1f,max_us=%.1f",
+                 perf_stage_names[s], (unsigned long)h->n,
+                 (float)h->min * k,
+                 (h->n > 0U) ? (float)h->sum / (float)h->n * k : 0.0f,
+                 (h->n > 0U) ? (float)perf_p99(h) * k : 0.0f,
+                 (float)h->max * k);
+        uartSend(buf);
     }
+    snprintf(buf, sizeof(buf),
+             "PERF_UART,src=stm32,rx_overruns=%lu,rx_errors=%lu,"
+             "rx_line_drop=%lu,rx_overlong=%lu,rx_dma_err=%lu,"
+             "tx_drop_prio=%lu,tx_drop_bulk=%lu,tx_dma_err=%lu",
+             (unsigned long)uart_rx_overruns, (unsigned long)uart_rx_errors,
+             (unsigned long)uart_rx_line_drops,
+             (unsigned long)uart_rx_line_overlong,
+             (unsigned long)uart_rx_dma_errors,
+             (unsigned long)uart_tx_lanes[UART_TX_LANE_PRIO].dropped,
+             (unsigned long)uart_tx_lanes[UART_TX_LANE_BULK].dropped,
+             (unsigned long)uart_tx_dma_errors);
+    uartSend(buf);
+    snprintf(buf, sizeof(buf), "PERF_END,src=stm32,stages=%u,uptime_ms=%lu",
+             (unsigned)PERF_STAGE_COUNT, (unsigned long)HAL_GetTick());
+    uartSend(buf);
+}
 
-    if (strcmp(line, "CMD,FIRE") == 0) {
-        fireRecipe();
-        return;
-    }
+static void cmdPerfReset(char* line, const char* args) {
+    (void)line;
+    (void)args;
+    memset(perf_hist, 0, sizeof(perf_hist));
+    uartSend("ACK,PERF_RESET");
+}
+#endif
 
-    if (strcmp(line, "CMD,ENABLE") == 0) {
-        armed = true;
-        uartSend("ACK,ENABLED");
-        return;
+/* Sorted by strcmp() order of `name` (',' < '?' < 'A'-'Z' < '_' < 'a'-'z').
+ * Keep it sorted when adding commands: lookup is a binary search. */
+static const UartCommand uart_commands[] = {
+    {"ARM", ',', cmdArm},
+    {"BOOTLOADER", '\0', cmdBootloader},
+    {"CAL_LEAD_START", '\0', cmdCalLeadStart},
+    {"CMD,BOOTLOADER", '\0', cmdBootloader},
+    {"CMD,CAL_LEAD_START", '\0', cmdCalLeadStart},
+    {"CMD,DISABLE", '\0', cmdDisable},
+    {"CMD,ENABLE", '\0', cmdEnable},
+    {"CMD,FIRE", '\0', cmdFire},
+    {"CMD,SET,POWER", ',', cmdSetPowerLegacy},
+    {"CMD,SET,PULSE", ',', cmdSetPulseLegacy},
+    {"CMD,STATUS", '\0', cmdStatus},
+    {"CONTACT_THRESH", '=', cmdContactThreshLegacy},
+    {"DBG_SHUNT", '\0', cmdDbgShunt},
+    {"FW_CRC", ',', cmdFwCrc},
+    {"GET_LEAD_R", '\0', cmdGetLeadR},
+    {"GET_LEAD_R_MOHM", '\0', cmdGetLeadR},
+    {"LEAD_R", ',', cmdLeadROhm},
+    {"LEAD_R?", '\0', cmdGetLeadR},
+    {"LEAD_R_MOHM", ',', cmdLeadRMohm},
+    {"LINK_PROBE", ',', cmdLinkProbe},
+    {"LINK_SPEED", ',', cmdLinkSpeed},
+#if PERF_STATS
+    {"PERF", '\0', cmdPerf},
+    {"PERF_RESET", '\0', cmdPerfReset},
+#endif
+    {"READY", ',', cmdReady},
+    {"SCHED", '\0', cmdSched},
+    {"SCHED_RESET", '\0', cmdSchedReset},
+    {"SET_CONTACT_HOLD", ',', cmdSetContactHold},
+    {"SET_CONTACT_THRESH", ',', cmdSetContactThresh},
+    {"SET_CONTACT_WITH_PEDAL", ',', cmdSetContactWithPedal},
+    {"SET_JOULE_MAX", ',', cmdSetJouleMax},
+    {"SET_JOULE_TARGET", ',', cmdSetJouleTarget},
+    {"SET_LEAD_R", ',', cmdLeadROhm},
+    {"SET_LEAD_R_MOHM", ',', cmdLeadRMohm},
+    {"SET_MODE", ',', cmdSetMode},
+    {"SET_POWER", ',', cmdSetPower},
+    {"SET_PREHEAT", ',', cmdSetPreheat},
+    {"SET_PULSE", ',', cmdSetPulse},
+    {"SET_TRIGGER_MODE", ',', cmdSetTriggerMode},
+    {"STATUS", '\0', cmdStatus},
+    {"STREAM", ',', cmdStream},
+    {"WAVEFORM_FMT", ',', cmdWaveformFmt},
+    {"WAVEFORM_GET", '\0', cmdWaveformGet},
+    {"WAVEFORM_MODE", ',', cmdWaveformMode},
+    {"lead_r_mohm", ',', cmdLeadRMohm},
+    {"lead_r_mohm?", '\0', cmdGetLeadR},
+    {"set_lead_r_mohm", ',', cmdLeadRMohm},
+};
+
+#define UART_COMMAND_COUNT (sizeof(uart_commands) / sizeof(uart_commands[0]))
+
+/* Length of the lookup key at the start of `line` (see banner above). */
+static size_t commandKeyLen(const char* line) {
+    size_t n = strcspn(line, ",=");
+    if (n == 3U && line[n] == ',' && strncmp(line, "CMD", 3) == 0) {
+        n += 1U + strcspn(line + n + 1U, ",=");
+        if (n == 7U && line[n] == ',' && strncmp(line, "CMD,SET", 7) == 0) {
+            n += 1U + strcspn(line + n + 1U, ",=");
+        }
     }
+    return n;
+}
 
-    if (strcmp(line, "CMD,DISABLE") == 0) {
-        armed = false;
-        uartSend("ACK,DISABLED");
-        return;
+static const UartCommand* findCommand(const char* key, size_t key_len) {
+    size_t lo = 0U;
+    size_t hi = UART_COMMAND_COUNT;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2U;
+        const char* name = uart_commands[mid].name;
+        int cmp = strncmp(key, name, key_len);
+        if (cmp == 0 && name[key_len] != '\0') {
+            cmp = -1; /* key is a strict prefix of name */
+        }
+        if (cmp == 0) {
+            return &uart_commands[mid];
+        }
+        if (cmp < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1U;
+        }
     }
+    return NULL;
+}
 
-    if (strcmp(line, "STATUS") == 0 || strcmp(line, "CMD,STATUS") == 0) {
-        /* Send both STATUS and STATUS2 packets on demand */
-        sendStatusPacket();
-        return;
-    }
-    if (strcmp(line, "DBG_SHUNT") == 0) {
-        adcPrepareFastCurrentChannels();
+static void parseCommand(char* line) {
+    /* Sanitise the incoming line BEFORE the lookup. The RX path normally
+     * splits on \r/\n, but be defensive: skip leading whitespace (and actually
+     * advance 'line' past it), then trim any trailing \r, \n or spaces. This
+     * guarantees "BOOTLOADER\r\n" (or " BOOTLOADER ") becomes exactly
+     * "BOOTLOADER" so the lookup below matches. */
+    {
+        char* p = line;
+        while (*p == ' ' || *p == '\t') p++;  /* skip leading whitespace */
+        line = p;
 
-        uint32_t p = 0U;
-        uint32_t n = 0U;
-        if (!adcReadFastCurrentPair(&p, &n)) {
-            uartSend("ERR,DBG_SHUNT_ADC_FAIL");
-            return;
+        size_t len = strlen(line);
+        while (len > 0 &&
+               (line[len - 1] == '\r' || line[len - 1] == '\n' ||
+                line[len - 1] == ' ' || line[len - 1] == '\t')) {
+            line[--len] = '\0';
         }
 
-        char buf[128];
-        snprintf(buf, sizeof(buf), "DBG,SHUNT,p=%lu,n=%lu,diff=%ld,vdda=%.3f",
-                 (unsigned long)p, (unsigned long)n,
-                 (long)((int32_t)p - (int32_t)n), measured_vdda);
+        if (len == 0) return;  /* nothing left after trimming */
+    }
 
-        uartSend(buf);
+    const size_t key_len = commandKeyLen(line);
+    const UartCommand* cmd = findCommand(line, key_len);
+    if (cmd != NULL && line[key_len] == cmd->delim) {
+        cmd->handler(line, (cmd->delim == '\0') ? "" : line + key_len + 1U);
         return;
     }
 
+    char response[256];
     snprintf(response, sizeof(response), "ERR,UNKNOWN_CMD,rx=%s", line);
     uartSend(response);
 }
 
-static void pollPedal(void) {
-    GPIO_PinState raw = HAL_GPIO_ReadPin(PEDAL_PORT, PEDAL_PIN);
-    uint32_t now = HAL_GetTick();
+/* ============ Pedal Trigger (EXTI + TIM7 debounce) ============
+ * PEDAL_PIN interrupts on both edges. The first edge of a bounce burst is
+ * timestamped with DWT->CYCCNT, and every edge restarts TIM7 (one-pulse,
+ * PEDAL_DEBOUNCE_MS). When TIM7 expires the line has been quiet for the
+ * whole debounce time; if it settled at a new level, a press is queued for
+ * pollPedal(). So the fire is released exactly PEDAL_DEBOUNCE_MS after the
+ * last bounce, whatever the loop was doing, and the only loop-dependent
+ * delay left is the distance to the next poll point, which the Cooperative
+ * Scheduler bounds. A press that settles while a weld is running is
+ * dropped rather than queued. WELD_DONE reports edge -> first FET on as
+ * pedal_fet_us. */
+#define PEDAL_TIM7_TICK_HZ 10000U /* 170 MHz / (PSC + 1) */
+
+static void pedalTriggerInit(void) {
+    __HAL_RCC_TIM7_CLK_ENABLE();
+    TIM7->CR1 = TIM_CR1_URS; /* only counter overflow raises UIF */
+    TIM7->PSC = (170000000U / PEDAL_TIM7_TICK_HZ) - 1U;
+    TIM7->ARR = (PEDAL_DEBOUNCE_MS * PEDAL_TIM7_TICK_HZ / 1000U) - 1U;
+    TIM7->EGR = TIM_EGR_UG; /* load PSC */
+    TIM7->SR = 0U;
+    TIM7->DIER = TIM_DIER_UIE;
+    TIM7->CR1 = TIM_CR1_URS | TIM_CR1_OPM;
+
+    /* PB12 -> EXTI12 (EXTICR4 port code 1). Set by HAL_GPIO_Init(); check it
+     * so a lost write shows up at boot instead of as a dead pedal. */
+    const uint32_t exti12_pb = 1UL << SYSCFG_EXTICR4_EXTI12_Pos;
+    pedal_exti_remapped =
+        ((SYSCFG->EXTICR[3] & SYSCFG_EXTICR4_EXTI12) != exti12_pb);
+    if (pedal_exti_remapped) {
+        SYSCFG->EXTICR[3] =
+            (SYSCFG->EXTICR[3] & ~SYSCFG_EXTICR4_EXTI12) | exti12_pb;
+    }
+
+    pedal_stable = HAL_GPIO_ReadPin(PEDAL_PORT, PEDAL_PIN);
+    pedal_press_ready = false;
+    EXTI->PR1 = PEDAL_PIN; /* drop edges seen during boot */
+
+    HAL_NVIC_SetPriority(TIM7_DAC_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(TIM7_DAC_IRQn);
+    HAL_NVIC_SetPriority(EXTI15_10_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+}
 
-    if (raw != pedal_last_raw) {
-        pedal_last_change_ms = now;
-        pedal_last_raw = raw;
+static void pollPedal(void) {
+    if (!pedal_press_ready) {
+        return;
     }
+    const uint32_t edge_cyc = pedal_press_edge_cyc;
+    pedal_press_ready = false;
 
-    if ((now - pedal_last_change_ms) >= PEDAL_DEBOUNCE_MS) {
-        if (raw != pedal_stable) {
-            GPIO_PinState prev = pedal_stable;
-            pedal_stable = raw;
-
-            if (prev == GPIO_PIN_SET && pedal_stable == GPIO_PIN_RESET) {
-                uartSend("EVENT,PEDAL_PRESS");
-                if (trigger_mode == 1) {
-                    fireRecipe();
-                }
-            }
-        }
+    uartSend("EVENT,PEDAL_PRESS");
+    if (trigger_mode == 1) {
+#if PERF_STATS
+        perf_record(PERF_PEDAL_FIRE, perf_cyc() - edge_cyc);
+        perf_trigger_cyc = edge_cyc;
+        perf_trigger_valid = true;
+#endif
+        weld_pedal_edge_cyc = edge_cyc;
+        weld_pedal_edge_valid = true;
+        fireRecipe();
+        weld_pedal_edge_valid = false; /* DENY: no pulse consumed it */
     }
 }
 
 static void pollContactTrigger(void) {
+    contactWatchService();
+
     if (trigger_mode != 2) {
         contact_hold_active = false;
         contact_hold_start_ms = 0;
@@ -4584,10 +7121,15 @@ static void pollContactTrigger(void) {
         return;
     }
 
-    if (!contact_hold_active) {
+    /* Contact Watch: the hold runs from the debounced make instant, and a
+     * break + re-make between two polls (new make stamp) restarts it. */
+    const uint32_t hold_start_ms =
+        contact_watch_running ? contact_watch_make_ms + CONTACT_DEBOUNCE_MS
+                              : now;
+    if (!contact_hold_active ||
+        (contact_watch_running && contact_hold_start_ms != hold_start_ms)) {
         contact_hold_active = true;
-        contact_hold_start_ms = now;
-        return;
+        contact_hold_start_ms = hold_start_ms;
     }
 
     if ((now - contact_hold_start_ms) >= hold_ms_required) {
@@ -4698,6 +7240,7 @@ static void jumpToBootloader(void) {
  *
  * This does NOT return. */
 static void requestBootloaderReset(void) {
+    (void)settingsCommit(); /* do not lose a SET_* still in its quiet period */
     g_bl_stage = BLSTAGE(1);   /* breadcrumb: cmd received, about to reset */
 
     /* PRIMARY: SRAM marker (survives warm reset on this board). */
@@ -4711,6 +7254,7 @@ static void requestBootloaderReset(void) {
     __DSB();
 
     uartSend("DBG,Wireless flash: marker set, resetting into ROM bootloader...");
+    uartFlush(500U);
     HAL_Delay(50);  /* let the debug line flush out of the UART before reset */
 
     /* CRITICAL FIX (stage-3 breadcrumb diagnostic): the ROM bootloader checks
@@ -4770,6 +7314,7 @@ static void requestKatapultReset(void) {
     volatile uint32_t *bl_vectors = (volatile uint32_t *)KATAPULT_FLASH_BOOT_ADDRESS;
     volatile uint64_t *req_sig    = (volatile uint64_t *)(uintptr_t)bl_vectors[0];
 
+    (void)settingsCommit(); /* do not lose a SET_* still in its quiet period */
     __disable_irq();
     *req_sig = KATAPULT_REQUEST_CANBOOT;
     __DSB();
@@ -4922,6 +7467,10 @@ int main(void) {
     MX_ADC2_Init(); /* ADC2 for PA4 (AMC1311B OUTN = ADC2_IN17) */
     MX_TIM1_Init();
     init_tim2_1mhz();
+#if WAVEFORM_DMA_CAPTURE
+    init_waveform_dma_engine();
+#endif
+    init_crc32_engine();
 
     /* Initial VDDA calibration using VREFINT */
     measured_vdda = measureVDDA();
@@ -4943,10 +7492,7 @@ int main(void) {
     g_contact_pending_since_ms = 0;
     g_contact_last_sample_ms = 0;
     g_contact_last_vcap = 0.0f;
-    GPIO_PinState r = HAL_GPIO_ReadPin(PEDAL_PORT, PEDAL_PIN);
-    pedal_last_raw = r;
-    pedal_stable = r;
-    pedal_last_change_ms = boot_ms;
+    pedalTriggerInit();
 
     /* NEW: Initialize INA226 sensors */
     {
@@ -4994,8 +7540,12 @@ int main(void) {
                  (int)trigger_mode);
         uartSend(boot_mode_msg);
     }
+    /* Pedal EXTI routing (pedalTriggerInit): FIXED means HAL_GPIO_Init()'s
+     * EXTICR write did not take and had to be repeated. */
+    uartSend(pedal_exti_remapped ? "BOOT,PEDAL_EXTI=FIXED"
+                                 : "BOOT,PEDAL_EXTI=PB12");
 
-    HAL_UART_Receive_IT(&huart1, &rx_byte, 1);
+    uart_rx_dma_start();
 
     /* TEMPORARY: IWDG disabled to allow the software bootloader jump.
      * Once the IWDG is started it can NEVER be stopped by software - it runs
@@ -5006,7 +7556,12 @@ int main(void) {
      * (it just writes the key register), so it is left in place. */
     /* MX_IWDG_Init(); */
 
+    sched_init(HAL_GetTick());
+
     while (1) {
+#if PERF_STATS
+        const uint32_t loop_start_cyc = perf_cyc();
+#endif
         HAL_IWDG_Refresh(&hiwdg);
 
         pollPedal();
@@ -5028,77 +7583,16 @@ int main(void) {
         }
 #endif
 
-        {
-            static uint32_t last_temp_ms = 0;
-            uint32_t now = HAL_GetTick();
-            if ((now - last_temp_ms) >= 1000) {
-                last_temp_ms = now;
-
-                /* Refresh VDDA calibration every 1s alongside temperature */
-                measured_vdda = measureVDDA();
-
-                float t = readThermistor();
-                if (t > -50.0f && t < 200.0f) {
-                    /* Valid reading: apply exponential filter */
-                    temp_filtered_c = (0.1f * t) + (0.9f * temp_filtered_c);
-                } else {
-                    /* Sensor fault (-99) or out-of-range: propagate immediately
-                     * instead of ignoring, so UI shows error state */
-                    temp_filtered_c = t;
-                }
-            }
-        }
-
-        /* NEW: INA226 read + charger state machine @ ~100ms interval */
-        {
-            static uint32_t last_ina_ms = 0;
-            uint32_t now = HAL_GetTick();
-            if ((now - last_ina_ms) >= 150) { /* 150ms matches AVG=64 conversion time */
-                last_ina_ms = now;
-                ina226_read_all();
-                chargerStateMachine();
-            }
-        }
-
-        /* Send STATUS + STATUS2 packets every 500ms */
-        {
-            static uint32_t last_chgstat_ms = 0;
-            uint32_t now = HAL_GetTick();
-            if ((now - last_chgstat_ms) >= 500) {
-                last_chgstat_ms = now;
-                sendStatusPacket();
-            }
-        }
-
-        if (rx_line_ready) {
-            char local_line[RX_LINE_MAX];
-            __disable_irq();
-            memcpy(local_line, rx_ready, sizeof(local_line));
-            rx_line_ready = false;
-            __enable_irq();
-            parseCommand(local_line);
-        }
+        /* INA226 + charger, telemetry stream, command dispatch,
+         * temperature/VDDA and RX health: see Cooperative Scheduler. */
+        sched_run();
 
-#if DEBUG_UART_RX
-        {
-            static uint32_t last_health = 0;
-            uint32_t now = HAL_GetTick();
-            if (now - last_health >= 5000) {
-                last_health = now;
-                char hb[128];
-                snprintf(hb, sizeof(hb),
-                         "RXHEALTH,bytes=%lu,errors=%lu,overruns=%lu",
-                         (unsigned long)uart_rx_bytes,
-                         (unsigned long)uart_rx_errors,
-                         (unsigned long)uart_rx_overruns);
-                uartSend(hb);
-
-                if (huart1.RxState == HAL_UART_STATE_READY) {
-                    HAL_UART_Receive_IT(&huart1, &rx_byte, 1);
-                    uartSend("RXHEALTH,REARM");
-                }
-            }
+#if PERF_STATS
+        perf_service();
+        if (!perf_loop_fired) {
+            perf_record(PERF_LOOP, perf_cyc() - loop_start_cyc);
         }
+        perf_loop_fired = false;
 #endif
     }
 }
@@ -5108,7 +7602,61 @@ void SysTick_Handler(void) {
     HAL_SYSTICK_IRQHandler();
 }
 
-void USART1_IRQHandler(void) { HAL_UART_IRQHandler(&huart1); }
+/* UART RX: IDLE (burst ended) and line errors. Received bytes are already
+ * in the DMA ring; just drain it. */
+void USART1_IRQHandler(void) {
+    const uint32_t isr = USART1->ISR;
+    if (isr & (USART_ISR_ORE | USART_ISR_FE | USART_ISR_NE | USART_ISR_PE)) {
+        uart_rx_errors++;
+        if (isr & USART_ISR_ORE) uart_rx_overruns++;
+        USART1->ICR =
+            USART_ICR_ORECF | USART_ICR_FECF | USART_ICR_NECF | USART_ICR_PECF;
+    }
+    if (isr & USART_ISR_IDLE) {
+        USART1->ICR = USART_ICR_IDLECF;
+    }
+    uart_rx_dma_drain();
+}
+
+/* UART RX ring half/full: drain so a long burst never laps the ring. */
+void DMA1_Channel3_IRQHandler(void) {
+    const uint32_t isr = DMA1->ISR;
+    if (isr & DMA_ISR_TEIF3) {
+        uart_rx_dma_errors++; /* hardware cleared EN; RXHEALTH restarts */
+    }
+    DMA1->IFCR = DMA_IFCR_CGIF3;
+    uart_rx_dma_drain();
+}
+
+/* UART TX queue: retire the finished segment and start the next one. */
+void DMA1_Channel2_IRQHandler(void) {
+    const uint32_t isr = DMA1->ISR;
+    if ((isr & (DMA_ISR_TCIF2 | DMA_ISR_TEIF2)) == 0U) {
+        return;
+    }
+
+    DMA1->IFCR = DMA_IFCR_CGIF2;
+    DMA1_Channel2->CCR &= ~DMA_CCR_EN;
+    if ((isr & DMA_ISR_TEIF2) != 0U) {
+        uart_tx_dma_errors++; /* segment is lost; keep the queue moving */
+    }
+
+    if (uart_tx_busy) {
+        UartTxLane* lane = &uart_tx_lanes[uart_tx_active_lane];
+        lane->tail = (uint16_t)((lane->tail + uart_tx_active_len) & lane->mask);
+        uart_tx_busy = false;
+#if PERF_STATS
+        if (uart_tx_active_lane == UART_TX_LANE_PRIO && perf_tx_left > 0) {
+            perf_tx_left -= (int32_t)uart_tx_active_len;
+            if (perf_tx_left <= 0) {
+                perf_tx_done_cyc = DWT->CYCCNT;
+                perf_tx_done = true;
+            }
+        }
+#endif
+    }
+    uartTxKick();
+}
 
 /**
  * @brief Timer Period Elapsed Callback
@@ -5128,6 +7676,69 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef* htim) {
  */
 void TIM1_UP_TIM16_IRQHandler(void) { HAL_TIM_IRQHandler(&htim1); }
 
+/**
+ * @brief I2C1 event / error handlers (INA226 interrupt-driven polling)
+ */
+void I2C1_EV_IRQHandler(void) { HAL_I2C_EV_IRQHandler(&hi2c1); }
+void I2C1_ER_IRQHandler(void) { HAL_I2C_ER_IRQHandler(&hi2c1); }
+
+/**
+ * @brief ADC2 analog watchdog 1: contact make/break (Contact Watch)
+ *
+ * ADC1 and ADC2 share this vector and nothing else is acknowledged here:
+ * ADC2 AWD1IE must stay the only ADC interrupt source enabled (the capture
+ * and polled reads use DMA or EOC polling), or this returns without
+ * clearing the other flag and the IRQ re-enters forever.
+ */
+void ADC1_2_IRQHandler(void) {
+    if ((ADC2->ISR & ADC_ISR_AWD1) == 0U) {
+        return;
+    }
+    const uint32_t dr = ADC2->DR;
+    ADC2->ISR = ADC_ISR_AWD1;
+    if (dr < contact_watch_make_counts) {
+        if (!contact_watch_raw) {
+            contact_watch_raw = true;
+            contact_watch_make_ms = HAL_GetTick();
+        }
+        ADC2->TR1 = contactWatchTr1(0U, contact_watch_break_counts);
+    } else if (dr > contact_watch_break_counts) {
+        contact_watch_raw = false;
+        ADC2->TR1 = contactWatchTr1(contact_watch_make_counts, 4095U);
+    }
+}
+
+/**
+ * @brief Pedal edge (PB12 = EXTI12): timestamp and restart the debounce
+ */
+void EXTI15_10_IRQHandler(void) {
+    if ((EXTI->PR1 & PEDAL_PIN) != 0U) {
+        EXTI->PR1 = PEDAL_PIN; /* write-1-to-clear */
+        if ((TIM7->CR1 & TIM_CR1_CEN) == 0U) {
+            pedal_burst_cyc = DWT->CYCCNT; /* debounce idle: burst starts */
+        }
+        TIM7->CNT = 0U;
+        TIM7->CR1 |= TIM_CR1_CEN; /* one-pulse: stops itself at expiry */
+    }
+}
+
+/**
+ * @brief Pedal debounce expiry: the line was quiet for PEDAL_DEBOUNCE_MS
+ */
+void TIM7_DAC_IRQHandler(void) {
+    if (TIM7->SR & TIM_SR_UIF) {
+        TIM7->SR = ~TIM_SR_UIF;
+        const GPIO_PinState level = HAL_GPIO_ReadPin(PEDAL_PORT, PEDAL_PIN);
+        if (level != pedal_stable) {
+            pedal_stable = level;
+            if (level == GPIO_PIN_RESET && !welding_now) {
+                pedal_press_edge_cyc = pedal_burst_cyc;
+                pedal_press_ready = true;
+            }
+        }
+    }
+}
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * TIM2 Global Interrupt Handler
  * ═══════════════════════════════════════════════════════════════════════════
@@ -5145,6 +7756,9 @@ void TIM1_UP_TIM16_IRQHandler(void) { HAL_TIM_IRQHandler(&htim1); }
 void TIM2_IRQHandler(void) {
     if (TIM2->SR & TIM_SR_UIF) {
         pwmOff();               /* IMMEDIATE FET kill — CCR=0       */
+#if PERF_STATS
+        tim2_kill_cyc = DWT->CYCCNT; /* after the kill: adds no latency */
+#endif
         tim2_fet_killed = true; /* signal sampling loop to exit     */
         TIM2->SR = ~TIM_SR_UIF; /* clear UIF (write-0-to-clear)     */
     }
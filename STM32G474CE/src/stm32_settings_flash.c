@@ -60,20 +60,71 @@ static void settings_update_crc(PersistentSettings* settings) {
     settings->crc32 = settings_calc_crc(settings);
 }
 
+/**
+ * One log slot: the settings record, zero padding, then the sequence number.
+ * The sequence number shares the last doubleword, which is programmed last.
+ */
+typedef struct __attribute__((packed)) {
+    PersistentSettings settings;
+    uint8_t pad[SETTINGS_LOG_SLOT_BYTES - sizeof(PersistentSettings) - 4U];
+    uint32_t seq;  // 0xFFFFFFFF = never committed
+} SettingsLogSlot;
+
+_Static_assert(sizeof(SettingsLogSlot) == SETTINGS_LOG_SLOT_BYTES,
+               "settings log slot must be SETTINGS_LOG_SLOT_BYTES");
+_Static_assert((SETTINGS_LOG_SLOT_BYTES % 8U) == 0U,
+               "settings log slot must be whole doublewords");
+
+#define SETTINGS_LOG_NO_SLOT 0xFFFFFFFFUL
+
+/* Newest valid slot (log index = page * SLOTS_PER_PAGE + slot) and the
+ * append cursor, both found by settings_flash_init(). */
+static uint32_t log_newest = SETTINGS_LOG_NO_SLOT;
+static uint32_t log_newest_seq = 0U;
+static uint32_t log_next = 0U;
+
 extern UART_HandleTypeDef huart1;
 
-static void flash_debug_send(const char* msg) {
-    if (!msg || huart1.Instance == NULL) return;
-    HAL_UART_Transmit(&huart1, (uint8_t*)msg, (uint16_t)strlen(msg), 50U);
+__attribute__((weak)) void settings_flash_debug(const char* line) {
+    if (!line || huart1.Instance == NULL) return;
+    HAL_UART_Transmit(&huart1, (uint8_t*)line, (uint16_t)strlen(line), 50U);
+    HAL_UART_Transmit(&huart1, (uint8_t*)"\r\n", 2U, 50U);
 }
 
 static void flash_debug_u32(const char* tag, uint32_t value) {
     char buf[96];
-    snprintf(buf, sizeof(buf), "DBG,%s=0x%08lX\r\n", tag, (unsigned long)value);
-    flash_debug_send(buf);
+    snprintf(buf, sizeof(buf), "DBG,%s=0x%08lX", tag, (unsigned long)value);
+    settings_flash_debug(buf);
+}
+
+static uint32_t log_slot_addr(uint32_t index) {
+    uint32_t page = index / SETTINGS_LOG_SLOTS_PER_PAGE;
+    uint32_t slot = index % SETTINGS_LOG_SLOTS_PER_PAGE;
+    return SETTINGS_FLASH_BASE_ADDR + (page * SETTINGS_FLASH_PAGE_SIZE) +
+           (slot * SETTINGS_LOG_SLOT_BYTES);
 }
 
-static void flash_prepare_erase_config(FLASH_EraseInitTypeDef* erase_config) {
+static uint32_t log_advance(uint32_t index) {
+    return (index + 1U) % (SETTINGS_LOG_PAGES * SETTINGS_LOG_SLOTS_PER_PAGE);
+}
+
+static bool log_range_blank(uint32_t addr, uint32_t bytes) {
+    const uint32_t* w = (const uint32_t*)addr;
+    for (uint32_t i = 0; i < bytes / 4U; i++) {
+        if (w[i] != 0xFFFFFFFFUL) return false;
+    }
+    return true;
+}
+
+static bool log_slot_valid(const SettingsLogSlot* slot) {
+    return (slot->seq != 0xFFFFFFFFUL) &&
+           (slot->settings.magic == SETTINGS_MAGIC) &&
+           (slot->settings.version == SETTINGS_VERSION) &&
+           settings_verify_crc(&slot->settings);
+}
+
+static void flash_prepare_erase_config(FLASH_EraseInitTypeDef* erase_config,
+                                       uint32_t page) {
     memset(erase_config, 0, sizeof(*erase_config));
     erase_config->TypeErase = FLASH_TYPEERASE_PAGES;
 
@@ -82,28 +133,51 @@ static void flash_prepare_erase_config(FLASH_EraseInitTypeDef* erase_config) {
     uint32_t dual_bank =
         (READ_BIT(FLASH->OPTR, FLASH_OPTR_DBANK) != 0U) ? 1U : 0U;
     if (dual_bank) {
-        if (SETTINGS_FLASH_PAGE_NUMBER >= 128U) {
+        if (page >= 128U) {
             erase_config->Banks = FLASH_BANK_2;
-            erase_config->Page = SETTINGS_FLASH_PAGE_NUMBER - 128U;
+            erase_config->Page = page - 128U;
         } else {
             erase_config->Banks = FLASH_BANK_1;
-            erase_config->Page = SETTINGS_FLASH_PAGE_NUMBER;
+            erase_config->Page = page;
         }
     } else {
         erase_config->Banks = FLASH_BANK_1;
-        erase_config->Page = SETTINGS_FLASH_PAGE_NUMBER;
+        erase_config->Page = page;
     }
 #else
     erase_config->Banks = FLASH_BANK_1;
-    erase_config->Page = SETTINGS_FLASH_PAGE_NUMBER;
+    erase_config->Page = page;
 #endif
 #else
-    erase_config->Page = SETTINGS_FLASH_PAGE_NUMBER;
+    erase_config->Page = page;
 #endif
 
     erase_config->NbPages = 1U;
 }
 
+/**
+ * Erase one log page (Flash must be unlocked).
+ * @param log_page Page index within the log (0..SETTINGS_LOG_PAGES-1)
+ * @return true on success
+ */
+static bool log_erase_page(uint32_t log_page) {
+    FLASH_EraseInitTypeDef erase_config;
+    flash_prepare_erase_config(&erase_config,
+                               SETTINGS_FLASH_PAGE_NUMBER + log_page);
+
+    uint32_t page_error = 0xFFFFFFFFUL;
+    HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&erase_config, &page_error);
+    if (status != HAL_OK) {
+        settings_flash_debug("DBG,FLASH_ERASE_FAILED");
+        flash_debug_u32("FLASH_ERASE_PAGE", erase_config.Page);
+        flash_debug_u32("FLASH_ERASE_STATUS", (uint32_t)status);
+        flash_debug_u32("FLASH_ERASE_PAGE_ERR", page_error);
+        flash_debug_u32("FLASH_ERASE_HAL_ERR", HAL_FLASH_GetError());
+        return false;
+    }
+    return true;
+}
+
 bool settings_flash_init(void) {
     // HAL Flash module is initialized during HAL_Init() in main().
     // Defensively clear any Flash error flags that may be latched at boot
@@ -113,92 +187,79 @@ bool settings_flash_init(void) {
     // clean state instead of failing in the pre-erase wait. See the detailed
     // note in settings_flash_save().
     __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_SR_ERRORS);
+
+    // Scan the log once: newest valid slot wins, appends continue after it.
+    log_newest = SETTINGS_LOG_NO_SLOT;
+    log_newest_seq = 0U;
+    const uint32_t slots = SETTINGS_LOG_PAGES * SETTINGS_LOG_SLOTS_PER_PAGE;
+    for (uint32_t i = 0; i < slots; i++) {
+        const SettingsLogSlot* slot =
+            (const SettingsLogSlot*)log_slot_addr(i);
+        if (!log_slot_valid(slot)) continue;
+        if (log_newest == SETTINGS_LOG_NO_SLOT || slot->seq > log_newest_seq) {
+            log_newest = i;
+            log_newest_seq = slot->seq;
+        }
+    }
+    log_next = (log_newest == SETTINGS_LOG_NO_SLOT) ? 0U
+                                                    : log_advance(log_newest);
     return true;
 }
 
 bool settings_flash_load(PersistentSettings* settings) {
     if (!settings) return false;
-
-    // Read settings directly from Flash memory (no HAL call needed for read)
-    const PersistentSettings* flash_settings =
-        (const PersistentSettings*)SETTINGS_FLASH_BASE_ADDR;
-
-    // Verify magic number
-    if (flash_settings->magic != SETTINGS_MAGIC) {
-        return false;  // Flash empty or invalid
-    }
-
-    // Verify version
-    if (flash_settings->version != SETTINGS_VERSION) {
-        return false;  // Incompatible version
+    if (log_newest == SETTINGS_LOG_NO_SLOT) {
+        return false;  // Flash empty or no valid slot
     }
 
-    // Verify CRC
-    if (!settings_verify_crc(flash_settings)) {
-        return false;  // Corrupted data
+    // Read directly from Flash memory (no HAL call needed for read) and
+    // re-check in case the log was erased since the scan.
+    const SettingsLogSlot* slot =
+        (const SettingsLogSlot*)log_slot_addr(log_newest);
+    if (!log_slot_valid(slot)) {
+        return false;
     }
 
     // Copy valid settings
-    memcpy(settings, flash_settings, sizeof(PersistentSettings));
+    memcpy(settings, &slot->settings, sizeof(PersistentSettings));
     return true;
 }
 
 bool settings_flash_save(const PersistentSettings* settings) {
     if (!settings) {
-        flash_debug_send("DBG,FLASH_SAVE_NULL_INPUT\r\n");
+        settings_flash_debug("DBG,FLASH_SAVE_NULL_INPUT");
         return false;
     }
 
-    flash_debug_send("DBG,FLASH_SAVE_START\r\n");
-    flash_debug_u32("FLASH_BASE", SETTINGS_FLASH_BASE_ADDR);
-    flash_debug_u32("FLASH_PAGE_CFG", SETTINGS_FLASH_PAGE_NUMBER);
-
     HAL_StatusTypeDef status;
 
-    // Create local copy and update CRC
-    PersistentSettings settings_with_crc;
-    memset(&settings_with_crc, 0, sizeof(settings_with_crc));
-    memcpy(&settings_with_crc, settings, sizeof(PersistentSettings));
-    settings_with_crc.magic = SETTINGS_MAGIC;
-    settings_with_crc.version = SETTINGS_VERSION;
-    settings_update_crc(&settings_with_crc);
-
-    flash_debug_u32("FLASH_NEW_CRC", settings_with_crc.crc32);
-
-    // Skip erase/program when payload CRC and headers are unchanged.
-    const PersistentSettings* flash_settings =
-        (const PersistentSettings*)SETTINGS_FLASH_BASE_ADDR;
-    uint32_t flash_calc_crc = settings_calc_crc(flash_settings);
-
-    flash_debug_u32("FLASH_CUR_CRC", flash_settings->crc32);
-    flash_debug_u32("FLASH_CUR_CALC_CRC", flash_calc_crc);
-
-    char cmp_buf[128];
-    snprintf(cmp_buf, sizeof(cmp_buf),
-             "DBG,FLASH_CMP,flash_crc=0x%08lX,new_crc=0x%08lX\r\n",
-             (unsigned long)flash_calc_crc,
-             (unsigned long)settings_with_crc.crc32);
-    flash_debug_send(cmp_buf);
-
-    const bool flash_header_valid =
-        (flash_settings->magic == SETTINGS_MAGIC) &&
-        (flash_settings->version == SETTINGS_VERSION);
-    const bool flash_crc_valid =
-        flash_header_valid && (flash_settings->crc32 == flash_calc_crc);
-
-    if (flash_crc_valid && (flash_calc_crc == settings_with_crc.crc32)) {
-        flash_debug_send("DBG,FLASH_SKIP_UNCHANGED\r\n");
-        return true;
+    // Build the slot image and update CRC
+    SettingsLogSlot image;
+    memset(&image, 0, sizeof(image));
+    memcpy(&image.settings, settings, sizeof(PersistentSettings));
+    image.settings.magic = SETTINGS_MAGIC;
+    image.settings.version = SETTINGS_VERSION;
+    settings_update_crc(&image.settings);
+    image.seq = log_newest_seq + 1U;
+
+    // Skip the write when the newest slot already holds the same payload.
+    if (log_newest != SETTINGS_LOG_NO_SLOT) {
+        const SettingsLogSlot* cur =
+            (const SettingsLogSlot*)log_slot_addr(log_newest);
+        if (log_slot_valid(cur) &&
+            memcmp(&cur->settings, &image.settings,
+                   sizeof(PersistentSettings)) == 0) {
+            return true;
+        }
     }
 
     // Unlock Flash for write/erase
     status = HAL_FLASH_Unlock();
     if (status != HAL_OK) {
-        flash_debug_send("DBG,FLASH_UNLOCK_FAILED\r\n");
+        settings_flash_debug("DBG,FLASH_UNLOCK_FAILED");
         flash_debug_u32("FLASH_UNLOCK_ERR", HAL_FLASH_GetError());
         return false;
     }
-    flash_debug_send("DBG,FLASH_UNLOCKED\r\n");
 
     // ---- Root-cause fix for persistent FLASH_SAVE_FAILED (HAL_ERR=0x80 PGSERR) ----
     // Diagnosis from the on-target DBG log: HAL_FLASHEx_Erase aborted in its
@@ -207,87 +268,104 @@ bool settings_flash_save(const PersistentSettings* settings) {
     // A stale Flash error flag — or a leftover operation bit (PG/PER/PNB/FSTPG)
     // in FLASH->CR from an aborted earlier op — makes every subsequent erase
     // fail. Clear both before erasing so the erase starts from a clean state.
-    // (Report SR/CR first so we can confirm what was stale on the next test.)
-    flash_debug_u32("FLASH_SR_PRECLEAR", FLASH->SR);
-    flash_debug_u32("FLASH_CR_PRECLEAR", FLASH->CR);
     __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_SR_ERRORS);
     CLEAR_BIT(FLASH->CR,
               FLASH_CR_PG | FLASH_CR_PER | FLASH_CR_PNB | FLASH_CR_FSTPG);
-    flash_debug_u32("FLASH_SR_POSTCLEAR", FLASH->SR);
-
-    // Erase the settings page
-    FLASH_EraseInitTypeDef erase_config;
-    flash_prepare_erase_config(&erase_config);
 
-    flash_debug_u32("FLASH_ERASE_PAGE", erase_config.Page);
-#if defined(FLASH_BANK_1)
-    flash_debug_u32("FLASH_ERASE_BANK", erase_config.Banks);
-#endif
-
-    uint32_t page_error = 0xFFFFFFFFUL;
-    status = HAL_FLASHEx_Erase(&erase_config, &page_error);
-    if (status != HAL_OK) {
-        flash_debug_send("DBG,FLASH_ERASE_FAILED\r\n");
-        flash_debug_u32("FLASH_ERASE_STATUS", (uint32_t)status);
-        flash_debug_u32("FLASH_ERASE_PAGE_ERR", page_error);
-        flash_debug_u32("FLASH_ERASE_HAL_ERR", HAL_FLASH_GetError());
+    // Find a blank slot. Entering a page at slot 0 erases it first (the log
+    // has wrapped onto its oldest page); a slot left half-written by a reset
+    // is skipped.
+    const uint32_t slots = SETTINGS_LOG_PAGES * SETTINGS_LOG_SLOTS_PER_PAGE;
+    uint32_t index = log_next;
+    bool found = false;
+    for (uint32_t tries = 0; tries < slots; tries++) {
+        if ((index % SETTINGS_LOG_SLOTS_PER_PAGE) == 0U &&
+            !log_range_blank(log_slot_addr(index), SETTINGS_FLASH_PAGE_SIZE)) {
+            if (!log_erase_page(index / SETTINGS_LOG_SLOTS_PER_PAGE)) {
+                HAL_FLASH_Lock();
+                return false;
+            }
+        }
+        if (log_range_blank(log_slot_addr(index), SETTINGS_LOG_SLOT_BYTES)) {
+            found = true;
+            break;
+        }
+        index = log_advance(index);
+    }
+    if (!found) {
+        settings_flash_debug("DBG,FLASH_LOG_NO_BLANK_SLOT");
         HAL_FLASH_Lock();
         return false;
     }
-    flash_debug_send("DBG,FLASH_ERASED\r\n");
 
-    // Write settings to Flash (64-bit chunks for STM32G4)
+    // Write the slot (64-bit chunks for STM32G4, sequence doubleword last)
     // STM32G4 Flash writes must be 64-bit (double word) aligned
-    enum { SETTINGS_WRITE_BYTES = ((sizeof(PersistentSettings) + 7U) & ~7U) };
-    uint8_t write_buffer[SETTINGS_WRITE_BYTES];
-    memset(write_buffer, 0, sizeof(write_buffer));
-    memcpy(write_buffer, &settings_with_crc, sizeof(PersistentSettings));
+    const uint32_t base = log_slot_addr(index);
+    uint64_t dwords[SETTINGS_LOG_SLOT_BYTES / 8U];
+    memcpy(dwords, &image, sizeof(image));
 
-    const uint64_t* data_ptr = (const uint64_t*)write_buffer;
-    uint32_t num_dwords = SETTINGS_WRITE_BYTES / 8U;
-    flash_debug_u32("FLASH_DWORDS", num_dwords);
-
-    for (uint32_t i = 0; i < num_dwords; i++) {
-        uint32_t address = SETTINGS_FLASH_BASE_ADDR + (i * 8U);
+    for (uint32_t i = 0; i < SETTINGS_LOG_SLOT_BYTES / 8U; i++) {
+        uint32_t address = base + (i * 8U);
         status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, address,
-                                   data_ptr[i]);
+                                   dwords[i]);
 
         if (status != HAL_OK) {
-            flash_debug_send("DBG,FLASH_WRITE_FAILED\r\n");
+            settings_flash_debug("DBG,FLASH_WRITE_FAILED");
             flash_debug_u32("FLASH_WRITE_INDEX", i);
             flash_debug_u32("FLASH_WRITE_ADDR", address);
             flash_debug_u32("FLASH_WRITE_STATUS", (uint32_t)status);
             flash_debug_u32("FLASH_WRITE_HAL_ERR", HAL_FLASH_GetError());
             HAL_FLASH_Lock();
+            log_next = log_advance(index);  // slot is dirty now
             return false;
         }
     }
-    flash_debug_send("DBG,FLASH_WRITTEN\r\n");
+    log_next = log_advance(index);
 
     // Lock Flash
     status = HAL_FLASH_Lock();
     if (status != HAL_OK) {
-        flash_debug_send("DBG,FLASH_LOCK_FAILED\r\n");
+        settings_flash_debug("DBG,FLASH_LOCK_FAILED");
         flash_debug_u32("FLASH_LOCK_ERR", HAL_FLASH_GetError());
         return false;
     }
-    flash_debug_send("DBG,FLASH_LOCKED\r\n");
 
     // Verify write by reading back
-    PersistentSettings verify;
-    if (!settings_flash_load(&verify)) {
-        flash_debug_send("DBG,FLASH_VERIFY_LOAD_FAILED\r\n");
+    const SettingsLogSlot* written = (const SettingsLogSlot*)base;
+    if (!log_slot_valid(written) ||
+        memcmp(written, &image, sizeof(image)) != 0) {
+        settings_flash_debug("DBG,FLASH_VERIFY_FAILED");
+        flash_debug_u32("FLASH_VERIFY_ADDR", base);
         return false;
     }
 
-    if (verify.crc32 != settings_with_crc.crc32) {
-        flash_debug_send("DBG,FLASH_VERIFY_CRC_MISMATCH\r\n");
-        flash_debug_u32("FLASH_VERIFY_CRC_RD", verify.crc32);
-        flash_debug_u32("FLASH_VERIFY_CRC_WR", settings_with_crc.crc32);
-        return false;
-    }
+    log_newest = index;
+    log_newest_seq = image.seq;
+
+    char ok[80];
+    snprintf(ok, sizeof(ok), "DBG,FLASH_SAVE_SUCCESS,page=%lu,slot=%lu,seq=%lu",
+             (unsigned long)(SETTINGS_FLASH_PAGE_NUMBER +
+                             index / SETTINGS_LOG_SLOTS_PER_PAGE),
+             (unsigned long)(index % SETTINGS_LOG_SLOTS_PER_PAGE),
+             (unsigned long)image.seq);
+    settings_flash_debug(ok);
+    return true;
+}
 
-    flash_debug_send("DBG,FLASH_SAVE_SUCCESS\r\n");
+bool settings_flash_save_needs_erase(void) {
+    // Same walk as settings_flash_save(), without touching the Flash.
+    const uint32_t slots = SETTINGS_LOG_PAGES * SETTINGS_LOG_SLOTS_PER_PAGE;
+    uint32_t index = log_next;
+    for (uint32_t tries = 0; tries < slots; tries++) {
+        if ((index % SETTINGS_LOG_SLOTS_PER_PAGE) == 0U &&
+            !log_range_blank(log_slot_addr(index), SETTINGS_FLASH_PAGE_SIZE)) {
+            return true;
+        }
+        if (log_range_blank(log_slot_addr(index), SETTINGS_LOG_SLOT_BYTES)) {
+            return false;
+        }
+        index = log_advance(index);
+    }
     return true;
 }
 
@@ -296,14 +374,17 @@ bool settings_flash_erase(void) {
 
     status = HAL_FLASH_Unlock();
     if (status != HAL_OK) return false;
+    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_SR_ERRORS);
 
-    FLASH_EraseInitTypeDef erase_config;
-    flash_prepare_erase_config(&erase_config);
-
-    uint32_t page_error = 0;
-    status = HAL_FLASHEx_Erase(&erase_config, &page_error);
+    bool ok = true;
+    for (uint32_t p = 0; p < SETTINGS_LOG_PAGES; p++) {
+        if (!log_erase_page(p)) ok = false;
+    }
 
     HAL_FLASH_Lock();
 
-    return (status == HAL_OK);
+    log_newest = SETTINGS_LOG_NO_SLOT;
+    log_newest_seq = 0U;
+    log_next = 0U;
+    return ok;
 }
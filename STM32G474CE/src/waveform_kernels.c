@@ -0,0 +1,587 @@
+/**
+ * @file waveform_kernels.c
+ * @brief Hardware-independent weld waveform kernels (see waveform_kernels.h)
+ */
+
+#include "waveform_kernels.h"
+
+#include <math.h>
+#include <stdio.h>
+
+uint32_t wf_sample_ts_us(const WaveformView* w, uint16_t idx) {
+#if WAVEFORM_PACKED_STORAGE
+    if (w->block_count == 0U) {
+        return 0U;
+    }
+    uint16_t lo = 0U;
+    uint16_t hi = w->block_count;
+    while ((uint16_t)(hi - lo) > 1U) {
+        const uint16_t mid = (uint16_t)((lo + hi) / 2U);
+        if (w->blocks[mid].first_index <= idx) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    uint32_t ts_us = w->blocks[lo].t0_us;
+    for (uint16_t i = (uint16_t)(w->blocks[lo].first_index + 1U); i <= idx;
+         i++) {
+        ts_us += w->words[i] >> 24;
+    }
+    return ts_us;
+#else
+    return w->samples[idx].timestamp_us;
+#endif
+}
+
+uint32_t wf_sample_dt_us(const WaveformView* w, uint16_t idx) {
+    if (idx == 0U) {
+        return 0U;
+    }
+#if WAVEFORM_PACKED_STORAGE
+    const uint32_t dt_us = w->words[idx] >> 24;
+    if (dt_us != 0U) {
+        return dt_us;
+    }
+#endif
+    const uint32_t t_us = wf_sample_ts_us(w, (uint16_t)(idx - 1U));
+    const uint32_t t_next_us = wf_sample_ts_us(w, idx);
+    return (t_next_us > t_us) ? (t_next_us - t_us) : 0U;
+}
+
+bool wf_find_phase_edge(const WaveformView* w, uint16_t start, uint16_t end,
+                        bool last, float peak_ratio, float min_amps,
+                        uint16_t* out_idx) {
+    if (end > w->count) {
+        end = w->count;
+    }
+    if (start >= end) {
+        return false;
+    }
+
+    float phase_peak_amps = 0.0f;
+    for (uint16_t i = start; i < end; i++) {
+        float amps = wf_sample_amps(w, i);
+        if (isfinite(amps) && amps > phase_peak_amps) {
+            phase_peak_amps = amps;
+        }
+    }
+    if (phase_peak_amps <= 0.0f) {
+        return false;
+    }
+
+    float threshold_amps = phase_peak_amps * peak_ratio;
+    if (threshold_amps < min_amps) {
+        threshold_amps = min_amps;
+    }
+
+    if (!last) {
+        for (uint16_t i = start; i < end; i++) {
+            float amps = wf_sample_amps(w, i);
+            if (isfinite(amps) && amps >= threshold_amps) {
+                *out_idx = i;
+                return true;
+            }
+        }
+    } else {
+        for (uint16_t i = end; i > start; i--) {
+            const uint16_t idx = (uint16_t)(i - 1U);
+            float amps = wf_sample_amps(w, idx);
+            if (isfinite(amps) && amps >= threshold_amps) {
+                *out_idx = idx;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void wf_interpolate_volts(WaveformView* w, float vcap_start, float vcap_end,
+                          uint16_t pulse_start, uint16_t pulse_end) {
+    if (w->count == 0U) {
+        return;
+    }
+
+    if (pulse_start > w->count) {
+        pulse_start = w->count;
+    }
+    if (pulse_end < pulse_start) {
+        pulse_end = pulse_start;
+    }
+    if (pulse_end > w->count) {
+        pulse_end = w->count;
+    }
+
+    for (uint16_t i = 0; i < pulse_start; i++) {
+        wf_set_sample_volts(w, i, vcap_start);
+    }
+
+    if (pulse_end > pulse_start) {
+        const float dv = vcap_start - vcap_end;
+        const float denom = (float)(pulse_end - pulse_start);
+
+        for (uint16_t i = pulse_start; i < pulse_end; i++) {
+            const float t = (float)(i - pulse_start) / denom;
+            wf_set_sample_volts(w, i, vcap_start - (dv * t));
+        }
+    }
+
+    for (uint16_t i = pulse_end; i < w->count; i++) {
+        wf_set_sample_volts(w, i, vcap_end);
+    }
+}
+
+void wf_integrate_pulse(const WaveformView* w, uint16_t start, uint16_t end,
+                        float lead_r_ohms, float nominal_dt_s,
+                        WaveformPulseStats* out) {
+    out->energy_j = 0.0f;
+    out->duration_s = 0.0f;
+    out->sum_amps = 0.0f;
+    out->sum_volts = 0.0f;
+    out->samples = 0U;
+
+    if (end > w->count) {
+        end = w->count;
+    }
+    if (start > end) {
+        start = end;
+    }
+
+    for (uint16_t i = start; i < end; i++) {
+        float i_shunt = wf_sample_amps(w, i);
+        float v_cap = wf_sample_volts(w, i);
+
+        if (!isfinite(i_shunt) || i_shunt < 0.0f) i_shunt = 0.0f;
+        if (!isfinite(v_cap) || v_cap < 0.0f) v_cap = 0.0f;
+
+        out->sum_amps += i_shunt;
+        out->sum_volts += v_cap;
+        out->samples++;
+    }
+
+    const uint16_t span = (uint16_t)(end - start);
+    if (span >= 2U) {
+        for (uint16_t i = start; (uint16_t)(i + 1U) < end; i++) {
+            float i0 = wf_sample_amps(w, i);
+            float v0 = wf_sample_volts(w, i);
+            float i1 = wf_sample_amps(w, (uint16_t)(i + 1U));
+            float v1 = wf_sample_volts(w, (uint16_t)(i + 1U));
+
+            if (!isfinite(i0) || i0 < 0.0f) i0 = 0.0f;
+            if (!isfinite(v0) || v0 < 0.0f) v0 = 0.0f;
+            if (!isfinite(i1) || i1 < 0.0f) i1 = 0.0f;
+            if (!isfinite(v1) || v1 < 0.0f) v1 = 0.0f;
+
+            float dt_s = nominal_dt_s;
+            uint32_t dt_us = wf_sample_dt_us(w, (uint16_t)(i + 1U));
+            if (dt_us > 0U) {
+                dt_s = (float)dt_us * 1.0e-6f;
+            }
+            if (!isfinite(dt_s) || dt_s <= 0.0f) dt_s = nominal_dt_s;
+
+            float v_tip0 = v0 - (i0 * lead_r_ohms);
+            float v_tip1 = v1 - (i1 * lead_r_ohms);
+            if (!isfinite(v_tip0) || v_tip0 < 0.0f) v_tip0 = 0.0f;
+            if (!isfinite(v_tip1) || v_tip1 < 0.0f) v_tip1 = 0.0f;
+
+            float p0_watts = v_tip0 * i0;
+            float p1_watts = v_tip1 * i1;
+            if (!isfinite(p0_watts) || p0_watts < 0.0f) p0_watts = 0.0f;
+            if (!isfinite(p1_watts) || p1_watts < 0.0f) p1_watts = 0.0f;
+
+            out->energy_j += 0.5f * (p0_watts + p1_watts) * dt_s;
+            out->duration_s += dt_s;
+        }
+    } else if (span == 1U) {
+        /* Degenerate case: one in-window sample only. */
+        out->duration_s = nominal_dt_s;
+    }
+
+    if (!isfinite(out->energy_j) || out->energy_j < 0.0f) {
+        out->energy_j = 0.0f;
+    }
+    if (!isfinite(out->duration_s) || out->duration_s < 0.0f) {
+        out->duration_s = 0.0f;
+    }
+}
+
+#if WAVEFORM_PACKED_STORAGE
+/* wf_analyze_pulse running sums, in counts. Tip power is kept as
+ * counts * volts (times amps_per_count at the end). */
+typedef struct {
+    float kv;          /* volts_per_count */
+    float kr;          /* lead volts per current count */
+    uint16_t start;
+    uint32_t sum_ci;   /* 4095 * 65535 fits */
+    uint32_t sum_cv;
+    uint64_t sum_ci2;
+    uint32_t peak_ci;
+    uint16_t peak_index;
+    float p_prev;
+    float e_us;        /* sum of (P[i-1] + P[i]) * dt_us[i] */
+    float e_nominal;   /* same, pairs with no dt (nominal_dt_s) */
+    uint32_t dt_us;
+    uint32_t nominal_pairs;
+} WfAnalyzeAcc;
+
+static void wf_analyze_span(const WaveformView* w, uint16_t from, uint16_t to,
+                            WfAnalyzeAcc* a) {
+    for (uint16_t i = from; i < to; i++) {
+        const uint32_t word = w->words[i];
+        const uint32_t ci = word & WAVEFORM_PACK_COUNT_MAX;
+        const uint32_t cv = (word >> 12) & WAVEFORM_PACK_COUNT_MAX;
+        a->sum_ci += ci;
+        a->sum_cv += cv;
+        a->sum_ci2 += (uint64_t)(ci * ci);
+        if (ci > a->peak_ci) {
+            a->peak_ci = ci;
+            a->peak_index = i;
+        }
+
+        const float fi = (float)ci;
+        const float p = fi * fmaxf((float)cv * a->kv - fi * a->kr, 0.0f);
+        if (i != a->start) {
+            uint32_t dt_us = word >> 24;
+            if (dt_us == 0U) {
+                dt_us = wf_sample_dt_us(w, i); /* block start */
+            }
+            if (dt_us != 0U) {
+                a->e_us += (a->p_prev + p) * (float)dt_us;
+                a->dt_us += dt_us;
+            } else {
+                a->e_nominal += a->p_prev + p;
+                a->nominal_pairs++;
+            }
+        }
+        a->p_prev = p;
+    }
+}
+#endif
+
+static float wf_contact_ohms(float sum_volts, float sum_amps,
+                             float lead_r_ohms) {
+    if (sum_amps <= 0.0f) {
+        return 0.0f;
+    }
+    const float r = sum_volts / sum_amps - lead_r_ohms;
+    return (!isfinite(r) || r < 0.0f) ? 0.0f : r;
+}
+
+void wf_analyze_pulse(const WaveformView* w, uint16_t start, uint16_t end,
+                      float lead_r_ohms, float nominal_dt_s,
+                      WaveformPulseAnalytics* out) {
+    out->pulse.energy_j = 0.0f;
+    out->pulse.duration_s = 0.0f;
+    out->pulse.sum_amps = 0.0f;
+    out->pulse.sum_volts = 0.0f;
+    out->pulse.samples = 0U;
+    out->rms_amps = 0.0f;
+    out->peak_amps = 0.0f;
+    out->peak_index = start;
+    out->didt_a_per_us = 0.0f;
+    out->r_start_ohms = 0.0f;
+    out->r_end_ohms = 0.0f;
+
+    if (end > w->count) {
+        end = w->count;
+    }
+    if (start >= end) {
+        return;
+    }
+    if (!isfinite(lead_r_ohms) || lead_r_ohms < 0.0f) {
+        lead_r_ohms = 0.0f;
+    }
+
+    const uint16_t span = (uint16_t)(end - start);
+    const uint16_t quarter = (uint16_t)(span / 4U);
+    float q_amps[2] = {0.0f, 0.0f};
+    float q_volts[2] = {0.0f, 0.0f};
+    uint16_t rise_index = start;
+
+#if WAVEFORM_PACKED_STORAGE
+    const float ka = w->amps_per_count;
+    WfAnalyzeAcc a = {0};
+    a.kv = w->volts_per_count;
+    a.kr = ka * lead_r_ohms;
+    a.start = start;
+    a.peak_index = start;
+
+    /* Three spans so the quarter sums fall out of the running totals. */
+    uint32_t q_ci[2] = {0U, 0U};
+    uint32_t q_cv[2] = {0U, 0U};
+    wf_analyze_span(w, start, (uint16_t)(start + quarter), &a);
+    q_ci[0] = a.sum_ci;
+    q_cv[0] = a.sum_cv;
+    wf_analyze_span(w, (uint16_t)(start + quarter), (uint16_t)(end - quarter),
+                    &a);
+    q_ci[1] = a.sum_ci;
+    q_cv[1] = a.sum_cv;
+    wf_analyze_span(w, (uint16_t)(end - quarter), end, &a);
+    q_ci[1] = a.sum_ci - q_ci[1];
+    q_cv[1] = a.sum_cv - q_cv[1];
+
+    out->pulse.samples = span;
+    out->pulse.sum_amps = (float)a.sum_ci * ka;
+    out->pulse.sum_volts = (float)a.sum_cv * a.kv;
+    if (span >= 2U) {
+        out->pulse.energy_j =
+            0.5f * ka *
+            (a.e_us * 1.0e-6f + a.e_nominal * nominal_dt_s);
+        out->pulse.duration_s = (float)a.dt_us * 1.0e-6f +
+                                (float)a.nominal_pairs * nominal_dt_s;
+    } else {
+        /* Degenerate case: one in-window sample only. */
+        out->pulse.duration_s = nominal_dt_s;
+    }
+    out->rms_amps = sqrtf((float)a.sum_ci2 / (float)span) * ka;
+    out->peak_amps = (float)a.peak_ci * ka;
+    out->peak_index = a.peak_index;
+    for (uint16_t q = 0U; q < 2U; q++) {
+        q_amps[q] = (float)q_ci[q] * ka;
+        q_volts[q] = (float)q_cv[q] * a.kv;
+    }
+
+    /* 90 % of the peak, compared in counts. */
+    while (rise_index < a.peak_index &&
+           (w->words[rise_index] & WAVEFORM_PACK_COUNT_MAX) * 10U <
+               a.peak_ci * 9U) {
+        rise_index++;
+    }
+#else
+    wf_integrate_pulse(w, start, end, lead_r_ohms, nominal_dt_s, &out->pulse);
+
+    float sum_sq = 0.0f;
+    for (uint16_t i = start; i < end; i++) {
+        float amps = wf_sample_amps(w, i);
+        float volts = wf_sample_volts(w, i);
+        if (!isfinite(amps) || amps < 0.0f) amps = 0.0f;
+        if (!isfinite(volts) || volts < 0.0f) volts = 0.0f;
+        sum_sq += amps * amps;
+        if (amps > out->peak_amps) {
+            out->peak_amps = amps;
+            out->peak_index = i;
+        }
+        if (i < start + quarter) {
+            q_amps[0] += amps;
+            q_volts[0] += volts;
+        } else if (i >= end - quarter) {
+            q_amps[1] += amps;
+            q_volts[1] += volts;
+        }
+    }
+    out->rms_amps = sqrtf(sum_sq / (float)span);
+
+    while (rise_index < out->peak_index) {
+        const float amps = wf_sample_amps(w, rise_index);
+        if (isfinite(amps) && amps >= 0.9f * out->peak_amps) {
+            break;
+        }
+        rise_index++;
+    }
+#endif
+
+    if (!isfinite(out->pulse.energy_j) || out->pulse.energy_j < 0.0f) {
+        out->pulse.energy_j = 0.0f;
+    }
+    if (!isfinite(out->pulse.duration_s) || out->pulse.duration_s < 0.0f) {
+        out->pulse.duration_s = 0.0f;
+    }
+    if (!isfinite(out->rms_amps) || out->rms_amps < 0.0f) {
+        out->rms_amps = 0.0f;
+    }
+
+    /* From the last sample before the window (FET still off), so a rise
+     * faster than one sample interval still gives a rate. */
+    const uint16_t base_index = (start > 0U) ? (uint16_t)(start - 1U) : start;
+    if (rise_index > base_index) {
+        const uint32_t t0 = wf_sample_ts_us(w, base_index);
+        const uint32_t t1 = wf_sample_ts_us(w, rise_index);
+        float a0 = wf_sample_amps(w, base_index);
+        if (!isfinite(a0) || a0 < 0.0f) a0 = 0.0f;
+        const float didt =
+            (t1 > t0) ? (wf_sample_amps(w, rise_index) - a0) / (float)(t1 - t0)
+                      : 0.0f;
+        out->didt_a_per_us = (!isfinite(didt) || didt < 0.0f) ? 0.0f : didt;
+    }
+
+    if (quarter > 0U) {
+        out->r_start_ohms = wf_contact_ohms(q_volts[0], q_amps[0], lead_r_ohms);
+        out->r_end_ohms = wf_contact_ohms(q_volts[1], q_amps[1], lead_r_ohms);
+    }
+}
+
+void wf_phase_stats(const WaveformView* w, uint16_t start, uint16_t end,
+                    float lead_r_ohms, float nominal_dt_s,
+                    WaveformPhaseStats* out) {
+    WaveformPulseAnalytics pa;
+    wf_analyze_pulse(w, start, end, lead_r_ohms, nominal_dt_s, &pa);
+    out->energy_j = pa.pulse.energy_j;
+    out->rms_amps = pa.rms_amps;
+    out->peak_amps = pa.peak_amps;
+    out->peak_index = pa.peak_index;
+    out->samples = pa.pulse.samples;
+}
+
+void wf_envelope_bucket(const WaveformView* w, uint16_t buckets, uint16_t b,
+                        WaveformEnvBucket* out) {
+    const uint16_t start = (uint16_t)(((uint32_t)b * w->count) / buckets);
+    const uint16_t end = (uint16_t)(((uint32_t)(b + 1U) * w->count) / buckets);
+
+    out->min_amps = 0.0f;
+    out->max_amps = 0.0f;
+    out->mean_amps = 0.0f;
+    out->mean_volts = 0.0f;
+    if (start >= end) {
+        return;
+    }
+
+    float lo = INFINITY;
+    float hi = 0.0f;
+    float sum_a = 0.0f;
+    float sum_v = 0.0f;
+    for (uint16_t i = start; i < end; i++) {
+        float a = wf_sample_amps(w, i);
+        float v = wf_sample_volts(w, i);
+        if (!isfinite(a) || a < 0.0f) a = 0.0f;
+        if (!isfinite(v) || v < 0.0f) v = 0.0f;
+        if (a < lo) lo = a;
+        if (a > hi) hi = a;
+        sum_a += a;
+        sum_v += v;
+    }
+    const float n = (float)(end - start);
+    out->min_amps = lo;
+    out->max_amps = hi;
+    out->mean_amps = sum_a / n;
+    out->mean_volts = sum_v / n;
+}
+
+/* Engineering value -> integer wire units, clamped to [0, max]. */
+static long wf_quantize(float value, float scale, long max) {
+    const float q = value * scale;
+    if (!isfinite(q) || q <= 0.0f) {
+        return 0L;
+    }
+    if (q >= (float)max) {
+        return max;
+    }
+    return lroundf(q);
+}
+
+int wf_format_env_chunk(const WaveformView* w, uint16_t buckets,
+                        uint16_t first, uint16_t count, char* line,
+                        size_t line_size) {
+    int n = snprintf(line, line_size, "WAVEFORM_ENV,%u,%u",
+                     (unsigned int)first, (unsigned int)count);
+
+    for (uint16_t k = 0; k < count; k++) {
+        if (n <= 0 || n >= (int)line_size) break;
+        WaveformEnvBucket e;
+        wf_envelope_bucket(w, buckets, (uint16_t)(first + k), &e);
+        n += snprintf(line + n, line_size - (size_t)n, ",%ld,%ld,%ld,%ld",
+                      wf_quantize(e.min_amps, WAVEFORM_BIN_AMPS_SCALE, 32767L),
+                      wf_quantize(e.max_amps, WAVEFORM_BIN_AMPS_SCALE, 32767L),
+                      wf_quantize(e.mean_amps, WAVEFORM_BIN_AMPS_SCALE, 32767L),
+                      wf_quantize(e.mean_volts, WAVEFORM_BIN_VOLTS_SCALE,
+                                  65535L));
+        if (n >= (int)line_size) break;
+    }
+
+    return (n <= 0 || n >= (int)line_size) ? -1 : n;
+}
+
+int wf_format_csv_chunk(const WaveformView* w, uint16_t start, uint16_t count,
+                        char* line, size_t line_size) {
+    int n = snprintf(line, line_size, "WAVEFORM_DATA,%u,%u",
+                     (unsigned int)start, (unsigned int)count);
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint16_t sample_idx = (uint16_t)(start + i);
+        if (n <= 0 || n >= (int)line_size) break;
+        n += snprintf(line + n, line_size - (size_t)n, ",%lu,%.2f,%.2f",
+                      (unsigned long)wf_sample_ts_us(w, sample_idx),
+                      (double)wf_sample_volts(w, sample_idx),
+                      (double)wf_sample_amps(w, sample_idx));
+        if (n >= (int)line_size) break;
+    }
+
+    return (n <= 0 || n >= (int)line_size) ? -1 : n;
+}
+
+uint16_t wf_pack_bin_chunk(const WaveformView* w, uint16_t start,
+                           uint8_t* payload, size_t* out_len,
+                           uint32_t* out_t0_us) {
+    uint16_t idx = start;
+    const uint32_t t0_us = wf_sample_ts_us(w, idx);
+    uint32_t prev_us = t0_us;
+    uint16_t count = 0U;
+    size_t len = 0U;
+
+    while (idx < w->count && count < WAVEFORM_CHUNK_SAMPLES) {
+        const uint32_t ts_us =
+            (count == 0U) ? t0_us : prev_us + wf_sample_dt_us(w, idx);
+        const uint32_t dt_us = ts_us - prev_us;
+        if (dt_us > WAVEFORM_BIN_MAX_DT_US) {
+            break;
+        }
+
+        float a_q = wf_sample_amps(w, idx) * WAVEFORM_BIN_AMPS_SCALE;
+        float v_q = wf_sample_volts(w, idx) * WAVEFORM_BIN_VOLTS_SCALE;
+        if (!isfinite(a_q)) a_q = 0.0f;
+        if (!isfinite(v_q) || v_q < 0.0f) v_q = 0.0f;
+        if (a_q > 32767.0f) a_q = 32767.0f;
+        if (a_q < -32768.0f) a_q = -32768.0f;
+        if (v_q > 65535.0f) v_q = 65535.0f;
+        const int16_t amps = (int16_t)lroundf(a_q);
+        const uint16_t mv = (uint16_t)lroundf(v_q);
+
+        payload[len++] = (uint8_t)((uint16_t)amps & 0xFFU);
+        payload[len++] = (uint8_t)((uint16_t)amps >> 8);
+        payload[len++] = (uint8_t)(mv & 0xFFU);
+        payload[len++] = (uint8_t)(mv >> 8);
+        payload[len++] = (uint8_t)dt_us;
+
+        prev_us = ts_us;
+        idx++;
+        count++;
+    }
+
+    *out_len = len;
+    *out_t0_us = t0_us;
+    return count;
+}
+
+size_t wf_base64_encode(const uint8_t* in, size_t len, char* out,
+                        size_t out_size) {
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const size_t needed = ((len + 2U) / 3U) * 4U;
+    if (out_size < needed + 1U) {
+        return 0U;
+    }
+
+    size_t o = 0U;
+    size_t i = 0U;
+    for (; i + 2U < len; i += 3U) {
+        const uint32_t v = ((uint32_t)in[i] << 16) |
+                           ((uint32_t)in[i + 1U] << 8) | in[i + 2U];
+        out[o++] = alphabet[(v >> 18) & 0x3FU];
+        out[o++] = alphabet[(v >> 12) & 0x3FU];
+        out[o++] = alphabet[(v >> 6) & 0x3FU];
+        out[o++] = alphabet[v & 0x3FU];
+    }
+    if (i < len) {
+        uint32_t v = (uint32_t)in[i] << 16;
+        if (i + 1U < len) {
+            v |= (uint32_t)in[i + 1U] << 8;
+        }
+        out[o++] = alphabet[(v >> 18) & 0x3FU];
+        out[o++] = alphabet[(v >> 12) & 0x3FU];
+        out[o++] = (i + 1U < len) ? alphabet[(v >> 6) & 0x3FU] : '=';
+        out[o++] = '=';
+    }
+    out[o] = '\0';
+    return o;
+}
@@ -0,0 +1,267 @@
+/**
+ * @file weld_control.c
+ * @brief Hardware-independent weld control decisions (see weld_control.h)
+ */
+
+#include "weld_control.h"
+
+#include <math.h>
+
+uint16_t weld_pct_to_duty(uint8_t pct) {
+    float duty_pct;
+
+    // Empirical calibration from measured 50% power data at constant charge
+    // level:
+    // - duty=723 (70.7%) -> 1502A (~37% of 4033A)
+    // - duty=788 (77.0%) -> 2378A (~59% of 4033A)
+    // - duty=870 (85.0%) -> 2656A (~66% of 4033A)
+    // Target: ~2017A (50% of 4033A)
+    // Linear interpolation between duty=723 and duty=788 gives ~duty=761,
+    // which is ~74% duty at 50% power. Use piecewise-linear mapping around 74%.
+    // Expected duty checkpoints: 25%->379, 50%->757, 75%->890, 100%->1023.
+    if (pct == 0U) {
+        return 0U;
+    } else if (pct <= 50U) {
+        // 0-50% power -> 0-74% duty (linear)
+        duty_pct = ((float)pct / 50.0f) * 0.74f;
+    } else if (pct < 100U) {
+        // 50-100% power -> 74-100% duty (linear)
+        duty_pct = 0.74f + (((float)pct - 50.0f) / 50.0f) * 0.26f;
+    } else {
+        duty_pct = 1.0f;
+    }
+
+    uint16_t duty = (uint16_t)lroundf(duty_pct * (float)WELD_PWM_MAX);
+
+    // Clamp to valid range
+    if (duty > WELD_PWM_MAX) duty = WELD_PWM_MAX;
+
+    return duty;
+}
+
+void joule_build_scale(float ki, float kv, float lead_r_ohms,
+                       float min_current_a, float target_j,
+                       JouleFixedScale* out) {
+    JouleFixedScale sc = {0U, 0U, UINT64_MAX, UINT64_MAX, 0.0f};
+
+    if (isfinite(ki) && isfinite(kv) && ki > 0.0f && kv > 0.0f) {
+        float lead_q16 = (ki * lead_r_ohms / kv) * 65536.0f + 0.5f;
+        if (isfinite(lead_q16) && lead_q16 > 0.0f) {
+            sc.lead_q16 = (lead_q16 < 4294967295.0f) ? (uint32_t)lead_q16
+                                                     : 0xFFFFFFFFUL;
+        }
+
+        float min_counts = ceilf(min_current_a / ki);
+        if (isfinite(min_counts) && min_counts > 0.0f) {
+            sc.min_current_counts =
+                (min_counts < 65535.0f) ? (uint32_t)min_counts : 65535U;
+        }
+
+        sc.joules_per_unit = kv * ki * 1.0e-6f;
+        float cutoff_j = target_j - JOULE_OVERSHOOT_COMP;
+        if (!isfinite(cutoff_j) || cutoff_j < 0.0f) cutoff_j = 0.0f;
+        float cutoff_units = cutoff_j / sc.joules_per_unit;
+        if (isfinite(cutoff_units) && cutoff_units < 1.8e19f) {
+            sc.cutoff_units = (uint64_t)cutoff_units;
+        }
+        if (!isfinite(target_j) || target_j < 0.0f) target_j = 0.0f;
+        float target_units = target_j / sc.joules_per_unit;
+        if (isfinite(target_units) && target_units < 1.8e19f) {
+            sc.target_units = (uint64_t)target_units;
+        }
+    }
+
+    *out = sc;
+}
+
+void joule_reset(JouleControl* jc) {
+    jc->total_units = 0U;
+    jc->loss_units = 0U;
+    jc->work_units = 0U;
+    jc->duration_us = 0U;
+    jc->stop = JOULE_STOP_NONE;
+}
+
+void joule_pulse_begin(JouleControl* jc, const JouleFixedScale* scale,
+                       bool predict, uint32_t nominal_dt_us,
+                       uint32_t horizon_us) {
+    jc->scale = *scale;
+#if JOULE_PREDICTIVE_CUTOFF
+    jc->predict = predict;
+#else
+    (void)predict;
+    jc->predict = false;
+#endif
+    jc->cutoff_units =
+        jc->predict ? jc->scale.target_units : jc->scale.cutoff_units;
+    jc->duration_offset_us = jc->duration_us;
+    jc->last_sample_elapsed_us = 0U;
+    jc->low_current_streak_us = 0U;
+    jc->nominal_dt_us = nominal_dt_us;
+    jc->horizon_us = horizon_us;
+    jc->p_filt = 0;
+    jc->slope_q4 = 0;
+    jc->have_p = false;
+    jc->predict_armed = false;
+    jc->predict_clamped = false;
+    jc->kill_elapsed_us = 0U;
+    jc->last_total_p = 0U;
+    jc->last_loss_p = 0U;
+}
+
+#if JOULE_PREDICTIVE_CUTOFF
+/* Time (µs) until `remaining` energy units are delivered if workpiece power
+ * follows p(t) = p + s * t (p in units/µs, s in units/µs² as Q4).  Solves
+ * p*t + s*t²/2 = remaining in the cancellation-free form
+ * t = 2R / (p + sqrt(p² + 2sR)).  Returns false if power would decay to
+ * zero first.  *out_units is the energy actually projected for the rounded
+ * t. */
+static bool joule_predict_time_us(uint64_t remaining, int32_t p,
+                                  int32_t slope_q4, uint32_t* out_t_us,
+                                  float* out_units) {
+    const float r = (float)remaining;
+    const float pf = (float)p;
+    const float sf = (float)slope_q4 / 16.0f;
+    const float disc = pf * pf + 2.0f * sf * r;
+    if (!isfinite(disc) || disc < 0.0f) {
+        return false;
+    }
+    const float denom = pf + sqrtf(disc);
+    if (!isfinite(denom) || denom <= 0.0f) {
+        return false;
+    }
+    const float t = (2.0f * r) / denom + 0.5f;
+    if (!isfinite(t) || t < 0.0f || t > 4.0e9f) {
+        return false;
+    }
+    *out_t_us = (uint32_t)t;
+    const float tu = (float)*out_t_us;
+    float units = pf * tu + 0.5f * sf * tu * tu;
+    if (!isfinite(units) || units < 0.0f) units = 0.0f;
+    *out_units = units;
+    return true;
+}
+#endif
+
+void joule_sample(JouleControl* jc, uint32_t i_counts, uint32_t vcap_counts,
+                  uint32_t elapsed_us, uint32_t max_us, JouleStep* out) {
+    out->stop = JOULE_STOP_NONE;
+    out->rearm = false;
+    out->kill_in_us = 0U;
+    out->pred_units = 0.0f;
+
+    uint32_t dt_us = elapsed_us - jc->last_sample_elapsed_us;
+    if (dt_us == 0U) {
+        dt_us = jc->nominal_dt_us;
+    }
+    out->dt_us = dt_us;
+    jc->last_sample_elapsed_us = elapsed_us;
+    jc->duration_us = jc->duration_offset_us + elapsed_us;
+
+    /* Real-time Joule integration (lead-compensated), integer domain:
+     * Total power = Vcap * I           -> vcap_counts * i_counts
+     * Lead loss power = I^2 * R_lead   -> i_counts^2 * lead_q16 >> 16
+     * Workpiece power = Total - Lead losses
+     * Each term is scaled by dt_us into uint64 units. */
+    const uint32_t total_p = vcap_counts * i_counts;
+    const uint64_t loss_p =
+        ((uint64_t)(i_counts * i_counts) * jc->scale.lead_q16) >> 16;
+
+    jc->total_units += (uint64_t)total_p * dt_us;
+    jc->loss_units += loss_p * dt_us;
+    if ((uint64_t)total_p > loss_p) {
+        jc->work_units += ((uint64_t)total_p - loss_p) * dt_us;
+    }
+
+#if JOULE_PREDICTIVE_CUTOFF
+    /* 0) Predictive cutoff: once the remaining energy fits inside the
+     * horizon, ask for the hardware kill to land on the projected instant.
+     * Each later sample refines the estimate. */
+    if (jc->predict) {
+        const int32_t work_p = ((uint64_t)total_p > loss_p)
+                                   ? (int32_t)((uint64_t)total_p - loss_p)
+                                   : 0;
+        jc->last_total_p = total_p;
+        jc->last_loss_p = loss_p;
+        if (!jc->have_p) {
+            jc->p_filt = work_p;
+            jc->have_p = true;
+        } else {
+            const int32_t prev_p = jc->p_filt;
+            jc->p_filt += (work_p - jc->p_filt) / 4;
+            const int32_t d_q4 = ((jc->p_filt - prev_p) * 16) / (int32_t)dt_us;
+            jc->slope_q4 += (d_q4 - jc->slope_q4) / 8;
+        }
+
+        uint32_t t_us = 0U;
+        float pred_units = 0.0f;
+        if (jc->work_units < jc->cutoff_units && jc->p_filt > 0 &&
+            (jc->cutoff_units - jc->work_units) <=
+                (uint64_t)jc->p_filt * jc->horizon_us &&
+            joule_predict_time_us(jc->cutoff_units - jc->work_units,
+                                  jc->p_filt, jc->slope_q4, &t_us,
+                                  &pred_units)) {
+            out->rearm = true;
+            out->kill_in_us = (t_us > JOULE_PREDICT_KILL_LEAD_US)
+                                  ? (t_us - JOULE_PREDICT_KILL_LEAD_US)
+                                  : 0U;
+            out->pred_units = (float)jc->work_units + pred_units;
+        }
+    }
+#endif
+
+    /* 1) Highest priority: stop immediately when workpiece target is met. */
+    if (jc->work_units >= jc->cutoff_units) {
+        jc->stop = JOULE_STOP_TARGET;
+        out->stop = jc->stop;
+        return;
+    }
+
+    /* 2) Safety backup timeout (only if energy target did not fire). */
+    if (elapsed_us >= max_us) {
+        jc->stop = JOULE_STOP_TIMEOUT;
+        out->stop = jc->stop;
+        return;
+    }
+
+    /* 3) Bad contact: current too low continuously for too long. */
+    if (i_counts < jc->scale.min_current_counts) {
+        jc->low_current_streak_us += dt_us;
+    } else {
+        jc->low_current_streak_us = 0U;
+    }
+
+    if (jc->low_current_streak_us >= JOULE_BAD_CONTACT_LIMIT_US) {
+        jc->stop = JOULE_STOP_BAD_CONTACT;
+        out->stop = jc->stop;
+    }
+}
+
+void joule_kill_programmed(JouleControl* jc, uint32_t kill_elapsed_us,
+                           bool clamped) {
+    jc->predict_armed = true;
+    jc->predict_clamped = clamped;
+    jc->kill_elapsed_us = kill_elapsed_us;
+}
+
+bool joule_pulse_end(JouleControl* jc) {
+    if (!jc->predict_armed || jc->stop != JOULE_STOP_NONE) {
+        return false;
+    }
+
+    if (jc->kill_elapsed_us > jc->last_sample_elapsed_us) {
+        const uint32_t tail_us = jc->kill_elapsed_us - jc->last_sample_elapsed_us;
+        jc->total_units += (uint64_t)jc->last_total_p * tail_us;
+        jc->loss_units += jc->last_loss_p * tail_us;
+        if ((uint64_t)jc->last_total_p > jc->last_loss_p) {
+            jc->work_units +=
+                ((uint64_t)jc->last_total_p - jc->last_loss_p) * tail_us;
+        }
+        jc->duration_us = jc->duration_offset_us + jc->kill_elapsed_us;
+    }
+    if (jc->predict_clamped) {
+        return false;
+    }
+    jc->stop = JOULE_STOP_TARGET;
+    return true;
+}
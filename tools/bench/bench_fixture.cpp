@@ -0,0 +1,184 @@
+// ============================================================
+//  Bench fixtures — loader and capture packer
+// ============================================================
+
+#include "bench_fixture.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fstream>
+
+// STM32G474CE/src/main.c scales at VDDA = 3.3 V (SHUNT_GAIN, SHUNT_EFF_OHMS,
+// CURRENT_CAL_FACTOR, V_CAP_DIVIDER).
+static const float kDefaultVPerCount     = 3.3f / 4095.0f;
+static const float kDefaultAmpsPerCount  = (kDefaultVPerCount / 8.2f / 0.000050f) * 1.76f;
+static const float kDefaultVoltsPerCount = kDefaultVPerCount * 6.0f;
+
+static bool starts_with(const std::string &s, const char *prefix)
+{
+    return s.compare(0, strlen(prefix), prefix) == 0;
+}
+
+static bool key_float(const std::string &line, const char *key, float *out)
+{
+    size_t pos = line.find(key);
+    if (pos == std::string::npos) return false;
+    *out = strtof(line.c_str() + pos + strlen(key), NULL);
+    return true;
+}
+
+bool bench_fixture_load(const std::string &path, BenchFixture *out, std::string *err)
+{
+    std::ifstream in(path);
+    if (!in) {
+        *err = "cannot open " + path;
+        return false;
+    }
+
+    BenchFixture fx;
+    size_t slash = path.find_last_of("/\\");
+    fx.name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+    fx.amps_per_count  = kDefaultAmpsPerCount;
+    fx.volts_per_count = kDefaultVoltsPerCount;
+
+    unsigned long declared = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+
+        if (starts_with(line, "# scale,")) {
+            float v;
+            if (key_float(line, "amps_per_count=", &v))  fx.amps_per_count = v;
+            if (key_float(line, "volts_per_count=", &v)) fx.volts_per_count = v;
+            if (key_float(line, "lead_r_ohm=", &v))      fx.lead_r_ohm = v;
+            if (key_float(line, "interval_us=", &v))     fx.interval_us = (uint32_t)v;
+        } else if (starts_with(line, "STATUS,") || starts_with(line, "STATUS2,") ||
+                   starts_with(line, "STATUS_DELTA,")) {
+            fx.telemetry.push_back(line);
+            float v;
+            if (fx.lead_r_ohm == 0.0f && key_float(line, ",lead_r_ohm=", &v)) fx.lead_r_ohm = v;
+        } else if (starts_with(line, "WAVEFORM_START,")) {
+            unsigned long f[7] = {0};
+            const char *p = line.c_str() + strlen("WAVEFORM_START,");
+            for (int i = 0; i < 7 && *p; i++) {
+                char *end;
+                f[i] = strtoul(p, &end, 10);
+                p = (*end == ',') ? end + 1 : end;
+            }
+            declared = f[0];
+            fx.pre_start  = (uint16_t)f[1];
+            fx.pre_end    = (uint16_t)f[2];
+            fx.gap_start  = (uint16_t)f[3];
+            fx.gap_end    = (uint16_t)f[4];
+            fx.main_start = (uint16_t)f[5];
+            fx.main_end   = (uint16_t)f[6];
+            fx.ts_us.clear();
+            fx.volts.clear();
+            fx.amps.clear();
+        } else if (starts_with(line, "WAVEFORM_DATA,")) {
+            char *p = (char *)line.c_str() + strlen("WAVEFORM_DATA,");
+            unsigned long start = strtoul(p, &p, 10);
+            if (*p == ',') p++;
+            unsigned long count = strtoul(p, &p, 10);
+            if (start != fx.ts_us.size()) {
+                *err = fx.name + ": WAVEFORM_DATA chunk out of order";
+                return false;
+            }
+            for (unsigned long i = 0; i < count && *p == ','; i++) {
+                uint32_t t = (uint32_t)strtoul(p + 1, &p, 10);
+                if (*p != ',') break;
+                float v = strtof(p + 1, &p);
+                if (*p != ',') break;
+                float a = strtof(p + 1, &p);
+                fx.ts_us.push_back(t);
+                fx.volts.push_back(v);
+                fx.amps.push_back(a);
+            }
+        }
+    }
+
+    if (fx.ts_us.empty()) {
+        *err = fx.name + ": no WAVEFORM_DATA (binary captures are not supported)";
+        return false;
+    }
+    if (fx.ts_us.size() > 0xFFFFU) {
+        *err = fx.name + ": more samples than a uint16_t index";
+        return false;
+    }
+    if (declared != 0 && declared != fx.ts_us.size()) {
+        *err = fx.name + ": WAVEFORM_START sample count does not match the data";
+        return false;
+    }
+    if (fx.interval_us == 0 && fx.ts_us.size() > 1) {
+        fx.interval_us = (fx.ts_us.back() - fx.ts_us.front()) / (uint32_t)(fx.ts_us.size() - 1);
+    }
+    uint16_t n = (uint16_t)fx.ts_us.size();
+    if (fx.main_end == 0 || fx.main_end > n) fx.main_end = n;
+    if (fx.main_start > fx.main_end) fx.main_start = 0;
+
+    *out = fx;
+    return true;
+}
+
+static uint32_t to_counts(float value, float per_count)
+{
+    if (!isfinite(value) || value <= 0.0f || per_count <= 0.0f) return 0U;
+    long c = lroundf(value / per_count);
+    return (c > (long)WAVEFORM_PACK_COUNT_MAX) ? WAVEFORM_PACK_COUNT_MAX : (uint32_t)c;
+}
+
+void bench_capture_store(const BenchFixture &fx, BenchCapture *out)
+{
+    const uint16_t n = (uint16_t)fx.ts_us.size();
+    out->count = n;
+    out->amps_per_count  = fx.amps_per_count;
+    out->volts_per_count = fx.volts_per_count;
+
+#if WAVEFORM_PACKED_STORAGE
+    // Same block rule as waveform_push_sample().
+    out->words.assign(n, 0U);
+    out->blocks.clear();
+    uint32_t prev_us = 0;
+    for (uint16_t i = 0; i < n; i++) {
+        const uint32_t ts = fx.ts_us[i];
+        const uint32_t dt_us = ts - prev_us;
+        const bool new_block = (i % WAVEFORM_TS_BLOCK_SAMPLES) == 0U || dt_us > WAVEFORM_PACK_DT_MAX;
+        if (new_block) {
+            WaveformTsBlock b;
+            b.first_index = i;
+            b.t0_us = ts;
+            out->blocks.push_back(b);
+        }
+        out->words[i] = to_counts(fx.amps[i], fx.amps_per_count) |
+                        (to_counts(fx.volts[i], fx.volts_per_count) << 12) |
+                        ((new_block ? 0U : dt_us) << 24);
+        prev_us = ts;
+    }
+#else
+    out->samples.resize(n);
+    for (uint16_t i = 0; i < n; i++) {
+        // Quantised as the firmware stores a count * scale.
+        out->samples[i].current_amps  = (float)to_counts(fx.amps[i], fx.amps_per_count) * fx.amps_per_count;
+        out->samples[i].voltage_volts = (float)to_counts(fx.volts[i], fx.volts_per_count) * fx.volts_per_count;
+        out->samples[i].timestamp_us  = fx.ts_us[i];
+    }
+#endif
+}
+
+WaveformView BenchCapture::view()
+{
+    WaveformView w;
+#if WAVEFORM_PACKED_STORAGE
+    w.words = words.data();
+    w.blocks = blocks.data();
+    w.block_count = (uint16_t)blocks.size();
+#else
+    w.samples = samples.data();
+#endif
+    w.count = count;
+    w.amps_per_count = amps_per_count;
+    w.volts_per_count = volts_per_count;
+    return w;
+}
@@ -0,0 +1,60 @@
+// ============================================================
+//  Bench fixtures — one weld as the P4 relays it
+// ============================================================
+// A fixture is a text file of STM32 wire lines (PROTOCOL.md): STATUS /
+// STATUS2 / STATUS_DELTA telemetry plus one WAVEFORM_START / WAVEFORM_DATA /
+// WAVEFORM_END burst (CSV format). Lines starting with '#' are comments; an
+// optional "# scale,amps_per_count=..,volts_per_count=..,lead_r_ohm=..,
+// interval_us=.." line carries the capture scales (defaults: main.c at
+// VDDA = 3.3 V). Anything else (EVENT, WAVEFORM_PHASES, ...) is ignored, so a
+// capture from the TCP bridge or the waveform history can be dropped in.
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "waveform_kernels.h"
+
+struct BenchFixture {
+    std::string name;
+
+    // WAVEFORM_DATA triplets, in sample order.
+    std::vector<uint32_t> ts_us;
+    std::vector<float>    volts;
+    std::vector<float>    amps;
+
+    // WAVEFORM_START sample indices.
+    uint16_t pre_start = 0, pre_end = 0;
+    uint16_t gap_start = 0, gap_end = 0;
+    uint16_t main_start = 0, main_end = 0;
+
+    float    amps_per_count  = 0.0f;
+    float    volts_per_count = 0.0f;
+    float    lead_r_ohm      = 0.0f;
+    uint32_t interval_us     = 0;
+
+    std::vector<std::string> telemetry;   // STATUS / STATUS2 / STATUS_DELTA
+};
+
+// False (with *err set) if the file cannot be read or holds no waveform.
+bool bench_fixture_load(const std::string &path, BenchFixture *out, std::string *err);
+
+// The fixture re-stored the way waveform_push_sample() stores a live capture
+// (packed counts + timestamp blocks, or the legacy float layout), so the
+// kernels see exactly what they see on the STM32.
+struct BenchCapture {
+#if WAVEFORM_PACKED_STORAGE
+    std::vector<uint32_t>        words;
+    std::vector<WaveformTsBlock> blocks;
+#else
+    std::vector<WaveformSample>  samples;
+#endif
+    uint16_t count = 0;
+    float    amps_per_count  = 0.0f;
+    float    volts_per_count = 0.0f;
+
+    WaveformView view();
+};
+
+void bench_capture_store(const BenchFixture &fx, BenchCapture *out);
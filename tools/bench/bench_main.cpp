@@ -0,0 +1,538 @@
+// ============================================================
+//  Host microbenchmark — STM32 waveform + P4 telemetry kernels
+// ============================================================
+// Times the firmware's per-weld and per-packet hot paths on the host, on
+// recorded weld fixtures (see bench_fixture.h), and reports ns (and TSC
+// ticks on x86) per unit of work. The kernels are the firmware's own
+// translation units:
+//   STM32G474CE/src/waveform_kernels.c  (phase edges, Vcap interpolation,
+//                                        tip-energy integration, CSV/BIN)
+//   ESP32P4/main/telemetry_parse.cpp    (STATUS tokenizer, enrichment,
+//                                        voltage smoother)
+//
+// Absolute ns depend on the host, so budgets.txt holds each kernel's cost as
+// a RATIO to ref_loop (a fixed scalar pass over the same capture) and
+// --check fails when a kernel exceeds its budget. Usage:
+//   waveform_bench [--check] [--budgets FILE] [--record FILE]
+//                  [--min-ms N] [fixture.txt | dir]...
+// With no fixtures, every *.txt in the built-in fixture directory is run.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#else
+#define BENCH_HAVE_TSC 0
+#endif
+
+#include "bench_fixture.h"
+#include "telemetry_parse.h"
+#include "waveform_kernels.h"
+
+#ifndef BENCH_FIXTURE_DIR
+#define BENCH_FIXTURE_DIR "fixtures"
+#endif
+
+// Headroom --record puts on top of the measured ratio.
+static const double kRecordHeadroom = 1.6;
+
+// STM32G474CE/src/main.c
+static const float kPhaseStartMinCurrentA = 50.0f;   // PHASE_START_MIN_CURRENT_A
+static const float kPhaseStartPeakRatio   = 0.10f;   // PHASE_START_PEAK_RATIO
+static const size_t kCsvLineSize = WAVEFORM_CHUNK_SAMPLES * 18 + 256;  // WAVEFORM_LINE_BUFFER_SIZE
+
+// enrich_refresh_tail() output as seen on a bench unit.
+static const char kEnrichTail[] =
+    ",wifi_connected=1,wifi_ap_mode=0,wifi_ssid=Workshop,wifi_ip=192.168.1.57,wifi_rssi=-61"
+    ",fw_version=1.0.0,chip_model=esp32p4,flash_size=16777216,free_heap=23456789,uptime_s=3600";
+
+static volatile uint64_t g_sink;
+
+static inline void bench_barrier(void)
+{
+#if defined(__GNUC__)
+    __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+// ============================================================
+//  TIMING
+// ============================================================
+struct Timing {
+    double ns_per_unit;
+    double tsc_per_unit;  // 0 without a TSC
+};
+
+static uint64_t now_ns(void)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t now_tsc(void)
+{
+#if BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Best batch wins: batches of back-to-back calls (each batch >= ~0.2 ms) are
+// repeated for at least min_ms, and the fastest batch is reported. That is
+// the least noisy estimate on a shared machine.
+template <class F>
+static Timing time_kernel(F &&fn, size_t units_per_call, double min_ms)
+{
+    size_t calls = 1;
+    for (;;) {
+        uint64_t t0 = now_ns();
+        for (size_t i = 0; i < calls; i++) fn();
+        if (now_ns() - t0 >= 200000 || calls >= (1u << 24)) break;
+        calls *= 2;
+    }
+
+    double best_ns = 1e300, best_tsc = 0;
+    uint64_t start = now_ns();
+    int batches = 0;
+    while (batches < 5 || (double)(now_ns() - start) < min_ms * 1e6) {
+        uint64_t c0 = now_tsc();
+        uint64_t t0 = now_ns();
+        for (size_t i = 0; i < calls; i++) fn();
+        uint64_t t1 = now_ns();
+        uint64_t c1 = now_tsc();
+        double ns = (double)(t1 - t0) / (double)calls;
+        if (ns < best_ns) {
+            best_ns = ns;
+            best_tsc = (double)(c1 - c0) / (double)calls;
+        }
+        batches++;
+    }
+
+    double units = (double)(units_per_call ? units_per_call : 1);
+    Timing t = { best_ns / units, best_tsc / units };
+    return t;
+}
+
+// ============================================================
+//  REFERENCE LOOP
+// ============================================================
+// One load, one convert and one dependent float add per sample: a cost that
+// moves with the host's clock and memory, not with the kernels under test.
+__attribute__((noinline)) static float ref_loop(const WaveformView *w)
+{
+    float acc = 0.0f;
+    for (uint16_t i = 0; i < w->count; i++) {
+#if WAVEFORM_PACKED_STORAGE
+        acc += (float)(w->words[i] & WAVEFORM_PACK_COUNT_MAX) * w->amps_per_count;
+#else
+        acc += w->samples[i].current_amps;
+#endif
+    }
+    return acc;
+}
+
+// ============================================================
+//  BUDGETS
+// ============================================================
+typedef std::map<std::string, double> Budgets;
+
+static bool load_budgets(const std::string &path, Budgets *out)
+{
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::istringstream ss(line);
+        std::string name;
+        double ratio;
+        if (ss >> name >> ratio) (*out)[name] = ratio;
+    }
+    return true;
+}
+
+static bool write_budgets(const std::string &path, const Budgets &ratios)
+{
+    FILE *f = fopen(path.c_str(), "w");
+    if (!f) return false;
+    fprintf(f, "# Per-kernel cost budget: max ratio of ns per unit to ref_loop's ns per\n"
+               "# sample, over all fixtures. Written by waveform_bench --record (measured\n"
+               "# ratio x %.1f); checked by waveform_bench --check (ctest).\n", kRecordHeadroom);
+    for (const auto &kv : ratios) {
+        fprintf(f, "%-16s %8.2f\n", kv.first.c_str(), kv.second * kRecordHeadroom);
+    }
+    fclose(f);
+    return true;
+}
+
+// ============================================================
+//  PER-FIXTURE RUN
+// ============================================================
+struct BenchContext {
+    double   min_ms = 20.0;
+    bool     check = false;
+    Budgets  budgets;
+    Budgets  recorded;   // max measured ratio per kernel
+    int      failures = 0;
+};
+
+static void report(BenchContext *ctx, const char *kernel, const char *unit,
+                   const Timing &t, double ref_ns)
+{
+    double ratio = t.ns_per_unit / ref_ns;
+    double &rec = ctx->recorded[kernel];
+    rec = std::max(rec, ratio);
+
+    char tsc[16] = "-";
+    if (BENCH_HAVE_TSC) snprintf(tsc, sizeof(tsc), "%.1f", t.tsc_per_unit);
+
+    auto it = ctx->budgets.find(kernel);
+    const char *verdict = "";
+    char budget[16] = "-";
+    if (it != ctx->budgets.end()) {
+        snprintf(budget, sizeof(budget), "%.2f", it->second);
+        if (ctx->check && ratio > it->second) {
+            verdict = "  OVER BUDGET";
+            ctx->failures++;
+        }
+    } else if (ctx->check && strcmp(kernel, "ref_loop") != 0) {
+        verdict = "  NO BUDGET";
+        ctx->failures++;
+    }
+    printf("  %-14s %-7s %10.2f %9s %8.2f %8s%s\n",
+           kernel, unit, t.ns_per_unit, tsc, ratio, budget, verdict);
+}
+
+static void sanity(BenchContext *ctx, bool ok, const char *what)
+{
+    if (ok) return;
+    printf("  FAIL: %s\n", what);
+    ctx->failures++;
+}
+
+static void run_fixture(BenchContext *ctx, const BenchFixture &fx)
+{
+    BenchCapture cap;
+    bench_capture_store(fx, &cap);
+    WaveformView w = cap.view();
+
+    const uint16_t n = w.count;
+    const uint16_t m0 = fx.main_start, m1 = fx.main_end;
+    const float nominal_dt_s = (float)fx.interval_us * 1.0e-6f;
+
+    size_t status_lines = 0;
+    for (const std::string &l : fx.telemetry) {
+        if (status_packet_kind(l.c_str()) == STATUS_PKT_MAIN) status_lines++;
+    }
+
+    printf("\n%s: %u samples @ %" PRIu32 " us, main [%u, %u), %zu telemetry lines\n",
+           fx.name.c_str(), (unsigned)n, fx.interval_us, (unsigned)m0, (unsigned)m1,
+           fx.telemetry.size());
+
+    // ---- What the kernels compute (so a no-op cannot pass as fast) ----
+    uint16_t edge_first = 0, edge_last = 0;
+    bool has_first = wf_find_phase_edge(&w, m0, m1, false, kPhaseStartPeakRatio,
+                                        kPhaseStartMinCurrentA, &edge_first);
+    bool has_last = wf_find_phase_edge(&w, m0, m1, true, kPhaseStartPeakRatio,
+                                       kPhaseStartMinCurrentA, &edge_last);
+    WaveformPulseStats ps;
+    wf_integrate_pulse(&w, m0, m1, fx.lead_r_ohm, nominal_dt_s, &ps);
+    printf("  main edges %u..%u, %.3f J at the tips over %.2f ms (lead_r %.6f ohm)\n",
+           (unsigned)edge_first, (unsigned)edge_last, (double)ps.energy_j,
+           (double)ps.duration_s * 1e3, (double)fx.lead_r_ohm);
+    sanity(ctx, has_first && has_last && edge_first <= edge_last, "no current in the main window");
+    sanity(ctx, ps.energy_j > 0.0f, "zero pulse energy");
+
+    WaveformPulseAnalytics pa;
+    wf_analyze_pulse(&w, m0, m1, fx.lead_r_ohm, nominal_dt_s, &pa);
+    printf("  analytics %.3f J, dI/dt %.2f A/us, contact %.3f -> %.3f mOhm\n",
+           (double)pa.pulse.energy_j, (double)pa.didt_a_per_us, (double)pa.r_start_ohms * 1e3,
+           (double)pa.r_end_ohms * 1e3);
+    sanity(ctx, fabsf(pa.pulse.energy_j - ps.energy_j) <= 1e-4f * ps.energy_j &&
+                    fabsf(pa.pulse.sum_amps - ps.sum_amps) <= 1e-4f * ps.sum_amps &&
+                    fabsf(pa.pulse.duration_s - ps.duration_s) <= 1e-6f &&
+                    pa.pulse.samples == ps.samples,
+           "analytics disagree with integrate");
+
+    static char line[kCsvLineSize];
+    size_t csv_bytes = 0;
+    for (uint16_t s = 0; s < n; s = (uint16_t)(s + WAVEFORM_CHUNK_SAMPLES)) {
+        uint16_t c = (uint16_t)std::min<unsigned>(WAVEFORM_CHUNK_SAMPLES, (unsigned)(n - s));
+        int len = wf_format_csv_chunk(&w, s, c, line, sizeof(line));
+        sanity(ctx, len > 0, "WAVEFORM_DATA chunk truncated");
+        if (len > 0) csv_bytes += (size_t)len;
+    }
+    uint8_t payload[WAVEFORM_BIN_PAYLOAD_SIZE];
+    char b64[((WAVEFORM_BIN_PAYLOAD_SIZE + 2) / 3) * 4 + 1];
+    size_t bin_chunks = 0, bin_bytes = 0;
+    for (uint16_t s = 0; s < n;) {
+        size_t plen;
+        uint32_t t0;
+        uint16_t c = wf_pack_bin_chunk(&w, s, payload, &plen, &t0);
+        bin_bytes += wf_base64_encode(payload, plen, b64, sizeof(b64));
+        bin_chunks++;
+        s = (uint16_t)(s + c);
+    }
+    printf("  WAVEFORM_DATA %zu bytes, WAVEFORM_BIN %zu chunks / %zu base64 bytes\n",
+           csv_bytes, bin_chunks, bin_bytes);
+
+    const uint16_t buckets = (uint16_t)std::min<unsigned>(WAVEFORM_SUMMARY_BUCKETS, n);
+    size_t env_bytes = 0;
+    for (uint16_t b = 0; b < buckets; b = (uint16_t)(b + WAVEFORM_ENV_CHUNK_BUCKETS)) {
+        uint16_t c = (uint16_t)std::min<unsigned>(WAVEFORM_ENV_CHUNK_BUCKETS, (unsigned)(buckets - b));
+        int len = wf_format_env_chunk(&w, buckets, b, c, line, sizeof(line));
+        sanity(ctx, len > 0, "WAVEFORM_ENV chunk truncated");
+        if (len > 0) env_bytes += (size_t)len;
+    }
+    WaveformPhaseStats mps;
+    wf_phase_stats(&w, m0, m1, fx.lead_r_ohm, nominal_dt_s, &mps);
+    printf("  WAVEFORM_ENV %u buckets / %zu bytes, main %.1f A rms, %.1f A peak @ %u\n",
+           (unsigned)buckets, env_bytes, (double)mps.rms_amps, (double)mps.peak_amps,
+           (unsigned)mps.peak_index);
+    sanity(ctx, mps.energy_j == pa.pulse.energy_j, "phase stats energy differs from analytics");
+    sanity(ctx, mps.peak_amps >= mps.rms_amps && mps.rms_amps > 0.0f, "bad main RMS / peak");
+
+    size_t parsed_fields = 0;
+    for (const std::string &l : fx.telemetry) {
+        StatusFields f;
+        status_fields_parse(l.c_str(), &f);
+        parsed_fields += (size_t)__builtin_popcountll(f.present);
+    }
+    sanity(ctx, fx.telemetry.empty() || parsed_fields > 0, "no telemetry fields parsed");
+
+    // ---- Timings ----
+    printf("  %-14s %-7s %10s %9s %8s %8s\n", "kernel", "unit", "ns/unit", "tsc/unit", "ratio", "budget");
+
+    Timing ref = time_kernel([&] { float a = ref_loop(&w); g_sink += (uint64_t)a; }, n, ctx->min_ms);
+    const double ref_ns = ref.ns_per_unit;
+    report(ctx, "ref_loop", "sample", ref, ref_ns);
+
+    report(ctx, "sample_ts", "sample", time_kernel([&] {
+        uint32_t acc = 0;
+        for (uint16_t i = 0; i < n; i++) acc += wf_sample_ts_us(&w, i);
+        g_sink += acc;
+    }, n, ctx->min_ms), ref_ns);
+
+    if (m1 > m0) {
+        report(ctx, "phase_edges", "sample", time_kernel([&] {
+            uint16_t a = 0, b = 0;
+            wf_find_phase_edge(&w, m0, m1, false, kPhaseStartPeakRatio, kPhaseStartMinCurrentA, &a);
+            wf_find_phase_edge(&w, m0, m1, true, kPhaseStartPeakRatio, kPhaseStartMinCurrentA, &b);
+            g_sink += (uint64_t)a + b;
+        }, m1 - m0, ctx->min_ms), ref_ns);
+
+        report(ctx, "integrate", "sample", time_kernel([&] {
+            WaveformPulseStats s;
+            wf_integrate_pulse(&w, m0, m1, fx.lead_r_ohm, nominal_dt_s, &s);
+            g_sink += (uint64_t)s.energy_j;
+        }, m1 - m0, ctx->min_ms), ref_ns);
+
+        report(ctx, "analyze", "sample", time_kernel([&] {
+            WaveformPulseAnalytics s;
+            wf_analyze_pulse(&w, m0, m1, fx.lead_r_ohm, nominal_dt_s, &s);
+            g_sink += (uint64_t)s.pulse.energy_j + s.peak_index;
+        }, m1 - m0, ctx->min_ms), ref_ns);
+
+        report(ctx, "phase_stats", "sample", time_kernel([&] {
+            WaveformPhaseStats s;
+            wf_phase_stats(&w, m0, m1, fx.lead_r_ohm, nominal_dt_s, &s);
+            g_sink += (uint64_t)s.energy_j + s.peak_index;
+        }, m1 - m0, ctx->min_ms), ref_ns);
+    }
+
+    {
+        BenchCapture scratch = cap;
+        WaveformView sw = scratch.view();
+        const float v0 = wf_sample_volts(&w, 0);
+        const float v1 = wf_sample_volts(&w, (uint16_t)(n - 1U));
+        report(ctx, "interpolate", "sample", time_kernel([&] {
+            wf_interpolate_volts(&sw, v0, v1, fx.pre_start ? fx.pre_start : m0, m1);
+            bench_barrier();
+        }, n, ctx->min_ms), ref_ns);
+    }
+
+    report(ctx, "csv_chunks", "sample", time_kernel([&] {
+        for (uint16_t s = 0; s < n; s = (uint16_t)(s + WAVEFORM_CHUNK_SAMPLES)) {
+            uint16_t c = (uint16_t)std::min<unsigned>(WAVEFORM_CHUNK_SAMPLES, (unsigned)(n - s));
+            g_sink += (uint64_t)wf_format_csv_chunk(&w, s, c, line, sizeof(line));
+        }
+    }, n, ctx->min_ms), ref_ns);
+
+    report(ctx, "envelope", "sample", time_kernel([&] {
+        for (uint16_t b = 0; b < buckets; b = (uint16_t)(b + WAVEFORM_ENV_CHUNK_BUCKETS)) {
+            uint16_t c = (uint16_t)std::min<unsigned>(WAVEFORM_ENV_CHUNK_BUCKETS, (unsigned)(buckets - b));
+            g_sink += (uint64_t)wf_format_env_chunk(&w, buckets, b, c, line, sizeof(line));
+        }
+    }, n, ctx->min_ms), ref_ns);
+
+    report(ctx, "bin_chunks", "sample", time_kernel([&] {
+        for (uint16_t s = 0; s < n;) {
+            size_t plen;
+            uint32_t t0;
+            uint16_t c = wf_pack_bin_chunk(&w, s, payload, &plen, &t0);
+            g_sink += wf_base64_encode(payload, plen, b64, sizeof(b64));
+            s = (uint16_t)(s + c);
+        }
+    }, n, ctx->min_ms), ref_ns);
+
+    if (fx.telemetry.empty()) return;
+
+    report(ctx, "status_parse", "line", time_kernel([&] {
+        for (const std::string &l : fx.telemetry) {
+            StatusFields f;
+            status_fields_parse(l.c_str(), &f);
+            g_sink += f.present;
+        }
+    }, fx.telemetry.size(), ctx->min_ms), ref_ns);
+
+    if (status_lines) {
+        std::vector<StatusFields> fields;
+        for (const std::string &l : fx.telemetry) {
+            if (status_packet_kind(l.c_str()) != STATUS_PKT_MAIN) continue;
+            StatusFields f;
+            status_fields_parse(l.c_str(), &f);
+            fields.push_back(f);
+        }
+        static char out[1024];
+        const StatusEnrichValues v = { 41.2f, 35.7f, 5.5f, 1234 };
+        report(ctx, "status_enrich", "line", time_kernel([&] {
+            size_t k = 0;
+            for (const std::string &l : fx.telemetry) {
+                if (status_packet_kind(l.c_str()) != STATUS_PKT_MAIN) continue;
+                g_sink += status_enrich_line(l.c_str(), fields[k++], v, kEnrichTail,
+                                             sizeof(kEnrichTail) - 1, out, sizeof(out));
+            }
+        }, status_lines, ctx->min_ms), ref_ns);
+    }
+
+    {
+        // What parse_status_line() feeds the smoother from STATUS / STATUS2.
+        std::vector<std::pair<int, float>> cells;
+        for (const std::string &l : fx.telemetry) {
+            StatusFields f;
+            status_fields_parse(l.c_str(), &f);
+            if (SF_HAS(f, vpack)) cells.push_back({ CH_VPACK, f.vpack });
+            if (SF_HAS(f, vcap))  cells.push_back({ CH_VCAP, f.vcap });
+            if (SF_HAS(f, cell1)) cells.push_back({ CH_CELL1, f.cell1 });
+            if (SF_HAS(f, cell2)) cells.push_back({ CH_CELL2, f.cell2 });
+            if (SF_HAS(f, cell3)) cells.push_back({ CH_CELL3, f.cell3 });
+        }
+        if (!cells.empty()) {
+            VoltageDisplaySmoother sm(0.005f);
+            report(ctx, "smoother", "value", time_kernel([&] {
+                float acc = 0.0f;
+                for (const auto &c : cells) acc += sm.getDisplayValue(c.first, c.second);
+                g_sink += (uint64_t)acc;
+            }, cells.size(), ctx->min_ms), ref_ns);
+        }
+    }
+}
+
+// ============================================================
+//  MAIN
+// ============================================================
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [--check] [--budgets FILE] [--record FILE] [--min-ms N] [fixture.txt | dir]...\n",
+            argv0);
+}
+
+int main(int argc, char **argv)
+{
+    BenchContext ctx;
+    std::string budgets_path, record_path;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--check") {
+            ctx.check = true;
+        } else if (a == "--budgets" && i + 1 < argc) {
+            budgets_path = argv[++i];
+        } else if (a == "--record" && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (a == "--min-ms" && i + 1 < argc) {
+            ctx.min_ms = atof(argv[++i]);
+        } else if (!a.empty() && a[0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            inputs.push_back(a);
+        }
+    }
+    if (inputs.empty()) inputs.push_back(BENCH_FIXTURE_DIR);
+
+    if (!budgets_path.empty() && !load_budgets(budgets_path, &ctx.budgets)) {
+        fprintf(stderr, "cannot read budgets %s\n", budgets_path.c_str());
+        return 2;
+    }
+    if (ctx.check && ctx.budgets.empty()) {
+        fprintf(stderr, "--check needs a non-empty --budgets file\n");
+        return 2;
+    }
+
+    std::vector<std::string> files;
+    for (const std::string &in : inputs) {
+        std::error_code ec;
+        if (std::filesystem::is_directory(in, ec)) {
+            std::vector<std::string> dir;
+            for (const auto &e : std::filesystem::directory_iterator(in, ec)) {
+                if (e.path().extension() == ".txt") dir.push_back(e.path().string());
+            }
+            std::sort(dir.begin(), dir.end());
+            files.insert(files.end(), dir.begin(), dir.end());
+        } else {
+            files.push_back(in);
+        }
+    }
+    if (files.empty()) {
+        fprintf(stderr, "no fixtures\n");
+        return 2;
+    }
+
+    printf("waveform_bench: %s storage, %s\n",
+           WAVEFORM_PACKED_STORAGE ? "packed" : "legacy float",
+           BENCH_HAVE_TSC ? "tsc = rdtsc ticks" : "no tsc");
+
+    for (const std::string &path : files) {
+        BenchFixture fx;
+        std::string err;
+        if (!bench_fixture_load(path, &fx, &err)) {
+            printf("\nFAIL: %s\n", err.c_str());
+            ctx.failures++;
+            continue;
+        }
+        run_fixture(&ctx, fx);
+    }
+
+    if (!record_path.empty()) {
+        ctx.recorded.erase("ref_loop");
+        if (!write_budgets(record_path, ctx.recorded)) {
+            fprintf(stderr, "cannot write %s\n", record_path.c_str());
+            return 2;
+        }
+        printf("\nbudgets recorded to %s\n", record_path.c_str());
+    }
+
+    if (ctx.failures) {
+        printf("\n%d failure(s)\n", ctx.failures);
+        return 1;
+    }
+    return 0;
+}
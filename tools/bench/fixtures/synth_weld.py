@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""Synthesize a weld fixture for tools/bench in the STM32 wire format.
+
+The output is what the P4 relays for one weld (STATUS / STATUS2 /
+STATUS_DELTA telemetry, then WAVEFORM_START / WAVEFORM_DATA / WAVEFORM_END /
+WAVEFORM_PHASES), so a real capture from the TCP bridge or the waveform
+history can replace it line for line. Samples come from a simple RC model
+(cap bank discharging into lead + workpiece resistance through an AMC1301
+shunt channel) and are quantised to ADC counts the way the firmware stores
+them. Deterministic: same arguments, same file.
+
+  python3 synth_weld.py --interval-us 20 --out weld_dma_50khz.txt
+  python3 synth_weld.py --interval-us 100 --polled --out weld_polled_10khz.txt
+"""
+
+import argparse
+import math
+import random
+
+# STM32G474CE/src/main.c (VDDA nominal)
+VDDA = 3.3
+V_PER_COUNT = VDDA / 4095.0
+AMPS_PER_COUNT = (V_PER_COUNT / 8.2 / 0.000050) * 1.76  # SHUNT_GAIN, SHUNT_EFF_OHMS, CURRENT_CAL_FACTOR
+VOLTS_PER_COUNT = V_PER_COUNT * 6.0                      # V_CAP_DIVIDER
+CHUNK = 100                                              # WAVEFORM_CHUNK_SAMPLES
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--interval-us", type=int, default=20)
+    ap.add_argument("--polled", action="store_true",
+                    help="no per-sample Vcap (interpolated, as the polled path sends it)")
+    ap.add_argument("--vcap", type=float, default=9.6)
+    ap.add_argument("--cap-f", type=float, default=6.0, help="bank capacitance")
+    ap.add_argument("--r-ohm", type=float, default=0.0045, help="total loop resistance")
+    ap.add_argument("--lead-r", type=float, default=0.0012)
+    ap.add_argument("--pre-ms", type=float, default=2.0)
+    ap.add_argument("--preheat-ms", type=float, default=2.0)
+    ap.add_argument("--preheat-pct", type=int, default=30)
+    ap.add_argument("--gap-ms", type=float, default=2.0)
+    ap.add_argument("--main-ms", type=float, default=8.0)
+    ap.add_argument("--post-ms", type=float, default=5.0)
+    ap.add_argument("--stall-every", type=int, default=0,
+                    help="insert a 300 us sampling stall every N samples (0 = none)")
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("--out", required=True)
+    a = ap.parse_args()
+
+    rnd = random.Random(a.seed)
+    dt = a.interval_us
+    n_pre = int(a.pre_ms * 1000 / dt)
+    n_ph = int(a.preheat_ms * 1000 / dt)
+    n_gap = int(a.gap_ms * 1000 / dt)
+    n_main = int(a.main_ms * 1000 / dt)
+    n_post = int(a.post_ms * 1000 / dt)
+
+    # Phase boundaries (sample indices), as in WAVEFORM_START.
+    pre_start, pre_end = n_pre, n_pre + n_ph
+    gap_start, gap_end = pre_end, pre_end + n_gap
+    main_start, main_end = gap_end, gap_end + n_main
+    total = main_end + n_post
+
+    samples = []
+    vcap = a.vcap
+    vcap_start = vcap
+    t_us = 0
+    for i in range(total):
+        if a.stall_every and i and i % a.stall_every == 0:
+            t_us += 300
+        if pre_start <= i < pre_end:
+            duty = a.preheat_pct / 100.0
+        elif main_start <= i < main_end:
+            duty = 1.0
+        else:
+            duty = 0.0
+        amps = (vcap / a.r_ohm) * duty if duty > 0 else 0.0
+        amps += rnd.gauss(0.0, 6.0)
+        vcap -= max(amps, 0.0) * (dt * 1e-6) / a.cap_f
+        v_meas = vcap - max(amps, 0.0) * 0.0004 + rnd.gauss(0.0, 0.004)  # ESR sag
+        a_counts = min(max(int(amps / AMPS_PER_COUNT + 0.5), 0), 0xFFF)
+        v_counts = min(max(int(v_meas / VOLTS_PER_COUNT + 0.5), 0), 0xFFF)
+        samples.append([t_us, v_counts * VOLTS_PER_COUNT, a_counts * AMPS_PER_COUNT])
+        t_us += dt
+
+    if a.polled:
+        # apply_waveform_voltage_interpolation(): hold / linear ramp / hold.
+        vcap_end = vcap
+        span = max(main_end - pre_start, 1)
+        for i, s in enumerate(samples):
+            if i < pre_start:
+                s[1] = vcap_start
+            elif i < main_end:
+                s[1] = vcap_start - (vcap_start - vcap_end) * (i - pre_start) / span
+            else:
+                s[1] = vcap_end
+            s[1] = int(s[1] / VOLTS_PER_COUNT + 0.5) * VOLTS_PER_COUNT
+
+    def t_rel(idx):
+        return samples[idx][0] if idx < total else samples[-1][0] + dt
+
+    with open(a.out, "w", newline="\n") as f:
+        f.write("# synthesized by synth_weld.py %s\n" % " ".join(
+            "--%s=%s" % (k.replace("_", "-"), v) for k, v in sorted(vars(a).items()) if k != "out"))
+        f.write("# scale,amps_per_count=%.6f,volts_per_count=%.7f,lead_r_ohm=%.6f,interval_us=%d\n"
+                % (AMPS_PER_COUNT, VOLTS_PER_COUNT, a.lead_r, dt))
+        for k in range(8):
+            f.write("STATUS,armed=1,ready=1,welding=0,vcap=%.2f,temp=%.2f,mode=2,d1=%d,gap1=%d,"
+                    "d2=%d,gap2=0,d3=0,power=80.00,preheat_en=1,preheat_ms=%d,preheat_pct=%d,"
+                    "preheat_gap_ms=%d,trigger_mode=1,contact_hold_steps=2,contact_with_pedal=1,"
+                    "vdda=3.300,lead_r_ohm=%.6f,control_mode=0,joule_target_j=0.0,joule_max_ms=50,"
+                    "caps=1,wf_fmt=0\n"
+                    % (a.vcap + rnd.gauss(0, 0.01), 31.0 + 0.1 * k, int(a.preheat_ms), int(a.gap_ms),
+                       int(a.main_ms), int(a.preheat_ms), a.preheat_pct, int(a.gap_ms), a.lead_r))
+            f.write("STATUS2,ina_ok=1,chg_en=%d,vpack=%.2f,vlow=%.2f,vmid=%.2f,cell1=%.2f,"
+                    "cell2=%.2f,cell3=%.2f,ichg=%.2f\n"
+                    % (k & 1, 12.40 + rnd.gauss(0, 0.004), 4.13, 8.27,
+                       4.13 + rnd.gauss(0, 0.003), 4.14 + rnd.gauss(0, 0.003),
+                       4.13 + rnd.gauss(0, 0.003), 0.52 * (k & 1)))
+            f.write("STATUS_DELTA,seq=%d,armed=1,ready=1,welding=0,contact=%d,fault=0\n"
+                    % (k, k >= 6))
+        f.write("WAVEFORM_START,%d,%d,%d,%d,%d,%d,%d\n"
+                % (total, pre_start, pre_end, gap_start, gap_end, main_start, main_end))
+        for start in range(0, total, CHUNK):
+            chunk = samples[start:start + CHUNK]
+            f.write("WAVEFORM_DATA,%d,%d" % (start, len(chunk)))
+            for t, v, i in chunk:
+                f.write(",%d,%.2f,%.2f" % (t, v, i))
+            f.write("\n")
+        f.write("WAVEFORM_END\n")
+        f.write("WAVEFORM_PHASES,preheat_start=%d,preheat_end=%d,gap_start=%d,gap_end=%d,"
+                "main_start=%d,main_end=%d\n"
+                % (t_rel(pre_start), t_rel(pre_end), t_rel(gap_start), t_rel(gap_end),
+                   t_rel(main_start), t_rel(main_end)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,191 @@
+// ============================================================
+//  Weld simulator — recipe sequencer + sampling loop
+// ============================================================
+
+#include "weld_sim.h"
+
+#include <algorithm>
+
+WeldResult WeldSim::run(const SimRecipe &r, const PlantParams &plant, const ContactModel *contact,
+                        std::mt19937 &rng)
+{
+    res_ = WeldResult();
+    r_ = &r;
+    plant_.reset(plant, contact);
+    t_weld_us_ = 0U;
+    joule_reset(&ctl_);
+
+    auto gap = [&](uint16_t ms) {
+        // tim2_delay_us() minus GAP_TIMING_COMPENSATION_US, which exists to
+        // make the FET-off -> FET-on gap match the configured one.
+        t_weld_us_ += (uint32_t)std::min<uint16_t>(ms, SIM_MAX_WELD_MS) * 1000U;
+    };
+    auto stop_requested = [&]() { return r.joule && ctl_.stop != JOULE_STOP_NONE; };
+
+    // Preheat (joule mode integrates it toward the target as well).
+    if (r.preheat_en && r.preheat_ms > 0U) {
+        res_.fet_on_us += pulse(r.preheat_ms, weld_pct_to_duty(r.preheat_pct), rng);
+        if (r.preheat_gap_ms > 0U) gap(r.preheat_gap_ms);
+    }
+
+    const uint16_t main_duty = weld_pct_to_duty(r.power_pct);
+    const uint16_t joule_ms = (uint16_t)std::min<uint32_t>(r.max_ms, SIM_MAX_WELD_MS);
+    const uint16_t main1_ms = r.joule ? joule_ms : r.d_ms[0];
+    if (r.weld_mode >= 1U && !stop_requested()) {
+        res_.fet_on_us += pulse(main1_ms, main_duty, rng);
+    }
+
+    // Cut off by the joule_max_ms pulse length: reported as TIMEOUT.
+    if (r.joule && ctl_.stop != JOULE_STOP_TARGET && ctl_.stop != JOULE_STOP_BAD_CONTACT) {
+        ctl_.stop = JOULE_STOP_TIMEOUT;
+    }
+
+    if (r.weld_mode >= 2U && !r.joule) {
+        if (r.gap_ms[0]) gap(r.gap_ms[0]);
+        res_.fet_on_us += pulse(r.d_ms[1], main_duty, rng);
+    }
+    if (r.weld_mode >= 3U && !r.joule) {
+        if (r.gap_ms[1]) gap(r.gap_ms[1]);
+        res_.fet_on_us += pulse(r.d_ms[2], main_duty, rng);
+    }
+
+    res_.work_j = plant_.work_j();
+    if (r.joule) {
+        res_.ctrl_work_j = joule_units_to_j(&ctl_, (float)ctl_.work_units);
+        res_.stop = ctl_.stop;
+    }
+    return res_;
+}
+
+uint32_t WeldSim::pulse(uint16_t ms, uint16_t duty, std::mt19937 &rng)
+{
+    if (ms == 0U) return 0U;
+    if (ms > SIM_MAX_WELD_MS) ms = SIM_MAX_WELD_MS;
+    const uint32_t dur_us = (uint32_t)ms * 1000U;
+    res_.planned_on_us += dur_us;
+
+    if (r_->joule) {
+        joule_build_scale(adc_->ki, adc_->kv, r_->lead_r_setting, r_->min_current_a,
+                          r_->target_j, &scale_);
+        joule_pulse_begin(&ctl_, &scale_, r_->predict && duty >= WELD_PWM_MAX,
+                          t_.interval_us, 3U * t_.interval_us);
+    }
+
+    const bool chopped = (duty > 0U) && (duty < WELD_PWM_MAX);
+    const uint32_t pwm_on_us = (uint32_t)duty * SIM_PWM_PERIOD_US / WELD_PWM_MAX;
+    const bool sweep = !t_.dma && chopped && t_.interval_us == SIM_PWM_PERIOD_US;
+
+    // All times are TIM2 counts: µs since GO (TIM2 start + pwmOnDuty). The
+    // sampling loop runs until kill_us (hardware ARR + 1, or the software
+    // pwmOff()); the gate conducts from fet_on_us to kill_us + fet_off_us.
+    const uint32_t cnt0 = t_.loop_start_us;
+    uint32_t kill_us = dur_us;
+    SimKill kill_kind = SIM_KILL_TIMER;
+
+    // ADC reads and the sample waiting for the loop to act on it.
+    uint32_t slot_us = t_.dma ? (uint32_t)(rng() % t_.interval_us) : cnt0;
+    uint32_t read_us = slot_us;
+    uint32_t sweep_i = 0U;
+    uint32_t best_i = 0U, best_v = 0U, best_us = 0U;
+    bool pend = false;
+    uint32_t pend_i = 0U, pend_v = 0U, pend_sample_us = 0U, pend_dec_us = 0U;
+
+    auto next_slot = [&](uint32_t now_us) {
+        slot_us += t_.interval_us;
+        while (slot_us <= now_us) slot_us += t_.interval_us;
+        read_us = slot_us;
+        sweep_i = 0U;
+    };
+
+    plant_.step(false, t_weld_us_);   // FET off up to GO
+    uint32_t t = 0U;
+    for (; t < kill_us + t_.fet_off_us; t++) {
+        // The ADC sees the current flowing at the start of the tick (0 A at
+        // FET-on), then the plant advances through it.
+        const bool pwm_high =
+            (t >= t_.fet_on_us) &&
+            ((duty >= WELD_PWM_MAX) || (chopped && (t % SIM_PWM_PERIOD_US) < pwm_on_us));
+        const float amps = plant_.current_a();
+        const float volts = plant_.sense_v();
+        plant_.step(pwm_high, t_weld_us_ + t);
+        if (t >= kill_us) continue;   // loop has exited, gate still turning off
+
+        if (t == read_us) {
+            const uint32_t i = adc_->amps_counts(amps);
+            const uint32_t v = adc_->volts_counts(volts);
+            if (t_.dma) {
+                pend = true;
+                pend_i = i;
+                pend_v = v;
+                pend_sample_us = t;
+                pend_dec_us = t + t_.loop_latency_us;
+                read_us += t_.interval_us;
+            } else if (sweep) {
+                if (sweep_i == 0U || i >= best_i) {
+                    best_i = i;
+                    best_v = v;
+                    best_us = t + t_.adc_read_us;
+                }
+                sweep_i++;
+                const uint32_t nxt = slot_us + sweep_i * t_.sweep_step_us;
+                if (sweep_i >= t_.sweep_samples || nxt >= dur_us) {
+                    pend = true;
+                    pend_i = best_i;
+                    pend_v = best_v;
+                    pend_sample_us = best_us;
+                    pend_dec_us = t + t_.adc_read_us + t_.loop_latency_us;
+                    next_slot(pend_dec_us);
+                    if (read_us >= dur_us) read_us = UINT32_MAX;   // no sweep left: loop breaks
+                } else {
+                    read_us = std::max(nxt, t + t_.adc_read_us);
+                }
+            } else {
+                pend = true;
+                pend_i = i;
+                pend_v = v;
+                pend_sample_us = t + t_.adc_read_us;
+                pend_dec_us = pend_sample_us + t_.loop_latency_us;
+                next_slot(pend_dec_us);
+            }
+        }
+
+        if (!pend || t != pend_dec_us) continue;
+        pend = false;
+        res_.samples++;
+        if (!r_->joule) continue;
+
+        const uint32_t elapsed_us = (pend_sample_us > cnt0) ? (pend_sample_us - cnt0) : 0U;
+        JouleStep js;
+        joule_sample(&ctl_, pend_i, pend_v, elapsed_us, r_->max_ms * 1000U, &js);
+
+        if (js.rearm) {
+            uint32_t kc = cnt0 + elapsed_us + js.kill_in_us;
+            bool clamped = false;
+            if (kc == 0U || (kc - 1U) > dur_us - 1U) {
+                kc = dur_us;
+                clamped = true;
+            }
+            if (t + JOULE_PREDICT_MIN_ARM_US >= kc) {
+                kill_us = t + 1U;   // pwmOff() this tick
+                kc = t;
+                kill_kind = SIM_KILL_SOFTWARE;
+            } else {
+                kill_us = kc;
+                kill_kind = clamped ? SIM_KILL_TIMER : SIM_KILL_PREDICT;
+            }
+            joule_kill_programmed(&ctl_, kc - cnt0, clamped);
+            res_.predicted_j = joule_units_to_j(&ctl_, js.pred_units);
+        }
+
+        if (js.stop != JOULE_STOP_NONE) {
+            kill_us = t + 1U;
+            kill_kind = SIM_KILL_SOFTWARE;
+        }
+    }
+
+    if (r_->joule) (void)joule_pulse_end(&ctl_);
+
+    res_.last_kill = kill_kind;
+    t_weld_us_ += t;
+    return t - t_.fet_on_us;
+}
@@ -0,0 +1,96 @@
+// ============================================================
+//  Weld simulator — recipe sequencer + sampling loop
+// ============================================================
+// Runs the firmware's own decision code (weld_control.c: the joule
+// controller and the power % -> duty curve) in closed loop against a
+// CapBankPlant, with the hardware around it modelled tick by tick:
+//   - TIM2 one-shot FET kill at the programmed count (ARR rewrites by the
+//     predictive cutoff, the MIN_ARM software-kill rule, gate turn-off),
+//   - TIM1 PWM chopping at PWM_PERIOD_US for duty < WELD_PWM_MAX,
+//   - ADC sampling: TIM6/DMA at a fixed interval, or the polled loop with
+//     the PWM phase sweep.
+// The phase sequence mirrors fireRecipe() (preheat -> preheat gap -> main
+// d1 / gap1 / d2 / gap2 / d3; joule mode = one main pulse of joule_max_ms),
+// which is interleaved with HAL calls and cannot be linked here. Keep the two
+// in step when the recipe changes.
+#pragma once
+
+#include <stdint.h>
+
+#include <random>
+
+#include "weld_control.h"
+#include "weld_sim_plant.h"
+
+// Firmware constants the sequencer mirrors (main.c).
+#define SIM_MAX_WELD_MS   200U
+#define SIM_PWM_PERIOD_US 100U
+
+struct SimTiming {
+    bool     dma = true;              // WAVEFORM_DMA_CAPTURE
+    uint32_t interval_us = 20U;       // WAVEFORM_SAMPLE_INTERVAL_US
+    uint32_t sweep_step_us = 12U;     // WAVEFORM_PWM_PHASE_SWEEP_STEP_US
+    uint32_t sweep_samples = 6U;      // WAVEFORM_PWM_PHASE_SWEEP_SAMPLES
+    uint32_t adc_read_us = 3U;        // polled adcReadFastTriplet + Vcap-
+    uint32_t loop_latency_us = 2U;    // sample -> decision (pop, integrate)
+    uint32_t loop_start_us = 1U;      // TIM2->CNT when the loop starts
+    uint32_t fet_on_us = 1U;          // pwmOnDuty -> current flowing
+    uint32_t fet_off_us = 1U;         // TIM2 ISR / pwmOff -> gate off
+};
+
+struct SimRecipe {
+    bool     joule = true;            // control_mode == 1
+    float    target_j = 10.0f;        // joule_target_j
+    uint32_t max_ms = 40U;            // joule_max_ms
+    float    min_current_a = 0.5f;    // joule_min_current_a
+    bool     predict = true;          // allow the predictive cutoff
+    uint8_t  weld_mode = 1U;          // time mode: number of main pulses
+    uint16_t d_ms[3] = {10U, 0U, 0U};
+    uint16_t gap_ms[2] = {0U, 0U};
+    uint8_t  power_pct = 100U;
+    bool     preheat_en = false;
+    uint16_t preheat_ms = 0U;
+    uint8_t  preheat_pct = 30U;
+    uint16_t preheat_gap_ms = 0U;
+    float    lead_r_setting = 0.0011f; // lead_resistance_ohms (calibrated)
+};
+
+enum SimKill {
+    SIM_KILL_TIMER = 0,   // TIM2 at the planned pulse end
+    SIM_KILL_PREDICT,     // TIM2 at a predictive ARR
+    SIM_KILL_SOFTWARE,    // pwmOff() from the loop (stop, MIN_ARM)
+};
+
+struct WeldResult {
+    float     work_j = 0.0f;        // true workpiece energy (plant)
+    float     ctrl_work_j = 0.0f;   // what the controller integrated
+    float     predicted_j = 0.0f;   // joule_predicted_j
+    uint32_t  fet_on_us = 0U;       // gate-on time, all pulses
+    uint32_t  planned_on_us = 0U;   // configured pulse time, all pulses
+    uint32_t  samples = 0U;
+    JouleStop stop = JOULE_STOP_NONE;
+    SimKill   last_kill = SIM_KILL_TIMER;
+};
+
+class WeldSim {
+   public:
+    WeldSim(const SimTiming &t, AdcModel *adc) : t_(t), adc_(adc) {}
+
+    // One fireRecipe() from the bank voltage in `plant` through the last
+    // pulse. `rng` picks the DMA sample phase.
+    WeldResult run(const SimRecipe &r, const PlantParams &plant, const ContactModel *contact,
+                   std::mt19937 &rng);
+
+   private:
+    // doPulseMsPwm() + capturePulseAmpsForDurationUs(); returns gate-on µs.
+    uint32_t pulse(uint16_t ms, uint16_t duty, std::mt19937 &rng);
+
+    SimTiming          t_;
+    AdcModel          *adc_;
+    CapBankPlant       plant_;
+    const SimRecipe   *r_ = nullptr;
+    JouleFixedScale    scale_;
+    JouleControl       ctl_;
+    WeldResult         res_;
+    uint32_t           t_weld_us_ = 0U;   // since the first FET-on
+};
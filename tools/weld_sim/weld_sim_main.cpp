@@ -0,0 +1,424 @@
+// ============================================================
+//  Closed-loop weld replay simulator
+// ============================================================
+// Sweeps recipe / controller configurations over Monte Carlo welds (bank
+// voltage, contact resistance, ADC noise and sample phase vary per weld)
+// and reports, per configuration, the true workpiece energy against the
+// target, the overshoot, FET-on time against the plan and how each weld
+// stopped. --replay feeds recorded WAVEFORM_* captures straight into the
+// joule controller instead, and trace:FILE contacts replay a capture's R(t)
+// through the plant. See README.md. Usage:
+//   weld_sim [--check] [--welds N] [--target LIST] [--time-ms LIST]
+//            [--power LIST] [--preheat LIST] [--contact SPEC]...
+//            [--sampling dma,polled] [--predict on,off] [plant options]
+//   weld_sim --replay FILE... [--target LIST]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench_fixture.h"
+#include "weld_control.h"
+#include "weld_sim.h"
+#include "weld_sim_plant.h"
+
+// Joule-mode accuracy goal: within ±2 % of target on 5-20 J welds.
+static const float kDefaultMaxErrPct = 2.0f;
+
+struct SimOptions {
+    uint32_t welds = 500U;
+    std::vector<float> targets = {5.0f, 10.0f, 15.0f, 20.0f};
+    std::vector<float> time_ms;
+    std::vector<float> power = {100.0f};
+    std::vector<float> preheat = {0.0f};
+    uint16_t preheat_ms = 5U;
+    uint16_t preheat_gap_ms = 5U;
+    std::vector<std::string> contacts;
+    std::vector<std::string> sampling = {"dma"};
+    std::vector<std::string> predict = {"on"};
+    uint32_t max_ms = 40U;
+
+    PlantParams plant;
+    float vcap_spread = 0.1f;
+    float contact_spread = 0.2f;
+    float lead_cal_err_pct = 0.0f;
+    float noise_counts = 1.0f;
+    uint32_t seed = 1U;
+
+    bool check = false;
+    float max_err_pct = kDefaultMaxErrPct;
+    std::vector<std::string> replay;
+};
+
+// One row of the report.
+struct RowStats {
+    uint32_t n = 0U;
+    double err_sum = 0.0, err_min = 1e9, err_max = -1e9;   // % of target
+    double ctrl_err_max = 0.0;                             // |controller - true| % of target
+    double work_sum = 0.0;
+    double on_sum = 0.0, on_max = 0.0, planned = 0.0;      // µs
+    uint32_t stops[4] = {0U, 0U, 0U, 0U};
+    uint32_t kills[3] = {0U, 0U, 0U};
+};
+
+static bool parse_floats(const char *s, std::vector<float> *out)
+{
+    out->clear();
+    while (*s) {
+        char *end;
+        float v = strtof(s, &end);
+        if (end == s || !isfinite(v) || v < 0.0f) return false;
+        out->push_back(v);
+        s = (*end == ',') ? end + 1 : end;
+        if (*end && *end != ',') return false;
+    }
+    return !out->empty();
+}
+
+static std::vector<std::string> split_list(const char *s)
+{
+    std::vector<std::string> out;
+    std::string cur;
+    for (; *s; s++) {
+        if (*s == ',') {
+            out.push_back(cur);
+            cur.clear();
+        } else {
+            cur += *s;
+        }
+    }
+    out.push_back(cur);
+    return out;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: weld_sim [--check] [--max-err-pct P] [--welds N] [--seed N]\n"
+            "                [--target J,..] [--time-ms MS,..] [--max-ms MS]\n"
+            "                [--power PCT,..] [--preheat PCT,..] [--preheat-ms MS]\n"
+            "                [--preheat-gap-ms MS] [--contact SPEC]...\n"
+            "                [--sampling dma,polled] [--predict on,off]\n"
+            "                [--vcap V] [--vcap-spread V] [--cap-f F] [--esr-mohm R]\n"
+            "                [--lead-mohm R] [--lead-cal-err-pct P] [--contact-spread F]\n"
+            "                [--noise COUNTS]\n"
+            "       weld_sim --replay FILE... [--target J,..]\n"
+            "contact SPEC: const:R | nugget:R0,R1,E_J | trace:FILE (R in mOhm)\n");
+}
+
+// ============================================================
+//  SWEEP
+// ============================================================
+static SimTiming timing_for(const std::string &sampling)
+{
+    SimTiming t;
+    if (sampling == "polled") {
+        t.dma = false;
+        t.interval_us = SIM_PWM_PERIOD_US;
+    }
+    return t;
+}
+
+static void row_add(RowStats *st, const SimRecipe &r, const WeldResult &w)
+{
+    st->n++;
+    st->work_sum += w.work_j;
+    st->on_sum += w.fet_on_us;
+    st->on_max = std::max(st->on_max, (double)w.fet_on_us);
+    st->planned = w.planned_on_us;
+    st->kills[w.last_kill]++;
+    if (!r.joule) return;
+    const double err = 100.0 * ((double)w.work_j - r.target_j) / r.target_j;
+    st->err_sum += err;
+    st->err_min = std::min(st->err_min, err);
+    st->err_max = std::max(st->err_max, err);
+    st->ctrl_err_max = std::max(st->ctrl_err_max,
+                                fabs(100.0 * ((double)w.ctrl_work_j - w.work_j) / r.target_j));
+    st->stops[w.stop]++;
+}
+
+static void row_print(const char *mode, const SimRecipe &r, const std::string &contact,
+                      const std::string &sampling, const RowStats &st)
+{
+    char what[48];
+    if (r.joule) {
+        snprintf(what, sizeof(what), "%6.1fJ", (double)r.target_j);
+    } else {
+        snprintf(what, sizeof(what), "%5ums", (unsigned)r.d_ms[0]);
+    }
+    char pre[16];
+    if (r.preheat_en) {
+        snprintf(pre, sizeof(pre), "%u%%", (unsigned)r.preheat_pct);
+    } else {
+        snprintf(pre, sizeof(pre), "-");
+    }
+    printf("%-5s %s %4u%% %4s %-6s %-4s %-24s %5u", mode, what, (unsigned)r.power_pct, pre,
+           sampling.c_str(), r.joule ? (r.predict ? "on" : "off") : "-", contact.c_str(), st.n);
+    if (r.joule) {
+        printf("  %+6.2f %+6.2f %+6.2f  %5.2f", st.err_sum / st.n, st.err_min, st.err_max,
+               st.ctrl_err_max);
+    } else {
+        printf("  %6.2fJ %20s", st.work_sum / st.n, "");
+    }
+    printf("  %7.3f %7.3f %7.3f", st.on_sum / st.n / 1000.0, st.on_max / 1000.0,
+           st.planned / 1000.0);
+    if (r.joule) {
+        printf("  %5u/%u/%u", st.stops[JOULE_STOP_TARGET], st.stops[JOULE_STOP_TIMEOUT],
+               st.stops[JOULE_STOP_BAD_CONTACT]);
+    } else {
+        printf("  %9s", "-");
+    }
+    printf("  %u/%u/%u\n", st.kills[SIM_KILL_PREDICT], st.kills[SIM_KILL_SOFTWARE],
+           st.kills[SIM_KILL_TIMER]);
+}
+
+static int run_sweep(const SimOptions &o)
+{
+    std::vector<std::unique_ptr<ContactModel>> contacts;
+    std::vector<std::string> specs = o.contacts;
+    if (specs.empty()) specs = {"const:0.6", "nugget:1.2,0.5,4"};
+    for (const std::string &spec : specs) {
+        std::string err;
+        std::unique_ptr<ContactModel> c = contact_model_parse(spec, &err);
+        if (!c) {
+            fprintf(stderr, "weld_sim: %s\n", err.c_str());
+            return 2;
+        }
+        contacts.push_back(std::move(c));
+    }
+
+    // Joule rows first, then time-mode rows.
+    std::vector<SimRecipe> recipes;
+    for (float pre : o.preheat) {
+        for (float pw : o.power) {
+            SimRecipe base;
+            base.max_ms = o.max_ms;
+            base.power_pct = (uint8_t)std::min(pw, 100.0f);
+            base.preheat_en = pre > 0.0f;
+            base.preheat_ms = o.preheat_ms;
+            base.preheat_pct = (uint8_t)std::min(pre, 100.0f);
+            base.preheat_gap_ms = o.preheat_gap_ms;
+            base.lead_r_setting = o.plant.lead_ohm * (1.0f + o.lead_cal_err_pct / 100.0f);
+            for (const std::string &pr : o.predict) {
+                for (float tj : o.targets) {
+                    SimRecipe r = base;
+                    r.joule = true;
+                    r.target_j = tj;
+                    r.predict = (pr != "off");
+                    recipes.push_back(r);
+                }
+            }
+            for (float ms : o.time_ms) {
+                SimRecipe r = base;
+                r.joule = false;
+                r.d_ms[0] = (uint16_t)std::min(ms, (float)SIM_MAX_WELD_MS);
+                recipes.push_back(r);
+            }
+        }
+    }
+
+    printf("%-5s %7s %5s %4s %-6s %-4s %-24s %5s  %6s %6s %6s  %5s  %7s %7s %7s  %9s  %s\n",
+           "mode", "target", "power", "pre", "adc", "pred", "contact", "welds", "err%", "min%",
+           "max%", "ctl%", "on_ms", "max_ms", "plan_ms", "tgt/to/bc", "pred/sw/tim");
+
+    AdcModel adc;
+    adc.noise_counts = o.noise_counts;
+    adc.rng.seed(o.seed);
+    std::mt19937 rng(o.seed);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    bool ok = true;
+    uint64_t total_welds = 0U;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (const std::string &sampling : o.sampling) {
+        WeldSim sim(timing_for(sampling), &adc);
+        for (const auto &contact : contacts) {
+            for (const SimRecipe &r : recipes) {
+                RowStats st;
+                for (uint32_t k = 0; k < o.welds; k++) {
+                    PlantParams p = o.plant;
+                    p.vcap_v += o.vcap_spread * unit(rng);
+                    p.contact_k = 1.0f + o.contact_spread * unit(rng);
+                    row_add(&st, r, sim.run(r, p, contact.get(), rng));
+                }
+                total_welds += st.n;
+                row_print(r.joule ? "joule" : "time", r, contact->name(), sampling, st);
+
+                if (o.check && r.joule) {
+                    const bool bad_err = fabs(st.err_min) > o.max_err_pct ||
+                                         fabs(st.err_max) > o.max_err_pct;
+                    const bool bad_stop = st.stops[JOULE_STOP_TARGET] != st.n;
+                    if (bad_err || bad_stop) {
+                        printf("FAIL: %.1f J %s: energy error %+.2f..%+.2f %% (limit %.1f), "
+                               "%u/%u stopped on target\n",
+                               (double)r.target_j, contact->name().c_str(), st.err_min, st.err_max,
+                               (double)o.max_err_pct, st.stops[JOULE_STOP_TARGET], st.n);
+                        ok = false;
+                    }
+                }
+            }
+        }
+    }
+    const double secs =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    printf("%llu welds in %.2f s (%.0f welds/s)\n", (unsigned long long)total_welds, secs,
+           secs > 0.0 ? (double)total_welds / secs : 0.0);
+    if (o.check) printf("%s\n", ok ? "check: OK" : "check: FAILED");
+    return ok ? 0 : 1;
+}
+
+// ============================================================
+//  RECORDED-TRACE REPLAY
+// ============================================================
+// The capture's main pulse, sample by sample, through joule_sample(): where
+// the controller would have stopped in that weld, and how its integer
+// energy compares with the capture integrated in floats.
+static int run_replay(const SimOptions &o)
+{
+    printf("%-22s %7s  %-8s %9s %9s %8s %8s %7s\n", "capture", "target", "stop", "stop_us",
+           "pulse_us", "ctrl_j", "trace_j", "diff%");
+    bool ok = true;
+    for (const std::string &path : o.replay) {
+        BenchFixture fx;
+        std::string err;
+        if (!bench_fixture_load(path, &fx, &err)) {
+            fprintf(stderr, "weld_sim: %s\n", err.c_str());
+            ok = false;
+            continue;
+        }
+        if (fx.main_end <= fx.main_start) {
+            fprintf(stderr, "weld_sim: %s: no main pulse\n", fx.name.c_str());
+            ok = false;
+            continue;
+        }
+        const uint32_t t_main = fx.ts_us[fx.main_start];
+        const uint32_t pulse_us = fx.ts_us[fx.main_end - 1U] - t_main;
+
+        for (float tj : o.targets) {
+            JouleFixedScale sc;
+            JouleControl jc;
+            joule_build_scale(fx.amps_per_count, fx.volts_per_count, fx.lead_r_ohm, 0.5f, tj, &sc);
+            joule_reset(&jc);
+            joule_pulse_begin(&jc, &sc, false, fx.interval_us, 3U * fx.interval_us);
+
+            double trace_j = 0.0;
+            uint32_t prev_us = 0U;
+            uint32_t stop_us = 0U;
+            for (uint16_t i = fx.main_start; i < fx.main_end; i++) {
+                const uint32_t el = fx.ts_us[i] - t_main;
+                const float a = fx.amps[i], v = fx.volts[i];
+                const uint32_t ic = (uint32_t)lroundf(a / fx.amps_per_count);
+                const uint32_t vc = (uint32_t)lroundf(v / fx.volts_per_count);
+                const uint32_t dt = (el > prev_us) ? el - prev_us : fx.interval_us;
+                prev_us = el;
+                trace_j += std::max(0.0, ((double)v * a - (double)a * a * fx.lead_r_ohm) * dt * 1e-6);
+                JouleStep js;
+                joule_sample(&jc, ic, vc, el, 200000U, &js);
+                stop_us = el;
+                if (js.stop != JOULE_STOP_NONE) break;
+            }
+            const float ctrl_j = joule_units_to_j(&jc, (float)jc.work_units);
+            const double diff = trace_j > 0.0 ? 100.0 * (ctrl_j - trace_j) / trace_j : 0.0;
+            printf("%-22s %6.1fJ  %-8s %9u %9u %8.3f %8.3f %+7.3f\n", fx.name.c_str(), (double)tj,
+                   jc.stop == JOULE_STOP_TARGET ? "target" : "ran_out", stop_us, pulse_us,
+                   (double)ctrl_j, trace_j, diff);
+            if (o.check && fabs(diff) > o.max_err_pct) ok = false;
+        }
+    }
+    if (o.check) printf("%s\n", ok ? "check: OK" : "check: FAILED");
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    SimOptions o;
+    bool replay_files = false;
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const bool has_val = i + 1 < argc;
+        const char *v = has_val ? argv[i + 1] : "";
+        bool bad = false;
+        if (!strcmp(a, "--check")) {
+            o.check = true;
+            continue;
+        } else if (!strcmp(a, "--replay")) {
+            replay_files = true;
+            continue;
+        } else if (a[0] != '-' && replay_files) {
+            o.replay.push_back(a);
+            continue;
+        } else if (!has_val) {
+            bad = true;
+        } else if (!strcmp(a, "--welds")) {
+            o.welds = (uint32_t)strtoul(v, nullptr, 10);
+            bad = o.welds == 0U;
+        } else if (!strcmp(a, "--seed")) {
+            o.seed = (uint32_t)strtoul(v, nullptr, 10);
+        } else if (!strcmp(a, "--max-err-pct")) {
+            o.max_err_pct = strtof(v, nullptr);
+        } else if (!strcmp(a, "--target")) {
+            bad = !parse_floats(v, &o.targets);
+        } else if (!strcmp(a, "--time-ms")) {
+            bad = !parse_floats(v, &o.time_ms);
+        } else if (!strcmp(a, "--max-ms")) {
+            o.max_ms = (uint32_t)strtoul(v, nullptr, 10);
+        } else if (!strcmp(a, "--power")) {
+            bad = !parse_floats(v, &o.power);
+        } else if (!strcmp(a, "--preheat")) {
+            bad = !parse_floats(v, &o.preheat);
+        } else if (!strcmp(a, "--preheat-ms")) {
+            o.preheat_ms = (uint16_t)strtoul(v, nullptr, 10);
+        } else if (!strcmp(a, "--preheat-gap-ms")) {
+            o.preheat_gap_ms = (uint16_t)strtoul(v, nullptr, 10);
+        } else if (!strcmp(a, "--contact")) {
+            o.contacts.push_back(v);
+        } else if (!strcmp(a, "--sampling")) {
+            o.sampling = split_list(v);
+            for (const std::string &s : o.sampling) bad |= (s != "dma" && s != "polled");
+        } else if (!strcmp(a, "--predict")) {
+            o.predict = split_list(v);
+            for (const std::string &s : o.predict) bad |= (s != "on" && s != "off");
+        } else if (!strcmp(a, "--vcap")) {
+            o.plant.vcap_v = strtof(v, nullptr);
+        } else if (!strcmp(a, "--vcap-spread")) {
+            o.vcap_spread = strtof(v, nullptr);
+        } else if (!strcmp(a, "--cap-f")) {
+            o.plant.cap_f = strtof(v, nullptr);
+        } else if (!strcmp(a, "--esr-mohm")) {
+            o.plant.esr_ohm = strtof(v, nullptr) * 1e-3f;
+        } else if (!strcmp(a, "--lead-mohm")) {
+            o.plant.lead_ohm = strtof(v, nullptr) * 1e-3f;
+        } else if (!strcmp(a, "--lead-cal-err-pct")) {
+            o.lead_cal_err_pct = strtof(v, nullptr);
+        } else if (!strcmp(a, "--contact-spread")) {
+            o.contact_spread = strtof(v, nullptr);
+        } else if (!strcmp(a, "--noise")) {
+            o.noise_counts = strtof(v, nullptr);
+        } else {
+            bad = true;
+        }
+        if (bad) {
+            usage();
+            return 2;
+        }
+        i++;
+    }
+
+    if (!(o.plant.cap_f > 0.0f) || !(o.plant.vcap_v > 0.0f) || !(o.plant.lead_ohm >= 0.0f) ||
+        !(o.plant.esr_ohm >= 0.0f)) {
+        usage();
+        return 2;
+    }
+#if !JOULE_PREDICTIVE_CUTOFF
+    o.predict = {"off"};   // compiled out: joule_pulse_begin() ignores predict
+#endif
+    if (replay_files) return run_replay(o);
+    return run_sweep(o);
+}
@@ -0,0 +1,165 @@
+// ============================================================
+//  Weld simulator — plant model (cap bank, leads, contact)
+// ============================================================
+
+#include "weld_sim_plant.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "bench_fixture.h"
+
+// ============================================================
+//  CONTACT MODELS
+// ============================================================
+std::string ConstContact::name() const
+{
+    char b[48];
+    snprintf(b, sizeof(b), "const:%.2f", (double)r_ * 1e3);
+    return b;
+}
+
+std::string NuggetContact::name() const
+{
+    char b[64];
+    snprintf(b, sizeof(b), "nugget:%.2f,%.2f,%.1f", (double)r_start_ * 1e3,
+             (double)r_end_ * 1e3, (double)e_fold_);
+    return b;
+}
+
+float NuggetContact::resistance_ohm(uint32_t, float e_j) const
+{
+    return r_end_ + (r_start_ - r_end_) * expf(-e_j / e_fold_);
+}
+
+std::unique_ptr<TraceContact> TraceContact::from_fixture(const BenchFixture &fx, std::string *err)
+{
+    std::unique_ptr<TraceContact> tc(new TraceContact());
+    tc->source_ = fx.name;
+
+    // Samples well inside the conduction: 10 % of the window peak as in
+    // resolve_phase_start_from_waveform(), and at least 50 A.
+    float peak = 0.0f;
+    for (uint16_t i = fx.main_start; i < fx.main_end; i++) peak = std::max(peak, fx.amps[i]);
+    const float min_a = std::max(50.0f, 0.1f * peak);
+
+    bool started = false;
+    uint32_t t0 = 0;
+    for (uint16_t i = fx.main_start; i < fx.main_end; i++) {
+        if (fx.amps[i] < min_a) continue;
+        if (!started) {
+            t0 = fx.ts_us[i];
+            started = true;
+        }
+        float r = fx.volts[i] / fx.amps[i] - fx.lead_r_ohm;
+        if (!isfinite(r) || r < 0.00002f) r = 0.00002f;
+        tc->t_us_.push_back(fx.ts_us[i] - t0);
+        tc->r_ohm_.push_back(r);
+    }
+    if (tc->t_us_.size() < 2) {
+        *err = fx.name + ": no conducting samples in the main pulse";
+        return nullptr;
+    }
+    return tc;
+}
+
+float TraceContact::resistance_ohm(uint32_t t_us, float) const
+{
+    auto it = std::upper_bound(t_us_.begin(), t_us_.end(), t_us);
+    if (it == t_us_.begin()) return r_ohm_.front();
+    if (it == t_us_.end()) return r_ohm_.back();
+    size_t k = (size_t)(it - t_us_.begin());
+    float f = (float)(t_us - t_us_[k - 1]) / (float)(t_us_[k] - t_us_[k - 1]);
+    return r_ohm_[k - 1] + f * (r_ohm_[k] - r_ohm_[k - 1]);
+}
+
+std::unique_ptr<ContactModel> contact_model_parse(const std::string &spec, std::string *err)
+{
+    size_t colon = spec.find(':');
+    std::string kind = spec.substr(0, colon);
+    std::string args = (colon == std::string::npos) ? "" : spec.substr(colon + 1);
+
+    if (kind == "trace") {
+        BenchFixture fx;
+        if (!bench_fixture_load(args, &fx, err)) return nullptr;
+        return TraceContact::from_fixture(fx, err);
+    }
+
+    float v[3] = {0.0f, 0.0f, 0.0f};
+    int n = 0;
+    const char *p = args.c_str();
+    while (n < 3 && *p) {
+        char *end;
+        v[n++] = strtof(p, &end);
+        p = (*end == ',') ? end + 1 : end;
+        if (end == p && *p) break;
+    }
+    if (kind == "const" && n == 1 && v[0] > 0.0f) {
+        return std::unique_ptr<ContactModel>(new ConstContact(v[0] * 1e-3f));
+    }
+    if (kind == "nugget" && n == 3 && v[0] > 0.0f && v[1] > 0.0f && v[2] > 0.0f) {
+        return std::unique_ptr<ContactModel>(new NuggetContact(v[0] * 1e-3f, v[1] * 1e-3f, v[2]));
+    }
+    *err = "bad contact model '" + spec + "' (const:R | nugget:R0,R1,E | trace:FILE, R in mOhm)";
+    return nullptr;
+}
+
+// ============================================================
+//  CAP BANK + LEADS
+// ============================================================
+void CapBankPlant::reset(const PlantParams &p, const ContactModel *contact)
+{
+    p_ = p;
+    contact_ = contact;
+    v_int_ = p.vcap_v;
+    i_a_ = 0.0f;
+    e_work_j_ = e_lead_j_ = e_src_j_ = 0.0f;
+}
+
+void CapBankPlant::step(bool conducting, uint32_t t_us)
+{
+    if (!conducting) {
+        i_a_ = 0.0f;
+        return;
+    }
+    const float rc = contact_->resistance_ohm(t_us, e_work_j_) * p_.contact_k;
+    const float r_total = p_.esr_ohm + p_.lead_ohm + rc;
+    i_a_ = v_int_ / r_total;
+    const float dt = 1.0e-6f;
+    e_work_j_ += i_a_ * i_a_ * rc * dt;
+    e_lead_j_ += i_a_ * i_a_ * p_.lead_ohm * dt;
+    e_src_j_  += sense_v() * i_a_ * dt;
+    v_int_    -= i_a_ * dt / p_.cap_f;
+}
+
+// ============================================================
+//  ADC
+// ============================================================
+AdcModel::AdcModel(float vdda) : rng(1)
+{
+    const float v_per_count = vdda / 4095.0f;
+    ki = (v_per_count / 8.2f / 0.000050f) * 1.76f;
+    kv = v_per_count * 6.0f;
+}
+
+static uint32_t quantise(float value, float per_count, float noise, std::mt19937 &rng)
+{
+    float c = value / per_count;
+    if (noise > 0.0f) c += std::normal_distribution<float>(0.0f, noise)(rng);
+    if (!(c > 0.0f)) return 0U;
+    if (c > 4095.0f) return 4095U;
+    return (uint32_t)lroundf(c);
+}
+
+uint32_t AdcModel::amps_counts(float amps)
+{
+    return quantise(amps, ki, noise_counts, rng);
+}
+
+uint32_t AdcModel::volts_counts(float volts)
+{
+    return quantise(volts, kv, noise_counts, rng);
+}
@@ -0,0 +1,120 @@
+// ============================================================
+//  Weld simulator — plant model (cap bank, leads, contact)
+// ============================================================
+// The electrical side of one weld, stepped in 1 µs ticks: a CAP_FARADS bank
+// with ESR discharging through the leads (everything between the Vcap sense
+// point and the electrode tips, i.e. what lead calibration measures) into a
+// contact resistance. The contact is the pluggable part (ContactModel):
+// constant, a softening-nugget curve, or a curve recovered from a recorded
+// WAVEFORM_* capture. The ADC model turns the plant into the counts the
+// STM32 sampling loop sees.
+#pragma once
+
+#include <stdint.h>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+struct BenchFixture;
+
+// ============================================================
+//  CONTACT MODELS
+// ============================================================
+class ContactModel {
+   public:
+    virtual ~ContactModel() {}
+    virtual std::string name() const = 0;
+    // Workpiece resistance t_us after the first FET-on, with e_j already
+    // delivered into the workpiece.
+    virtual float resistance_ohm(uint32_t t_us, float e_j) const = 0;
+};
+
+class ConstContact : public ContactModel {
+   public:
+    explicit ConstContact(float r_ohm) : r_(r_ohm) {}
+    std::string name() const override;
+    float resistance_ohm(uint32_t, float) const override { return r_; }
+
+   private:
+    float r_;
+};
+
+// Resistance falls from r_start toward r_end as the joint heats and the
+// contact spots grow: r = r_end + (r_start - r_end) * exp(-E / e_fold).
+class NuggetContact : public ContactModel {
+   public:
+    NuggetContact(float r_start, float r_end, float e_fold)
+        : r_start_(r_start), r_end_(r_end), e_fold_(e_fold) {}
+    std::string name() const override;
+    float resistance_ohm(uint32_t t_us, float e_j) const override;
+
+   private:
+    float r_start_, r_end_, e_fold_;
+};
+
+// R(t) recovered from a capture: V/I over the main pulse minus the lead
+// resistance recorded with it, held flat past the end of the recording.
+class TraceContact : public ContactModel {
+   public:
+    // False (with *err) if the capture has no usable main pulse.
+    static std::unique_ptr<TraceContact> from_fixture(const BenchFixture &fx, std::string *err);
+    std::string name() const override { return "trace:" + source_; }
+    float resistance_ohm(uint32_t t_us, float e_j) const override;
+
+   private:
+    std::string           source_;
+    std::vector<uint32_t> t_us_;
+    std::vector<float>    r_ohm_;
+};
+
+// "const:R", "nugget:R0,R1,E" or "trace:FILE" (resistances in mOhm).
+std::unique_ptr<ContactModel> contact_model_parse(const std::string &spec, std::string *err);
+
+// ============================================================
+//  CAP BANK + LEADS
+// ============================================================
+struct PlantParams {
+    float cap_f     = 413.0f;     // CAP_FARADS (main.c)
+    float esr_ohm   = 0.0003f;    // bank + busbar, inside the Vcap sense
+    float lead_ohm  = 0.0011f;    // sense point -> tips (lead calibration)
+    float vcap_v    = 8.6f;       // bank voltage at FET-on
+    float contact_k = 1.0f;       // per-weld contact resistance multiplier
+};
+
+class CapBankPlant {
+   public:
+    void reset(const PlantParams &p, const ContactModel *contact);
+
+    // Advance 1 µs; t_us = time since the first FET-on of the weld.
+    void step(bool conducting, uint32_t t_us);
+
+    float current_a() const { return i_a_; }
+    float sense_v() const { return v_int_ - i_a_ * p_.esr_ohm; }   // ADC Vcap
+    float work_j() const { return e_work_j_; }    // I^2 * R_contact (ground truth)
+    float lead_j() const { return e_lead_j_; }
+    float source_j() const { return e_src_j_; }   // sense_v * I at the sense
+
+   private:
+    PlantParams         p_;
+    const ContactModel *contact_ = nullptr;
+    float v_int_ = 0.0f, i_a_ = 0.0f;
+    float e_work_j_ = 0.0f, e_lead_j_ = 0.0f, e_src_j_ = 0.0f;
+};
+
+// ============================================================
+//  ADC
+// ============================================================
+// main.c scales (SHUNT_GAIN, SHUNT_EFF_OHMS, CURRENT_CAL_FACTOR,
+// V_CAP_DIVIDER) at a given VDDA, with Gaussian noise in counts.
+struct AdcModel {
+    float ki;   // A per count
+    float kv;   // V per count
+    float noise_counts = 1.0f;
+    std::mt19937 rng;
+
+    explicit AdcModel(float vdda = 3.3f);
+    uint32_t amps_counts(float amps);
+    uint32_t volts_counts(float volts);
+};